@@ -0,0 +1,120 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+// hashbench: measures the throughput of every CRC32 and SHA1 kernel on map sized buffers
+// usage: hashbench [buffer size in MB] [iterations]
+
+#include "ghost.h"
+#include "crc32.h"
+#include "sha1.h"
+
+#include <cstdlib>
+#include <chrono>
+
+void CONSOLE_Print( string message )
+{
+	cout << message << endl;
+}
+
+double ElapsedSeconds( chrono :: steady_clock :: time_point start )
+{
+	return chrono :: duration<double>( chrono :: steady_clock :: now( ) - start ).count( );
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t SizeMB = argc > 1 ? atoi( argv[1] ) : 8;
+	uint32_t Iterations = argc > 2 ? atoi( argv[2] ) : 10;
+
+	if( SizeMB == 0 )
+		SizeMB = 8;
+
+	if( Iterations == 0 )
+		Iterations = 10;
+
+	// fill the buffer with junk, the contents don't matter for throughput
+
+	BYTEARRAY Data( SizeMB * 1024 * 1024 );
+	srand( 0 );
+
+	for( BYTEARRAY :: iterator i = Data.begin( ); i != Data.end( ); i++ )
+		*i = rand( );
+
+	CCRC32 CRC;
+	CRC.Initialize( );
+
+	cout << "hashing " << SizeMB << " MB " << Iterations << " times" << endl;
+	cout << "best CRC32 kernel is " << CCRC32 :: GetBestKernel( ) << ", SHA-NI is " << ( CSHA1 :: HasHardware( ) ? "supported" : "not supported" ) << endl;
+
+	string KernelNames[] = { "", "crc32 byte", "crc32 slice-by-8", "crc32 pclmul" };
+	uint32_t Reference = 0;
+
+	for( uint32_t Kernel = CRC32_KERNEL_BYTE; Kernel <= CRC32_KERNEL_PCLMUL; Kernel++ )
+	{
+		if( Kernel == CRC32_KERNEL_PCLMUL && CCRC32 :: GetBestKernel( ) != CRC32_KERNEL_PCLMUL )
+			continue;
+
+		uint32_t Result = 0;
+		chrono :: steady_clock :: time_point Start = chrono :: steady_clock :: now( );
+
+		for( uint32_t i = 0; i < Iterations; i++ )
+		{
+			Result = 0xFFFFFFFF;
+			CRC.PartialCRCWithKernel( Kernel, &Result, &Data[0], Data.size( ) );
+		}
+
+		double Seconds = ElapsedSeconds( Start );
+
+		if( Kernel == CRC32_KERNEL_BYTE )
+			Reference = Result;
+
+		cout << setw( 20 ) << left << KernelNames[Kernel] << fixed << setprecision( 1 ) << setw( 10 ) << right << ( SizeMB * Iterations ) / Seconds << " MB/s" << ( Result == Reference ? "" : "  (WRONG RESULT)" ) << endl;
+	}
+
+	unsigned char ReferenceHash[20];
+
+	for( int Hardware = 0; Hardware <= 1; Hardware++ )
+	{
+		if( Hardware && !CSHA1 :: HasHardware( ) )
+			continue;
+
+		CSHA1 SHA;
+		SHA.SetHardware( Hardware != 0 );
+		unsigned char Hash[20];
+		chrono :: steady_clock :: time_point Start = chrono :: steady_clock :: now( );
+
+		for( uint32_t i = 0; i < Iterations; i++ )
+		{
+			SHA.Reset( );
+			SHA.Update( &Data[0], Data.size( ) );
+			SHA.Final( );
+			SHA.GetHash( Hash );
+		}
+
+		double Seconds = ElapsedSeconds( Start );
+
+		if( !Hardware )
+			memcpy( ReferenceHash, Hash, 20 );
+
+		cout << setw( 20 ) << left << ( Hardware ? "sha1 sha-ni" : "sha1 portable" ) << fixed << setprecision( 1 ) << setw( 10 ) << right << ( SizeMB * Iterations ) / Seconds << " MB/s" << ( memcmp( Hash, ReferenceHash, 20 ) == 0 ? "" : "  (WRONG RESULT)" ) << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+// langbench: measures how fast CLanguage builds its messages
+// "replace" is the old way, i.e. a config lookup followed by one UTIL_Replace per token
+// "template" is CLanguage with the messages compiled when the language file is loaded
+// usage: langbench [language file] [iterations]
+
+#include "ghost.h"
+#include "util.h"
+#include "config.h"
+#include "language.h"
+
+#include <cstdlib>
+#include <chrono>
+
+void CONSOLE_Print( string message )
+{
+	cout << message << endl;
+}
+
+double ElapsedSeconds( chrono :: steady_clock :: time_point start )
+{
+	return chrono :: duration<double>( chrono :: steady_clock :: now( ) - start ).count( );
+}
+
+// copied from CLanguage before the messages were compiled
+
+string GameRefreshed( CConfig *CFG )
+{
+	return CFG->GetString( "lang_0042", "lang_0042" );
+}
+
+string HasPlayedGamesWithThisBot( CConfig *CFG, string user, string firstgame, string lastgame, string totalgames, string avgloadingtime, string avgstay )
+{
+	string Out = CFG->GetString( "lang_0061", "lang_0061" );
+	UTIL_Replace( Out, "$USER$", user );
+	UTIL_Replace( Out, "$FIRSTGAME$", firstgame );
+	UTIL_Replace( Out, "$LASTGAME$", lastgame );
+	UTIL_Replace( Out, "$TOTALGAMES$", totalgames );
+	UTIL_Replace( Out, "$AVGLOADINGTIME$", avgloadingtime );
+	UTIL_Replace( Out, "$AVGSTAY$", avgstay );
+	return Out;
+}
+
+string UserWasBannedOnByBecause( CConfig *CFG, string server, string victim, string date, string admin, string reason )
+{
+	string Out = CFG->GetString( "lang_0011", "lang_0011" );
+	UTIL_Replace( Out, "$SERVER$", server );
+	UTIL_Replace( Out, "$VICTIM$", victim );
+	UTIL_Replace( Out, "$DATE$", date );
+	UTIL_Replace( Out, "$ADMIN$", admin );
+	UTIL_Replace( Out, "$REASON$", reason );
+	return Out;
+}
+
+int main( int argc, char **argv )
+{
+	string File = argc > 1 ? argv[1] : "../language.cfg";
+	uint32_t Iterations = argc > 2 ? atoi( argv[2] ) : 1000000;
+
+	if( Iterations == 0 )
+		Iterations = 1000000;
+
+	CConfig CFG;
+	CFG.Read( File );
+	CLanguage Language( File );
+
+	// both must build exactly the same messages
+
+	if( GameRefreshed( &CFG ) != Language.GameRefreshed( ) ||
+		HasPlayedGamesWithThisBot( &CFG, "Varlock", "2009-01-01", "2009-12-31", "1234", "42.5", "97" ) != Language.HasPlayedGamesWithThisBot( "Varlock", "2009-01-01", "2009-12-31", "1234", "42.5", "97" ) ||
+		UserWasBannedOnByBecause( &CFG, "europe.battle.net", "Varlock", "2009-06-01", "admin", "leaver" ) != Language.UserWasBannedOnByBecause( "europe.battle.net", "Varlock", "2009-06-01", "admin", "leaver" ) )
+	{
+		CONSOLE_Print( "[LANGBENCH] the messages differ" );
+		return 1;
+	}
+
+	string Names[] = { "replace", "template" };
+
+	for( uint32_t Method = 0; Method < 2; Method++ )
+	{
+		uint64_t Bytes = 0;
+		chrono :: steady_clock :: time_point Start = chrono :: steady_clock :: now( );
+
+		for( uint32_t i = 0; i < Iterations; i++ )
+		{
+			if( Method == 0 )
+			{
+				Bytes += GameRefreshed( &CFG ).size( );
+				Bytes += HasPlayedGamesWithThisBot( &CFG, "Varlock", "2009-01-01", "2009-12-31", "1234", "42.5", "97" ).size( );
+				Bytes += UserWasBannedOnByBecause( &CFG, "europe.battle.net", "Varlock", "2009-06-01", "admin", "leaver" ).size( );
+			}
+			else
+			{
+				Bytes += Language.GameRefreshed( ).size( );
+				Bytes += Language.HasPlayedGamesWithThisBot( "Varlock", "2009-01-01", "2009-12-31", "1234", "42.5", "97" ).size( );
+				Bytes += Language.UserWasBannedOnByBecause( "europe.battle.net", "Varlock", "2009-06-01", "admin", "leaver" ).size( );
+			}
+		}
+
+		double Elapsed = ElapsedSeconds( Start );
+		CONSOLE_Print( "[" + Names[Method] + "] " + UTIL_ToString( Elapsed * 1000000000.0 / ( 3.0 * Iterations ), 1 ) + " ns per message (" + UTIL_ToString( Bytes ) + " bytes)" );
+	}
+
+	return 0;
+}
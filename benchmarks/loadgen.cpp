@@ -0,0 +1,926 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+// loadgen: a swarm of fake Warcraft III clients for measuring how many games and players a bot can sustain
+// each "wave" of clients joins the bot's current lobby over LAN (host counter id 0), claims to have the map (or downloads it), loads and then plays
+// while playing every client sends actions at the configured APM and answers every W3GS_INCOMING_ACTION with a W3GS_OUTGOING_KEEPALIVE like a real client
+// every action carries the time it was sent so the delay until the bot relays it back to us is the action delivery latency
+// GProxy++ clients drop their connection once per game and reconnect through the bot's reconnect port
+// the bot must be autohosting a map with fixed player settings and autostart set to the number of players per game, and running against a local MySQL server
+// the bot's database is whatever its config points at, loadgen never talks to it
+// usage: loadgen [-host ip] [-port port] [-players n] [-games n] [-time seconds] [-duration seconds] [-apm n] [-download] [-gproxy percent] [-pid botpid] [-report seconds]
+
+#include "ghost.h"
+#include "util.h"
+#include "gameprotocol.h"
+#include "gpsprotocol.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#define LOADGEN_WAITING			0		// waiting to (re)join the lobby
+#define LOADGEN_LOBBY			1		// connected, waiting for the game to start
+#define LOADGEN_LOADING			2		// the countdown finished, waiting for the first W3GS_INCOMING_ACTION
+#define LOADGEN_PLAYING			3
+#define LOADGEN_RECONNECTING	4		// dropped on purpose, reconnecting through GProxy++
+#define LOADGEN_DONE			5
+
+#define LOADGEN_ACTION_ID		119		// not a real action id so the bot's stats parsers ignore it
+
+void CONSOLE_Print( string message )
+{
+	cout << message << endl;
+}
+
+int64_t GetMicroseconds( )
+{
+	return chrono :: duration_cast<chrono :: microseconds>( chrono :: steady_clock :: now( ).time_since_epoch( ) ).count( );
+}
+
+//
+// options
+//
+
+string gHost = "127.0.0.1";
+uint16_t gPort = 6112;
+uint32_t gPlayers = 10;
+uint32_t gGames = 10;
+uint32_t gTime = 300;
+uint32_t gDuration = 120;
+uint32_t gAPM = 120;
+bool gDownload = false;
+uint32_t gGProxy = 0;
+uint32_t gBotPID = 0;
+uint32_t gReport = 10;
+
+//
+// statistics, reset after every report
+//
+
+struct LoadStats
+{
+	vector<double> Latencies;			// ms from sending an action to receiving it back from the bot
+	vector<double> TickIntervals;		// ms between two W3GS_INCOMING_ACTION packets
+	uint32_t ActionsSent;
+	uint32_t ActionsReceived;
+	uint32_t Joins;
+	uint32_t Rejects;
+	uint32_t Kicks;						// connections the bot closed on us outside of a GProxy++ drop
+	uint32_t Reconnects;
+	uint32_t ReconnectsFailed;
+	uint64_t BytesSent;
+	uint64_t BytesReceived;
+};
+
+LoadStats gStats;
+LoadStats gTotalStats;
+CGPSProtocol gGPSProtocol;
+
+void ResetStats( LoadStats &stats )
+{
+	stats.Latencies.clear( );
+	stats.TickIntervals.clear( );
+	stats.ActionsSent = 0;
+	stats.ActionsReceived = 0;
+	stats.Joins = 0;
+	stats.Rejects = 0;
+	stats.Kicks = 0;
+	stats.Reconnects = 0;
+	stats.ReconnectsFailed = 0;
+	stats.BytesSent = 0;
+	stats.BytesReceived = 0;
+}
+
+string Percentiles( vector<double> &values )
+{
+	if( values.empty( ) )
+		return "n/a";
+
+	sort( values.begin( ), values.end( ) );
+	double P50 = values[values.size( ) * 50 / 100];
+	double P90 = values[values.size( ) * 90 / 100];
+	double P99 = values[values.size( ) * 99 / 100];
+	double P999 = values[values.size( ) * 999 / 1000];
+	return "p50 " + UTIL_ToString( P50, 1 ) + " p90 " + UTIL_ToString( P90, 1 ) + " p99 " + UTIL_ToString( P99, 1 ) + " p99.9 " + UTIL_ToString( P999, 1 ) + " max " + UTIL_ToString( values.back( ), 1 ) + " ms";
+}
+
+//
+// the bot's process, sampled from /proc
+//
+
+int64_t gLastBotSample = 0;
+uint64_t gLastBotCPU = 0;
+
+string SampleBot( )
+{
+	if( gBotPID == 0 )
+		return string( );
+
+	ifstream Stat( ( "/proc/" + UTIL_ToString( gBotPID ) + "/stat" ).c_str( ) );
+	string Line;
+
+	if( !getline( Stat, Line ) || Line.rfind( ')' ) == string :: npos )
+		return "bot: process " + UTIL_ToString( gBotPID ) + " not found";
+
+	// the fields after the command name (which can contain spaces) start with the state, utime and stime are the 12th and 13th of those
+
+	stringstream SS( Line.substr( Line.rfind( ')' ) + 2 ) );
+	string Field;
+	uint64_t CPU = 0;
+
+	for( int i = 0; i < 13 && SS >> Field; i++ )
+	{
+		if( i >= 11 )
+			CPU += strtoull( Field.c_str( ), NULL, 10 );
+	}
+
+	ifstream Status( ( "/proc/" + UTIL_ToString( gBotPID ) + "/status" ).c_str( ) );
+	string RSS = "?";
+
+	while( getline( Status, Line ) )
+	{
+		if( Line.compare( 0, 6, "VmRSS:" ) == 0 )
+		{
+			RSS = Line.substr( 6 );
+			RSS.erase( 0, RSS.find_first_not_of( " \t" ) );
+		}
+	}
+
+	int64_t Now = GetMicroseconds( );
+	string Result = "bot: rss " + RSS;
+
+	if( gLastBotSample != 0 && Now > gLastBotSample )
+	{
+		double Seconds = (double)( CPU - gLastBotCPU ) / sysconf( _SC_CLK_TCK );
+		Result += ", cpu " + UTIL_ToString( Seconds * 100 * 1000000 / ( Now - gLastBotSample ), 1 ) + "%";
+	}
+
+	gLastBotSample = Now;
+	gLastBotCPU = CPU;
+	return Result;
+}
+
+//
+// CFakeClient
+//
+
+class CFakeClient
+{
+public:
+	uint32_t m_Index;
+	string m_Name;
+	uint32_t m_State;
+	int m_Socket;
+	bool m_Connecting;						// waiting for the non blocking connect to finish
+	BYTEARRAY m_RecvBuffer;
+	BYTEARRAY m_SendBuffer;
+	unsigned char m_PID;
+	bool m_GProxy;
+	uint16_t m_ReconnectPort;
+	uint32_t m_ReconnectKey;
+	uint32_t m_MapSize;
+	uint32_t m_MapReceived;
+	uint32_t m_PacketsReceived;				// W3GS packets received since joining (GProxy++ counts these)
+	uint32_t m_PacketsSent;					// W3GS packets sent since joining
+	deque<BYTEARRAY> m_SentPackets;			// the last W3GS packets we sent, kept for resending after a GProxy++ reconnect
+	uint32_t m_Ticks;
+	int64_t m_LastTick;
+	int64_t m_NextAction;
+	int64_t m_LoadedTime;
+	int64_t m_DropTime;						// when to drop the connection on purpose (GProxy++ only, 0 if never)
+	int64_t m_RetryTime;					// when to retry joining or reconnecting
+
+	CFakeClient( uint32_t nIndex, bool nGProxy );
+	~CFakeClient( );
+
+	void Connect( uint16_t port );
+	void Close( );
+	void Send( BYTEARRAY packet, bool w3gs = true );
+	void DoSend( );
+	void DoRecv( );
+	void ProcessPacket( BYTEARRAY &packet );
+	void ProcessIncomingAction( BYTEARRAY &packet, int64_t now );
+	void Update( int64_t now );
+	void Disconnected( );
+};
+
+CFakeClient :: CFakeClient( uint32_t nIndex, bool nGProxy )
+{
+	m_Index = nIndex;
+	m_Name = "loadgen" + UTIL_ToString( nIndex );
+	m_State = LOADGEN_WAITING;
+	m_Socket = -1;
+	m_Connecting = false;
+	m_PID = 255;
+	m_GProxy = nGProxy;
+	m_ReconnectPort = 0;
+	m_ReconnectKey = 0;
+	m_MapSize = 0;
+	m_MapReceived = 0;
+	m_PacketsReceived = 0;
+	m_PacketsSent = 0;
+	m_Ticks = 0;
+	m_LastTick = 0;
+	m_NextAction = 0;
+	m_LoadedTime = 0;
+	m_DropTime = 0;
+	m_RetryTime = 0;
+}
+
+CFakeClient :: ~CFakeClient( )
+{
+	Close( );
+}
+
+void CFakeClient :: Connect( uint16_t port )
+{
+	Close( );
+	m_Socket = socket( AF_INET, SOCK_STREAM, 0 );
+
+	if( m_Socket < 0 )
+	{
+		CONSOLE_Print( "[LOADGEN] error creating socket (" + UTIL_ToString( errno ) + "), raise the open file limit for more clients" );
+		return;
+	}
+
+	int One = 1;
+	setsockopt( m_Socket, IPPROTO_TCP, TCP_NODELAY, &One, sizeof( One ) );
+	fcntl( m_Socket, F_SETFL, fcntl( m_Socket, F_GETFL ) | O_NONBLOCK );
+
+	struct sockaddr_in Address;
+	memset( &Address, 0, sizeof( Address ) );
+	Address.sin_family = AF_INET;
+	Address.sin_port = htons( port );
+	Address.sin_addr.s_addr = inet_addr( gHost.c_str( ) );
+
+	if( connect( m_Socket, (struct sockaddr *)&Address, sizeof( Address ) ) < 0 && errno != EINPROGRESS )
+	{
+		Close( );
+		return;
+	}
+
+	m_Connecting = true;
+}
+
+void CFakeClient :: Close( )
+{
+	if( m_Socket >= 0 )
+		close( m_Socket );
+
+	m_Socket = -1;
+	m_Connecting = false;
+	m_RecvBuffer.clear( );
+	m_SendBuffer.clear( );
+}
+
+void CFakeClient :: Send( BYTEARRAY packet, bool w3gs )
+{
+	if( w3gs )
+	{
+		m_PacketsSent++;
+
+		if( m_GProxy && m_State >= LOADGEN_PLAYING )
+		{
+			m_SentPackets.push_back( packet );
+
+			if( m_SentPackets.size( ) > 1000 )
+				m_SentPackets.pop_front( );
+		}
+	}
+
+	if( m_State != LOADGEN_RECONNECTING )
+		UTIL_AppendByteArrayFast( m_SendBuffer, packet );
+}
+
+void CFakeClient :: DoSend( )
+{
+	if( m_Socket < 0 || m_Connecting || m_SendBuffer.empty( ) )
+		return;
+
+	ssize_t Sent = send( m_Socket, &m_SendBuffer[0], m_SendBuffer.size( ), MSG_NOSIGNAL );
+
+	if( Sent > 0 )
+	{
+		gStats.BytesSent += Sent;
+		m_SendBuffer.erase( m_SendBuffer.begin( ), m_SendBuffer.begin( ) + Sent );
+	}
+	else if( Sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK )
+		Disconnected( );
+}
+
+void CFakeClient :: DoRecv( )
+{
+	unsigned char Buffer[16384];
+	ssize_t Received = -1;
+
+	while( m_Socket >= 0 && ( Received = recv( m_Socket, Buffer, sizeof( Buffer ), 0 ) ) > 0 )
+	{
+		gStats.BytesReceived += Received;
+		m_RecvBuffer.insert( m_RecvBuffer.end( ), Buffer, Buffer + Received );
+	}
+
+	if( m_Socket >= 0 && ( Received == 0 || ( errno != EAGAIN && errno != EWOULDBLOCK ) ) )
+	{
+		Disconnected( );
+		return;
+	}
+
+	// split the buffer into packets, the header is the header constant, the packet id and the length (including the header)
+
+	uint32_t Offset = 0;
+
+	while( m_Socket >= 0 && m_RecvBuffer.size( ) - Offset >= 4 )
+	{
+		uint16_t Length = UTIL_ByteArrayToUInt16( &m_RecvBuffer[Offset + 2], false );
+
+		if( Length < 4 || ( m_RecvBuffer[Offset] != W3GS_HEADER_CONSTANT && m_RecvBuffer[Offset] != GPS_HEADER_CONSTANT ) )
+		{
+			CONSOLE_Print( "[LOADGEN] client [" + m_Name + "] received an invalid packet, disconnecting" );
+			Disconnected( );
+			return;
+		}
+
+		if( m_RecvBuffer.size( ) - Offset < Length )
+			break;
+
+		BYTEARRAY Packet( m_RecvBuffer.begin( ) + Offset, m_RecvBuffer.begin( ) + Offset + Length );
+		Offset += Length;
+		ProcessPacket( Packet );
+	}
+
+	if( m_Socket >= 0 )
+		m_RecvBuffer.erase( m_RecvBuffer.begin( ), m_RecvBuffer.begin( ) + Offset );
+}
+
+void CFakeClient :: ProcessPacket( BYTEARRAY &packet )
+{
+	int64_t Now = GetMicroseconds( );
+
+	if( packet[0] == GPS_HEADER_CONSTANT )
+	{
+		if( packet[1] == CGPSProtocol :: GPS_INIT && packet.size( ) >= 11 )
+		{
+			m_ReconnectPort = UTIL_ByteArrayToUInt16( packet, false, 4 );
+			m_ReconnectKey = UTIL_ByteArrayToUInt32( packet, false, 7 );
+		}
+		else if( packet[1] == CGPSProtocol :: GPS_RECONNECT && packet.size( ) >= 8 )
+		{
+			// the bot tells us how many of our packets it received, resend the rest
+
+			uint32_t LastPacket = UTIL_ByteArrayToUInt32( packet, false, 4 );
+			uint32_t FirstBuffered = m_PacketsSent - m_SentPackets.size( );
+			m_State = LOADGEN_PLAYING;
+			gStats.Reconnects++;
+
+			for( uint32_t i = 0; i < m_SentPackets.size( ); i++ )
+			{
+				if( FirstBuffered + i >= LastPacket )
+					UTIL_AppendByteArrayFast( m_SendBuffer, m_SentPackets[i] );
+			}
+		}
+		else if( packet[1] == CGPSProtocol :: GPS_REJECT )
+		{
+			gStats.ReconnectsFailed++;
+			Close( );
+			m_State = LOADGEN_DONE;
+		}
+
+		return;
+	}
+
+	m_PacketsReceived++;
+
+	switch( packet[1] )
+	{
+	case CGameProtocol :: W3GS_PING_FROM_HOST:
+		if( packet.size( ) >= 8 )
+		{
+			BYTEARRAY Pong;
+			Pong.push_back( W3GS_HEADER_CONSTANT );
+			Pong.push_back( CGameProtocol :: W3GS_PONG_TO_HOST );
+			UTIL_AppendByteArray( Pong, (uint16_t)8, false );
+			Pong.insert( Pong.end( ), packet.begin( ) + 4, packet.begin( ) + 8 );
+			Send( Pong );
+		}
+
+		break;
+
+	case CGameProtocol :: W3GS_SLOTINFOJOIN:
+		if( packet.size( ) >= 7 )
+		{
+			uint16_t SlotInfoSize = UTIL_ByteArrayToUInt16( packet, false, 4 );
+
+			if( packet.size( ) > 6 + (uint32_t)SlotInfoSize )
+				m_PID = packet[6 + SlotInfoSize];
+		}
+
+		gStats.Joins++;
+
+		if( m_GProxy )
+			Send( gGPSProtocol.SEND_GPSC_INIT( 1 ), false );
+
+		break;
+
+	case CGameProtocol :: W3GS_REJECTJOIN:
+		gStats.Rejects++;
+		Close( );
+		m_State = LOADGEN_WAITING;
+		m_RetryTime = Now + 1000000;
+		break;
+
+	case CGameProtocol :: W3GS_MAPCHECK:
+		if( packet.size( ) > 9 )
+		{
+			BYTEARRAY Path = UTIL_ExtractCString( packet, 8 );
+
+			if( packet.size( ) >= 8 + Path.size( ) + 5 )
+				m_MapSize = UTIL_ByteArrayToUInt32( packet, false, 8 + Path.size( ) + 1 );
+
+			// size flag 1 with the right size means we have the map, anything else asks the bot to send it
+
+			BYTEARRAY MapSize;
+			MapSize.push_back( W3GS_HEADER_CONSTANT );
+			MapSize.push_back( CGameProtocol :: W3GS_MAPSIZE );
+			UTIL_AppendByteArray( MapSize, (uint16_t)13, false );
+			UTIL_AppendByteArray( MapSize, (uint32_t)1, false );
+			MapSize.push_back( 1 );
+			UTIL_AppendByteArray( MapSize, gDownload ? (uint32_t)0 : m_MapSize, false );
+			Send( MapSize );
+		}
+
+		break;
+
+	case CGameProtocol :: W3GS_MAPPART:
+		if( packet.size( ) > 18 )
+		{
+			uint32_t Start = UTIL_ByteArrayToUInt32( packet, false, 10 );
+
+			if( Start == m_MapReceived )
+				m_MapReceived += packet.size( ) - 18;
+
+			// acknowledge the part with size flag 3, the final acknowledgement uses size flag 1 like a client that already had the map
+
+			BYTEARRAY MapSize;
+			MapSize.push_back( W3GS_HEADER_CONSTANT );
+			MapSize.push_back( CGameProtocol :: W3GS_MAPSIZE );
+			UTIL_AppendByteArray( MapSize, (uint16_t)13, false );
+			UTIL_AppendByteArray( MapSize, (uint32_t)1, false );
+			MapSize.push_back( m_MapReceived >= m_MapSize ? 1 : 3 );
+			UTIL_AppendByteArray( MapSize, m_MapReceived, false );
+			Send( MapSize );
+		}
+
+		break;
+
+	case CGameProtocol :: W3GS_COUNTDOWN_END:
+	{
+		BYTEARRAY Loaded;
+		Loaded.push_back( W3GS_HEADER_CONSTANT );
+		Loaded.push_back( CGameProtocol :: W3GS_GAMELOADED_SELF );
+		UTIL_AppendByteArray( Loaded, (uint16_t)4, false );
+		Send( Loaded );
+		m_State = LOADGEN_LOADING;
+		break;
+	}
+
+	case CGameProtocol :: W3GS_INCOMING_ACTION:
+		ProcessIncomingAction( packet, Now );
+
+		if( m_State == LOADGEN_LOADING )
+		{
+			m_State = LOADGEN_PLAYING;
+			m_LoadedTime = Now;
+			m_NextAction = Now + rand( ) % ( 60000000 / gAPM );
+
+			if( m_GProxy )
+				m_DropTime = Now + 5000000 + (int64_t)( rand( ) % 1000 ) * gDuration * 500;
+		}
+
+		// every tick must be acknowledged, the checksum has to match across all the players in the game or the bot reports a desync
+
+		m_Ticks++;
+
+		if( m_LastTick != 0 )
+			gStats.TickIntervals.push_back( ( Now - m_LastTick ) / 1000.0 );
+
+		m_LastTick = Now;
+
+		{
+			BYTEARRAY KeepAlive;
+			KeepAlive.push_back( W3GS_HEADER_CONSTANT );
+			KeepAlive.push_back( CGameProtocol :: W3GS_OUTGOING_KEEPALIVE );
+			UTIL_AppendByteArray( KeepAlive, (uint16_t)9, false );
+			KeepAlive.push_back( 0 );
+			UTIL_AppendByteArray( KeepAlive, m_Ticks, false );
+			Send( KeepAlive );
+		}
+
+		if( m_GProxy && m_Ticks % 50 == 0 )
+			Send( gGPSProtocol.SEND_GPSC_ACK( m_PacketsReceived ), false );
+
+		break;
+
+	case CGameProtocol :: W3GS_INCOMING_ACTION2:
+		ProcessIncomingAction( packet, Now );
+		break;
+	}
+}
+
+void CFakeClient :: ProcessIncomingAction( BYTEARRAY &packet, int64_t now )
+{
+	// 2 bytes send interval, 2 bytes crc, then for every action: 1 byte PID, 2 bytes length, the action itself
+
+	uint32_t i = 8;
+
+	while( i + 3 <= packet.size( ) )
+	{
+		unsigned char PID = packet[i];
+		uint16_t Length = UTIL_ByteArrayToUInt16( packet, false, i + 1 );
+		i += 3;
+
+		if( i + Length > packet.size( ) )
+			break;
+
+		if( PID == m_PID && Length == 13 && packet[i] == LOADGEN_ACTION_ID )
+		{
+			int64_t SentTime;
+			memcpy( &SentTime, &packet[i + 1], sizeof( SentTime ) );
+			gStats.Latencies.push_back( ( now - SentTime ) / 1000.0 );
+			gStats.ActionsReceived++;
+		}
+
+		i += Length;
+	}
+}
+
+void CFakeClient :: Update( int64_t now )
+{
+	if( m_State == LOADGEN_WAITING && now >= m_RetryTime )
+	{
+		Connect( gPort );
+
+		if( m_Socket < 0 )
+		{
+			m_RetryTime = now + 1000000;
+			return;
+		}
+
+		m_PID = 255;
+		m_MapReceived = 0;
+		m_PacketsReceived = 0;
+		m_PacketsSent = 0;
+		m_State = LOADGEN_LOBBY;
+
+		// the bot treats host counter id 0 as a LAN join so there's no spoof check
+
+		BYTEARRAY Join;
+		Join.push_back( W3GS_HEADER_CONSTANT );
+		Join.push_back( CGameProtocol :: W3GS_REQJOIN );
+		UTIL_AppendByteArray( Join, (uint16_t)0, false );
+		UTIL_AppendByteArray( Join, (uint32_t)0, false );			// host counter
+		UTIL_AppendByteArray( Join, (uint32_t)0, false );			// entry key
+		Join.push_back( 0 );
+		UTIL_AppendByteArray( Join, (uint16_t)6112, false );		// listen port
+		UTIL_AppendByteArray( Join, (uint32_t)0, false );			// peer key
+		UTIL_AppendByteArray( Join, m_Name );
+		UTIL_AppendByteArray( Join, (uint32_t)0, false );
+		UTIL_AppendByteArray( Join, (uint16_t)6112, false );		// internal port
+		UTIL_AppendByteArray( Join, (uint32_t)0x0100007F, false );	// internal ip
+		Join[2] = Join.size( ) & 0xFF;
+		Join[3] = Join.size( ) >> 8;
+		m_SendBuffer = Join;
+		return;
+	}
+
+	if( m_State == LOADGEN_RECONNECTING && m_Socket < 0 && now >= m_RetryTime )
+	{
+		Connect( m_ReconnectPort );
+
+		if( m_Socket < 0 )
+		{
+			gStats.ReconnectsFailed++;
+			m_State = LOADGEN_DONE;
+			return;
+		}
+
+		m_SendBuffer = gGPSProtocol.SEND_GPSC_RECONNECT( m_PID, m_ReconnectKey, m_PacketsReceived );
+		return;
+	}
+
+	if( m_State != LOADGEN_PLAYING )
+		return;
+
+	if( now - m_LoadedTime >= (int64_t)gDuration * 1000000 )
+	{
+		BYTEARRAY Leave;
+		Leave.push_back( W3GS_HEADER_CONSTANT );
+		Leave.push_back( CGameProtocol :: W3GS_LEAVEGAME );
+		UTIL_AppendByteArray( Leave, (uint16_t)8, false );
+		UTIL_AppendByteArray( Leave, (uint32_t)PLAYERLEAVE_LOST, false );
+		Send( Leave );
+		DoSend( );
+		Close( );
+		m_State = LOADGEN_DONE;
+		return;
+	}
+
+	if( m_DropTime != 0 && now >= m_DropTime && m_ReconnectPort != 0 )
+	{
+		// pretend our connection died, GProxy++ reconnects after a short while
+
+		Close( );
+		m_DropTime = 0;
+		m_State = LOADGEN_RECONNECTING;
+		m_RetryTime = now + 1000000 + rand( ) % 2000000;
+		return;
+	}
+
+	while( now >= m_NextAction )
+	{
+		// the action is our own id followed by the time we sent it so we can recognize it when the bot relays it
+
+		BYTEARRAY Action;
+		Action.push_back( W3GS_HEADER_CONSTANT );
+		Action.push_back( CGameProtocol :: W3GS_OUTGOING_ACTION );
+		UTIL_AppendByteArray( Action, (uint16_t)21, false );
+		UTIL_AppendByteArray( Action, (uint32_t)0, false );
+		Action.push_back( LOADGEN_ACTION_ID );
+		Action.insert( Action.end( ), (unsigned char *)&now, (unsigned char *)&now + sizeof( now ) );
+		UTIL_AppendByteArray( Action, m_Index, false );
+		Send( Action );
+		gStats.ActionsSent++;
+
+		int64_t Interval = 60000000 / gAPM;
+		m_NextAction += Interval / 2 + rand( ) % ( Interval + 1 );
+	}
+}
+
+void CFakeClient :: Disconnected( )
+{
+	Close( );
+
+	if( m_State == LOADGEN_LOBBY )
+	{
+		m_State = LOADGEN_WAITING;
+		m_RetryTime = GetMicroseconds( ) + 1000000;
+	}
+	else if( m_State == LOADGEN_RECONNECTING )
+	{
+		gStats.ReconnectsFailed++;
+		m_State = LOADGEN_DONE;
+	}
+	else if( m_State != LOADGEN_DONE )
+	{
+		gStats.Kicks++;
+		m_State = LOADGEN_DONE;
+	}
+}
+
+//
+// main
+//
+
+int main( int argc, char **argv )
+{
+	for( int i = 1; i < argc; i++ )
+	{
+		string Arg = argv[i];
+		string Value = i + 1 < argc ? argv[i + 1] : string( );
+
+		if( Arg == "-download" )
+			gDownload = true;
+		else if( Value.empty( ) )
+		{
+			CONSOLE_Print( "usage: loadgen [-host ip] [-port port] [-players n] [-games n] [-time seconds] [-duration seconds] [-apm n] [-download] [-gproxy percent] [-pid botpid] [-report seconds]" );
+			return 1;
+		}
+		else
+		{
+			if( Arg == "-host" )
+				gHost = Value;
+			else if( Arg == "-port" )
+				gPort = UTIL_ToUInt16( Value );
+			else if( Arg == "-players" )
+				gPlayers = UTIL_ToUInt32( Value );
+			else if( Arg == "-games" )
+				gGames = UTIL_ToUInt32( Value );
+			else if( Arg == "-time" )
+				gTime = UTIL_ToUInt32( Value );
+			else if( Arg == "-duration" )
+				gDuration = UTIL_ToUInt32( Value );
+			else if( Arg == "-apm" )
+				gAPM = UTIL_ToUInt32( Value );
+			else if( Arg == "-gproxy" )
+				gGProxy = UTIL_ToUInt32( Value );
+			else if( Arg == "-pid" )
+				gBotPID = UTIL_ToUInt32( Value );
+			else if( Arg == "-report" )
+				gReport = UTIL_ToUInt32( Value );
+
+			i++;
+		}
+	}
+
+	if( gPlayers == 0 || gPlayers > 12 || gGames == 0 || gAPM == 0 || gReport == 0 )
+	{
+		CONSOLE_Print( "[LOADGEN] invalid options" );
+		return 1;
+	}
+
+	CONSOLE_Print( "[LOADGEN] filling " + UTIL_ToString( gGames ) + " concurrent games of " + UTIL_ToString( gPlayers ) + " players on " + gHost + ":" + UTIL_ToString( gPort ) + " for " + UTIL_ToString( gTime ) + " seconds" );
+	CONSOLE_Print( "[LOADGEN] each game lasts " + UTIL_ToString( gDuration ) + " seconds at " + UTIL_ToString( gAPM ) + " APM, " + UTIL_ToString( gGProxy ) + "% of the players use GProxy++" + ( gDownload ? ", every player downloads the map" : "" ) );
+
+	srand( time( NULL ) );
+	ResetStats( gStats );
+	ResetStats( gTotalStats );
+	SampleBot( );
+
+	// a wave is the clients of one game, only one wave can be in the lobby at a time because the bot only hosts one lobby
+
+	vector< vector<CFakeClient *> > Waves;
+	uint32_t NextIndex = 0;
+	uint32_t GamesStarted = 0;
+	int64_t Start = GetMicroseconds( );
+	int64_t LastReport = Start;
+	vector<struct pollfd> PollFDs;
+	vector<CFakeClient *> PollClients;
+
+	while( GetMicroseconds( ) - Start < (int64_t)gTime * 1000000 )
+	{
+		// start a new wave when the previous one has left the lobby
+
+		bool InLobby = false;
+
+		for( vector< vector<CFakeClient *> > :: iterator i = Waves.begin( ); i != Waves.end( ); i++ )
+		{
+			for( vector<CFakeClient *> :: iterator j = i->begin( ); j != i->end( ); j++ )
+			{
+				if( (*j)->m_State <= LOADGEN_LOBBY )
+					InLobby = true;
+			}
+		}
+
+		if( !InLobby && Waves.size( ) < gGames )
+		{
+			vector<CFakeClient *> Wave;
+
+			for( uint32_t i = 0; i < gPlayers; i++ )
+				Wave.push_back( new CFakeClient( NextIndex++, (uint32_t)( rand( ) % 100 ) < gGProxy ) );
+
+			Waves.push_back( Wave );
+			GamesStarted++;
+		}
+
+		PollFDs.clear( );
+		PollClients.clear( );
+
+		for( vector< vector<CFakeClient *> > :: iterator i = Waves.begin( ); i != Waves.end( ); i++ )
+		{
+			for( vector<CFakeClient *> :: iterator j = i->begin( ); j != i->end( ); j++ )
+			{
+				if( (*j)->m_Socket >= 0 )
+				{
+					struct pollfd FD;
+					FD.fd = (*j)->m_Socket;
+					FD.events = POLLIN | ( (*j)->m_Connecting || !(*j)->m_SendBuffer.empty( ) ? POLLOUT : 0 );
+					FD.revents = 0;
+					PollFDs.push_back( FD );
+					PollClients.push_back( *j );
+				}
+			}
+		}
+
+		if( !PollFDs.empty( ) )
+			poll( &PollFDs[0], PollFDs.size( ), 5 );
+		else
+			usleep( 5000 );
+
+		for( uint32_t i = 0; i < PollFDs.size( ); i++ )
+		{
+			CFakeClient *Client = PollClients[i];
+
+			if( Client->m_Connecting && ( PollFDs[i].revents & ( POLLOUT | POLLERR | POLLHUP ) ) )
+			{
+				int Error = 0;
+				socklen_t ErrorLength = sizeof( Error );
+				getsockopt( Client->m_Socket, SOL_SOCKET, SO_ERROR, &Error, &ErrorLength );
+
+				if( Error != 0 )
+				{
+					Client->Disconnected( );
+					continue;
+				}
+
+				Client->m_Connecting = false;
+			}
+
+			if( PollFDs[i].revents & ( POLLIN | POLLERR | POLLHUP ) )
+				Client->DoRecv( );
+		}
+
+		int64_t Now = GetMicroseconds( );
+
+		for( vector< vector<CFakeClient *> > :: iterator i = Waves.begin( ); i != Waves.end( ); )
+		{
+			bool Done = true;
+
+			for( vector<CFakeClient *> :: iterator j = i->begin( ); j != i->end( ); j++ )
+			{
+				(*j)->Update( Now );
+				(*j)->DoSend( );
+
+				if( (*j)->m_State != LOADGEN_DONE )
+					Done = false;
+			}
+
+			if( Done )
+			{
+				for( vector<CFakeClient *> :: iterator j = i->begin( ); j != i->end( ); j++ )
+					delete *j;
+
+				i = Waves.erase( i );
+			}
+			else
+				i++;
+		}
+
+		if( Now - LastReport >= (int64_t)gReport * 1000000 )
+		{
+			uint32_t Clients = 0;
+			uint32_t Playing = 0;
+
+			for( vector< vector<CFakeClient *> > :: iterator i = Waves.begin( ); i != Waves.end( ); i++ )
+			{
+				for( vector<CFakeClient *> :: iterator j = i->begin( ); j != i->end( ); j++ )
+				{
+					if( (*j)->m_Socket >= 0 )
+						Clients++;
+
+					if( (*j)->m_State == LOADGEN_PLAYING )
+						Playing++;
+				}
+			}
+
+			double Seconds = ( Now - LastReport ) / 1000000.0;
+			CONSOLE_Print( "[LOADGEN] " + UTIL_ToString( ( Now - Start ) / 1000000 ) + "s: " + UTIL_ToString( Waves.size( ) ) + " games, " + UTIL_ToString( Clients ) + " connected, " + UTIL_ToString( Playing ) + " playing, " + UTIL_ToString( gStats.Joins ) + " joins, " + UTIL_ToString( gStats.Rejects ) + " rejects, " + UTIL_ToString( gStats.Kicks ) + " kicks, " + UTIL_ToString( gStats.Reconnects ) + "/" + UTIL_ToString( gStats.Reconnects + gStats.ReconnectsFailed ) + " reconnects" );
+			CONSOLE_Print( "[LOADGEN]   actions " + UTIL_ToString( gStats.ActionsSent / Seconds, 0 ) + "/s sent, " + UTIL_ToString( gStats.ActionsReceived / Seconds, 0 ) + "/s delivered, " + UTIL_ToString( gStats.BytesSent / Seconds / 1024, 1 ) + " KB/s up, " + UTIL_ToString( gStats.BytesReceived / Seconds / 1024, 1 ) + " KB/s down" );
+			CONSOLE_Print( "[LOADGEN]   action latency " + Percentiles( gStats.Latencies ) );
+			CONSOLE_Print( "[LOADGEN]   tick interval " + Percentiles( gStats.TickIntervals ) );
+
+			string Bot = SampleBot( );
+
+			if( !Bot.empty( ) )
+				CONSOLE_Print( "[LOADGEN]   " + Bot );
+
+			// keep everything for the summary
+
+			gTotalStats.Latencies.insert( gTotalStats.Latencies.end( ), gStats.Latencies.begin( ), gStats.Latencies.end( ) );
+			gTotalStats.TickIntervals.insert( gTotalStats.TickIntervals.end( ), gStats.TickIntervals.begin( ), gStats.TickIntervals.end( ) );
+			gTotalStats.ActionsSent += gStats.ActionsSent;
+			gTotalStats.ActionsReceived += gStats.ActionsReceived;
+			gTotalStats.Joins += gStats.Joins;
+			gTotalStats.Kicks += gStats.Kicks;
+			gTotalStats.Reconnects += gStats.Reconnects;
+			gTotalStats.ReconnectsFailed += gStats.ReconnectsFailed;
+			ResetStats( gStats );
+			LastReport = Now;
+		}
+	}
+
+	for( vector< vector<CFakeClient *> > :: iterator i = Waves.begin( ); i != Waves.end( ); i++ )
+	{
+		for( vector<CFakeClient *> :: iterator j = i->begin( ); j != i->end( ); j++ )
+			delete *j;
+	}
+
+	CONSOLE_Print( "[LOADGEN] summary: " + UTIL_ToString( GamesStarted ) + " games started, " + UTIL_ToString( gTotalStats.Joins ) + " joins, " + UTIL_ToString( gTotalStats.Kicks ) + " kicks, " + UTIL_ToString( gTotalStats.Reconnects ) + "/" + UTIL_ToString( gTotalStats.Reconnects + gTotalStats.ReconnectsFailed ) + " reconnects, " + UTIL_ToString( gTotalStats.ActionsReceived ) + "/" + UTIL_ToString( gTotalStats.ActionsSent ) + " actions delivered" );
+	CONSOLE_Print( "[LOADGEN] summary: action latency " + Percentiles( gTotalStats.Latencies ) );
+	CONSOLE_Print( "[LOADGEN] summary: tick interval " + Percentiles( gTotalStats.TickIntervals ) );
+	return 0;
+}
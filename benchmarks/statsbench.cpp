@@ -0,0 +1,271 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+// statsbench: measures how fast the stats classes find the stored integers in the players' actions
+// "bytewise" is the old loop from CStatsDOTA :: ProcessAction which compares every position and copies each record's strings into temporary byte arrays
+// "scanner" is CActionScanner as used by CStatsDOTA and CStatsW3MMD now
+// the actions are either read from replays (each player's actions of each timeslot are one payload, just like a CIncomingAction) or generated
+// usage: statsbench [iterations] [replay.w3g ...]
+
+#include "ghost.h"
+#include "util.h"
+#include "packed.h"
+#include "replay.h"
+#include "actionscanner.h"
+
+#include <cstdlib>
+#include <chrono>
+
+void CONSOLE_Print( string message )
+{
+	cout << message << endl;
+}
+
+double ElapsedSeconds( chrono :: steady_clock :: time_point start )
+{
+	return chrono :: duration<double>( chrono :: steady_clock :: now( ) - start ).count( );
+}
+
+struct Record
+{
+	string MissionKey;
+	string Key;
+	uint32_t Value;
+
+	bool operator==( const Record &other ) const	{ return MissionKey == other.MissionKey && Key == other.Key && Value == other.Value; }
+};
+
+void ScanBytewise( BYTEARRAY *ActionData, vector<Record> &records )
+{
+	// copied from CStatsDOTA :: ProcessAction before CActionScanner
+
+	unsigned int i = 0;
+	BYTEARRAY Data;
+	BYTEARRAY Key;
+	BYTEARRAY Value;
+
+	while( ActionData->size( ) >= i + 6 )
+	{
+		if( (*ActionData)[i] == 0x6b && (*ActionData)[i + 1] == 0x64 && (*ActionData)[i + 2] == 0x72 && (*ActionData)[i + 3] == 0x2e && (*ActionData)[i + 4] == 0x78 && (*ActionData)[i + 5] == 0x00 )
+		{
+			if( ActionData->size( ) >= i + 7 )
+			{
+				Data = UTIL_ExtractCString( *ActionData, i + 6 );
+
+				if( ActionData->size( ) >= i + 8 + Data.size( ) )
+				{
+					Key = UTIL_ExtractCString( *ActionData, i + 7 + Data.size( ) );
+
+					if( ActionData->size( ) >= i + 12 + Data.size( ) + Key.size( ) )
+					{
+						Value = BYTEARRAY( ActionData->begin( ) + i + 8 + Data.size( ) + Key.size( ), ActionData->begin( ) + i + 12 + Data.size( ) + Key.size( ) );
+						Record R;
+						R.MissionKey = string( Data.begin( ), Data.end( ) );
+						R.Key = string( Key.begin( ), Key.end( ) );
+						R.Value = UTIL_ByteArrayToUInt32( Value, false );
+						records.push_back( R );
+						i += 12 + Data.size( ) + Key.size( );
+					}
+					else
+						i++;
+				}
+				else
+					i++;
+			}
+			else
+				i++;
+		}
+		else
+			i++;
+	}
+}
+
+void ScanScanner( CActionScanner &scanner, BYTEARRAY *ActionData, vector<Record> &records )
+{
+	vector<CSyncStoredInteger> &Records = scanner.Scan( ActionData->empty( ) ? NULL : &(*ActionData)[0], ActionData->size( ) );
+
+	for( vector<CSyncStoredInteger> :: iterator i = Records.begin( ); i != Records.end( ); i++ )
+	{
+		Record R;
+		R.MissionKey = i->MissionKey.ToString( );
+		R.Key = i->Key.ToString( );
+		R.Value = i->Value;
+		records.push_back( R );
+	}
+}
+
+void AppendStoredInteger( BYTEARRAY &payload, string missionKey, string key, uint32_t value )
+{
+	UTIL_AppendByteArray( payload, string( "kdr.x" ) );
+	UTIL_AppendByteArray( payload, missionKey );
+	UTIL_AppendByteArray( payload, key );
+	UTIL_AppendByteArray( payload, value, false );
+}
+
+void GeneratePayloads( vector<BYTEARRAY> &payloads, uint32_t count )
+{
+	// something like a DotA game: mostly orders with object ids and coordinates (plenty of zeros and the odd 0x6b) and now and then a stored integer
+	// a few payloads end in the middle of a stored integer to exercise the incomplete record paths
+
+	for( uint32_t i = 0; i < count; i++ )
+	{
+		BYTEARRAY Payload;
+		uint32_t Orders = 1 + rand( ) % 3;
+
+		for( uint32_t j = 0; j < Orders; j++ )
+		{
+			uint32_t Length = 12 + rand( ) % 40;
+
+			for( uint32_t k = 0; k < Length; k++ )
+				Payload.push_back( rand( ) % 3 == 0 ? 0 : rand( ) % 256 );
+		}
+
+		uint32_t Kind = rand( ) % 100;
+
+		if( Kind < 3 )
+			AppendStoredInteger( Payload, "Data", "Hero" + UTIL_ToString( 1 + rand( ) % 11 ), rand( ) % 12 );
+		else if( Kind < 5 )
+			AppendStoredInteger( Payload, UTIL_ToString( 1 + rand( ) % 10 ), UTIL_ToString( 1 + rand( ) % 7 ), rand( ) % 100 );
+		else if( Kind < 6 )
+		{
+			AppendStoredInteger( Payload, "Data", "Tower" + UTIL_ToString( rand( ) % 2 ) + UTIL_ToString( rand( ) % 4 ) + UTIL_ToString( rand( ) % 3 ), rand( ) % 12 );
+			Payload.resize( Payload.size( ) - rand( ) % 8 );
+		}
+
+		payloads.push_back( Payload );
+	}
+}
+
+void LoadPayloads( vector<BYTEARRAY> &payloads, string fileName )
+{
+	CReplay Replay;
+	Replay.Load( fileName, true );
+
+	if( !Replay.GetValid( ) )
+		return;
+
+	Replay.ParseReplay( true );
+
+	if( !Replay.GetValid( ) )
+		return;
+
+	queue<BYTEARRAY> *Blocks = Replay.GetBlocks( );
+
+	while( !Blocks->empty( ) )
+	{
+		// REPLAY_TIMESLOT, 2 bytes block size, 2 bytes time increment, then the PID, 2 bytes length and actions of each player
+
+		BYTEARRAY &Block = Blocks->front( );
+
+		if( !Block.empty( ) && Block[0] == CReplay :: REPLAY_TIMESLOT )
+		{
+			uint32_t i = 5;
+
+			while( i + 3 <= Block.size( ) )
+			{
+				uint16_t Length = UTIL_ByteArrayToUInt16( &Block[i + 1], false );
+
+				if( i + 3 + Length > Block.size( ) )
+					break;
+
+				payloads.push_back( BYTEARRAY( Block.begin( ) + i + 3, Block.begin( ) + i + 3 + Length ) );
+				i += 3 + Length;
+			}
+		}
+
+		Blocks->pop( );
+	}
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t Iterations = argc > 1 ? atoi( argv[1] ) : 20;
+
+	if( Iterations == 0 )
+		Iterations = 20;
+
+	vector<BYTEARRAY> Payloads;
+	srand( 0 );
+
+	for( int i = 2; i < argc; i++ )
+		LoadPayloads( Payloads, argv[i] );
+
+	if( Payloads.empty( ) )
+	{
+		CONSOLE_Print( "[STATSBENCH] no replays given, generating 200000 DotA like payloads" );
+		GeneratePayloads( Payloads, 200000 );
+	}
+
+	uint64_t Bytes = 0;
+
+	for( vector<BYTEARRAY> :: iterator i = Payloads.begin( ); i != Payloads.end( ); i++ )
+		Bytes += i->size( );
+
+	CONSOLE_Print( "[STATSBENCH] " + UTIL_ToString( Payloads.size( ) ) + " payloads, " + UTIL_ToString( Bytes ) + " bytes, " + UTIL_ToString( Iterations ) + " iterations" );
+
+	// both scanners must find exactly the same records
+
+	CActionScanner Scanner( "kdr.x" );
+	uint32_t Found = 0;
+	uint32_t Mismatches = 0;
+
+	for( vector<BYTEARRAY> :: iterator i = Payloads.begin( ); i != Payloads.end( ); i++ )
+	{
+		vector<Record> Old;
+		vector<Record> New;
+		ScanBytewise( &*i, Old );
+		ScanScanner( Scanner, &*i, New );
+		Found += Old.size( );
+
+		if( !( Old == New ) )
+			Mismatches++;
+	}
+
+	CONSOLE_Print( "[STATSBENCH] " + UTIL_ToString( Found ) + " stored integers, " + UTIL_ToString( Mismatches ) + " payloads with different results" );
+
+	string Names[] = { "bytewise", "scanner" };
+
+	for( uint32_t Method = 0; Method < 2; Method++ )
+	{
+		vector<Record> Records;
+		uint32_t Total = 0;
+		chrono :: steady_clock :: time_point Start = chrono :: steady_clock :: now( );
+
+		for( uint32_t i = 0; i < Iterations; i++ )
+		{
+			for( vector<BYTEARRAY> :: iterator j = Payloads.begin( ); j != Payloads.end( ); j++ )
+			{
+				Records.clear( );
+
+				if( Method == 0 )
+					ScanBytewise( &*j, Records );
+				else
+					ScanScanner( Scanner, &*j, Records );
+
+				Total += Records.size( );
+			}
+		}
+
+		double Elapsed = ElapsedSeconds( Start );
+		CONSOLE_Print( "[" + Names[Method] + "] " + UTIL_ToString( Bytes * Iterations / Elapsed / 1048576.0, 1 ) + " MB/s, " + UTIL_ToString( Elapsed * 1000000000.0 / ( (double)Payloads.size( ) * Iterations ), 1 ) + " ns per payload (" + UTIL_ToString( Total ) + " records)" );
+	}
+
+	return 0;
+}
@@ -0,0 +1,296 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+// tickbench: measures the action packet jitter of the main loop's game scheduling
+// a number of simulated games send an action packet every [latency] ms, each game update burns [work] microseconds of CPU
+// "scan" is the old loop: the select timeout is the minimum over every game's GetNextTimedActionTicks clamped to 1ms, every game is updated on every loop and the timing is done with GetTicks
+// "wheel" is the current loop: the games' timers are kept in a CTimerWheel, the socket poller sleeps until exactly the next deadline and only the due games are updated
+// usage: tickbench [games] [latency in ms] [seconds] [work per game update in us]
+
+#include "ghost.h"
+#include "util.h"
+#include "socket.h"
+#include "timerwheel.h"
+
+#include <cstdlib>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+void CONSOLE_Print( string message )
+{
+	cout << message << endl;
+}
+
+uint64_t GetMicroTicks( )
+{
+	struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return (uint64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+uint32_t GetTicks( )
+{
+	return GetMicroTicks( ) / 1000;
+}
+
+uint32_t GetTime( )
+{
+	return GetTicks( ) / 1000;
+}
+
+double GetCPUSeconds( )
+{
+	struct rusage Usage;
+	getrusage( RUSAGE_SELF, &Usage );
+	return Usage.ru_utime.tv_sec + Usage.ru_stime.tv_sec + ( Usage.ru_utime.tv_usec + Usage.ru_stime.tv_usec ) / 1000000.0;
+}
+
+void Work( uint32_t usec )
+{
+	uint64_t End = GetMicroTicks( ) + usec;
+
+	while( GetMicroTicks( ) < End )
+		;
+}
+
+struct SimGame
+{
+	// the old millisecond timing
+
+	uint32_t LastSentTicks;
+	uint32_t LateByTicks;
+
+	// the new microsecond timing
+
+	uint64_t LastSentMicroTicks;
+	uint64_t LateByMicroTicks;
+	CTimer ActionTimer;
+	CTimer HousekeepingTimer;
+
+	uint64_t LastSend;
+};
+
+struct Result
+{
+	vector<double> Jitter;					// |interval - latency| in ms
+	vector<double> Lateness;				// how late each send was compared to the game's own deadline in ms
+	uint32_t Loops;
+	uint32_t Updates;
+	double CPU;
+	double Drift;							// ms the average interval was off by
+};
+
+double Percentile( vector<double> &values, double p )
+{
+	if( values.empty( ) )
+		return 0.0;
+
+	sort( values.begin( ), values.end( ) );
+	return values[(size_t)( p * ( values.size( ) - 1 ) )];
+}
+
+void Print( string name, Result &result, uint32_t seconds )
+{
+	double Sum = 0.0;
+
+	for( vector<double> :: iterator i = result.Jitter.begin( ); i != result.Jitter.end( ); i++ )
+		Sum += *i;
+
+	CONSOLE_Print( "[" + name + "] " + UTIL_ToString( result.Jitter.size( ) ) + " action packets, " + UTIL_ToString( result.Loops / seconds ) + " loops/s, " + UTIL_ToString( result.Updates / seconds ) + " game updates/s, " + UTIL_ToString( result.CPU / seconds * 100, 1 ) + "% CPU" );
+	CONSOLE_Print( "[" + name + "]   interval jitter ms: mean " + UTIL_ToString( result.Jitter.empty( ) ? 0.0 : Sum / result.Jitter.size( ), 3 ) + " p50 " + UTIL_ToString( Percentile( result.Jitter, 0.5 ), 3 ) + " p99 " + UTIL_ToString( Percentile( result.Jitter, 0.99 ), 3 ) + " max " + UTIL_ToString( Percentile( result.Jitter, 1.0 ), 3 ) );
+	CONSOLE_Print( "[" + name + "]   lateness ms:        p50 " + UTIL_ToString( Percentile( result.Lateness, 0.5 ), 3 ) + " p99 " + UTIL_ToString( Percentile( result.Lateness, 0.99 ), 3 ) + " max " + UTIL_ToString( Percentile( result.Lateness, 1.0 ), 3 ) + ", average interval off by " + UTIL_ToString( result.Drift, 4 ) + " ms" );
+}
+
+void RecordSend( SimGame &game, Result &result, uint32_t latency, uint64_t now, uint64_t deadline )
+{
+	if( game.LastSend != 0 )
+	{
+		double Interval = ( now - game.LastSend ) / 1000.0;
+		result.Jitter.push_back( Interval > latency ? Interval - latency : latency - Interval );
+		result.Drift += Interval - latency;
+	}
+
+	result.Lateness.push_back( now > deadline ? ( now - deadline ) / 1000.0 : 0.0 );
+	game.LastSend = now;
+}
+
+Result RunScan( vector<SimGame> &games, uint32_t latency, uint32_t seconds, uint32_t work )
+{
+	// the old loop, copied from CGHost :: Update and CBaseGame before the timer wheel
+	// the old epoll backend rounded the timeout down to whole milliseconds
+
+	Result R;
+	R.Loops = 0;
+	R.Updates = 0;
+	R.Drift = 0.0;
+	int EPoll = epoll_create( 1 );
+	double CPUStart = GetCPUSeconds( );
+	uint32_t Start = GetTicks( );
+
+	for( uint32_t i = 0; i < games.size( ); i++ )
+	{
+		games[i].LastSentTicks = Start - rand( ) % latency;
+		games[i].LateByTicks = 0;
+		games[i].LastSend = 0;
+	}
+
+	while( GetTicks( ) - Start < seconds * 1000 )
+	{
+		long usecBlock = 50000;
+
+		for( vector<SimGame> :: iterator i = games.begin( ); i != games.end( ); i++ )
+		{
+			uint32_t TicksSinceLastUpdate = GetTicks( ) - i->LastSentTicks;
+			uint32_t Next = TicksSinceLastUpdate > latency - i->LateByTicks ? 0 : latency - i->LateByTicks - TicksSinceLastUpdate;
+
+			if( Next * 1000 < usecBlock )
+				usecBlock = Next * 1000;
+		}
+
+		if( usecBlock < 1000 )
+			usecBlock = 1000;
+
+		struct epoll_event Events[1];
+		epoll_wait( EPoll, Events, 1, usecBlock / 1000 );
+		R.Loops++;
+
+		for( vector<SimGame> :: iterator i = games.begin( ); i != games.end( ); i++ )
+		{
+			Work( work );
+			R.Updates++;
+
+			if( GetTicks( ) - i->LastSentTicks >= latency - i->LateByTicks )
+			{
+				uint64_t Deadline = ( (uint64_t)i->LastSentTicks + latency - i->LateByTicks ) * 1000;
+				RecordSend( *i, R, latency, GetMicroTicks( ), Deadline );
+
+				uint32_t ActualSendInterval = GetTicks( ) - i->LastSentTicks;
+				uint32_t ExpectedSendInterval = latency - i->LateByTicks;
+				i->LateByTicks = ActualSendInterval - ExpectedSendInterval;
+
+				if( i->LateByTicks > latency )
+					i->LateByTicks = latency;
+
+				i->LastSentTicks = GetTicks( );
+			}
+		}
+	}
+
+	close( EPoll );
+	R.CPU = GetCPUSeconds( ) - CPUStart;
+	R.Drift = R.Jitter.empty( ) ? 0.0 : R.Drift / R.Jitter.size( );
+	return R;
+}
+
+Result RunWheel( vector<SimGame> &games, uint32_t latency, uint32_t seconds, uint32_t work )
+{
+	// the current loop, see CGHost :: Update, CBaseGame :: GetUpdateDue and CBaseGame :: UpdateTimers
+
+	Result R;
+	R.Loops = 0;
+	R.Updates = 0;
+	R.Drift = 0.0;
+	double CPUStart = GetCPUSeconds( );
+	uint64_t Start = GetMicroTicks( );
+	CTimerWheel Wheel( Start );
+
+	for( uint32_t i = 0; i < games.size( ); i++ )
+	{
+		games[i].LastSentMicroTicks = Start - ( rand( ) % latency ) * 1000 - rand( ) % 1000;
+		games[i].LateByMicroTicks = 0;
+		games[i].LastSend = 0;
+		Wheel.Schedule( &games[i].ActionTimer, games[i].LastSentMicroTicks + latency * 1000 );
+		Wheel.Schedule( &games[i].HousekeepingTimer, Start + 50000 );
+	}
+
+	while( GetMicroTicks( ) - Start < seconds * 1000000ULL )
+	{
+		uint64_t Now = GetMicroTicks( );
+		uint64_t NextDeadline = Wheel.GetNextDeadline( Now, 50000 );
+		gSocketPoller->Wait( NextDeadline > Now ? NextDeadline - Now : 0 );
+		Wheel.Expire( GetMicroTicks( ) );
+		R.Loops++;
+
+		for( vector<SimGame> :: iterator i = games.begin( ); i != games.end( ); i++ )
+		{
+			if( !i->ActionTimer.GetExpired( ) && !i->HousekeepingTimer.GetExpired( ) )
+				continue;
+
+			Work( work );
+			R.Updates++;
+			Now = GetMicroTicks( );
+			uint64_t Deadline = i->LastSentMicroTicks + latency * 1000 - i->LateByMicroTicks;
+
+			if( Now >= Deadline )
+			{
+				RecordSend( *i, R, latency, Now, Deadline );
+
+				uint64_t ActualSendInterval = Now - i->LastSentMicroTicks;
+				uint64_t ExpectedSendInterval = latency * 1000 - i->LateByMicroTicks;
+				i->LateByMicroTicks = ActualSendInterval > ExpectedSendInterval ? ActualSendInterval - ExpectedSendInterval : 0;
+
+				if( i->LateByMicroTicks > latency * 1000 )
+					i->LateByMicroTicks = latency * 1000;
+
+				i->LastSentMicroTicks = Now;
+			}
+
+			Wheel.Schedule( &i->ActionTimer, i->LastSentMicroTicks + latency * 1000 - i->LateByMicroTicks );
+			Wheel.Schedule( &i->HousekeepingTimer, GetMicroTicks( ) + 50000 );
+		}
+	}
+
+	R.CPU = GetCPUSeconds( ) - CPUStart;
+	R.Drift = R.Jitter.empty( ) ? 0.0 : R.Drift / R.Jitter.size( );
+	return R;
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t NumGames = argc > 1 ? atoi( argv[1] ) : 50;
+	uint32_t Latency = argc > 2 ? atoi( argv[2] ) : 50;
+	uint32_t Seconds = argc > 3 ? atoi( argv[3] ) : 10;
+	uint32_t Work = argc > 4 ? atoi( argv[4] ) : 5;
+
+	if( NumGames == 0 || Latency == 0 || Seconds == 0 )
+	{
+		CONSOLE_Print( "usage: tickbench [games] [latency in ms] [seconds] [work per game update in us]" );
+		return 1;
+	}
+
+	// the poller sleeps instead of waiting when it has no sockets so give it a listening socket to wait on
+
+	gSocketPoller = CSocketPoller :: Create( string( ) );
+	CTCPServer *Server = new CTCPServer( );
+	Server->Listen( "127.0.0.1", 0 );
+
+	CONSOLE_Print( "[TICKBENCH] " + UTIL_ToString( NumGames ) + " games, " + UTIL_ToString( Latency ) + "ms latency, " + UTIL_ToString( Seconds ) + " seconds, " + UTIL_ToString( Work ) + "us per game update, " + gSocketPoller->GetName( ) + " poller" );
+
+	vector<SimGame> Games( NumGames );
+	srand( 0 );
+	Result Scan = RunScan( Games, Latency, Seconds, Work );
+	Print( "scan", Scan, Seconds );
+	Result Wheel = RunWheel( Games, Latency, Seconds, Work );
+	Print( "wheel", Wheel, Seconds );
+
+	delete Server;
+	delete gSocketPoller;
+	return 0;
+}
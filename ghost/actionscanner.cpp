@@ -0,0 +1,138 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#include "ghost.h"
+#include "util.h"
+#include "actionscanner.h"
+
+#include <string.h>
+
+#if defined( __SSE2__ ) && defined( __GNUC__ )
+ #define ACTIONSCANNER_SSE2
+ #include <emmintrin.h>
+#endif
+
+//
+// CActionScanner
+//
+
+CActionScanner :: CActionScanner( const string &signature )
+{
+	m_Signature = UTIL_CreateByteArray( (unsigned char *)signature.c_str( ), signature.size( ) + 1 );
+}
+
+CActionScanner :: ~CActionScanner( )
+{
+
+}
+
+uint32_t CActionScanner :: Find( const unsigned char *data, uint32_t size, uint32_t start )
+{
+	const unsigned char *Signature = &m_Signature[0];
+	uint32_t Length = m_Signature.size( );
+
+	if( size < Length )
+		return size;
+
+	uint32_t Last = size - Length;		// the last position a signature can start at
+	uint32_t i = start;
+
+#ifdef ACTIONSCANNER_SSE2
+	// the second to last byte is compared as well because the last byte is the null terminator which is far too common in action data
+
+	__m128i First = _mm_set1_epi8( (char)Signature[0] );
+	__m128i SecondToLast = _mm_set1_epi8( (char)Signature[Length - 2] );
+
+	while( i + 15 <= Last )
+	{
+		__m128i A = _mm_loadu_si128( (const __m128i *)( data + i ) );
+		__m128i B = _mm_loadu_si128( (const __m128i *)( data + i + Length - 2 ) );
+		unsigned int Candidates = _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi8( A, First ), _mm_cmpeq_epi8( B, SecondToLast ) ) );
+
+		while( Candidates )
+		{
+			uint32_t Position = i + __builtin_ctz( Candidates );
+
+			if( memcmp( data + Position, Signature, Length ) == 0 )
+				return Position;
+
+			Candidates &= Candidates - 1;
+		}
+
+		i += 16;
+	}
+#endif
+
+	while( i <= Last )
+	{
+		const unsigned char *Candidate = (const unsigned char *)memchr( data + i, Signature[0], Last - i + 1 );
+
+		if( !Candidate )
+			break;
+
+		i = Candidate - data;
+
+		if( memcmp( data + i, Signature, Length ) == 0 )
+			return i;
+
+		i++;
+	}
+
+	return size;
+}
+
+vector<CSyncStoredInteger> &CActionScanner :: Scan( const unsigned char *data, uint32_t size )
+{
+	m_Records.clear( );
+	uint32_t i = 0;
+
+	while( ( i = Find( data, size, i ) ) < size )
+	{
+		// we think we've found a stored integer (but we can't be 100% sure)
+		// next we parse out two null terminated strings and a 4 byte integer, if any of them is incomplete we keep searching from the next byte
+
+		uint32_t MissionKeyStart = i + m_Signature.size( );
+		const unsigned char *MissionKeyEnd = (const unsigned char *)memchr( data + MissionKeyStart, 0, size - MissionKeyStart );
+
+		if( MissionKeyEnd )
+		{
+			uint32_t KeyStart = MissionKeyEnd - data + 1;
+			const unsigned char *KeyEnd = (const unsigned char *)memchr( data + KeyStart, 0, size - KeyStart );
+
+			if( KeyEnd && KeyEnd - data + 5 <= size )
+			{
+				CSyncStoredInteger Record;
+				Record.MissionKey.Data = data + MissionKeyStart;
+				Record.MissionKey.Length = MissionKeyEnd - Record.MissionKey.Data;
+				Record.Key.Data = data + KeyStart;
+				Record.Key.Length = KeyEnd - Record.Key.Data;
+				Record.ValueData = KeyEnd + 1;
+				Record.Value = UTIL_ByteArrayToUInt32( Record.ValueData, false );
+				m_Records.push_back( Record );
+				i = KeyEnd - data + 5;
+				continue;
+			}
+		}
+
+		i++;
+	}
+
+	return m_Records;
+}
@@ -0,0 +1,83 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#ifndef ACTIONSCANNER_H
+#define ACTIONSCANNER_H
+
+//
+// CActionString
+//
+
+// a null terminated string inside an action payload, it points into the payload so it's only valid as long as the action is
+
+struct CActionString
+{
+	const unsigned char *Data;
+	uint32_t Length;					// not counting the null terminator
+
+	string ToString( ) const			{ return string( (const char *)Data, Length ); }
+};
+
+//
+// CSyncStoredInteger
+//
+
+// a stored integer which was synced by the map script, i.e. the signature followed by two null terminated strings and a 4 byte integer
+// DotA uses the mission keys "Data", "Global" or a player id and W3MMD uses "val:<id>", "chk:<id>", ...
+
+struct CSyncStoredInteger
+{
+	CActionString MissionKey;
+	CActionString Key;
+	const unsigned char *ValueData;		// the 4 value bytes, little endian
+	uint32_t Value;
+};
+
+//
+// CActionScanner
+//
+
+// finds the stored integers a map script syncs through the game's actions
+// the actions aren't parsed (more than one action can be sent in a single packet and their lengths aren't explicitly represented)
+// so the payload is searched for the signature instead, e.g. "6b 64 72 2e 78 00" (action 0x6b and the null terminated string "dr.x") for DotA
+// 1.) with SSE2 sixteen positions are checked at once against the signature's first and second to last byte and only the candidates are compared in full
+// 2.) otherwise (and for the last few positions) memchr finds the candidates for the signature's first byte
+// 3.) the records point into the payload instead of copying their strings
+
+class CActionScanner
+{
+private:
+	BYTEARRAY m_Signature;				// including the null terminator
+	vector<CSyncStoredInteger> m_Records;
+
+public:
+	CActionScanner( const string &signature );
+	~CActionScanner( );
+
+	// returns the position of the first signature at or after start (or size if there isn't one)
+
+	uint32_t Find( const unsigned char *data, uint32_t size, uint32_t start );
+
+	// returns every complete record in the payload, the vector is reused by the next call
+
+	vector<CSyncStoredInteger> &Scan( const unsigned char *data, uint32_t size );
+};
+
+#endif
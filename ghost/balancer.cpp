@@ -0,0 +1,361 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#include "ghost.h"
+#include "util.h"
+#include "balancer.h"
+
+#include <boost/bind.hpp>
+
+//
+// CTeamBalancer
+//
+
+CTeamBalancer :: CTeamBalancer( uint32_t nNumThreads, uint32_t nTimeLimit )
+{
+	m_NumThreads = nNumThreads == 0 ? 1 : nNumThreads;
+	m_TimeLimit = nTimeLimit;
+	m_NumPlayers = 0;
+	m_NumTeams = 0;
+	m_NextTask = 0;
+	m_BestDifference = -1.0;
+	m_Deadline = 0;
+	m_TimedOut = false;
+	m_Nodes = 0;
+}
+
+CTeamBalancer :: ~CTeamBalancer( )
+{
+
+}
+
+vector<unsigned char> CTeamBalancer :: Balance( const vector<unsigned char> &playerIDs, unsigned char *teamSizes, double *playerScores )
+{
+	m_TimedOut = false;
+	m_Nodes = 0;
+	m_BestDifference = -1.0;
+
+	if( playerIDs.empty( ) || playerIDs.size( ) > BALANCER_MAX_PLAYERS )
+		return playerIDs;
+
+	// sort the players by score, highest first
+	// putting the strongest players on a team first makes the greedy assignment good and the bound tight early on
+
+	vector< pair<double, unsigned char> > Players;
+
+	for( vector<unsigned char> :: const_iterator i = playerIDs.begin( ); i != playerIDs.end( ); i++ )
+		Players.push_back( pair<double, unsigned char>( -playerScores[*i], *i ) );
+
+	sort( Players.begin( ), Players.end( ) );
+	m_NumPlayers = Players.size( );
+
+	for( uint32_t i = 0; i < m_NumPlayers; i++ )
+	{
+		m_PIDs[i] = Players[i].second;
+		m_Scores[i] = -Players[i].first;
+	}
+
+	uint32_t TotalSize = 0;
+	m_NumTeams = 0;
+
+	for( unsigned char i = 0; i < 12; i++ )
+	{
+		if( teamSizes[i] > 0 )
+		{
+			m_TeamSizes[m_NumTeams] = teamSizes[i];
+			TotalSize += teamSizes[i];
+			m_NumTeams++;
+		}
+	}
+
+	if( TotalSize != m_NumPlayers )
+		return playerIDs;
+
+	State Root;
+	memset( &Root, 0, sizeof( State ) );
+	m_Deadline = GetTicks( ) + m_TimeLimit;
+
+	// start with the greedy assignment (always take the first branch) so we have an answer no matter how little time we get
+
+	State Greedy = Root;
+	State Children[BALANCER_MAX_PLAYERS];
+
+	while( Greedy.Next < m_NumPlayers )
+	{
+		Expand( Greedy, -1.0, Children );
+		Greedy = Children[0];
+	}
+
+	m_BestDifference = GetDifference( Greedy );
+	memcpy( m_BestMembers, Greedy.Members, sizeof( m_BestMembers ) );
+
+	// split the top of the search tree into enough tasks to keep every worker busy even though some subtrees are cut much earlier than others
+
+	m_Tasks.clear( );
+	m_Tasks.push_back( Root );
+	m_NextTask = 0;
+
+	while( !m_Tasks.empty( ) && m_Tasks.size( ) < m_NumThreads * 8 && m_Tasks[0].Next < m_NumPlayers )
+	{
+		vector<State> Level;
+
+		for( vector<State> :: iterator i = m_Tasks.begin( ); i != m_Tasks.end( ); i++ )
+		{
+			uint32_t NumChildren = Expand( *i, m_BestDifference, Children );
+			Level.insert( Level.end( ), Children, Children + NumChildren );
+		}
+
+		m_Tasks.swap( Level );
+	}
+
+	vector<boost :: thread *> Threads;
+
+	for( uint32_t i = 1; i < m_NumThreads; i++ )
+	{
+		try
+		{
+			Threads.push_back( new boost :: thread( boost :: bind( &CTeamBalancer :: WorkerLoop, this ) ) );
+		}
+		catch( const boost :: thread_resource_error &tre )
+		{
+			CONSOLE_Print( "[BALANCER] error spawning balancer thread #" + UTIL_ToString( i ) + " [" + string( tre.what( ) ) + "], continuing with " + UTIL_ToString( Threads.size( ) + 1 ) + " threads" );
+			break;
+		}
+	}
+
+	WorkerLoop( );
+
+	for( vector<boost :: thread *> :: iterator i = Threads.begin( ); i != Threads.end( ); i++ )
+	{
+		(*i)->join( );
+		delete *i;
+	}
+
+	m_Tasks.clear( );
+
+	// the best assignment is a bitmask per team, turn it into the players grouped by team in team order
+
+	vector<unsigned char> Ordering;
+
+	for( uint32_t i = 0; i < m_NumTeams; i++ )
+	{
+		for( uint32_t j = 0; j < m_NumPlayers; j++ )
+		{
+			if( m_BestMembers[i] & ( 1 << j ) )
+				Ordering.push_back( m_PIDs[j] );
+		}
+	}
+
+	return Ordering;
+}
+
+uint32_t CTeamBalancer :: Expand( const State &state, double best, State *children )
+{
+	// the remaining players are sorted so the next one has the highest remaining score and the last one the lowest
+
+	double Highest = m_Scores[state.Next];
+	double Lowest = m_Scores[m_NumPlayers - 1];
+
+	if( best >= 0.0 )
+	{
+		// every team's final score lies somewhere in [Sum + Open * Lowest, Sum + Open * Highest]
+		// so no completion of this state can have a smaller difference than the largest lower bound minus the smallest upper bound
+
+		double LargestLow = 0.0;
+		double SmallestHigh = 0.0;
+
+		for( uint32_t i = 0; i < m_NumTeams; i++ )
+		{
+			unsigned char Open = m_TeamSizes[i] - state.Counts[i];
+			double Low = state.Sums[i] + Open * Lowest;
+			double High = state.Sums[i] + Open * Highest;
+
+			if( i == 0 || Low > LargestLow )
+				LargestLow = Low;
+
+			if( i == 0 || High < SmallestHigh )
+				SmallestHigh = High;
+		}
+
+		if( LargestLow - SmallestHigh >= best )
+			return 0;
+	}
+
+	// try the teams with the lowest total score first so the first leaf we reach is the greedy assignment
+
+	unsigned char Order[BALANCER_MAX_PLAYERS];
+	uint32_t NumChildren = 0;
+
+	for( uint32_t i = 0; i < m_NumTeams; i++ )
+	{
+		if( state.Counts[i] >= m_TeamSizes[i] )
+			continue;
+
+		if( state.Counts[i] == 0 )
+		{
+			bool Duplicate = false;
+
+			for( uint32_t j = 0; j < i; j++ )
+			{
+				if( state.Counts[j] == 0 && m_TeamSizes[j] == m_TeamSizes[i] )
+				{
+					Duplicate = true;
+					break;
+				}
+			}
+
+			if( Duplicate )
+				continue;
+		}
+
+		uint32_t Position = NumChildren;
+
+		while( Position > 0 && state.Sums[Order[Position - 1]] > state.Sums[i] )
+		{
+			Order[Position] = Order[Position - 1];
+			Position--;
+		}
+
+		Order[Position] = i;
+		NumChildren++;
+	}
+
+	for( uint32_t i = 0; i < NumChildren; i++ )
+	{
+		unsigned char Team = Order[i];
+		children[i] = state;
+		children[i].Sums[Team] += Highest;
+		children[i].Counts[Team]++;
+		children[i].Members[Team] |= 1 << state.Next;
+		children[i].Next++;
+	}
+
+	return NumChildren;
+}
+
+double CTeamBalancer :: GetDifference( const State &state )
+{
+	double Largest = state.Sums[0];
+	double Smallest = state.Sums[0];
+
+	for( uint32_t i = 1; i < m_NumTeams; i++ )
+	{
+		if( state.Sums[i] > Largest )
+			Largest = state.Sums[i];
+
+		if( state.Sums[i] < Smallest )
+			Smallest = state.Sums[i];
+	}
+
+	return Largest - Smallest;
+}
+
+void CTeamBalancer :: Leaf( Worker &worker, const State &state )
+{
+	double Difference = GetDifference( state );
+
+	if( Difference < worker.Best )
+	{
+		boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+		if( Difference < m_BestDifference )
+		{
+			m_BestDifference = Difference;
+			memcpy( m_BestMembers, state.Members, sizeof( m_BestMembers ) );
+		}
+
+		worker.Best = m_BestDifference;
+	}
+}
+
+void CTeamBalancer :: Sync( Worker &worker )
+{
+	// pick up the better assignments the other workers found and check if we're out of time
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+	if( m_BestDifference < worker.Best )
+		worker.Best = m_BestDifference;
+
+	if( GetTicks( ) >= m_Deadline )
+		m_TimedOut = true;
+
+	worker.Stop = m_TimedOut;
+}
+
+void CTeamBalancer :: Search( Worker &worker, const State &state )
+{
+	if( worker.Stop )
+		return;
+
+	worker.Nodes++;
+
+	if( worker.Nodes % 1024 == 0 )
+	{
+		Sync( worker );
+
+		if( worker.Stop )
+			return;
+	}
+
+	if( state.Next == m_NumPlayers )
+	{
+		Leaf( worker, state );
+		return;
+	}
+
+	State Children[BALANCER_MAX_PLAYERS];
+	uint32_t NumChildren = Expand( state, worker.Best, Children );
+
+	for( uint32_t i = 0; i < NumChildren; i++ )
+		Search( worker, Children[i] );
+}
+
+void CTeamBalancer :: WorkerLoop( )
+{
+	Worker Self;
+	Self.Nodes = 0;
+	Self.Stop = false;
+
+	{
+		boost :: mutex :: scoped_lock Lock( m_Mutex );
+		Self.Best = m_BestDifference;
+	}
+
+	while( true )
+	{
+		State Task;
+
+		{
+			boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+			if( m_TimedOut || m_NextTask >= m_Tasks.size( ) )
+				break;
+
+			Task = m_Tasks[m_NextTask++];
+		}
+
+		Sync( Self );
+		Search( Self, Task );
+	}
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	m_Nodes += Self.Nodes;
+}
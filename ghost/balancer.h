@@ -0,0 +1,103 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#ifndef BALANCER_H
+#define BALANCER_H
+
+#include <boost/thread.hpp>
+
+//
+// CTeamBalancer
+//
+
+// finds the assignment of players to teams which minimizes the largest difference in total scores between any two teams
+// this is a branch and bound search over the players sorted by score (highest first), each step puts the next player on a team that isn't full yet
+// 1.) a team's members are a bitmask and its total score is updated incrementally so a search step never allocates or recomputes anything
+// 2.) empty teams of the same size are interchangeable so only the first one of them is ever tried
+// 3.) a branch is cut when even the best possible completion (every open slot filled with the highest or lowest remaining score) can't beat the best assignment found so far
+// 4.) the first few levels of the search tree are split into tasks which can be handed out to a number of worker threads sharing the best assignment
+// 5.) the search gives up after m_TimeLimit milliseconds and returns the best assignment found so far, which is at least as good as the greedy one
+
+#define BALANCER_MAX_PLAYERS	12
+
+class CTeamBalancer
+{
+private:
+	struct State
+	{
+		double Sums[BALANCER_MAX_PLAYERS];				// the total score of each team
+		unsigned char Counts[BALANCER_MAX_PLAYERS];		// the number of players on each team
+		uint16_t Members[BALANCER_MAX_PLAYERS];			// the players on each team (bit N is the Nth player in m_Scores)
+		unsigned char Next;								// the next player to put on a team
+	};
+
+	struct Worker
+	{
+		double Best;									// our copy of m_BestDifference
+		uint32_t Nodes;
+		bool Stop;
+	};
+
+	uint32_t m_NumThreads;
+	uint32_t m_TimeLimit;								// milliseconds
+
+	// the current problem, these don't change during the search
+
+	uint32_t m_NumPlayers;
+	uint32_t m_NumTeams;
+	unsigned char m_PIDs[BALANCER_MAX_PLAYERS];			// the players sorted by score
+	double m_Scores[BALANCER_MAX_PLAYERS];				// sorted, highest first
+	unsigned char m_TeamSizes[BALANCER_MAX_PLAYERS];	// only the teams with players on them
+
+	// shared by the workers (protected by m_Mutex)
+
+	boost :: mutex m_Mutex;
+	vector<State> m_Tasks;
+	uint32_t m_NextTask;
+	double m_BestDifference;
+	uint16_t m_BestMembers[BALANCER_MAX_PLAYERS];
+	uint32_t m_Deadline;								// GetTicks when we give up
+	bool m_TimedOut;
+	uint32_t m_Nodes;
+
+	uint32_t Expand( const State &state, double best, State *children );
+	double GetDifference( const State &state );
+	void Leaf( Worker &worker, const State &state );
+	void Sync( Worker &worker );
+	void Search( Worker &worker, const State &state );
+	void WorkerLoop( );
+
+public:
+	CTeamBalancer( uint32_t nNumThreads, uint32_t nTimeLimit );
+	~CTeamBalancer( );
+
+	uint32_t GetNumThreads( )		{ return m_NumThreads; }
+	uint32_t GetTimeLimit( )		{ return m_TimeLimit; }
+	bool GetTimedOut( )				{ return m_TimedOut; }
+	double GetBestDifference( )		{ return m_BestDifference; }
+	uint32_t GetNodes( )			{ return m_Nodes; }
+
+	// teamSizes has 12 elements, playerScores is indexed by PID
+	// returns the players grouped by team in team order (the same ordering BalanceSlots expects)
+
+	vector<unsigned char> Balance( const vector<unsigned char> &playerIDs, unsigned char *teamSizes, double *playerScores );
+};
+
+#endif
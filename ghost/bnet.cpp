@@ -35,6 +35,7 @@
 #include "replay.h"
 #include "gameprotocol.h"
 #include "game_base.h"
+#include "metrics.h"
 
 #include <boost/filesystem.hpp>
 
@@ -50,6 +51,7 @@ CBNET :: CBNET( CGHost *nGHost, string nServer, string nServerAlias, string nBNL
 
 	m_GHost = nGHost;
 	m_Socket = new CTCPClient( );
+	m_Socket->SetMetricsClass( "bnet" );
 	m_Protocol = new CBNETProtocol( );
 	m_BNLSClient = NULL;
 	m_BNCSUtil = new CBNCSUtilInterface( nUserName, nUserPassword );
@@ -121,6 +123,7 @@ CBNET :: CBNET( CGHost *nGHost, string nServer, string nServerAlias, string nBNL
 	m_LastNullTime = 0;
 	m_LastOutPacketTicks = 0;
 	m_LastOutPacketSize = 0;
+	m_OutPacketsQueued = gMetrics->Gauge( "ghost_bnet_out_packets", "Packets waiting in the battle.net anti flood queue.", CMetrics :: Label( "server", m_ServerAlias ) );
 	m_LastAdminRefreshTime = GetTime( );
 	m_LastBanRefreshTime = GetTime( );
 	m_FirstConnect = true;
@@ -145,6 +148,7 @@ CBNET :: ~CBNET( )
 	}
 
 	delete m_BNCSUtil;
+	gMetrics->Remove( "ghost_bnet_out_packets", CMetrics :: Label( "server", m_ServerAlias ) );
 
 	for( vector<CIncomingFriendList *> :: iterator i = m_Friends.begin( ); i != m_Friends.end( ); i++ )
 		delete *i;
@@ -158,24 +162,9 @@ BYTEARRAY CBNET :: GetUniqueName( )
 	return m_Protocol->GetUniqueName( );
 }
 
-unsigned int CBNET :: SetFD( void *fd, void *send_fd, int *nfds )
-{
-	unsigned int NumFDs = 0;
-
-	if( !m_Socket->HasError( ) && m_Socket->GetConnected( ) )
-	{
-		m_Socket->SetFD( (fd_set *)fd, (fd_set *)send_fd, nfds );
-		NumFDs++;
-
-		if( m_BNLSClient )
-			NumFDs += m_BNLSClient->SetFD( fd, send_fd, nfds );
-	}
-
-	return NumFDs;
-}
-
-bool CBNET :: Update( void *fd, void *send_fd )
+bool CBNET :: Update( )
 {
+	m_OutPacketsQueued->Set( m_OutPackets.size( ) );
 
 	// we return at the end of each if statement so we don't have to deal with errors related to the order of the if statements
 	// that means it might take a few ms longer to complete a task involving multiple steps (in this case, reconnecting) due to blocking or sleeping
@@ -224,7 +213,7 @@ bool CBNET :: Update( void *fd, void *send_fd )
 	if( m_Socket->GetConnected( ) )
 	{
 		// the socket is connected and everything appears to be working properly
-		m_Socket->DoRecv( (fd_set *)fd );
+		m_Socket->DoRecv( );
 		ExtractPackets( );
 		ProcessPackets( );
 
@@ -232,7 +221,7 @@ bool CBNET :: Update( void *fd, void *send_fd )
 
 		if( m_BNLSClient )
 		{
-			if( m_BNLSClient->Update( fd, send_fd ) )
+			if( m_BNLSClient->Update( ) )
 			{
 				CONSOLE_Print( "[BNET: " + m_ServerAlias + "] deleting BNLS client" );
 				delete m_BNLSClient;
@@ -278,7 +267,7 @@ bool CBNET :: Update( void *fd, void *send_fd )
 			m_LastNullTime = GetTime( );
 		}
 
-		m_Socket->DoSend( (fd_set *)send_fd );
+		m_Socket->DoSend( );
 		return m_Exiting;
 	}
 
@@ -294,7 +283,7 @@ bool CBNET :: Update( void *fd, void *send_fd )
 			m_GHost->EventBNETConnected( this );
 			m_Socket->PutBytes( m_Protocol->SEND_PROTOCOL_INITIALIZE_SELECTOR( ) );
 			m_Socket->PutBytes( m_Protocol->SEND_SID_AUTH_INFO( m_War3Version, m_GHost->m_TFT, m_LocaleID, m_CountryAbbrev, m_Country ) );
-			m_Socket->DoSend( (fd_set *)send_fd );
+			m_Socket->DoSend( );
 			m_LastNullTime = GetTime( );
 			m_LastOutPacketTicks = GetTicks( );
 
@@ -357,47 +346,52 @@ bool CBNET :: Update( void *fd, void *send_fd )
 void CBNET :: ExtractPackets( )
 {
 	// extract as many packets as possible from the socket's receive buffer and put them in the m_Packets queue
+	// the buffer is scanned in place and only consumed once at the end
 
-	string *RecvBuffer = m_Socket->GetBytes( );
-	BYTEARRAY Bytes = UTIL_CreateByteArray( (unsigned char *)RecvBuffer->c_str( ), RecvBuffer->size( ) );
+	unsigned char *Data = m_Socket->GetRecvData( );
+	uint32_t Size = m_Socket->GetRecvSize( );
+	uint32_t Offset = 0;
 
 	// a packet is at least 4 bytes so loop as long as the buffer contains 4 bytes
 
-	while( Bytes.size( ) >= 4 )
+	while( Size - Offset >= 4 )
 	{
+		unsigned char *Packet = Data + Offset;
+
 		// byte 0 is always 255
 
-		if( Bytes[0] == BNET_HEADER_CONSTANT )
+		if( Packet[0] == BNET_HEADER_CONSTANT )
 		{
 			// bytes 2 and 3 contain the length of the packet
 
-			uint16_t Length = UTIL_ByteArrayToUInt16( Bytes, false, 2 );
+			uint16_t Length = UTIL_ByteArrayToUInt16( Packet + 2, false );
 
 			if( Length >= 4 )
 			{
-				if( Bytes.size( ) >= Length )
+				if( Size - Offset >= Length )
 				{
-					m_Packets.push( new CCommandPacket( BNET_HEADER_CONSTANT, Bytes[1], BYTEARRAY( Bytes.begin( ), Bytes.begin( ) + Length ) ) );
-					*RecvBuffer = RecvBuffer->substr( Length );
-					Bytes = BYTEARRAY( Bytes.begin( ) + Length, Bytes.end( ) );
+					m_Packets.push( new CCommandPacket( BNET_HEADER_CONSTANT, Packet[1], BYTEARRAY( Packet, Packet + Length ) ) );
+					Offset += Length;
 				}
 				else
-					return;
+					break;
 			}
 			else
 			{
 				CONSOLE_Print( "[BNET: " + m_ServerAlias + "] error - received invalid packet from battle.net (bad length), disconnecting" );
 				m_Socket->Disconnect( );
-				return;
+				break;
 			}
 		}
 		else
 		{
 			CONSOLE_Print( "[BNET: " + m_ServerAlias + "] error - received invalid packet from battle.net (bad header constant), disconnecting" );
 			m_Socket->Disconnect( );
-			return;
+			break;
 		}
 	}
+
+	m_Socket->ConsumeRecvBytes( Offset );
 }
 
 void CBNET :: ProcessPackets( )
@@ -34,6 +34,7 @@ class CIncomingFriendList;
 class CIncomingClanList;
 class CIncomingChatEvent;
 class CDBBan;
+class CMetricGauge;
 
 class CBNET
 {
@@ -79,6 +80,7 @@ private:
 	uint32_t m_LastNullTime;						// GetTime when the last null packet was sent for detecting disconnects
 	uint32_t m_LastOutPacketTicks;					// GetTicks when the last packet was sent for the m_OutPackets queue
 	uint32_t m_LastOutPacketSize;
+	CMetricGauge *m_OutPacketsQueued;				// the number of packets in m_OutPackets, for the metrics endpoint
 	uint32_t m_LastAdminRefreshTime;				// GetTime when the admin list was last refreshed from the database
 	uint32_t m_LastBanRefreshTime;					// GetTime when the ban list was last refreshed from the database
 	bool m_FirstConnect;							// if we haven't tried to connect to battle.net yet
@@ -119,8 +121,7 @@ public:
 
 	// processing functions
 
-	unsigned int SetFD( void *fd, void *send_fd, int *nfds );
-	bool Update( void *fd, void *send_fd );
+	bool Update( );
 	void ExtractPackets( );
 	void ProcessPackets( );
 	void ProcessChatEvent( CIncomingChatEvent *chatEvent );
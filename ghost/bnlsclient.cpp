@@ -32,6 +32,7 @@
 CBNLSClient :: CBNLSClient( string nServer, uint16_t nPort, uint32_t nWardenCookie )
 {
 	m_Socket = new CTCPClient( );
+	m_Socket->SetMetricsClass( "bnls" );
 	m_Protocol = new CBNLSProtocol( );
 	m_WasConnected = false;
 	m_Server = nServer;
@@ -68,18 +69,7 @@ BYTEARRAY CBNLSClient :: GetWardenResponse( )
 	return WardenResponse;
 }
 
-unsigned int CBNLSClient :: SetFD( void *fd, void *send_fd, int *nfds )
-{
-	if( !m_Socket->HasError( ) && m_Socket->GetConnected( ) )
-	{
-		m_Socket->SetFD( (fd_set *)fd, (fd_set *)send_fd, nfds );
-		return 1;
-	}
-
-	return 0;
-}
-
-bool CBNLSClient :: Update( void *fd, void *send_fd )
+bool CBNLSClient :: Update( )
 {
 	if( m_Socket->HasError( ) )
 	{
@@ -95,7 +85,7 @@ bool CBNLSClient :: Update( void *fd, void *send_fd )
 
 	if( m_Socket->GetConnected( ) )
 	{
-		m_Socket->DoRecv( (fd_set *)fd );
+		m_Socket->DoRecv( );
 		ExtractPackets( );
 		ProcessPackets( );
 
@@ -111,7 +101,7 @@ bool CBNLSClient :: Update( void *fd, void *send_fd )
 			m_OutPackets.pop( );
 		}
 
-		m_Socket->DoSend( (fd_set *)send_fd );
+		m_Socket->DoSend( );
 		return false;
 	}
 
@@ -135,31 +125,34 @@ bool CBNLSClient :: Update( void *fd, void *send_fd )
 
 void CBNLSClient :: ExtractPackets( )
 {
-	string *RecvBuffer = m_Socket->GetBytes( );
-	BYTEARRAY Bytes = UTIL_CreateByteArray( (unsigned char *)RecvBuffer->c_str( ), RecvBuffer->size( ) );
+	unsigned char *Data = m_Socket->GetRecvData( );
+	uint32_t Size = m_Socket->GetRecvSize( );
+	uint32_t Offset = 0;
 
-	while( Bytes.size( ) >= 3 )
+	while( Size - Offset >= 3 )
 	{
-		uint16_t Length = UTIL_ByteArrayToUInt16( Bytes, false );
+		unsigned char *Packet = Data + Offset;
+		uint16_t Length = UTIL_ByteArrayToUInt16( Packet, false );
 
 		if( Length >= 3 )
 		{
-			if( Bytes.size( ) >= Length )
+			if( Size - Offset >= Length )
 			{
-				m_Packets.push( new CCommandPacket( 0, Bytes[2], BYTEARRAY( Bytes.begin( ), Bytes.begin( ) + Length ) ) );
-				*RecvBuffer = RecvBuffer->substr( Length );
-				Bytes = BYTEARRAY( Bytes.begin( ) + Length, Bytes.end( ) );
+				m_Packets.push( new CCommandPacket( 0, Packet[2], BYTEARRAY( Packet, Packet + Length ) ) );
+				Offset += Length;
 			}
 			else
-				return;
+				break;
 		}
 		else
 		{
 			CONSOLE_Print( "[BNLSC: " + m_Server + ":" + UTIL_ToString( m_Port ) + ":C" + UTIL_ToString( m_WardenCookie ) + "] error - received invalid packet from BNLS server (bad length), disconnecting" );
 			m_Socket->Disconnect( );
-			return;
+			break;
 		}
 	}
+
+	m_Socket->ConsumeRecvBytes( Offset );
 }
 
 void CBNLSClient :: ProcessPackets( )
@@ -25,6 +25,12 @@
 // CCommandPacket
 //
 
+CCommandPacket :: CCommandPacket( )
+{
+	m_PacketType = 0;
+	m_ID = 0;
+}
+
 CCommandPacket :: CCommandPacket( unsigned char nPacketType, int nID, BYTEARRAY nData )
 {
 	m_PacketType = nPacketType;
@@ -36,3 +42,10 @@ CCommandPacket :: ~CCommandPacket( )
 {
 
 }
+
+void CCommandPacket :: Set( unsigned char nPacketType, int nID, unsigned char *data, uint32_t length )
+{
+	m_PacketType = nPacketType;
+	m_ID = nID;
+	m_Data.assign( data, data + length );
+}
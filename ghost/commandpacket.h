@@ -33,12 +33,17 @@ private:
 	BYTEARRAY m_Data;
 
 public:
+	CCommandPacket( );
 	CCommandPacket( unsigned char nPacketType, int nID, BYTEARRAY nData );
 	~CCommandPacket( );
 
 	unsigned char GetPacketType( )	{ return m_PacketType; }
 	int GetID( )					{ return m_ID; }
-	BYTEARRAY GetData( )			{ return m_Data; }
+	BYTEARRAY &GetData( )			{ return m_Data; }
+
+	// reuses the data's capacity when the packet is recycled by a pool
+
+	void Set( unsigned char nPacketType, int nID, unsigned char *data, uint32_t length );
 };
 
 #endif
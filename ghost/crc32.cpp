@@ -1,6 +1,20 @@
 #include "ghost.h"
 #include "crc32.h"
 
+// the PCLMULQDQ kernel is compiled for that instruction set on its own (the rest of the bot still runs on any x86 CPU) and only used if CPUID says it's supported
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+ #define CRC32_X86
+ #define CRC32_TARGET_PCLMUL __attribute__(( target( "sse2,pclmul" ) ))
+ #include <cpuid.h>
+ #include <emmintrin.h>
+ #include <wmmintrin.h>
+#elif defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+ #define CRC32_X86
+ #define CRC32_TARGET_PCLMUL
+ #include <intrin.h>
+#endif
+
 void CCRC32 :: Initialize( )
 {
 	for( int iCodes = 0; iCodes <= 0xFF; iCodes++ )
@@ -12,6 +26,14 @@ void CCRC32 :: Initialize( )
 
 		ulTable[iCodes] = Reflect( ulTable[iCodes], 32 );
 	}
+
+	for( int iCodes = 0; iCodes <= 0xFF; iCodes++ )
+	{
+		ulSliceTable[0][iCodes] = ulTable[iCodes];
+
+		for( int iSlice = 1; iSlice < 8; iSlice++ )
+			ulSliceTable[iSlice][iCodes] = ( ulSliceTable[iSlice - 1][iCodes] >> 8 ) ^ ulTable[ulSliceTable[iSlice - 1][iCodes] & 0xFF];
+	}
 }
 
 uint32_t CCRC32 :: Reflect( uint32_t ulReflect, char cChar )
@@ -36,8 +58,163 @@ uint32_t CCRC32 :: FullCRC( unsigned char *sData, uint32_t ulLength )
 	return ulCRC ^ 0xFFFFFFFF;
 }
 
+#ifdef CRC32_X86
+
+static bool CRC32_HasPCLMUL( )
+{
+#ifdef _MSC_VER
+	int Info[4];
+	__cpuid( Info, 1 );
+	return ( Info[2] & ( 1 << 1 ) ) != 0;
+#else
+	unsigned int EAX, EBX, ECX, EDX;
+
+	if( !__get_cpuid( 1, &EAX, &EBX, &ECX, &EDX ) )
+		return false;
+
+	return ( ECX & bit_PCLMUL ) != 0;
+#endif
+}
+
+// folds 64 bytes at a time with carry-less multiplication, then reduces the 128 bit remainder to the CRC (Barrett reduction)
+// see Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" for where the constants come from
+// ulLength must be at least 64 and a multiple of 16, the caller handles anything else
+
+CRC32_TARGET_PCLMUL static uint32_t CRC32_PCLMUL( uint32_t ulCRC, unsigned char *sData, uint32_t ulLength )
+{
+	const __m128i K1K2 = _mm_set_epi64x( 0x01C6E41596LL, 0x0154442BD4LL );
+	const __m128i K3K4 = _mm_set_epi64x( 0x00CCAA009ELL, 0x01751997D0LL );
+	const __m128i K5K0 = _mm_set_epi64x( 0, 0x0163CD6124LL );
+	const __m128i Poly = _mm_set_epi64x( 0x01F7011641LL, 0x01DB710641LL );
+	const __m128i Mask32 = _mm_setr_epi32( ~0, 0, ~0, 0 );
+
+	__m128i X1 = _mm_loadu_si128( (__m128i *)( sData + 0 ) );
+	__m128i X2 = _mm_loadu_si128( (__m128i *)( sData + 16 ) );
+	__m128i X3 = _mm_loadu_si128( (__m128i *)( sData + 32 ) );
+	__m128i X4 = _mm_loadu_si128( (__m128i *)( sData + 48 ) );
+	X1 = _mm_xor_si128( X1, _mm_cvtsi32_si128( ulCRC ) );
+	sData += 64;
+	ulLength -= 64;
+
+	// fold 512 bits at a time
+
+	while( ulLength >= 64 )
+	{
+		__m128i X5 = _mm_clmulepi64_si128( X1, K1K2, 0x00 );
+		__m128i X6 = _mm_clmulepi64_si128( X2, K1K2, 0x00 );
+		__m128i X7 = _mm_clmulepi64_si128( X3, K1K2, 0x00 );
+		__m128i X8 = _mm_clmulepi64_si128( X4, K1K2, 0x00 );
+		X1 = _mm_clmulepi64_si128( X1, K1K2, 0x11 );
+		X2 = _mm_clmulepi64_si128( X2, K1K2, 0x11 );
+		X3 = _mm_clmulepi64_si128( X3, K1K2, 0x11 );
+		X4 = _mm_clmulepi64_si128( X4, K1K2, 0x11 );
+		X1 = _mm_xor_si128( _mm_xor_si128( X1, X5 ), _mm_loadu_si128( (__m128i *)( sData + 0 ) ) );
+		X2 = _mm_xor_si128( _mm_xor_si128( X2, X6 ), _mm_loadu_si128( (__m128i *)( sData + 16 ) ) );
+		X3 = _mm_xor_si128( _mm_xor_si128( X3, X7 ), _mm_loadu_si128( (__m128i *)( sData + 32 ) ) );
+		X4 = _mm_xor_si128( _mm_xor_si128( X4, X8 ), _mm_loadu_si128( (__m128i *)( sData + 48 ) ) );
+		sData += 64;
+		ulLength -= 64;
+	}
+
+	// fold the four 128 bit values into one
+
+	__m128i X5 = _mm_clmulepi64_si128( X1, K3K4, 0x00 );
+	X1 = _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( X1, K3K4, 0x11 ), X2 ), X5 );
+	X5 = _mm_clmulepi64_si128( X1, K3K4, 0x00 );
+	X1 = _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( X1, K3K4, 0x11 ), X3 ), X5 );
+	X5 = _mm_clmulepi64_si128( X1, K3K4, 0x00 );
+	X1 = _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( X1, K3K4, 0x11 ), X4 ), X5 );
+
+	// fold 128 bits at a time
+
+	while( ulLength >= 16 )
+	{
+		X5 = _mm_clmulepi64_si128( X1, K3K4, 0x00 );
+		X1 = _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( X1, K3K4, 0x11 ), _mm_loadu_si128( (__m128i *)sData ) ), X5 );
+		sData += 16;
+		ulLength -= 16;
+	}
+
+	// fold 128 bits down to 64 bits
+
+	X2 = _mm_clmulepi64_si128( X1, K3K4, 0x10 );
+	X1 = _mm_xor_si128( _mm_srli_si128( X1, 8 ), X2 );
+	X2 = _mm_srli_si128( X1, 4 );
+	X1 = _mm_and_si128( X1, Mask32 );
+	X1 = _mm_xor_si128( _mm_clmulepi64_si128( X1, K5K0, 0x00 ), X2 );
+
+	// Barrett reduction down to 32 bits
+
+	X2 = _mm_and_si128( X1, Mask32 );
+	X2 = _mm_clmulepi64_si128( X2, Poly, 0x10 );
+	X2 = _mm_and_si128( X2, Mask32 );
+	X2 = _mm_clmulepi64_si128( X2, Poly, 0x00 );
+	X1 = _mm_xor_si128( X1, X2 );
+	return (uint32_t)_mm_cvtsi128_si32( _mm_srli_si128( X1, 4 ) );
+}
+
+#endif
+
+uint32_t CCRC32 :: GetBestKernel( )
+{
+#ifdef CRC32_X86
+	static const bool HasPCLMUL = CRC32_HasPCLMUL( );
+
+	if( HasPCLMUL )
+		return CRC32_KERNEL_PCLMUL;
+#endif
+
+	return CRC32_KERNEL_SLICE8;
+}
+
 void CCRC32 :: PartialCRC( uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength )
+{
+	static const uint32_t Kernel = GetBestKernel( );
+	PartialCRCWithKernel( Kernel, ulInCRC, sData, ulLength );
+}
+
+void CCRC32 :: PartialCRCWithKernel( uint32_t kernel, uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength )
+{
+#ifdef CRC32_X86
+	if( kernel == CRC32_KERNEL_PCLMUL && ulLength >= 64 )
+	{
+		uint32_t ulFolded = ulLength & ~15;
+		*ulInCRC = CRC32_PCLMUL( *ulInCRC, sData, ulFolded );
+		sData += ulFolded;
+		ulLength -= ulFolded;
+	}
+#endif
+
+	if( kernel != CRC32_KERNEL_BYTE )
+		PartialCRCSlice8( ulInCRC, sData, ulLength );
+	else
+		PartialCRCByte( ulInCRC, sData, ulLength );
+}
+
+void CCRC32 :: PartialCRCByte( uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength )
 {
 	while( ulLength-- )
 		*ulInCRC = ( *ulInCRC >> 8 ) ^ ulTable[( *ulInCRC & 0xFF ) ^ *sData++];
 }
+
+void CCRC32 :: PartialCRCSlice8( uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength )
+{
+	// the words are assembled byte by byte so this works on big endian systems too (it compiles to plain loads on little endian systems)
+
+	uint32_t ulCRC = *ulInCRC;
+
+	while( ulLength >= 8 )
+	{
+		uint32_t ulLow = ulCRC ^ ( (uint32_t)sData[0] | (uint32_t)sData[1] << 8 | (uint32_t)sData[2] << 16 | (uint32_t)sData[3] << 24 );
+		uint32_t ulHigh = (uint32_t)sData[4] | (uint32_t)sData[5] << 8 | (uint32_t)sData[6] << 16 | (uint32_t)sData[7] << 24;
+
+		ulCRC = ulSliceTable[7][ulLow & 0xFF] ^ ulSliceTable[6][( ulLow >> 8 ) & 0xFF] ^ ulSliceTable[5][( ulLow >> 16 ) & 0xFF] ^ ulSliceTable[4][ulLow >> 24] ^
+				ulSliceTable[3][ulHigh & 0xFF] ^ ulSliceTable[2][( ulHigh >> 8 ) & 0xFF] ^ ulSliceTable[1][( ulHigh >> 16 ) & 0xFF] ^ ulSliceTable[0][ulHigh >> 24];
+
+		sData += 8;
+		ulLength -= 8;
+	}
+
+	*ulInCRC = ulCRC;
+	PartialCRCByte( ulInCRC, sData, ulLength );
+}
@@ -3,6 +3,13 @@
 
 #define CRC32_POLYNOMIAL 0x04c11db7
 
+// the CRC kernels, PartialCRC picks the fastest one the CPU supports the first time it's called
+// every kernel gives exactly the same result, the byte at a time loop handles whatever the faster kernels leave over
+
+#define CRC32_KERNEL_BYTE		1		// one table lookup per byte (the original implementation)
+#define CRC32_KERNEL_SLICE8		2		// eight table lookups per 8 bytes (slice-by-8)
+#define CRC32_KERNEL_PCLMUL		3		// carry-less multiplication folding 64 bytes at a time (x86 with PCLMULQDQ)
+
 class CCRC32
 {
 public:
@@ -10,9 +17,15 @@ public:
 	uint32_t FullCRC( unsigned char *sData, uint32_t ulLength );
 	void PartialCRC( uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength );
 
+	static uint32_t GetBestKernel( );
+	void PartialCRCWithKernel( uint32_t kernel, uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength );
+
 private:
 	uint32_t Reflect( uint32_t ulReflect, char cChar );
+	void PartialCRCByte( uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength );
+	void PartialCRCSlice8( uint32_t *ulInCRC, unsigned char *sData, uint32_t ulLength );
 	uint32_t ulTable[256];
+	uint32_t ulSliceTable[8][256];	// ulSliceTable[0] is ulTable, ulSliceTable[n] is the CRC of a byte followed by n zero bytes
 };
 
 #endif
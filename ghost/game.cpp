@@ -40,6 +40,8 @@
 #include <string.h>
 #include <time.h>
 
+#include <boost/bind.hpp>
+
 //
 // sorting classes
 //
@@ -78,37 +80,29 @@ CGame :: CGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16_t nHost
 	else
 		m_Stats = NULL;
 
-	m_CallableGameAdd = NULL;
+	m_CallableGameResultAdd = NULL;
+
+	for( vector<CBNET *> :: iterator i = m_GHost->m_BNETs.begin( ); i != m_GHost->m_BNETs.end( ); i++ )
+		m_BNETServers.push_back( (*i)->GetServer( ) );
 }
 
 CGame :: ~CGame( )
 {
-	if( m_CallableGameAdd && m_CallableGameAdd->GetReady( ) )
+	if( m_CallableGameResultAdd && m_CallableGameResultAdd->GetReady( ) )
 	{
-		if( m_CallableGameAdd->GetResult( ) > 0 )
-		{
-			CONSOLE_Print( "[GAME: " + m_GameName + "] saving player/stats data to database" );
-
-			// store the CDBGamePlayers in the database
-
-			for( vector<CDBGamePlayer *> :: iterator i = m_DBGamePlayers.begin( ); i != m_DBGamePlayers.end( ); i++ )
-				m_GHost->m_Callables.push_back( m_GHost->m_DB->ThreadedGamePlayerAdd( m_GameId, (*i)->GetName( ), (*i)->GetIP( ), (*i)->GetSpoofed( ), (*i)->GetSpoofedRealm( ), (*i)->GetReserved( ), (*i)->GetLoadingTime( ), (*i)->GetLeft( ), (*i)->GetLeftReason( ), (*i)->GetTeam( ), (*i)->GetColour( ), (*i)->GetPlayerId( ) ) );
-
-			// store the stats in the database
-
-			if( m_Stats )
-				m_Stats->Save( m_GHost, m_GHost->m_DB, m_GameId );
-		}
+		if( m_CallableGameResultAdd->GetResult( ) > 0 )
+			CONSOLE_Print( "[GAME: " + m_GameName + "] saved game/player/stats data to database" );
 		else
-			CONSOLE_Print( "[GAME: " + m_GameName + "] unable to save player/stats data to database" );
+			CONSOLE_Print( "[GAME: " + m_GameName + "] unable to save game/player/stats data to database" );
 
-		m_GHost->m_DB->RecoverCallable( m_CallableGameAdd );
-		delete m_CallableGameAdd;
-		m_CallableGameAdd = NULL;
+		m_GHost->InvalidateProfiles( m_CallableGameResultAdd->GetGameResult( ) );
+		m_GHost->m_DB->RecoverCallable( m_CallableGameResultAdd );
+		delete m_CallableGameResultAdd;
+		m_CallableGameResultAdd = NULL;
 	}
 
         for( vector<PairedBanAdd> :: iterator i = m_PairedBanAdds.begin( ); i != m_PairedBanAdds.end( ); i++ )
-                m_GHost->m_Callables.push_back( i->second );
+                m_GHost->OrphanCallable( i->second );
 
 	for( vector<CDBBan *> :: iterator i = m_DBBans.begin( ); i != m_DBBans.end( ); i++ )
 		delete *i;
@@ -120,26 +114,26 @@ CGame :: ~CGame( )
 
 	delete m_Stats;
 
-	// it's a "bad thing" if m_CallableGameAdd is non NULL here
-	// it means the game is being deleted after m_CallableGameAdd was created (the first step to saving the game data) but before the associated thread terminated
-	// rather than failing horribly we choose to allow the thread to complete in the orphaned callables list but step 2 will never be completed
-	// so this will create a game entry in the database without any gameplayers and/or DotA stats
+	// it's a "bad thing" if m_CallableGameResultAdd is non NULL here
+	// it means the game is being deleted after m_CallableGameResultAdd was created but before the associated thread terminated
+	// rather than failing horribly we choose to allow the thread to complete in the orphaned callables list
+	// the callable already has all the data it needs so the game will still be saved, we just won't hear about the result
 
-	if( m_CallableGameAdd )
+	if( m_CallableGameResultAdd )
 	{
-		CONSOLE_Print( "[GAME: " + m_GameName + "] game is being deleted before all game data was saved, game data has been lost" );
-		m_GHost->m_Callables.push_back( m_CallableGameAdd );
+		CONSOLE_Print( "[GAME: " + m_GameName + "] game is being deleted before all game data was saved" );
+		m_GHost->OrphanCallable( m_CallableGameResultAdd );
 	}
 }
 
-bool CGame :: Update( void *fd, void *send_fd )
+bool CGame :: Update( )
 {
         for( vector<PairedBanAdd> :: iterator i = m_PairedBanAdds.begin( ); i != m_PairedBanAdds.end( ); )
         {
                 if( i->second->GetReady( ) )
                 {
                     if( i->second->GetResult( )) {
-                        SendAllChat( m_GHost->m_Language->PlayerWasBannedByPlayer( i->second->GetServer( ), i->second->GetUser( ), i->first ) );
+                        SendAllChat( m_Language->PlayerWasBannedByPlayer( i->second->GetServer( ), i->second->GetUser( ), i->first ) );
                     }
                     
                     m_GHost->m_DB->RecoverCallable( i->second );
@@ -150,7 +144,7 @@ bool CGame :: Update( void *fd, void *send_fd )
                         i++;
         }
 
-	return CBaseGame :: Update( fd, send_fd );
+	return CBaseGame :: Update( );
 }
 
 void CGame :: EventPlayerDeleted( CGamePlayer *player )
@@ -236,7 +230,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 			if( ( Command == "abort" || Command == "a" ) && m_CountDownStarted && !m_GameLoading && !m_GameLoaded )
 			{
-				SendAllChat( m_GHost->m_Language->CountDownAborted( ) );
+				SendAllChat( m_Language->CountDownAborted( ) );
 				m_CountDownStarted = false;
 			}
 
@@ -248,7 +242,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			{
 				if( Payload.empty( ) || Payload == "off" )
 				{
-					SendAllChat( m_GHost->m_Language->AnnounceMessageDisabled( ) );
+					SendAllChat( m_Language->AnnounceMessageDisabled( ) );
 					SetAnnounce( 0, string( ) );
 				}
 				else
@@ -276,7 +270,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 							if( Start != string :: npos )
 								Message = Message.substr( Start );
 
-							SendAllChat( m_GHost->m_Language->AnnounceMessageEnabled( ) );
+							SendAllChat( m_Language->AnnounceMessageEnabled( ) );
 							SetAnnounce( Interval, Message );
 						}
 					}
@@ -291,12 +285,12 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			{
 				if( Payload == "on" )
 				{
-					SendAllChat( m_GHost->m_Language->AutoSaveEnabled( ) );
+					SendAllChat( m_Language->AutoSaveEnabled( ) );
 					m_AutoSave = true;
 				}
 				else if( Payload == "off" )
 				{
-					SendAllChat( m_GHost->m_Language->AutoSaveDisabled( ) );
+					SendAllChat( m_Language->AutoSaveDisabled( ) );
 					m_AutoSave = false;
 				}
 			}
@@ -309,7 +303,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			{
 				if( Payload.empty( ) || Payload == "off" )
 				{
-					SendAllChat( m_GHost->m_Language->AutoStartDisabled( ) );
+					SendAllChat( m_Language->AutoStartDisabled( ) );
 					m_AutoStartPlayers = 0;
 				}
 				else
@@ -318,7 +312,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 					if( AutoStartPlayers != 0 )
 					{
-						SendAllChat( m_GHost->m_Language->AutoStartEnabled( UTIL_ToString( AutoStartPlayers ) ) );
+						SendAllChat( m_Language->AutoStartEnabled( UTIL_ToString( AutoStartPlayers ) ) );
 						m_AutoStartPlayers = AutoStartPlayers;
 					}
 				}
@@ -328,7 +322,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			// !BANLAST
 			//
 
-			if( Command == "banlast" && m_GameLoaded && !m_GHost->m_BNETs.empty( ) && m_DBBanLast )
+			if( Command == "banlast" && m_GameLoaded && !m_BNETServers.empty( ) && m_DBBanLast )
                             m_PairedBanAdds.push_back( PairedBanAdd( User, m_GHost->m_DB->ThreadedBanAdd( m_DBBanLast->GetServer( ), m_DBBanLast->GetName( ), m_DBBanLast->GetIP( ), m_GameName, User, Payload, m_GHost->m_BanLastTime ) ) );
 
                         
@@ -344,19 +338,19 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					uint32_t Matches = GetPlayerFromNamePartial( Payload, &LastMatch );
 
 					if( Matches == 0 )
-						SendAllChat( m_GHost->m_Language->UnableToCheckPlayerNoMatchesFound( Payload ) );
+						SendAllChat( m_Language->UnableToCheckPlayerNoMatchesFound( Payload ) );
 					else if( Matches == 1 )
 					{
 						bool LastMatchAdminCheck = IsAdmin( LastMatch->GetName() );
 						bool LastMatchRootAdminCheck = IsRootAdmin( LastMatch->GetName() );
 
-						SendAllChat( m_GHost->m_Language->CheckedPlayer( LastMatch->GetName( ), LastMatch->GetNumPings( ) > 0 ? UTIL_ToString( LastMatch->GetPing( m_GHost->m_LCPings ) ) + "ms" : "N/A", "??", LastMatchAdminCheck || LastMatchRootAdminCheck ? "Yes" : "No", IsOwner( LastMatch->GetName( ) ) ? "Yes" : "No", LastMatch->GetSpoofed( ) ? "Yes" : "No", LastMatch->GetSpoofedRealm( ).empty( ) ? "N/A" : LastMatch->GetSpoofedRealm( ), LastMatch->GetReserved( ) ? "Yes" : "No" ) );
+						SendAllChat( m_Language->CheckedPlayer( LastMatch->GetName( ), LastMatch->GetNumPings( ) > 0 ? UTIL_ToString( LastMatch->GetPing( m_GHost->m_LCPings ) ) + "ms" : "N/A", "??", LastMatchAdminCheck || LastMatchRootAdminCheck ? "Yes" : "No", IsOwner( LastMatch->GetName( ) ) ? "Yes" : "No", LastMatch->GetSpoofed( ) ? "Yes" : "No", LastMatch->GetSpoofedRealm( ).empty( ) ? "N/A" : LastMatch->GetSpoofedRealm( ), LastMatch->GetReserved( ) ? "Yes" : "No" ) );
 					}
 					else
-						SendAllChat( m_GHost->m_Language->UnableToCheckPlayerFoundMoreThanOneMatch( Payload ) );
+						SendAllChat( m_Language->UnableToCheckPlayerFoundMoreThanOneMatch( Payload ) );
 				}
 				else
-					SendAllChat( m_GHost->m_Language->CheckedPlayer( User, player->GetNumPings( ) > 0 ? UTIL_ToString( player->GetPing( m_GHost->m_LCPings ) ) + "ms" : "N/A", "??", AdminCheck || RootAdminCheck ? "Yes" : "No", IsOwner( User ) ? "Yes" : "No", player->GetSpoofed( ) ? "Yes" : "No", player->GetSpoofedRealm( ).empty( ) ? "N/A" : player->GetSpoofedRealm( ), player->GetReserved( ) ? "Yes" : "No" ) );
+					SendAllChat( m_Language->CheckedPlayer( User, player->GetNumPings( ) > 0 ? UTIL_ToString( player->GetPing( m_GHost->m_LCPings ) ) + "ms" : "N/A", "??", AdminCheck || RootAdminCheck ? "Yes" : "No", IsOwner( User ) ? "Yes" : "No", player->GetSpoofed( ) ? "Yes" : "No", player->GetSpoofedRealm( ).empty( ) ? "N/A" : player->GetSpoofedRealm( ), player->GetReserved( ) ? "Yes" : "No" ) );
 			}
 
 			//
@@ -366,7 +360,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			if( Command == "clearhcl" && !m_CountDownStarted )
 			{
 				m_HCLCommandString.clear( );
-				SendAllChat( m_GHost->m_Language->ClearingHCL( ) );
+				SendAllChat( m_Language->ClearingHCL( ) );
 			}
 
 			//
@@ -647,7 +641,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 				uint32_t Matches = GetPlayerFromNamePartial( Payload, &LastMatch );
 
 				if( Matches == 0 )
-					SendAllChat( m_GHost->m_Language->UnableToStartDownloadNoMatchesFound( Payload ) );
+					SendAllChat( m_Language->UnableToStartDownloadNoMatchesFound( Payload ) );
 				else if( Matches == 1 )
 				{
 					if( !LastMatch->GetDownloadStarted( ) && !LastMatch->GetDownloadFinished( ) )
@@ -667,7 +661,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					}
 				}
 				else
-					SendAllChat( m_GHost->m_Language->UnableToStartDownloadFoundMoreThanOneMatch( Payload ) );
+					SendAllChat( m_Language->UnableToStartDownloadFoundMoreThanOneMatch( Payload ) );
 			}
 
 			//
@@ -738,16 +732,16 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 						if( Payload.find_first_not_of( HCLChars ) == string :: npos )
 						{
 							m_HCLCommandString = Payload;
-							SendAllChat( m_GHost->m_Language->SettingHCL( m_HCLCommandString ) );
+							SendAllChat( m_Language->SettingHCL( m_HCLCommandString ) );
 						}
 						else
-							SendAllChat( m_GHost->m_Language->UnableToSetHCLInvalid( ) );
+							SendAllChat( m_Language->UnableToSetHCLInvalid( ) );
 					}
 					else
-						SendAllChat( m_GHost->m_Language->UnableToSetHCLTooLong( ) );
+						SendAllChat( m_Language->UnableToSetHCLTooLong( ) );
 				}
 				else
-					SendAllChat( m_GHost->m_Language->TheHCLIs( m_HCLCommandString ) );
+					SendAllChat( m_Language->TheHCLIs( m_HCLCommandString ) );
 			}
 
 			//
@@ -773,7 +767,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					}
 					else
 					{
-						SendAllChat( m_GHost->m_Language->AddedPlayerToTheHoldList( HoldName ) );
+						SendAllChat( m_Language->AddedPlayerToTheHoldList( HoldName ) );
 						AddToReserved( HoldName );
 					}
 				}
@@ -789,11 +783,11 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 				uint32_t Matches = GetPlayerFromNamePartial( Payload, &LastMatch );
 
 				if( Matches == 0 )
-					SendAllChat( m_GHost->m_Language->UnableToKickNoMatchesFound( Payload ) );
+					SendAllChat( m_Language->UnableToKickNoMatchesFound( Payload ) );
 				else if( Matches == 1 )
 				{
 					LastMatch->SetDeleteMe( true );
-					LastMatch->SetLeftReason( m_GHost->m_Language->WasKickedByPlayer( User ) );
+					LastMatch->SetLeftReason( m_Language->WasKickedByPlayer( User ) );
 
 					if( !m_GameLoading && !m_GameLoaded )
 						LastMatch->SetLeftCode( PLAYERLEAVE_LOBBY );
@@ -804,7 +798,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 						OpenSlot( GetSIDFromPID( LastMatch->GetPID( ) ), false );
 				}
 				else
-					SendAllChat( m_GHost->m_Language->UnableToKickFoundMoreThanOneMatch( Payload ) );
+					SendAllChat( m_Language->UnableToKickFoundMoreThanOneMatch( Payload ) );
 			}
 
 			//
@@ -814,7 +808,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			if( Command == "latency" )
 			{
 				if( Payload.empty( ) )
-					SendAllChat( m_GHost->m_Language->LatencyIs( UTIL_ToString( m_Latency ) ) );
+					SendAllChat( m_Language->LatencyIs( UTIL_ToString( m_Latency ) ) );
 				else
 				{
 					m_Latency = UTIL_ToUInt32( Payload );
@@ -822,15 +816,15 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					if( m_Latency <= 20 )
 					{
 						m_Latency = 20;
-						SendAllChat( m_GHost->m_Language->SettingLatencyToMinimum( "20" ) );
+						SendAllChat( m_Language->SettingLatencyToMinimum( "20" ) );
 					}
 					else if( m_Latency >= 500 )
 					{
 						m_Latency = 500;
-						SendAllChat( m_GHost->m_Language->SettingLatencyToMaximum( "500" ) );
+						SendAllChat( m_Language->SettingLatencyToMaximum( "500" ) );
 					}
 					else
-						SendAllChat( m_GHost->m_Language->SettingLatencyTo( UTIL_ToString( m_Latency ) ) );
+						SendAllChat( m_Language->SettingLatencyTo( UTIL_ToString( m_Latency ) ) );
 				}
 			}
 
@@ -840,7 +834,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 			if( Command == "lock" && ( RootAdminCheck || IsOwner( User ) ) )
 			{
-				SendAllChat( m_GHost->m_Language->GameLocked( ) );
+				SendAllChat( m_Language->GameLocked( ) );
 				m_Locked = true;
 			}
 
@@ -852,12 +846,12 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			{
 				if( Payload == "on" )
 				{
-					SendAllChat( m_GHost->m_Language->LocalAdminMessagesEnabled( ) );
+					SendAllChat( m_Language->LocalAdminMessagesEnabled( ) );
 					m_LocalAdminMessages = true;
 				}
 				else if( Payload == "off" )
 				{
-					SendAllChat( m_GHost->m_Language->LocalAdminMessagesDisabled( ) );
+					SendAllChat( m_Language->LocalAdminMessagesDisabled( ) );
 					m_LocalAdminMessages = false;
 				}
 			}
@@ -872,14 +866,14 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 				uint32_t Matches = GetPlayerFromNamePartial( Payload, &LastMatch );
 
 				if( Matches == 0 )
-					SendAllChat( m_GHost->m_Language->UnableToMuteNoMatchesFound( Payload ) );
+					SendAllChat( m_Language->UnableToMuteNoMatchesFound( Payload ) );
 				else if( Matches == 1 )
 				{
-					SendAllChat( m_GHost->m_Language->MutedPlayer( LastMatch->GetName( ), User ) );
+					SendAllChat( m_Language->MutedPlayer( LastMatch->GetName( ), User ) );
 					LastMatch->SetMuted( true );
 				}
 				else
-					SendAllChat( m_GHost->m_Language->UnableToMuteFoundMoreThanOneMatch( Payload ) );
+					SendAllChat( m_Language->UnableToMuteFoundMoreThanOneMatch( Payload ) );
 			}
 
 			//
@@ -888,7 +882,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 			if( Command == "muteall" && m_GameLoaded )
 			{
-				SendAllChat( m_GHost->m_Language->GlobalChatMuted( ) );
+				SendAllChat( m_Language->GlobalChatMuted( ) );
 				m_MuteAll = true;
 			}
 
@@ -935,17 +929,17 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 				{
 					if( !Payload.empty( ) )
 					{
-						SendAllChat( m_GHost->m_Language->SettingGameOwnerTo( Payload ) );
+						SendAllChat( m_Language->SettingGameOwnerTo( Payload ) );
 						m_OwnerName = Payload;
 					}
 					else
 					{
-						SendAllChat( m_GHost->m_Language->SettingGameOwnerTo( User ) );
+						SendAllChat( m_Language->SettingGameOwnerTo( User ) );
 						m_OwnerName = User;
 					}
 				}
 				else
-					SendAllChat( m_GHost->m_Language->UnableToSetGameOwner( m_OwnerName ) );
+					SendAllChat( m_Language->UnableToSetGameOwner( m_OwnerName ) );
 			}
 
 			//
@@ -1008,7 +1002,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					SendAllChat( Pings );
 
 				if( Kicked > 0 )
-					SendAllChat( m_GHost->m_Language->KickingPlayersWithPingsGreaterThan( UTIL_ToString( Kicked ), UTIL_ToString( KickPing ) ) );
+					SendAllChat( m_Language->KickingPlayersWithPingsGreaterThan( UTIL_ToString( Kicked ), UTIL_ToString( KickPing ) ) );
 			}
 
 			//
@@ -1019,12 +1013,12 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			{
 				if( Payload == "on" )
 				{
-					SendAllChat( m_GHost->m_Language->RefreshMessagesEnabled( ) );
+					SendAllChat( m_Language->RefreshMessagesEnabled( ) );
 					m_RefreshMessages = true;
 				}
 				else if( Payload == "off" )
 				{
-					SendAllChat( m_GHost->m_Language->RefreshMessagesDisabled( ) );
+					SendAllChat( m_Language->RefreshMessagesDisabled( ) );
 					m_RefreshMessages = false;
 				}
 			}
@@ -1035,8 +1029,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 			if( Command == "say" && !Payload.empty( ) )
 			{
-				for( vector<CBNET *> :: iterator i = m_GHost->m_BNETs.begin( ); i != m_GHost->m_BNETs.end( ); i++ )
-					(*i)->QueueChatCommand( Payload );
+				RunOnMainThread( boost :: bind( &CGHost :: QueueBNETChatCommand, m_GHost, Payload ) );
 
 				HideCommand = true;
 			}
@@ -1102,7 +1095,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 			if( Command == "sp" && !m_CountDownStarted )
 			{
-				SendAllChat( m_GHost->m_Language->ShufflingPlayers( ) );
+				SendAllChat( m_Language->ShufflingPlayers( ) );
 				ShuffleSlots( );
 			}
 
@@ -1122,7 +1115,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					if( GetTicks( ) - m_LastPlayerLeaveTicks >= 2000 )
 						StartCountDown( false );
 					else
-						SendAllChat( m_GHost->m_Language->CountDownAbortedSomeoneLeftRecently( ) );
+						SendAllChat( m_Language->CountDownAbortedSomeoneLeftRecently( ) );
 				}
 			}
 
@@ -1163,7 +1156,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			if( Command == "synclimit" )
 			{
 				if( Payload.empty( ) )
-					SendAllChat( m_GHost->m_Language->SyncLimitIs( UTIL_ToString( m_SyncLimit ) ) );
+					SendAllChat( m_Language->SyncLimitIs( UTIL_ToString( m_SyncLimit ) ) );
 				else
 				{
 					m_SyncLimit = UTIL_ToUInt32( Payload );
@@ -1171,15 +1164,15 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					if( m_SyncLimit <= 10 )
 					{
 						m_SyncLimit = 10;
-						SendAllChat( m_GHost->m_Language->SettingSyncLimitToMinimum( "10" ) );
+						SendAllChat( m_Language->SettingSyncLimitToMinimum( "10" ) );
 					}
 					else if( m_SyncLimit >= 10000 )
 					{
 						m_SyncLimit = 10000;
-						SendAllChat( m_GHost->m_Language->SettingSyncLimitToMaximum( "10000" ) );
+						SendAllChat( m_Language->SettingSyncLimitToMaximum( "10000" ) );
 					}
 					else
-						SendAllChat( m_GHost->m_Language->SettingSyncLimitTo( UTIL_ToString( m_SyncLimit ) ) );
+						SendAllChat( m_Language->SettingSyncLimitTo( UTIL_ToString( m_SyncLimit ) ) );
 				}
 			}
 
@@ -1196,7 +1189,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 			if( Command == "unlock" && ( RootAdminCheck || IsOwner( User ) ) )
 			{
-				SendAllChat( m_GHost->m_Language->GameUnlocked( ) );
+				SendAllChat( m_Language->GameUnlocked( ) );
 				m_Locked = false;
 			}
 
@@ -1210,14 +1203,14 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 				uint32_t Matches = GetPlayerFromNamePartial( Payload, &LastMatch );
 
 				if( Matches == 0 )
-					SendAllChat( m_GHost->m_Language->UnableToMuteNoMatchesFound( Payload ) );
+					SendAllChat( m_Language->UnableToMuteNoMatchesFound( Payload ) );
 				else if( Matches == 1 )
 				{
-					SendAllChat( m_GHost->m_Language->UnmutedPlayer( LastMatch->GetName( ), User ) );
+					SendAllChat( m_Language->UnmutedPlayer( LastMatch->GetName( ), User ) );
 					LastMatch->SetMuted( false );
 				}
 				else
-					SendAllChat( m_GHost->m_Language->UnableToMuteFoundMoreThanOneMatch( Payload ) );
+					SendAllChat( m_Language->UnableToMuteFoundMoreThanOneMatch( Payload ) );
 			}
 
 			//
@@ -1226,7 +1219,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 			if( Command == "unmuteall" && m_GameLoaded )
 			{
-				SendAllChat( m_GHost->m_Language->GlobalChatUnmuted( ) );
+				SendAllChat( m_Language->GlobalChatUnmuted( ) );
 				m_MuteAll = false;
 			}
 
@@ -1246,7 +1239,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 			if( Command == "votecancel" && !m_KickVotePlayer.empty( ) )
 			{
-				SendAllChat( m_GHost->m_Language->VoteKickCancelled( m_KickVotePlayer ) );
+				SendAllChat( m_Language->VoteKickCancelled( m_KickVotePlayer ) );
 				m_KickVotePlayer.clear( );
 				m_StartedKickVoteTime = 0;
 			}
@@ -1269,8 +1262,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					Name = Payload.substr( 0, MessageStart );
 					Message = Payload.substr( MessageStart + 1 );
 
-					for( vector<CBNET *> :: iterator i = m_GHost->m_BNETs.begin( ); i != m_GHost->m_BNETs.end( ); i++ )
-						(*i)->QueueChatCommand( Message, Name, true );
+					RunOnMainThread( boost :: bind( &CGHost :: QueueBNETWhisper, m_GHost, Name, Message ) );
 				}
 
 				HideCommand = true;
@@ -1279,7 +1271,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 		else
 		{
 			CONSOLE_Print( "[GAME: " + m_GameName + "] admin command ignored, the game is locked" );
-			SendChat( player, m_GHost->m_Language->TheGameIsLocked( ) );
+			SendChat( player, m_Language->TheGameIsLocked( ) );
 		}
 	}
 	else
@@ -1299,7 +1291,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	//
 
 	if( Command == "checkme" )
-		SendChat( player, m_GHost->m_Language->CheckedPlayer( User, player->GetNumPings( ) > 0 ? UTIL_ToString( player->GetPing( m_GHost->m_LCPings ) ) + "ms" : "N/A", "??", AdminCheck || RootAdminCheck ? "Yes" : "No", IsOwner( User ) ? "Yes" : "No", player->GetSpoofed( ) ? "Yes" : "No", player->GetSpoofedRealm( ).empty( ) ? "N/A" : player->GetSpoofedRealm( ), player->GetReserved( ) ? "Yes" : "No" ) );
+		SendChat( player, m_Language->CheckedPlayer( User, player->GetNumPings( ) > 0 ? UTIL_ToString( player->GetPing( m_GHost->m_LCPings ) ) + "ms" : "N/A", "??", AdminCheck || RootAdminCheck ? "Yes" : "No", IsOwner( User ) ? "Yes" : "No", player->GetSpoofed( ) ? "Yes" : "No", player->GetSpoofedRealm( ).empty( ) ? "N/A" : player->GetSpoofedRealm( ), player->GetReserved( ) ? "Yes" : "No" ) );
 
 	//
 	// !VERSION
@@ -1308,9 +1300,9 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	if( Command == "version" )
 	{
 		if( player->GetSpoofed( ) && ( AdminCheck || RootAdminCheck || IsOwner( User ) ) )
-			SendChat( player, m_GHost->m_Language->VersionAdmin( m_GHost->m_Version ) );
+			SendChat( player, m_Language->VersionAdmin( m_GHost->m_Version ) );
 		else
-			SendChat( player, m_GHost->m_Language->VersionNotAdmin( m_GHost->m_Version ) );
+			SendChat( player, m_Language->VersionNotAdmin( m_GHost->m_Version ) );
 	}
 
 	//
@@ -1320,20 +1312,20 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 	if( Command == "votekick" && m_GHost->m_VoteKickAllowed && !Payload.empty( ) )
 	{
 		if( !m_KickVotePlayer.empty( ) )
-			SendChat( player, m_GHost->m_Language->UnableToVoteKickAlreadyInProgress( ) );
+			SendChat( player, m_Language->UnableToVoteKickAlreadyInProgress( ) );
 		else if( m_Players.size( ) == 2 )
-			SendChat( player, m_GHost->m_Language->UnableToVoteKickNotEnoughPlayers( ) );
+			SendChat( player, m_Language->UnableToVoteKickNotEnoughPlayers( ) );
 		else
 		{
 			CGamePlayer *LastMatch = NULL;
 			uint32_t Matches = GetPlayerFromNamePartial( Payload, &LastMatch );
 
 			if( Matches == 0 )
-				SendChat( player, m_GHost->m_Language->UnableToVoteKickNoMatchesFound( Payload ) );
+				SendChat( player, m_Language->UnableToVoteKickNoMatchesFound( Payload ) );
 			else if( Matches == 1 )
 			{
 				if( LastMatch->GetReserved( ) )
-					SendChat( player, m_GHost->m_Language->UnableToVoteKickPlayerIsReserved( LastMatch->GetName( ) ) );
+					SendChat( player, m_Language->UnableToVoteKickPlayerIsReserved( LastMatch->GetName( ) ) );
 				else
 				{
 					m_KickVotePlayer = LastMatch->GetName( );
@@ -1344,12 +1336,12 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 
 					player->SetKickVote( true );
 					CONSOLE_Print( "[GAME: " + m_GameName + "] votekick against player [" + m_KickVotePlayer + "] started by player [" + User + "]" );
-					SendAllChat( m_GHost->m_Language->StartedVoteKick( LastMatch->GetName( ), User, UTIL_ToString( (uint32_t)ceil( ( GetNumHumanPlayers( ) - 1 ) * (float)m_GHost->m_VoteKickPercentage / 100 ) - 1 ) ) );
-					SendAllChat( m_GHost->m_Language->TypeYesToVote( string( 1, m_GHost->m_CommandTrigger ) ) );
+					SendAllChat( m_Language->StartedVoteKick( LastMatch->GetName( ), User, UTIL_ToString( (uint32_t)ceil( ( GetNumHumanPlayers( ) - 1 ) * (float)m_GHost->m_VoteKickPercentage / 100 ) - 1 ) ) );
+					SendAllChat( m_Language->TypeYesToVote( string( 1, m_GHost->m_CommandTrigger ) ) );
 				}
 			}
 			else
-				SendChat( player, m_GHost->m_Language->UnableToVoteKickFoundMoreThanOneMatch( Payload ) );
+				SendChat( player, m_Language->UnableToVoteKickFoundMoreThanOneMatch( Payload ) );
 		}
 	}
 
@@ -1376,7 +1368,7 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 			if( Victim )
 			{
 				Victim->SetDeleteMe( true );
-				Victim->SetLeftReason( m_GHost->m_Language->WasKickedByVote( ) );
+				Victim->SetLeftReason( m_Language->WasKickedByVote( ) );
 
 				if( !m_GameLoading && !m_GameLoaded )
 					Victim->SetLeftCode( PLAYERLEAVE_LOBBY );
@@ -1387,16 +1379,16 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
 					OpenSlot( GetSIDFromPID( Victim->GetPID( ) ), false );
 
 				CONSOLE_Print( "[GAME: " + m_GameName + "] votekick against player [" + m_KickVotePlayer + "] passed with " + UTIL_ToString( Votes ) + "/" + UTIL_ToString( GetNumHumanPlayers( ) ) + " votes" );
-				SendAllChat( m_GHost->m_Language->VoteKickPassed( m_KickVotePlayer ) );
+				SendAllChat( m_Language->VoteKickPassed( m_KickVotePlayer ) );
 			}
 			else
-				SendAllChat( m_GHost->m_Language->ErrorVoteKickingPlayer( m_KickVotePlayer ) );
+				SendAllChat( m_Language->ErrorVoteKickingPlayer( m_KickVotePlayer ) );
 
 			m_KickVotePlayer.clear( );
 			m_StartedKickVoteTime = 0;
 		}
 		else
-			SendAllChat( m_GHost->m_Language->VoteKickAcceptedNeedMoreVotes( m_KickVotePlayer, User, UTIL_ToString( VotesNeeded - Votes ) ) );
+			SendAllChat( m_Language->VoteKickAcceptedNeedMoreVotes( m_KickVotePlayer, User, UTIL_ToString( VotesNeeded - Votes ) ) );
 	}
 
         //
@@ -1426,18 +1418,18 @@ bool CGame :: EventPlayerBotCommand( CGamePlayer *player, string command, string
             }
 
             if(AliasId != 0 || Command == "stats") {
-                uint32_t playerid = player->GetPlayerId( );
+                CGamePlayer *Target = player;
                 if(!Payload.empty()){
                     CGamePlayer *LastMatch = NULL;
                     uint32_t Matches = GetPlayerFromNamePartial( Payload, &LastMatch );
                     if(Matches == 1) {
-                        playerid = LastMatch->GetPlayerId( );
+                        Target = LastMatch;
                     } else {
                         SendChat(player, "Couldn't find match for " + Payload);
                     }
                 }
                 
-                m_PairedGPS.push_back( PairedGPS( player->GetName(), m_GHost->m_DB->ThreadedGetPlayerStats( AliasId, playerid )));
+                RequestPlayerStats( Target, AliasId );
             }
 	}
 
@@ -1551,11 +1543,21 @@ void CGame :: EventGameStarted( )
 
 bool CGame :: IsGameDataSaved( )
 {
-	return m_CallableGameAdd && m_CallableGameAdd->GetReady( );
+	return m_CallableGameResultAdd && m_CallableGameResultAdd->GetReady( );
 }
 
 void CGame :: SaveGameData( )
 {
+	// everything is known by now (there are no players left) so the game, its players and its stats are saved together in one transaction
+
 	CONSOLE_Print( "[GAME: " + m_GameName + "] saving game data to database" );
-	m_CallableGameAdd = m_GHost->m_DB->ThreadedGameAdd( m_GHost->m_BNETs.size( ) == 1 ? m_GHost->m_BNETs[0]->GetServer( ) : string( ), m_DBGame->GetMap( ), m_GameName, m_OwnerName, m_GameTicks / 1000, m_GameState, m_CreatorName, m_CreatorServer, m_GameId, m_GHost->m_AliasId, m_LobbyLog, m_GameLog, m_EloChange );
+	CDBGameResult *Result = new CDBGameResult( m_BNETServers.size( ) == 1 ? m_BNETServers[0] : string( ), m_DBGame->GetMap( ), m_GameName, m_OwnerName, m_GameTicks / 1000, m_GameState, m_CreatorName, m_CreatorServer, m_GameId, m_GHost->m_AliasId, m_LobbyLog, m_GameLog, m_EloChange );
+
+	for( vector<CDBGamePlayer *> :: iterator i = m_DBGamePlayers.begin( ); i != m_DBGamePlayers.end( ); i++ )
+		Result->m_GamePlayers.push_back( **i );
+
+	if( m_Stats )
+		m_Stats->Save( Result );
+
+	m_CallableGameResultAdd = m_GHost->m_DB->ThreadedGameResultAdd( Result );
 }
@@ -30,7 +30,7 @@ class CDBGame;
 class CDBGamePlayer;
 class CStats;
 class CCallableBanAdd;
-class CCallableGameAdd;
+class CCallableGameResultAdd;
 
 typedef pair<string,CCallableBanAdd *> PairedBanAdd;
 
@@ -42,14 +42,15 @@ protected:
 	CDBGame *m_DBGame;							// potential game data for the database
 	vector<CDBGamePlayer *> m_DBGamePlayers;	// vector of potential gameplayer data for the database
 	CStats *m_Stats;							// class to keep track of game stats such as kills/deaths/assists in dota
-	CCallableGameAdd *m_CallableGameAdd;		// threaded database game addition in progress
+	CCallableGameResultAdd *m_CallableGameResultAdd;	// threaded database game result addition in progress
+	vector<string> m_BNETServers;				// the servers of our battle.net connections when the game was created (the connections belong to the main thread)
         vector<PairedBanAdd> m_PairedBanAdds;
 
 public:
 	CGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16_t nHostPort, unsigned char nGameState, string nGameName, string nOwnerName, string nCreatorName, string nCreatorServer, uint32_t nGameId );
 	virtual ~CGame( );
 
-	virtual bool Update( void *fd, void *send_fd );
+	virtual bool Update( );
 	virtual void EventPlayerDeleted( CGamePlayer *player );
 	virtual void EventPlayerAction( CGamePlayer *player, CIncomingAction *action );
 	virtual bool EventPlayerBotCommand( CGamePlayer *player, string command, string payload );
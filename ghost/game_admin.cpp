@@ -37,6 +37,7 @@
 #include <string.h>
 
 #include <boost/filesystem.hpp>
+#include <boost/bind.hpp>
 
 using namespace boost :: filesystem;
 
@@ -54,29 +55,29 @@ CAdminGame :: CAdminGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint
 CAdminGame :: ~CAdminGame( )
 {
 	for( vector<PairedAdminCount> :: iterator i = m_PairedAdminCounts.begin( ); i != m_PairedAdminCounts.end( ); i++ )
-		m_GHost->m_Callables.push_back( i->second );
+		m_GHost->OrphanCallable( i->second );
 
 	for( vector<PairedAdminAdd> :: iterator i = m_PairedAdminAdds.begin( ); i != m_PairedAdminAdds.end( ); i++ )
-		m_GHost->m_Callables.push_back( i->second );
+		m_GHost->OrphanCallable( i->second );
 
 	for( vector<PairedAdminRemove> :: iterator i = m_PairedAdminRemoves.begin( ); i != m_PairedAdminRemoves.end( ); i++ )
-		m_GHost->m_Callables.push_back( i->second );
+		m_GHost->OrphanCallable( i->second );
 
 	for( vector<PairedBanCount> :: iterator i = m_PairedBanCounts.begin( ); i != m_PairedBanCounts.end( ); i++ )
-		m_GHost->m_Callables.push_back( i->second );
+		m_GHost->OrphanCallable( i->second );
 
 	/*
 
 	for( vector<PairedBanAdd> :: iterator i = m_PairedBanAdds.begin( ); i != m_PairedBanAdds.end( ); i++ )
-		m_GHost->m_Callables.push_back( i->second );
+		m_GHost->OrphanCallable( i->second );
 
 	*/
 
 	for( vector<PairedBanRemove> :: iterator i = m_PairedBanRemoves.begin( ); i != m_PairedBanRemoves.end( ); i++ )
-		m_GHost->m_Callables.push_back( i->second );
+		m_GHost->OrphanCallable( i->second );
 }
 
-bool CAdminGame :: Update( void *fd, void *send_fd )
+bool CAdminGame :: Update( )
 {
 	//
 	// update callables
@@ -265,7 +266,7 @@ bool CAdminGame :: Update( void *fd, void *send_fd )
 	// reset the last reserved seen timer since the admin game should never be considered abandoned
 
 	m_LastReservedSeen = GetTime( );
-	return CBaseGame :: Update( fd, send_fd );
+	return CBaseGame :: Update( );
 }
 
 void CAdminGame :: SendAdminChat( string message )
@@ -806,9 +807,12 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 
 			if( GameNumber < m_GHost->m_Games.size( ) )
 			{
-				SendChat( player, m_GHost->m_Language->EndingGame( m_GHost->m_Games[GameNumber]->GetDescription( ) ) );
-				CONSOLE_Print( "[GAME: " + m_GHost->m_Games[GameNumber]->GetGameName( ) + "] is over (admin ended game)" );
-				m_GHost->m_Games[GameNumber]->StopPlayers( "was disconnected (admin ended game)" );
+				// the game might be running on a game thread so it has to stop its players itself
+
+				CBaseGame *Game = m_GHost->m_Games[GameNumber];
+				SendChat( player, m_GHost->m_Language->EndingGame( Game->GetDescriptionSnapshot( ) ) );
+				CONSOLE_Print( "[GAME: " + Game->GetGameName( ) + "] is over (admin ended game)" );
+				Game->RunOnGameThread( boost :: bind( &CBaseGame :: StopPlayers, Game, string( "was disconnected (admin ended game)" ) ) );
 			}
 			else
 				SendChat( player, m_GHost->m_Language->GameNumberDoesntExist( Payload ) );
@@ -871,7 +875,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 			uint32_t GameNumber = UTIL_ToUInt32( Payload ) - 1;
 
 			if( GameNumber < m_GHost->m_Games.size( ) )
-				SendChat( player, m_GHost->m_Language->GameNumberIs( Payload, m_GHost->m_Games[GameNumber]->GetDescription( ) ) );
+				SendChat( player, m_GHost->m_Language->GameNumberIs( Payload, m_GHost->m_Games[GameNumber]->GetDescriptionSnapshot( ) ) );
 			else
 				SendChat( player, m_GHost->m_Language->GameNumberDoesntExist( Payload ) );
 		}
@@ -1194,7 +1198,10 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 						Message = Message.substr( Start );
 
 					if( GameNumber - 1 < m_GHost->m_Games.size( ) )
-						m_GHost->m_Games[GameNumber - 1]->SendAllChat( "ADMIN: " + Message );
+					{
+						CBaseGame *Game = m_GHost->m_Games[GameNumber - 1];
+						Game->RunOnGameThread( boost :: bind( (void (CBaseGame :: *)( string ))&CBaseGame :: SendAllChat, Game, "ADMIN: " + Message ) );
+					}
 					else
 						SendChat( player, m_GHost->m_Language->GameNumberDoesntExist( UTIL_ToString( GameNumber ) ) );
 				}
@@ -1211,7 +1218,7 @@ bool CAdminGame :: EventPlayerBotCommand( CGamePlayer *player, string command, s
 				m_GHost->m_CurrentGame->SendAllChat( Payload );
 
 			for( vector<CBaseGame *> :: iterator i = m_GHost->m_Games.begin( ); i != m_GHost->m_Games.end( ); i++ )
-				(*i)->SendAllChat( "ADMIN: " + Payload );
+				(*i)->RunOnGameThread( boost :: bind( (void (CBaseGame :: *)( string ))&CBaseGame :: SendAllChat, *i, "ADMIN: " + Payload ) );
 		}
 
 		//
@@ -57,7 +57,7 @@ public:
 	CAdminGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16_t nHostPort, unsigned char nGameState, string nGameName, string nPassword );
 	virtual ~CAdminGame( );
 
-	virtual bool Update( void *fd, void *send_fd );
+	virtual bool Update( );
 	virtual void SendAdminChat( string message );
 	virtual void SendWelcomeMessage( CGamePlayer *player );
 	virtual void EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinPlayer *joinPlayer );
@@ -31,14 +31,24 @@
 #include "replay.h"
 #include "gameplayer.h"
 #include "gameprotocol.h"
+#include "gpsprotocol.h"
 #include "elo.h"
+#include "profilecache.h"
+#include "metrics.h"
+#include "timerwheel.h"
+#include "gproxylog.h"
+#include "pool.h"
+#include "commandpacket.h"
 #include "game_base.h"
+#include "gamethreads.h"
 
 #include <cmath>
 #include <string.h>
 #include <time.h>
 
-#include "next_combination.h"
+#include <boost/bind.hpp>
+
+#include "balancer.h"
 
 //
 // CBaseGame
@@ -60,6 +70,7 @@ CBaseGame :: CBaseGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16
 
 	m_Exiting = false;
 	m_Saving = false;
+	m_ProfilesPrefetched = false;
 	m_HostPort = nHostPort;
 	m_GameState = nGameState;
 	m_VirtualHostPID = 255;
@@ -97,8 +108,8 @@ CBaseGame :: CBaseGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16
 	m_CreationTime = GetTime( );
 	m_LastPingTime = GetTime( );
 	m_LastRefreshTime = GetTime( );
-	m_LastDownloadTicks = GetTime( );
-	m_DownloadCounter = 0;
+	m_LastDownloadTicks = GetTicks( );
+	m_DownloadRotation = 0;
 	m_LastDownloadCounterResetTicks = GetTicks( );
 	m_LastAnnounceTime = 0;
 	m_AnnounceInterval = 0;
@@ -117,6 +128,25 @@ CBaseGame :: CBaseGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16
 	m_StartedKickVoteTime = 0;
 	m_GameOverTime = 0;
 	m_LastPlayerLeaveTicks = 0;
+
+	// the game's own metrics are labelled with the host counter because the game name changes when the game is rehosted
+
+	m_MetricsLabels = CMetrics :: Label( "game", UTIL_ToString( m_HostCounter ) );
+	m_ActionLateness = gMetrics->Histogram( "ghost_game_action_lateness_seconds", "How late each action packet was sent compared to the latency.", m_MetricsLabels, CMetrics :: MicrosecondBuckets( ), 1000000.0 );
+	m_ActionOverruns = gMetrics->Counter( "ghost_game_action_overruns_total", "Action packets which were late by more than the latency.", m_MetricsLabels );
+	m_MapDownloadBytes = gMetrics->Counter( "ghost_map_download_bytes_total", "Map data sent to downloading players." );
+	m_MapDownloads = gMetrics->Counter( "ghost_map_downloads_total", "Finished map downloads." );
+	m_ActionTimer = new CTimer( );
+	m_HousekeepingTimer = new CTimer( );
+	m_TimerWheel = m_GHost->m_TimerWheel;
+	m_GProxyLog = new CGProxyLog( m_GHost->m_ReconnectBufferSize * 1024, m_MetricsLabels );
+	m_PacketPool = new CPool<CCommandPacket>( GAME_POOL_MAX_FREE, gMetrics->Counter( "ghost_pool_allocations_total", "Objects which had to be allocated because their pool was empty.", CMetrics :: Label( "pool", "packet" ) ), gMetrics->Counter( "ghost_pool_reuses_total", "Objects which were recycled from their pool.", CMetrics :: Label( "pool", "packet" ) ) );
+	m_ActionPool = new CPool<CIncomingAction>( GAME_POOL_MAX_FREE, gMetrics->Counter( "ghost_pool_allocations_total", "Objects which had to be allocated because their pool was empty.", CMetrics :: Label( "pool", "action" ) ), gMetrics->Counter( "ghost_pool_reuses_total", "Objects which were recycled from their pool.", CMetrics :: Label( "pool", "action" ) ) );
+	m_TickAllocations = gMetrics->Histogram( "ghost_game_tick_allocations", "Packets and actions allocated (instead of recycled) per action packet.", string( ), CMetrics :: CountBuckets( ), 1.0 );
+	m_MapDownloadRate = gMetrics->Histogram( "ghost_map_download_rate_kilobytes_per_second", "The average rate of each finished map download.", string( ), CMetrics :: RateBuckets( ), 1.0 );
+	m_GameThread = NULL;
+	m_Language = m_GHost->m_Language;
+	m_AdminList = m_GHost->m_AdminList;
 	m_MinimumScore = 0.0;
 	m_MaximumScore = 0.0;
 	m_SlotInfoChanged = false;
@@ -217,7 +247,7 @@ CBaseGame :: CBaseGame( CGHost *nGHost, CMap *nMap, CSaveGame *nSaveGame, uint16
 CBaseGame :: ~CBaseGame( )
 {
 	// save replay
-	// todotodo: put this in a thread
+	// the replay writer takes ownership of the replay, it's compressed and written to disk in the background
 
 	if( m_Replay && ( m_GameLoading || m_GameLoaded ) )
 	{
@@ -235,7 +265,8 @@ CBaseGame :: ~CBaseGame( )
 			SecString.insert( 0, "0" );
 
 		m_Replay->BuildReplay( m_GameName, m_StatString, m_GHost->m_ReplayWar3Version, m_GHost->m_ReplayBuildNumber );
-		m_Replay->Save( m_GHost->m_TFT, m_GHost->m_ReplayPath + UTIL_FileSafeName( "GHost++ " + UTIL_ToString(m_GameId) + ".w3g" ) );
+		m_GHost->m_ReplayWriter->Save( m_Replay, m_GHost->m_TFT, m_GHost->m_ReplayPath + UTIL_FileSafeName( "GHost++ " + UTIL_ToString(m_GameId) + ".w3g" ) );
+		m_Replay = NULL;
 	}
 
 	delete m_Socket;
@@ -246,51 +277,76 @@ CBaseGame :: ~CBaseGame( )
 	for( vector<CPotentialPlayer *> :: iterator i = m_Potentials.begin( ); i != m_Potentials.end( ); i++ )
 		delete *i;
 
+	// the players remove themselves from the GProxy++ resend log so it's deleted after them
+
 	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
 		delete *i;
 
+	delete m_GProxyLog;
+
 	for( vector<CCallableScoreCheck *> :: iterator i = m_ScoreChecks.begin( ); i != m_ScoreChecks.end( ); i++ )
-		m_GHost->m_Callables.push_back( *i );
+		m_GHost->OrphanCallable( *i );
         
 	for( vector<CCallableGetPlayerId *> :: iterator i = m_PairedGetPlayerIds.begin( ); i != m_PairedGetPlayerIds.end( ); i++ )
-		m_GHost->m_Callables.push_back( *i );
+		m_GHost->OrphanCallable( *i );
 
 	for( vector<CCallableGetPlayerScore *> :: iterator i = m_PairedGetPlayerScores.begin( ); i != m_PairedGetPlayerScores.end( ); i++ )
-		m_GHost->m_Callables.push_back( *i );
+		m_GHost->OrphanCallable( *i );
         
 	for( vector<CCallableCreatePlayerId *> :: iterator i = m_PairedCreatePlayerIds.begin( ); i != m_PairedCreatePlayerIds.end( ); i++ )
-		m_GHost->m_Callables.push_back( *i );
+		m_GHost->OrphanCallable( *i );
 
         
         for( vector<PairedGPS> :: iterator i = m_PairedGPS.begin( ); i != m_PairedGPS.end( ); i++ )
-                m_GHost->m_Callables.push_back( i->second );
+                m_GHost->OrphanCallable( i->second );
+
+	for( vector<CCallableGetPlayerStatsBatch *> :: iterator i = m_PlayerStatsPrefetches.begin( ); i != m_PlayerStatsPrefetches.end( ); i++ )
+		m_GHost->OrphanCallable( *i );
 
-        for( vector<PairedGameUpdate> :: iterator i = m_GameUpdates.begin( ); i != m_GameUpdates.end( ); ++i )
-                m_GHost->m_Callables.push_back( i->second );
+        m_GHost->ForgetGameListRow( m_GameId );
 
         while( !m_Actions.empty( ) )
         {
                 delete m_Actions.front( );
                 m_Actions.pop( );
         }
+
+	delete m_ActionTimer;
+	delete m_HousekeepingTimer;
+	delete m_PacketPool;
+	delete m_ActionPool;
+	gMetrics->Remove( "ghost_game_action_lateness_seconds", m_MetricsLabels );
+	gMetrics->Remove( "ghost_game_action_overruns_total", m_MetricsLabels );
 }
 
-uint32_t CBaseGame :: GetNextTimedActionTicks( )
+bool CBaseGame :: GetUpdateDue( )
 {
-	// return the number of ticks (ms) until the next "timed action", which for our purposes is the next game update
-	// the main GHost++ loop will make sure the next loop update happens at or before this value
-	// note: there's no reason this function couldn't take into account the game's other timers too but they're far less critical
-	// warning: this function must take into account when actions are not being sent (e.g. during loading or lagging)
+	// the main loop (or the game thread running us) only updates the games which have something to do, the others are skipped until their housekeeping timer is due
+	// note: we also look at the receive buffers because a socket can be handed to a game thread with data already received
 
-	if( !m_GameLoaded || m_Lagging )
-		return 50;
+	if( m_ActionTimer->GetExpired( ) || m_HousekeepingTimer->GetExpired( ) || !m_HousekeepingTimer->GetScheduled( ) )
+		return true;
 
-	uint32_t TicksSinceLastUpdate = GetTicks( ) - m_LastActionSentTicks;
+	if( m_Socket && m_Socket->GetReadable( ) )
+		return true;
 
-	if( TicksSinceLastUpdate > m_Latency - m_LastActionLateBy )
-		return 0;
-	else
-		return m_Latency - m_LastActionLateBy - TicksSinceLastUpdate;
+	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
+	{
+		CTCPSocket *Socket = (*i)->GetSocket( );
+
+		if( Socket && ( Socket->GetReadable( ) || Socket->GetRecvSize( ) > 0 || ( Socket->GetWritable( ) && Socket->GetSendSize( ) > 0 ) ) )
+			return true;
+	}
+
+	for( vector<CPotentialPlayer *> :: iterator i = m_Potentials.begin( ); i != m_Potentials.end( ); i++ )
+	{
+		CTCPSocket *Socket = (*i)->GetSocket( );
+
+		if( Socket && ( Socket->GetReadable( ) || Socket->GetRecvSize( ) > 0 || ( Socket->GetWritable( ) && Socket->GetSendSize( ) > 0 ) ) )
+			return true;
+	}
+
+	return false;
 }
 
 uint32_t CBaseGame :: GetSlotsOccupied( )
@@ -354,45 +410,32 @@ string CBaseGame :: GetDescription( )
 	return Description;
 }
 
-void CBaseGame :: SetAnnounce( uint32_t interval, string message )
+string CBaseGame :: GetDescriptionSnapshot( )
 {
-	m_AnnounceInterval = interval;
-	m_AnnounceMessage = message;
-	m_LastAnnounceTime = GetTime( );
-}
+	// the main thread can't call GetDescription while we're running on a game thread
 
-unsigned int CBaseGame :: SetFD( void *fd, void *send_fd, int *nfds )
-{
-	unsigned int NumFDs = 0;
+	if( !m_GameThread )
+		return GetDescription( );
 
-	if( m_Socket )
-	{
-            m_Socket->SetFD( (fd_set *)fd, (fd_set *)send_fd, nfds );
-            NumFDs++;
-	}
-
-	for( vector<CPotentialPlayer *> :: iterator i = m_Potentials.begin( ); i != m_Potentials.end( ); i++ )
-	{
-            if( (*i)->GetSocket( ) )
-            {
-                (*i)->GetSocket( )->SetFD( (fd_set *)fd, (fd_set *)send_fd, nfds );
-                NumFDs++;
-            }
-	}
+	boost :: mutex :: scoped_lock Lock( m_DescriptionMutex );
+	return m_DescriptionSnapshot;
+}
 
-	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
-	{
-            if( (*i)->GetSocket( ) )
-            {
-                (*i)->GetSocket( )->SetFD( (fd_set *)fd, (fd_set *)send_fd, nfds );
-                NumFDs++;
-            }
-	}
+void CBaseGame :: UpdateDescriptionSnapshot( )
+{
+	string Description = GetDescription( );
+	boost :: mutex :: scoped_lock Lock( m_DescriptionMutex );
+	m_DescriptionSnapshot = Description;
+}
 
-	return NumFDs;
+void CBaseGame :: SetAnnounce( uint32_t interval, string message )
+{
+	m_AnnounceInterval = interval;
+	m_AnnounceMessage = message;
+	m_LastAnnounceTime = GetTime( );
 }
 
-bool CBaseGame :: Update( void *fd, void *send_fd )
+bool CBaseGame :: Update( )
 {
 	// update callables
 
@@ -401,6 +444,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 		if( (*i)->GetReady( ) )
 		{
 			double Score = (*i)->GetResult( );
+			m_GHost->m_ProfileCache->SetCategoryScore( (*i)->GetName( ), (*i)->GetServer( ), (*i)->GetCategory( ), Score );
 
 			for( vector<CPotentialPlayer *> :: iterator j = m_Potentials.begin( ); j != m_Potentials.end( ); j++ )
 			{
@@ -416,6 +460,16 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 			i++;
 	}
 
+	for( vector<CachedPlayerId> :: iterator i = m_CachedPlayerIds.begin( ); i != m_CachedPlayerIds.end( ); i++ )
+	{
+		CGamePlayer *player = GetPlayerFromName( i->first, true );
+
+		if( player )
+			EventPlayerIdFound( player, i->second );
+	}
+
+	m_CachedPlayerIds.clear( );
+
 	for( vector<CCallableGetPlayerId *> :: iterator i = m_PairedGetPlayerIds.begin( ); i != m_PairedGetPlayerIds.end( ); )
 	{
             if( (*i)->GetReady( ) )
@@ -423,17 +477,11 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
                 CGamePlayer *player = GetPlayerFromName((*i)->GetUser(), true);
                 uint32_t id = (*i)->GetResult();
 
-                if(id != 0){
-                    SendChat(player, "Welcome back " + player->GetName() + "! Enjoy your stay and good luck for your game :-)");
-                    player->SetPlayerId( id );
-                    if(m_GHost->m_ShowStatsOnJoin) {
-                        m_PairedGPS.push_back(PairedGPS( player->GetName(), m_GHost->m_DB->ThreadedGetPlayerStats( m_GHost->m_AliasId, id )));
-                    }
-                    
-                    m_PairedGetPlayerScores.push_back(m_GHost->m_DB->ThreadedGetPlayerScore( m_GHost->m_AliasId, id ));
-                } else {
-                    SendChat(player, "Hey you are new here! Please stand by, we shortly create an unique identifier for your.");
-                    m_PairedCreatePlayerIds.push_back(m_GHost->m_DB->ThreadedCreatePlayerId(player->GetName(), player->GetExternalIPString(), player->GetJoinedRealm()));
+                if(player) {
+                    if(id != 0)
+                        m_GHost->m_ProfileCache->SetPlayerID(player->GetName(), player->GetJoinedRealm(), id);
+
+                    EventPlayerIdFound(player, id);
                 }
 
                 m_GHost->m_DB->RecoverCallable( *i );
@@ -456,6 +504,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
                         score = 1000.00;
                     }
                     player->SetScore(score);
+                    m_GHost->m_ProfileCache->SetScore(player->GetName(), player->GetJoinedRealm(), (*i)->GetAliasId(), score);
                 }
                 
                 m_GHost->m_DB->RecoverCallable( *i );
@@ -473,9 +522,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
                 CGamePlayer *player = GetPlayerFromName((*i)->GetUser(), true);
                 uint32_t id = (*i)->GetResult();
 
-                if(id != 0) {
+                if(player && id != 0) {
                     SendChat(player, "We have created your unique identifier: " + UTIL_ToString(id));
                     player->SetPlayerId(id);
+                    m_GHost->m_ProfileCache->SetPlayerID(player->GetName(), player->GetJoinedRealm(), id);
                 }
 
                 m_GHost->m_DB->RecoverCallable( *i );
@@ -487,37 +537,17 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 	}
     
     
-        for( vector<PairedGameUpdate> :: iterator i = m_GameUpdates.begin( ); i != m_GameUpdates.end( );) {
-                if(i->second->GetReady()) {
-                m_GHost->m_DB->RecoverCallable( i->second );
-                delete i->second;
-                i = m_GameUpdates.erase( i );
-            }
-            else
-                ++i;
-        }
-
         for( vector<PairedGPS> :: iterator i = m_PairedGPS.begin( ); i != m_PairedGPS.end( ); )
         {
                 if( i->second->GetReady( ) )
                 {
-			string StatsTemplate = m_GHost->m_StatsTemplates[i->second->GetAliasId( )];
-			string AliasName     = m_GHost->m_Aliases[i->second->GetAliasId( )];
-			CGamePlayer *player  = GetPlayerFromId(i->second->GetPlayerId( ));
+			CGamePlayer *player = GetPlayerFromId(i->second->GetPlayerId( ));
 
-			map<string, string> stats = i->second->GetResult( );
-
-			typedef map<string, string>::iterator value_iterator;
-    			for(value_iterator value = stats.begin(); value != stats.end(); value++)
+			if( player )
 			{
-                            UTIL_Replace( StatsTemplate, "{" + value->first + "}", value->second );
+				m_GHost->m_ProfileCache->SetStats( player->GetName( ), player->GetJoinedRealm( ), i->second->GetAliasId( ), i->second->GetResult( ) );
+				ShowPlayerStats( player, i->second->GetAliasId( ), i->second->GetResult( ) );
 			}
-                        
-                        if(stats.find("VALUE_01") != stats.end()) {
-                            SendAllChat(StatsTemplate);
-                        } else {
-                            SendAllChat( player->GetName() + " has not played any " + AliasName + " yet.");
-                        }
 
                         m_GHost->m_DB->RecoverCallable( i->second );
                         delete i->second;
@@ -526,12 +556,44 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
                 else
                         i++;
         }
+
+	for( vector<CCallableGetPlayerStatsBatch *> :: iterator i = m_PlayerStatsPrefetches.begin( ); i != m_PlayerStatsPrefetches.end( ); )
+	{
+		if( (*i)->GetReady( ) )
+		{
+			// players without any games on this alias aren't in the result, we leave them uncached so !stats still reports them properly
+
+			map<uint32_t, map<string, string> > Result = (*i)->GetResult( );
+
+			for( map<uint32_t, map<string, string> > :: iterator j = Result.begin( ); j != Result.end( ); j++ )
+			{
+				CGamePlayer *Player = GetPlayerFromId( j->first );
+
+				if( Player )
+					m_GHost->m_ProfileCache->SetStats( Player->GetName( ), Player->GetJoinedRealm( ), (*i)->GetAliasId( ), j->second );
+			}
+
+			m_GHost->m_DB->RecoverCallable( *i );
+			delete *i;
+			i = m_PlayerStatsPrefetches.erase( i );
+		}
+		else
+			i++;
+	}
+
+	// warm the profile cache with the whole lobby's stats in one query once the lobby is full
+	// players usually ask for each other's stats right before the game starts
+
+	if( GetSlotsOpen( ) > 0 )
+		m_ProfilesPrefetched = false;
+	else if( !m_CountDownStarted && !m_GameLoading && !m_GameLoaded && !m_ProfilesPrefetched && m_PairedGetPlayerIds.empty( ) && m_PairedCreatePlayerIds.empty( ) )
+		PrefetchProfiles( );
     
 	// update players
 
 	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); )
 	{
-		if( (*i)->Update( fd ) )
+		if( (*i)->Update( ) )
 		{
 			EventPlayerDeleted( *i );
 			delete *i;
@@ -543,12 +605,12 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 
 	for( vector<CPotentialPlayer *> :: iterator i = m_Potentials.begin( ); i != m_Potentials.end( ); )
 	{
-		if( (*i)->Update( fd ) )
+		if( (*i)->Update( ) )
 		{
 			// flush the socket (e.g. in case a rejection message is queued)
 
 			if( (*i)->GetSocket( ) )
-				(*i)->GetSocket( )->DoSend( (fd_set *)send_fd );
+				(*i)->GetSocket( )->DoSend( );
 
 			delete *i;
 			i = m_Potentials.erase( i );
@@ -566,7 +628,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 
 	if( m_Locked && !GetPlayerFromName( m_OwnerName, false ) )
 	{
-		SendAllChat( m_GHost->m_Language->GameUnlocked( ) );
+		SendAllChat( m_Language->GameUnlocked( ) );
 		m_Locked = false;
 	}
 
@@ -675,7 +737,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 		// only print the "game refreshed" message if we actually refreshed on at least one battle.net server
 
 		if( m_RefreshMessages && Refreshed )
-			SendAllChat( m_GHost->m_Language->GameRefreshed( ) );
+			SendAllChat( m_Language->GameRefreshed( ) );
 
 		m_LastRefreshTime = GetTime( );
 	}
@@ -685,67 +747,74 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 	if( !m_GameLoading && !m_GameLoaded && GetTicks( ) - m_LastDownloadCounterResetTicks >= 1000 )
 	{
 		// hackhack: another timer hijack is in progress here
-		// since the download counter is reset once per second it's a great place to update the slot info if necessary
+		// the download counter used to be reset once per second which made it a great place to update the slot info if necessary
 
 		if( m_SlotInfoChanged )
 			SendAllSlotInfo( );
 
-		m_DownloadCounter = 0;
 		m_LastDownloadCounterResetTicks = GetTicks( );
 	}
 
 	if( !m_GameLoading && !m_GameLoaded && GetTicks( ) - m_LastDownloadTicks >= 100 )
 	{
-		uint32_t Downloaders = 0;
+		// map parts are handed out one per downloader per round (starting with a different downloader every cycle) so everyone gets a fair share
+		// each downloader can have a window of unacknowledged parts in flight, see GetMapDownloadWindow
+		// the window keeps a slow connection from being clogged with map data, which would delay every lobby change (joins, slot changes, chat) for that player
+		// the total speed is limited by a token bucket refilled at bot_maxdownloadspeed which is shared with every other lobby
+
+		uint32_t MapSize = UTIL_ByteArrayToUInt32( m_Map->GetMapSize( ), false );
+		vector<CGamePlayer *> Downloaders;
 
 		for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
 		{
 			if( (*i)->GetDownloadStarted( ) && !(*i)->GetDownloadFinished( ) )
 			{
-				Downloaders++;
+				if( m_GHost->m_MaxDownloaders > 0 && Downloaders.size( ) >= m_GHost->m_MaxDownloaders )
+					break;
+
+				Downloaders.push_back( *i );
+			}
+		}
+
+		if( m_GHost->m_MaxDownloadSpeed > 0 )
+			m_GHost->RefillDownloadTokens( );
 
-				if( m_GHost->m_MaxDownloaders > 0 && Downloaders > m_GHost->m_MaxDownloaders )
+		bool Sent = !Downloaders.empty( );
+
+		while( Sent )
+		{
+			Sent = false;
+
+			for( uint32_t i = 0; i < Downloaders.size( ); i++ )
+			{
+				if( m_GHost->m_MaxDownloadSpeed > 0 && m_GHost->m_DownloadTokens < 1442 )
 					break;
 
-				// send up to 100 pieces of the map at once so that the download goes faster
-				// if we wait for each MAPPART packet to be acknowledged by the client it'll take a long time to download
-				// this is because we would have to wait the round trip time (the ping time) between sending every 1442 bytes of map data
-				// doing it this way allows us to send at least 140 KB in each round trip interval which is much more reasonable
-				// the theoretical throughput is [140 KB * 1000 / ping] in KB/sec so someone with 100 ping (round trip ping, not LC ping) could download at 1400 KB/sec
-				// note: this creates a queue of map data which clogs up the connection when the client is on a slower connection (e.g. dialup)
-				// in this case any changes to the lobby are delayed by the amount of time it takes to send the queued data (i.e. 140 KB, which could be 30 seconds or more)
-				// for example, players joining and leaving, slot changes, chat messages would all appear to happen much later for the low bandwidth player
-				// note: the throughput is also limited by the number of times this code is executed each second
-				// e.g. if we send the maximum amount (140 KB) 10 times per second the theoretical throughput is 1400 KB/sec
-				// therefore the maximum throughput is 1400 KB/sec regardless of ping and this value slowly diminishes as the player's ping increases
-				// in addition to this, the throughput is limited by the configuration value bot_maxdownloadspeed
-				// in summary: the actual throughput is MIN( 140 * 1000 / ping, 1400, bot_maxdownloadspeed ) in KB/sec assuming only one player is downloading the map
-
-				uint32_t MapSize = UTIL_ByteArrayToUInt32( m_Map->GetMapSize( ), false );
-
-				while( (*i)->GetLastMapPartSent( ) < (*i)->GetLastMapPartAcked( ) + 1442 * 100 && (*i)->GetLastMapPartSent( ) < MapSize )
+				CGamePlayer *Player = Downloaders[( i + m_DownloadRotation ) % Downloaders.size( )];
+
+				if( Player->GetLastMapPartSent( ) >= Player->GetLastMapPartAcked( ) + 1442 * GetMapDownloadWindow( Player ) || Player->GetLastMapPartSent( ) >= MapSize )
+					continue;
+
+				if( Player->GetLastMapPartSent( ) == 0 )
 				{
-					if( (*i)->GetLastMapPartSent( ) == 0 )
-					{
-						// overwrite the "started download ticks" since this is the first time we've sent any map data to the player
-						// prior to this we've only determined if the player needs to download the map but it's possible we could have delayed sending any data due to download limits
+					// overwrite the "started download ticks" since this is the first time we've sent any map data to the player
+					// prior to this we've only determined if the player needs to download the map but it's possible we could have delayed sending any data due to download limits
 
-						(*i)->SetStartedDownloadingTicks( GetTicks( ) );
-					}
+					Player->SetStartedDownloadingTicks( GetTicks( ) );
+				}
 
-					// limit the download speed if we're sending too much data
-					// the download counter is the # of map bytes downloaded in the last second (it's reset once per second)
+				Send( Player, m_Protocol->SEND_W3GS_MAPPART( GetHostPID( ), Player->GetPID( ), Player->GetLastMapPartSent( ), m_Map ) );
+				m_MapDownloadBytes->Add( min( (uint32_t)1442, MapSize - Player->GetLastMapPartSent( ) ) );
+				Player->SetLastMapPartSent( Player->GetLastMapPartSent( ) + 1442 );
 
-					if( m_GHost->m_MaxDownloadSpeed > 0 && m_DownloadCounter > m_GHost->m_MaxDownloadSpeed * 1024 )
-						break;
+				if( m_GHost->m_MaxDownloadSpeed > 0 )
+					m_GHost->m_DownloadTokens -= 1442;
 
-					Send( *i, m_Protocol->SEND_W3GS_MAPPART( GetHostPID( ), (*i)->GetPID( ), (*i)->GetLastMapPartSent( ), m_Map->GetMapData( ) ) );
-					(*i)->SetLastMapPartSent( (*i)->GetLastMapPartSent( ) + 1442 );
-					m_DownloadCounter += 1442;
-				}
+				Sent = true;
 			}
 		}
 
+		m_DownloadRotation++;
 		m_LastDownloadTicks = GetTicks( );
 	}
 
@@ -766,7 +835,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 			if( !(*i)->GetSpoofed( ) && GetTime( ) - (*i)->GetJoinTime( ) >= 20 )
 			{
 				(*i)->SetDeleteMe( true );
-				(*i)->SetLeftReason( m_GHost->m_Language->WasKickedForNotSpoofChecking( ) );
+				(*i)->SetLeftReason( m_Language->WasKickedForNotSpoofChecking( ) );
 				(*i)->SetLeftCode( PLAYERLEAVE_LOBBY );
 				OpenSlot( GetSIDFromPID( (*i)->GetPID( ) ), false );
 			}
@@ -804,8 +873,6 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 
 	if( !m_GameLoading && !m_GameLoaded && m_AutoStartPlayers == 0 && m_GHost->m_LobbyTimeLimit > 0 )
 	{
-        DoGameUpdate(true);
-        
 		// check if there's a player with reserved status in the game
 
 		for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
@@ -821,7 +888,6 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 			CONSOLE_Print( "[GAME: " + m_GameName + "] is over (lobby time limit hit)" );
 			return true;
 		}
-        DoGameUpdate(false);
 	}
 
 	// check if the game is loaded
@@ -840,7 +906,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 
 		if( FinishedLoading )
 		{
-			m_LastActionSentTicks = GetTicks( );
+			m_LastActionSentTicks = GetMicroTicks( );
 			m_GameLoading = false;
 			m_GameLoaded = true;
 			EventGameLoaded( );
@@ -884,10 +950,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 							// empty actions are used to extend the time a player can use when reconnecting
 
 							for( unsigned char j = 0; j < m_GProxyEmptyActions; j++ )
-								Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+								Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( vector<CIncomingAction *>( ), 0 ) );
 						}
 
-						Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+						Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( vector<CIncomingAction *>( ), 0 ) );
 
 						// start the lag screen
 
@@ -904,10 +970,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 							// empty actions are used to extend the time a player can use when reconnecting
 
 							for( unsigned char j = 0; j < m_GProxyEmptyActions; j++ )
-								(*i)->AddLoadInGameData( m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+								(*i)->AddLoadInGameData( m_Protocol->SEND_W3GS_INCOMING_ACTION( vector<CIncomingAction *>( ), 0 ) );
 						}
 
-						(*i)->AddLoadInGameData( m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+						(*i)->AddLoadInGameData( m_Protocol->SEND_W3GS_INCOMING_ACTION( vector<CIncomingAction *>( ), 0 ) );
 					}
 				}
 
@@ -918,10 +984,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 					if( UsingGProxy )
 					{
 						for( unsigned char i = 0; i < m_GProxyEmptyActions; i++ )
-							m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+							m_Replay->AddTimeSlot( 0, vector<CIncomingAction *>( ) );
 					}
 
-					m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+					m_Replay->AddTimeSlot( 0, vector<CIncomingAction *>( ) );
 				}
 
 				// Warcraft III doesn't seem to respond to empty actions
@@ -995,7 +1061,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 				WaitTime = ( m_GProxyEmptyActions + 1 ) * 60;
 
 			if( GetTime( ) - m_StartedLaggingTime >= WaitTime )
-				StopLaggers( m_GHost->m_Language->WasAutomaticallyDroppedAfterSeconds( UTIL_ToString( WaitTime ) ) );
+				StopLaggers( m_Language->WasAutomaticallyDroppedAfterSeconds( UTIL_ToString( WaitTime ) ) );
 
 			// we cannot allow the lag screen to stay up for more than ~65 seconds because Warcraft III disconnects if it doesn't receive an action packet at least this often
 			// one (easy) solution is to simply drop all the laggers if they lag for more than 60 seconds
@@ -1024,10 +1090,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 						// empty actions are used to extend the time a player can use when reconnecting
 
 						for( unsigned char j = 0; j < m_GProxyEmptyActions; j++ )
-							Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+							Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( vector<CIncomingAction *>( ), 0 ) );
 					}
 
-					Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+					Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( vector<CIncomingAction *>( ), 0 ) );
 
 					// start the lag screen
 
@@ -1041,10 +1107,10 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 					if( UsingGProxy )
 					{
 						for( unsigned char i = 0; i < m_GProxyEmptyActions; i++ )
-							m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+							m_Replay->AddTimeSlot( 0, vector<CIncomingAction *>( ) );
 					}
 
-					m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+					m_Replay->AddTimeSlot( 0, vector<CIncomingAction *>( ) );
 				}
 
 				// Warcraft III doesn't seem to respond to empty actions
@@ -1086,7 +1152,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 
 			// reset m_LastActionSentTicks because we want the game to stop running while the lag screen is up
 
-			m_LastActionSentTicks = GetTicks( );
+			m_LastActionSentTicks = GetMicroTicks( );
 
 			// keep track of the last lag screen time so we can avoid timing out players
 
@@ -1098,7 +1164,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 	// actions are at the heart of every Warcraft 3 game but luckily we don't need to know their contents to relay them
 	// we queue player actions in EventPlayerAction then just resend them in batches to all players here
 
-	if( m_GameLoaded && !m_Lagging && GetTicks( ) - m_LastActionSentTicks >= m_Latency - m_LastActionLateBy )
+	if( m_GameLoaded && !m_Lagging && GetMicroTicks( ) >= m_LastActionSentTicks + (uint64_t)m_Latency * 1000 - m_LastActionLateBy )
 		SendAllActions( );
 
 	// expire the votekick
@@ -1106,7 +1172,7 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 	if( !m_KickVotePlayer.empty( ) && GetTime( ) - m_StartedKickVoteTime >= 60 )
 	{
 		CONSOLE_Print( "[GAME: " + m_GameName + "] votekick against player [" + m_KickVotePlayer + "] expired" );
-		SendAllChat( m_GHost->m_Language->VoteKickExpired( m_KickVotePlayer ) );
+		SendAllChat( m_Language->VoteKickExpired( m_KickVotePlayer ) );
 		m_KickVotePlayer.clear( );
 		m_StartedKickVoteTime = 0;
 	}
@@ -1166,10 +1232,12 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 
 	if( m_Socket )
 	{
-		CTCPSocket *NewSocket = m_Socket->Accept( (fd_set *)fd );
+		CTCPSocket *NewSocket = m_Socket->Accept( );
 
 		if( NewSocket )
 		{
+			NewSocket->SetMetricsClass( "game" );
+
 			// check the IP blacklist
 
 			if( m_IPBlackList.find( NewSocket->GetIPString( ) ) == m_IPBlackList.end( ) )
@@ -1193,7 +1261,22 @@ bool CBaseGame :: Update( void *fd, void *send_fd )
 	return m_Exiting;
 }
 
-void CBaseGame :: UpdatePost( void *send_fd )
+void CBaseGame :: UpdateTimers( )
+{
+	// this is called after every update, the timers are always rescheduled because so many things (loading, lagging, the latency, ...) change when the next action packet is due
+
+	if( !m_TimerWheel )
+		return;
+
+	if( m_GameLoaded && !m_Lagging )
+		m_TimerWheel->Schedule( m_ActionTimer, m_LastActionSentTicks + (uint64_t)m_Latency * 1000 - m_LastActionLateBy );
+	else
+		m_TimerWheel->Cancel( m_ActionTimer );
+
+	m_TimerWheel->Schedule( m_HousekeepingTimer, GetMicroTicks( ) + GAME_HOUSEKEEPING_INTERVAL );
+}
+
+void CBaseGame :: UpdatePost( )
 {
 	// we need to manually call DoSend on each player now because CGamePlayer :: Update doesn't do it
 	// this is in case player 2 generates a packet for player 1 during the update but it doesn't get sent because player 1 already finished updating
@@ -1202,22 +1285,132 @@ void CBaseGame :: UpdatePost( void *send_fd )
 	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
 	{
 		if( (*i)->GetSocket( ) )
-			(*i)->GetSocket( )->DoSend( (fd_set *)send_fd );
+			(*i)->GetSocket( )->DoSend( );
 	}
 
 	for( vector<CPotentialPlayer *> :: iterator i = m_Potentials.begin( ); i != m_Potentials.end( ); i++ )
 	{
 		if( (*i)->GetSocket( ) )
-			(*i)->GetSocket( )->DoSend( (fd_set *)send_fd );
+			(*i)->GetSocket( )->DoSend( );
 	}
 }
 
+void CBaseGame :: SetTimerWheel( CTimerWheel *nTimerWheel )
+{
+	// our timers can only be linked into the wheel of the thread running us
+
+	if( m_TimerWheel )
+	{
+		m_TimerWheel->Cancel( m_ActionTimer );
+		m_TimerWheel->Cancel( m_HousekeepingTimer );
+	}
+
+	m_TimerWheel = nTimerWheel;
+}
+
+void CBaseGame :: DetachSockets( )
+{
+	if( m_Socket )
+		m_Socket->Detach( );
+
+	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
+	{
+		if( (*i)->GetSocket( ) )
+			(*i)->GetSocket( )->Detach( );
+	}
+
+	for( vector<CPotentialPlayer *> :: iterator i = m_Potentials.begin( ); i != m_Potentials.end( ); i++ )
+	{
+		if( (*i)->GetSocket( ) )
+			(*i)->GetSocket( )->Detach( );
+	}
+}
+
+void CBaseGame :: AttachSockets( CSocketPoller *poller )
+{
+	if( m_Socket )
+		m_Socket->Attach( poller );
+
+	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
+	{
+		if( (*i)->GetSocket( ) )
+			(*i)->GetSocket( )->Attach( poller );
+	}
+
+	for( vector<CPotentialPlayer *> :: iterator i = m_Potentials.begin( ); i != m_Potentials.end( ); i++ )
+	{
+		if( (*i)->GetSocket( ) )
+			(*i)->GetSocket( )->Attach( poller );
+	}
+}
+
+void CBaseGame :: RunOnMainThread( boost :: function<void( )> task )
+{
+	// e.g. anything to do with the battle.net connections, they belong to the main thread
+
+	if( m_GameThread )
+		m_GHost->m_GameThreads->PostMain( task );
+	else
+		task( );
+}
+
+void CBaseGame :: RunOnGameThread( boost :: function<void( )> task )
+{
+	if( m_GameThread )
+		m_GameThread->Post( this, task );
+	else
+		task( );
+}
+
+void CBaseGame :: SetSnapshots( boost :: shared_ptr<CLanguage> language, boost :: shared_ptr<const map<string, uint32_t> > adminList )
+{
+	m_Language = language;
+	m_AdminList = adminList;
+}
+
+bool CBaseGame :: GProxyReconnect( CTCPSocket *socket, unsigned char PID, uint32_t reconnectKey, uint32_t lastPacket )
+{
+	// returns false if the reconnecting player isn't one of ours, otherwise we take care of the socket
+
+	if( !m_GameLoaded )
+		return false;
+
+	CGamePlayer *Player = GetPlayerFromPID( PID );
+
+	if( !Player || !Player->GetGProxy( ) || Player->GetGProxyReconnectKey( ) != reconnectKey )
+		return false;
+
+	if( !Player->GetGProxyCanResume( lastPacket ) )
+	{
+		// the packets GProxy++ is missing were dropped from the game's resend log so it would desync
+		// the player will be dropped when the reconnect wait time runs out, just like when they don't reconnect at all
+
+		CONSOLE_Print( "[GAME: " + m_GameName + "] rejecting GProxy++ reconnect from player [" + Player->GetName( ) + "] because the packets it missed are no longer in the resend log" );
+		socket->PutBytes( m_GHost->m_GPSProtocol->SEND_GPSS_REJECT( REJECTGPS_NOTFOUND ) );
+		socket->DoSend( );
+		delete socket;
+		return true;
+	}
+
+	// reconnect successful!
+
+	socket->SetMetricsClass( "game" );
+	Player->EventGProxyReconnect( socket, lastPacket );
+	return true;
+}
+
 void CBaseGame :: Send( CGamePlayer *player, BYTEARRAY data )
 {
 	if( player )
 		player->Send( data );
 }
 
+void CBaseGame :: Send( CGamePlayer *player, SHAREDBYTEARRAY data )
+{
+	if( player )
+		player->Send( data );
+}
+
 void CBaseGame :: Send( unsigned char PID, BYTEARRAY data )
 {
 	Send( GetPlayerFromPID( PID ), data );
@@ -1225,14 +1418,20 @@ void CBaseGame :: Send( unsigned char PID, BYTEARRAY data )
 
 void CBaseGame :: Send( BYTEARRAY PIDs, BYTEARRAY data )
 {
+	SHAREDBYTEARRAY Data = UTIL_CreateSharedByteArray( data );
+
 	for( unsigned int i = 0; i < PIDs.size( ); i++ )
-		Send( PIDs[i], data );
+		Send( GetPlayerFromPID( PIDs[i] ), Data );
 }
 
 void CBaseGame :: SendAll( BYTEARRAY data )
 {
+	// the packet is shared by every player's socket (and GProxy++ buffer) instead of being copied for each of them
+
+	SHAREDBYTEARRAY Data = UTIL_CreateSharedByteArray( data );
+
 	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
-		(*i)->Send( data );
+		(*i)->Send( Data );
 }
 
 void CBaseGame :: SendChat( unsigned char fromPID, CGamePlayer *player, string message )
@@ -1375,14 +1574,14 @@ void CBaseGame :: SendAllActions( )
 			if( !(*i)->GetGProxy( ) )
 			{
 				for( unsigned char j = 0; j < m_GProxyEmptyActions; j++ )
-					Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *>( ), 0 ) );
+					Send( *i, m_Protocol->SEND_W3GS_INCOMING_ACTION( vector<CIncomingAction *>( ), 0 ) );
 			}
 		}
 
 		if( m_Replay )
 		{
 			for( unsigned char i = 0; i < m_GProxyEmptyActions; i++ )
-				m_Replay->AddTimeSlot( 0, queue<CIncomingAction *>( ) );
+				m_Replay->AddTimeSlot( 0, vector<CIncomingAction *>( ) );
 		}
 	}
 
@@ -1400,10 +1599,10 @@ void CBaseGame :: SendAllActions( )
 		// we use a "sub actions queue" which we keep adding actions to until we reach the size limit
 		// start by adding one action to the sub actions queue
 
-		queue<CIncomingAction *> SubActions;
+		vector<CIncomingAction *> SubActions;
 		CIncomingAction *Action = m_Actions.front( );
 		m_Actions.pop( );
-		SubActions.push( Action );
+		SubActions.push_back( Action );
 		uint32_t SubActionsLength = Action->GetLength( );
 
 		while( !m_Actions.empty( ) )
@@ -1424,16 +1623,14 @@ void CBaseGame :: SendAllActions( )
 				if( m_Replay )
 					m_Replay->AddTimeSlot2( SubActions );
 
-				while( !SubActions.empty( ) )
-				{
-					delete SubActions.front( );
-					SubActions.pop( );
-				}
+				for( vector<CIncomingAction *> :: iterator i = SubActions.begin( ); i != SubActions.end( ); i++ )
+					m_ActionPool->Put( *i );
 
+				SubActions.clear( );
 				SubActionsLength = 0;
 			}
 
-			SubActions.push( Action );
+			SubActions.push_back( Action );
 			SubActionsLength += Action->GetLength( );
 		}
 
@@ -1442,35 +1639,47 @@ void CBaseGame :: SendAllActions( )
 		if( m_Replay )
 			m_Replay->AddTimeSlot( m_Latency, SubActions );
 
-		while( !SubActions.empty( ) )
-		{
-			delete SubActions.front( );
-			SubActions.pop( );
-		}
+		// the actions have been broadcast and recorded so they can be recycled
+
+		for( vector<CIncomingAction *> :: iterator i = SubActions.begin( ); i != SubActions.end( ); i++ )
+			m_ActionPool->Put( *i );
 	}
 	else
 	{
-		SendAll( m_Protocol->SEND_W3GS_INCOMING_ACTION( m_Actions, m_Latency ) );
+		SendAll( m_Protocol->SEND_W3GS_INCOMING_ACTION( vector<CIncomingAction *>( ), m_Latency ) );
 
 		if( m_Replay )
-			m_Replay->AddTimeSlot( m_Latency, m_Actions );
+			m_Replay->AddTimeSlot( m_Latency, vector<CIncomingAction *>( ) );
 	}
 
-	uint32_t ActualSendInterval = GetTicks( ) - m_LastActionSentTicks;
-	uint32_t ExpectedSendInterval = m_Latency - m_LastActionLateBy;
-	m_LastActionLateBy = ActualSendInterval - ExpectedSendInterval;
+	// record how many packets and actions couldn't be recycled since the last action packet
+
+	m_TickAllocations->Observe( m_PacketPool->GetAllocations( ) + m_ActionPool->GetAllocations( ) );
+	m_PacketPool->ResetAllocations( );
+	m_ActionPool->ResetAllocations( );
+
+	// the timing is done in microseconds so the lateness doesn't accumulate millisecond rounding errors
+	// an action packet can also be sent early on purpose (e.g. to autosave before a player drop) which doesn't count as being late
 
-	if( m_LastActionLateBy > m_Latency )
+	uint64_t Now = GetMicroTicks( );
+	uint64_t ActualSendInterval = Now - m_LastActionSentTicks;
+	uint64_t ExpectedSendInterval = (uint64_t)m_Latency * 1000 - m_LastActionLateBy;
+	m_LastActionLateBy = ActualSendInterval > ExpectedSendInterval ? ActualSendInterval - ExpectedSendInterval : 0;
+	m_ActionLateness->Observe( m_LastActionLateBy );
+
+	if( m_LastActionLateBy > (uint64_t)m_Latency * 1000 )
 	{
+		m_ActionOverruns->Add( 1 );
+
 		// something is going terribly wrong - GHost++ is probably starved of resources
 		// print a message because even though this will take more resources it should provide some information to the administrator for future reference
 		// other solutions - dynamically modify the latency, request higher priority, terminate other games, ???
 
-		CONSOLE_Print( "[GAME: " + m_GameName + "] warning - the latency is " + UTIL_ToString( m_Latency ) + "ms but the last update was late by " + UTIL_ToString( m_LastActionLateBy ) + "ms" );
-		m_LastActionLateBy = m_Latency;
+		CONSOLE_Print( "[GAME: " + m_GameName + "] warning - the latency is " + UTIL_ToString( m_Latency ) + "ms but the last update was late by " + UTIL_ToString( m_LastActionLateBy / 1000 ) + "ms" );
+		m_LastActionLateBy = (uint64_t)m_Latency * 1000;
 	}
 
-	m_LastActionSentTicks = GetTicks( );
+	m_LastActionSentTicks = Now;
 }
 
 void CBaseGame :: SendWelcomeMessage( CGamePlayer *player )
@@ -1496,22 +1705,7 @@ void CBaseGame :: EventPlayerDeleted( CGamePlayer *player )
 	// remove any queued spoofcheck messages for this player
 
 	if( player->GetWhoisSent( ) && !player->GetJoinedRealm( ).empty( ) && player->GetSpoofedRealm( ).empty( ) )
-	{
-		for( vector<CBNET *> :: iterator i = m_GHost->m_BNETs.begin( ); i != m_GHost->m_BNETs.end( ); i++ )
-		{
-			if( (*i)->GetServer( ) == player->GetJoinedRealm( ) )
-			{
-				// hackhack: there must be a better way to do this
-
-				if( (*i)->GetPasswordHashType( ) == "pvpgn" )
-					(*i)->UnqueueChatCommand( "/whereis " + player->GetName( ) );
-				else
-					(*i)->UnqueueChatCommand( "/whois " + player->GetName( ) );
-
-				(*i)->UnqueueChatCommand( "/w " + player->GetName( ) + " " + m_GHost->m_Language->SpoofCheckByReplying( ) );
-			}
-		}
-	}
+		RunOnMainThread( boost :: bind( &CGHost :: UnqueueSpoofCheck, m_GHost, player->GetJoinedRealm( ), player->GetName( ) ) );
 
 	m_LastPlayerLeaveTicks = GetTicks( );
 
@@ -1531,7 +1725,7 @@ void CBaseGame :: EventPlayerDeleted( CGamePlayer *player )
 	if( m_GameLoaded && player->GetLeftCode( ) == PLAYERLEAVE_DISCONNECT && m_AutoSave )
 	{
 		string SaveGameName = UTIL_FileSafeName( "GHost++ AutoSave " + m_GameName + " (" + player->GetName( ) + ").w3z" );
-		CONSOLE_Print( "[GAME: " + m_GameName + "] auto saving [" + SaveGameName + "] before player drop, shortened send interval = " + UTIL_ToString( GetTicks( ) - m_LastActionSentTicks ) );
+		CONSOLE_Print( "[GAME: " + m_GameName + "] auto saving [" + SaveGameName + "] before player drop, shortened send interval = " + UTIL_ToString( ( GetMicroTicks( ) - m_LastActionSentTicks ) / 1000 ) );
 		BYTEARRAY CRC;
 		BYTEARRAY Action;
 		Action.push_back( 6 );
@@ -1588,14 +1782,14 @@ void CBaseGame :: EventPlayerDeleted( CGamePlayer *player )
 
 	if( m_CountDownStarted && !m_GameLoading && !m_GameLoaded )
 	{
-		SendAllChat( m_GHost->m_Language->CountDownAborted( ) );
+		SendAllChat( m_Language->CountDownAborted( ) );
 		m_CountDownStarted = false;
 	}
 
 	// abort the votekick
 
 	if( !m_KickVotePlayer.empty( ) )
-		SendAllChat( m_GHost->m_Language->VoteKickCancelled( m_KickVotePlayer ) );
+		SendAllChat( m_Language->VoteKickCancelled( m_KickVotePlayer ) );
 
 
     player->SetLeftTime( m_GameTicks / 1000 );
@@ -1610,7 +1804,7 @@ void CBaseGame :: EventPlayerDisconnectTimedOut( CGamePlayer *player )
 	{
 		if( !player->GetGProxyDisconnectNoticeSent( ) )
 		{
-			SendAllChat( player->GetName( ) + " " + m_GHost->m_Language->HasLostConnectionTimedOutGProxy( ) + "." );
+			SendAllChat( player->GetName( ) + " " + m_Language->HasLostConnectionTimedOutGProxy( ) + "." );
 			player->SetGProxyDisconnectNoticeSent( true );
 		}
 
@@ -1621,7 +1815,7 @@ void CBaseGame :: EventPlayerDisconnectTimedOut( CGamePlayer *player )
 			if( TimeRemaining > ( (uint32_t)m_GProxyEmptyActions + 1 ) * 60 )
 				TimeRemaining = ( m_GProxyEmptyActions + 1 ) * 60;
 
-			SendAllChat( player->GetPID( ), m_GHost->m_Language->WaitForReconnectSecondsRemain( UTIL_ToString( TimeRemaining ) ) );
+			SendAllChat( player->GetPID( ), m_Language->WaitForReconnectSecondsRemain( UTIL_ToString( TimeRemaining ) ) );
 			player->SetLastGProxyWaitNoticeSentTime( GetTime( ) );
 		}
 
@@ -1635,7 +1829,7 @@ void CBaseGame :: EventPlayerDisconnectTimedOut( CGamePlayer *player )
 	if( GetTime( ) - m_LastLagScreenTime >= 10 )
 	{
 		player->SetDeleteMe( true );
-		player->SetLeftReason( m_GHost->m_Language->HasLostConnectionTimedOut( ) );
+		player->SetLeftReason( m_Language->HasLostConnectionTimedOut( ) );
 		player->SetLeftCode( PLAYERLEAVE_DISCONNECT );
 
 		if( !m_GameLoading && !m_GameLoaded )
@@ -1649,7 +1843,7 @@ void CBaseGame :: EventPlayerDisconnectPlayerError( CGamePlayer *player )
 	// since TCP has checks and balances for data corruption the chances of this are pretty slim
 
 	player->SetDeleteMe( true );
-	player->SetLeftReason( m_GHost->m_Language->HasLostConnectionPlayerError( player->GetErrorString( ) ) );
+	player->SetLeftReason( m_Language->HasLostConnectionPlayerError( player->GetErrorString( ) ) );
 	player->SetLeftCode( PLAYERLEAVE_DISCONNECT );
 
 	if( !m_GameLoading && !m_GameLoaded )
@@ -1662,7 +1856,7 @@ void CBaseGame :: EventPlayerDisconnectSocketError( CGamePlayer *player )
 	{
 		if( !player->GetGProxyDisconnectNoticeSent( ) )
 		{
-			SendAllChat( player->GetName( ) + " " + m_GHost->m_Language->HasLostConnectionSocketErrorGProxy( player->GetSocket( )->GetErrorString( ) ) + "." );
+			SendAllChat( player->GetName( ) + " " + m_Language->HasLostConnectionSocketErrorGProxy( player->GetSocket( )->GetErrorString( ) ) + "." );
 			player->SetGProxyDisconnectNoticeSent( true );
 		}
 
@@ -1673,7 +1867,7 @@ void CBaseGame :: EventPlayerDisconnectSocketError( CGamePlayer *player )
 			if( TimeRemaining > ( (uint32_t)m_GProxyEmptyActions + 1 ) * 60 )
 				TimeRemaining = ( m_GProxyEmptyActions + 1 ) * 60;
 
-			SendAllChat( player->GetPID( ), m_GHost->m_Language->WaitForReconnectSecondsRemain( UTIL_ToString( TimeRemaining ) ) );
+			SendAllChat( player->GetPID( ), m_Language->WaitForReconnectSecondsRemain( UTIL_ToString( TimeRemaining ) ) );
 			player->SetLastGProxyWaitNoticeSentTime( GetTime( ) );
 		}
 
@@ -1681,7 +1875,7 @@ void CBaseGame :: EventPlayerDisconnectSocketError( CGamePlayer *player )
 	}
 
 	player->SetDeleteMe( true );
-	player->SetLeftReason( m_GHost->m_Language->HasLostConnectionSocketError( player->GetSocket( )->GetErrorString( ) ) );
+	player->SetLeftReason( m_Language->HasLostConnectionSocketError( player->GetSocket( )->GetErrorString( ) ) );
 	player->SetLeftCode( PLAYERLEAVE_DISCONNECT );
 
 	if( !m_GameLoading && !m_GameLoaded )
@@ -1694,7 +1888,7 @@ void CBaseGame :: EventPlayerDisconnectConnectionClosed( CGamePlayer *player )
 	{
 		if( !player->GetGProxyDisconnectNoticeSent( ) )
 		{
-			SendAllChat( player->GetName( ) + " " + m_GHost->m_Language->HasLostConnectionClosedByRemoteHostGProxy( ) + "." );
+			SendAllChat( player->GetName( ) + " " + m_Language->HasLostConnectionClosedByRemoteHostGProxy( ) + "." );
 			player->SetGProxyDisconnectNoticeSent( true );
 		}
 
@@ -1705,7 +1899,7 @@ void CBaseGame :: EventPlayerDisconnectConnectionClosed( CGamePlayer *player )
 			if( TimeRemaining > ( (uint32_t)m_GProxyEmptyActions + 1 ) * 60 )
 				TimeRemaining = ( m_GProxyEmptyActions + 1 ) * 60;
 
-			SendAllChat( player->GetPID( ), m_GHost->m_Language->WaitForReconnectSecondsRemain( UTIL_ToString( TimeRemaining ) ) );
+			SendAllChat( player->GetPID( ), m_Language->WaitForReconnectSecondsRemain( UTIL_ToString( TimeRemaining ) ) );
 			player->SetLastGProxyWaitNoticeSentTime( GetTime( ) );
 		}
 
@@ -1713,7 +1907,7 @@ void CBaseGame :: EventPlayerDisconnectConnectionClosed( CGamePlayer *player )
 	}
 
 	player->SetDeleteMe( true );
-	player->SetLeftReason( m_GHost->m_Language->HasLostConnectionClosedByRemoteHost( ) );
+	player->SetLeftReason( m_Language->HasLostConnectionClosedByRemoteHost( ) );
 	player->SetLeftCode( PLAYERLEAVE_DISCONNECT );
 
 	if( !m_GameLoading && !m_GameLoaded )
@@ -1747,7 +1941,7 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 	if( GetPlayerFromName( joinPlayer->GetName( ), false ) )
 	{
 		CONSOLE_Print( "[GAME: " + m_GameName + "] player [" + joinPlayer->GetName( ) + "|" + potential->GetExternalIPString( ) + "] is trying to join the game but that name is already taken" );
-		// SendAllChat( m_GHost->m_Language->TryingToJoinTheGameButTaken( joinPlayer->GetName( ) ) );
+		// SendAllChat( m_Language->TryingToJoinTheGameButTaken( joinPlayer->GetName( ) ) );
 		potential->Send( m_Protocol->SEND_W3GS_REJECTJOIN( REJECTJOIN_FULL ) );
 		potential->SetDeleteMe( true );
 		return;
@@ -1788,8 +1982,8 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 
                     if( m_IgnoredNames.find( joinPlayer->GetName( ) ) == m_IgnoredNames.end( ) )
                     {
-                            SendAllChat( m_GHost->m_Language->TryingToJoinTheGameButBannedByName( joinPlayer->GetName( ) ) );
-                            SendAllChat( m_GHost->m_Language->UserWasBannedOnByBecause( Ban->GetServer( ), Ban->GetName( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
+                            SendAllChat( m_Language->TryingToJoinTheGameButBannedByName( joinPlayer->GetName( ) ) );
+                            SendAllChat( m_Language->UserWasBannedOnByBecause( Ban->GetServer( ), Ban->GetName( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
                             m_IgnoredNames.insert( joinPlayer->GetName( ) );
                     }
                     
@@ -1813,8 +2007,8 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 
                     if( m_IgnoredNames.find( joinPlayer->GetName( ) ) == m_IgnoredNames.end( ) )
                     {
-                            SendAllChat( m_GHost->m_Language->TryingToJoinTheGameButBannedByIP( joinPlayer->GetName( ), potential->GetExternalIPString( ), Ban->GetName( ) ) );
-                            SendAllChat( m_GHost->m_Language->UserWasBannedOnByBecause( Ban->GetServer( ), Ban->GetName( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
+                            SendAllChat( m_Language->TryingToJoinTheGameButBannedByIP( joinPlayer->GetName( ), potential->GetExternalIPString( ), Ban->GetName( ) ) );
+                            SendAllChat( m_Language->UserWasBannedOnByBecause( Ban->GetServer( ), Ban->GetName( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
                             m_IgnoredNames.insert( joinPlayer->GetName( ) );
                     }
 
@@ -1835,6 +2029,15 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 		// matchmaking is enabled
 		// start a database query to determine the player's score
 		// when the query is complete we will call EventPlayerJoinedWithScore
+		// players who joined one of our lobbies recently are still in the profile cache so we can skip the query
+
+		double Score;
+
+		if( m_GHost->m_ProfileCache->GetCategoryScore( joinPlayer->GetName( ), JoinedRealm, m_Map->GetMapMatchMakingCategory( ), &Score ) )
+		{
+			EventPlayerJoinedWithScore( potential, joinPlayer, Score );
+			return;
+		}
 
 		m_ScoreChecks.push_back( m_GHost->m_DB->ThreadedScoreCheck( m_Map->GetMapMatchMakingCategory( ), joinPlayer->GetName( ), JoinedRealm ) );
 		return;
@@ -1908,7 +2111,7 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 				if( KickedPlayer )
 				{
 					KickedPlayer->SetDeleteMe( true );
-					KickedPlayer->SetLeftReason( m_GHost->m_Language->WasKickedForReservedPlayer( joinPlayer->GetName( ) ) );
+					KickedPlayer->SetLeftReason( m_Language->WasKickedForReservedPlayer( joinPlayer->GetName( ) ) );
 					KickedPlayer->SetLeftCode( PLAYERLEAVE_LOBBY );
 
 					// send a playerleave message immediately since it won't normally get sent until the player is deleted which is after we send a playerjoin message
@@ -1941,7 +2144,7 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 			if( KickedPlayer )
 			{
 				KickedPlayer->SetDeleteMe( true );
-				KickedPlayer->SetLeftReason( m_GHost->m_Language->WasKickedForOwnerPlayer( joinPlayer->GetName( ) ) );
+				KickedPlayer->SetLeftReason( m_Language->WasKickedForOwnerPlayer( joinPlayer->GetName( ) ) );
 				KickedPlayer->SetLeftCode( PLAYERLEAVE_LOBBY );
 
 				// send a playerleave message immediately since it won't normally get sent until the player is deleted which is after we send a playerjoin message
@@ -1975,8 +2178,8 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 				if( Ban )
 				{
 					CONSOLE_Print( "[GAME: " + m_GameName + "] player [" + joinPlayer->GetName( ) + "|" + potential->GetExternalIPString( ) + "] is using a banned name" );
-					SendAllChat( m_GHost->m_Language->HasBannedName( joinPlayer->GetName( ) ) );
-					SendAllChat( m_GHost->m_Language->UserWasBannedOnByBecause( Ban->GetServer( ), Ban->GetName( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
+					SendAllChat( m_Language->HasBannedName( joinPlayer->GetName( ) ) );
+					SendAllChat( m_Language->UserWasBannedOnByBecause( Ban->GetServer( ), Ban->GetName( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
 					break;
 				}
 			}
@@ -1986,8 +2189,8 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 			if( Ban )
 			{
 				CONSOLE_Print( "[GAME: " + m_GameName + "] player [" + joinPlayer->GetName( ) + "|" + potential->GetExternalIPString( ) + "] is using a banned IP address" );
-				SendAllChat( m_GHost->m_Language->HasBannedIP( joinPlayer->GetName( ), potential->GetExternalIPString( ), Ban->GetName( ) ) );
-				SendAllChat( m_GHost->m_Language->UserWasBannedOnByBecause( Ban->GetServer( ), Ban->GetName( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
+				SendAllChat( m_Language->HasBannedIP( joinPlayer->GetName( ), potential->GetExternalIPString( ), Ban->GetName( ) ) );
+				SendAllChat( m_Language->UserWasBannedOnByBecause( Ban->GetServer( ), Ban->GetName( ), Ban->GetDate( ), Ban->GetAdmin( ), Ban->GetReason( ) ) );
 				break;
 			}
 		}
@@ -2004,7 +2207,15 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 	// we also have to be careful to not modify the m_Potentials vector since we're currently looping through it
 	CONSOLE_Print( "[GAME: " + m_GameName + "] player [" + joinPlayer->GetName( ) + "|" + potential->GetExternalIPString( ) + "] joined the game" );
 	CGamePlayer *Player = new CGamePlayer( potential, m_SaveGame ? EnforcePID : GetNewPID( ), JoinedRealm, joinPlayer->GetName( ), joinPlayer->GetInternalIP( ), Reserved );
-        m_PairedGetPlayerIds.push_back(m_GHost->m_DB->ThreadedGetPlayerId(Player->GetName()));
+
+	// the player id is handled in the next update either way so the welcome message is sent after the player has joined
+
+	uint32_t CachedId;
+
+	if( m_GHost->m_ProfileCache->GetPlayerID( Player->GetName( ), JoinedRealm, &CachedId ) )
+		m_CachedPlayerIds.push_back( CachedPlayerId( Player->GetName( ), CachedId ) );
+	else
+		m_PairedGetPlayerIds.push_back( m_GHost->m_DB->ThreadedGetPlayerId( Player->GetName( ) ) );
     
 	// consider LAN players to have already spoof checked since they can't
 	// since so many people have trouble with this feature we now use the JoinedRealm to determine LAN status
@@ -2113,7 +2324,7 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 			BYTEARRAY UniqueName = (*i)->GetUniqueName( );
 
 			if( (*i)->GetServer( ) == JoinedRealm )
-				SendChat( Player, m_GHost->m_Language->SpoofCheckByWhispering( string( UniqueName.begin( ), UniqueName.end( ) )  ) );
+				SendChat( Player, m_Language->SpoofCheckByWhispering( string( UniqueName.begin( ), UniqueName.end( ) )  ) );
 		}
 	}
 
@@ -2135,14 +2346,14 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 		}
 
 		if( !Others.empty( ) )
-			SendAllChat( m_GHost->m_Language->MultipleIPAddressUsageDetected( joinPlayer->GetName( ), Others ) );
+			SendAllChat( m_Language->MultipleIPAddressUsageDetected( joinPlayer->GetName( ), Others ) );
 	}
 
 	// abort the countdown if there was one in progress
 
 	if( m_CountDownStarted && !m_GameLoading && !m_GameLoaded )
 	{
-		SendAllChat( m_GHost->m_Language->CountDownAborted( ) );
+		SendAllChat( m_Language->CountDownAborted( ) );
 		m_CountDownStarted = false;
 	}
 
@@ -2150,7 +2361,7 @@ void CBaseGame :: EventPlayerJoined( CPotentialPlayer *potential, CIncomingJoinP
 
 	if( m_GHost->m_AutoLock && !m_Locked && IsOwner( joinPlayer->GetName( ) ) )
 	{
-		SendAllChat( m_GHost->m_Language->GameLocked( ) );
+		SendAllChat( m_Language->GameLocked( ) );
 		m_Locked = true;
 	}
         
@@ -2191,7 +2402,7 @@ void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CInco
 	if( GetPlayerFromName( joinPlayer->GetName( ), false ) )
 	{
 		CONSOLE_Print( "[GAME: " + m_GameName + "] player [" + joinPlayer->GetName( ) + "|" + potential->GetExternalIPString( ) + "] is trying to join the game but that name is already taken" );
-		// SendAllChat( m_GHost->m_Language->TryingToJoinTheGameButTaken( joinPlayer->GetName( ) ) );
+		// SendAllChat( m_Language->TryingToJoinTheGameButTaken( joinPlayer->GetName( ) ) );
 		potential->Send( m_Protocol->SEND_W3GS_REJECTJOIN( REJECTJOIN_FULL ) );
 		potential->SetDeleteMe( true );
 		return;
@@ -2303,9 +2514,9 @@ void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CInco
 			FurthestPlayer->SetDeleteMe( true );
 
 			if( FurthestPlayer->GetScore( ) < -99999.0 )
-				FurthestPlayer->SetLeftReason( m_GHost->m_Language->WasKickedForHavingFurthestScore( "N/A", UTIL_ToString( AverageScore, 2 ) ) );
+				FurthestPlayer->SetLeftReason( m_Language->WasKickedForHavingFurthestScore( "N/A", UTIL_ToString( AverageScore, 2 ) ) );
 			else
-				FurthestPlayer->SetLeftReason( m_GHost->m_Language->WasKickedForHavingFurthestScore( UTIL_ToString( FurthestPlayer->GetScore( ), 2 ), UTIL_ToString( AverageScore, 2 ) ) );
+				FurthestPlayer->SetLeftReason( m_Language->WasKickedForHavingFurthestScore( UTIL_ToString( FurthestPlayer->GetScore( ), 2 ), UTIL_ToString( AverageScore, 2 ) ) );
 
 			FurthestPlayer->SetLeftCode( PLAYERLEAVE_LOBBY );
 
@@ -2316,9 +2527,9 @@ void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CInco
 			FurthestPlayer->SetLeftMessageSent( true );
 
 			if( FurthestPlayer->GetScore( ) < -99999.0 )
-				SendAllChat( m_GHost->m_Language->PlayerWasKickedForFurthestScore( FurthestPlayer->GetName( ), "N/A", UTIL_ToString( AverageScore, 2 ) ) );
+				SendAllChat( m_Language->PlayerWasKickedForFurthestScore( FurthestPlayer->GetName( ), "N/A", UTIL_ToString( AverageScore, 2 ) ) );
 			else
-				SendAllChat( m_GHost->m_Language->PlayerWasKickedForFurthestScore( FurthestPlayer->GetName( ), UTIL_ToString( FurthestPlayer->GetScore( ), 2 ), UTIL_ToString( AverageScore, 2 ) ) );
+				SendAllChat( m_Language->PlayerWasKickedForFurthestScore( FurthestPlayer->GetName( ), UTIL_ToString( FurthestPlayer->GetScore( ), 2 ), UTIL_ToString( AverageScore, 2 ) ) );
 		}
 		else if( m_GHost->m_MatchMakingMethod == 2 )
 		{
@@ -2363,9 +2574,9 @@ void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CInco
 			LowestPlayer->SetDeleteMe( true );
 
 			if( LowestPlayer->GetScore( ) < -99999.0 )
-				LowestPlayer->SetLeftReason( m_GHost->m_Language->WasKickedForHavingLowestScore( "N/A" ) );
+				LowestPlayer->SetLeftReason( m_Language->WasKickedForHavingLowestScore( "N/A" ) );
 			else
-				LowestPlayer->SetLeftReason( m_GHost->m_Language->WasKickedForHavingLowestScore( UTIL_ToString( LowestPlayer->GetScore( ), 2 ) ) );
+				LowestPlayer->SetLeftReason( m_Language->WasKickedForHavingLowestScore( UTIL_ToString( LowestPlayer->GetScore( ), 2 ) ) );
 
 			LowestPlayer->SetLeftCode( PLAYERLEAVE_LOBBY );
 
@@ -2376,9 +2587,9 @@ void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CInco
 			LowestPlayer->SetLeftMessageSent( true );
 
 			if( LowestPlayer->GetScore( ) < -99999.0 )
-				SendAllChat( m_GHost->m_Language->PlayerWasKickedForLowestScore( LowestPlayer->GetName( ), "N/A" ) );
+				SendAllChat( m_Language->PlayerWasKickedForLowestScore( LowestPlayer->GetName( ), "N/A" ) );
 			else
-				SendAllChat( m_GHost->m_Language->PlayerWasKickedForLowestScore( LowestPlayer->GetName( ), UTIL_ToString( LowestPlayer->GetScore( ), 2 ) ) );
+				SendAllChat( m_Language->PlayerWasKickedForLowestScore( LowestPlayer->GetName( ), UTIL_ToString( LowestPlayer->GetScore( ), 2 ) ) );
 		}
 	}
 
@@ -2498,14 +2709,14 @@ void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CInco
 			BYTEARRAY UniqueName = (*i)->GetUniqueName( );
 
 			if( (*i)->GetServer( ) == JoinedRealm )
-				SendChat( Player, m_GHost->m_Language->SpoofCheckByWhispering( string( UniqueName.begin( ), UniqueName.end( ) )  ) );
+				SendChat( Player, m_Language->SpoofCheckByWhispering( string( UniqueName.begin( ), UniqueName.end( ) )  ) );
 		}
 	}
 
 	if( score < -99999.0 )
-		SendAllChat( m_GHost->m_Language->PlayerHasScore( joinPlayer->GetName( ), "N/A" ) );
+		SendAllChat( m_Language->PlayerHasScore( joinPlayer->GetName( ), "N/A" ) );
 	else
-		SendAllChat( m_GHost->m_Language->PlayerHasScore( joinPlayer->GetName( ), UTIL_ToString( score, 2 ) ) );
+		SendAllChat( m_Language->PlayerHasScore( joinPlayer->GetName( ), UTIL_ToString( score, 2 ) ) );
 
 	uint32_t PlayersScored = 0;
 	uint32_t PlayersNotScored = 0;
@@ -2537,7 +2748,7 @@ void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CInco
 	}
 
 	double Spread = MaxScore - MinScore;
-	SendAllChat( m_GHost->m_Language->RatedPlayersSpread( UTIL_ToString( PlayersScored ), UTIL_ToString( PlayersScored + PlayersNotScored ), UTIL_ToString( (uint32_t)Spread ) ) );
+	SendAllChat( m_Language->RatedPlayersSpread( UTIL_ToString( PlayersScored ), UTIL_ToString( PlayersScored + PlayersNotScored ), UTIL_ToString( (uint32_t)Spread ) ) );
 
 	// check for multiple IP usage
 
@@ -2557,14 +2768,14 @@ void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CInco
 		}
 
 		if( !Others.empty( ) )
-			SendAllChat( m_GHost->m_Language->MultipleIPAddressUsageDetected( joinPlayer->GetName( ), Others ) );
+			SendAllChat( m_Language->MultipleIPAddressUsageDetected( joinPlayer->GetName( ), Others ) );
 	}
 
 	// abort the countdown if there was one in progress
 
 	if( m_CountDownStarted && !m_GameLoading && !m_GameLoaded )
 	{
-		SendAllChat( m_GHost->m_Language->CountDownAborted( ) );
+		SendAllChat( m_Language->CountDownAborted( ) );
 		m_CountDownStarted = false;
 	}
 
@@ -2572,7 +2783,7 @@ void CBaseGame :: EventPlayerJoinedWithScore( CPotentialPlayer *potential, CInco
 
 	if( m_GHost->m_AutoLock && !m_Locked && IsOwner( joinPlayer->GetName( ) ) )
 	{
-		SendAllChat( m_GHost->m_Language->GameLocked( ) );
+		SendAllChat( m_Language->GameLocked( ) );
 		m_Locked = true;
 	}
 
@@ -2589,9 +2800,9 @@ void CBaseGame :: EventPlayerLeft( CGamePlayer *player, uint32_t reason )
 	player->SetDeleteMe( true );
 
 	if( reason == PLAYERLEAVE_GPROXY )
-		player->SetLeftReason( m_GHost->m_Language->WasUnrecoverablyDroppedFromGProxy( ) );
+		player->SetLeftReason( m_Language->WasUnrecoverablyDroppedFromGProxy( ) );
 	else
-		player->SetLeftReason( m_GHost->m_Language->HasLeftVoluntarily( ) );
+		player->SetLeftReason( m_Language->HasLeftVoluntarily( ) );
 
 	player->SetLeftCode( PLAYERLEAVE_LOST );
 
@@ -2645,11 +2856,11 @@ void CBaseGame :: EventPlayerLoaded( CGamePlayer *player )
 		for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
 		{
 			if( *i != player && (*i)->GetFinishedLoading( ) )
-				SendChat( *i, m_GHost->m_Language->PlayerFinishedLoading( player->GetName( ) ) );
+				SendChat( *i, m_Language->PlayerFinishedLoading( player->GetName( ) ) );
 		}
 
 		if( !FinishedLoading )
-			SendChat( player, m_GHost->m_Language->PleaseWaitPlayersStillLoading( ) );
+			SendChat( player, m_Language->PleaseWaitPlayersStillLoading( ) );
 	}
 	else
 		SendAll( m_Protocol->SEND_W3GS_GAMELOADED_OTHERS( player->GetPID( ) ) );
@@ -2664,7 +2875,7 @@ void CBaseGame :: EventPlayerAction( CGamePlayer *player, CIncomingAction *actio
 	if( !action->GetAction( )->empty( ) && (*action->GetAction( ))[0] == 6 )
 	{
 		CONSOLE_Print( "[GAME: " + m_GameName + "] player [" + player->GetName( ) + "] is saving the game" );
-		SendAllChat( m_GHost->m_Language->PlayerIsSavingTheGame( player->GetName( ) ) );
+		SendAllChat( m_Language->PlayerIsSavingTheGame( player->GetName( ) ) );
 	}
 }
 
@@ -2705,7 +2916,7 @@ void CBaseGame :: EventPlayerKeepAlive( CGamePlayer *player, uint32_t checkSum )
 		if( !(*i)->GetDeleteMe( ) && (*i)->GetCheckSums( )->front( ) != FirstCheckSum )
 		{
 			CONSOLE_Print( "[GAME: " + m_GameName + "] desync detected" );
-			SendAllChat( m_GHost->m_Language->DesyncDetected( ) );
+			SendAllChat( m_Language->DesyncDetected( ) );
 
 			// try to figure out who desynced
 			// this is complicated by the fact that we don't know what the correct game state is so we let the players vote
@@ -2748,7 +2959,7 @@ void CBaseGame :: EventPlayerKeepAlive( CGamePlayer *player, uint32_t checkSum )
 					}
 				}
 
-				SendAllChat( m_GHost->m_Language->PlayersInGameState( UTIL_ToString( StateNumber ), Players ) );
+				SendAllChat( m_Language->PlayersInGameState( UTIL_ToString( StateNumber ), Players ) );
 				StateNumber++;
 			}
 
@@ -2764,7 +2975,7 @@ void CBaseGame :: EventPlayerKeepAlive( CGamePlayer *player, uint32_t checkSum )
 				// todotodo: it would be possible to split the game at this point and create a "new" game for each game state
 
 				CONSOLE_Print( "[GAME: " + m_GameName + "] can't kick desynced players because there is a tie, kicking all players instead" );
-				StopPlayers( m_GHost->m_Language->WasDroppedDesync( ) );
+				StopPlayers( m_Language->WasDroppedDesync( ) );
 				AddToReplay = false;
 			}
 			else
@@ -2787,7 +2998,7 @@ void CBaseGame :: EventPlayerKeepAlive( CGamePlayer *player, uint32_t checkSum )
 							if( Player )
 							{
 								Player->SetDeleteMe( true );
-								Player->SetLeftReason( m_GHost->m_Language->WasDroppedDesync( ) );
+								Player->SetLeftReason( m_Language->WasDroppedDesync( ) );
 								Player->SetLeftCode( PLAYERLEAVE_LOST );
 							}
 						}
@@ -2887,7 +3098,7 @@ void CBaseGame :: EventPlayerChatToHost( CGamePlayer *player, CIncomingChatPlaye
 			string Message = chatPlayer->GetMessage( );
 
 			if( Message == "?trigger" )
-				SendChat( player, m_GHost->m_Language->CommandTrigger( string( 1, m_GHost->m_CommandTrigger ) ) );
+				SendChat( player, m_Language->CommandTrigger( string( 1, m_GHost->m_CommandTrigger ) ) );
 			else if( !Message.empty( ) && Message[0] == m_GHost->m_CommandTrigger )
 			{
 				// extract the command trigger, the command, and the payload
@@ -3081,7 +3292,7 @@ void CBaseGame :: EventPlayerDropRequest( CGamePlayer *player )
 	if( m_Lagging )
 	{
 		CONSOLE_Print( "[GAME: " + m_GameName + "] player [" + player->GetName( ) + "] voted to drop laggers" );
-		SendAllChat( m_GHost->m_Language->PlayerVotedToDropLaggers( player->GetName( ) ) );
+		SendAllChat( m_Language->PlayerVotedToDropLaggers( player->GetName( ) ) );
 
 		// check if at least half the players voted to drop
 
@@ -3094,7 +3305,7 @@ void CBaseGame :: EventPlayerDropRequest( CGamePlayer *player )
 		}
 
 		if( (float)Votes / m_Players.size( ) > 0.49 )
-			StopLaggers( m_GHost->m_Language->LaggedOutDroppedByVote( ) );
+			StopLaggers( m_Language->LaggedOutDroppedByVote( ) );
 	}
 }
 
@@ -3113,9 +3324,7 @@ void CBaseGame :: EventPlayerMapSize( CGamePlayer *player, CIncomingMapSize *map
 
 		if( m_GHost->m_AllowDownloads != 0 )
 		{
-			string *MapData = m_Map->GetMapData( );
-
-			if( !MapData->empty( ) )
+			if( m_Map->GetMapDataSize( ) > 0 )
 			{
 				if( m_GHost->m_AllowDownloads == 1 || ( m_GHost->m_AllowDownloads == 2 && player->GetDownloadAllowed( ) ) )
 				{
@@ -3157,13 +3366,17 @@ void CBaseGame :: EventPlayerMapSize( CGamePlayer *player, CIncomingMapSize *map
 			float Seconds = (float)( GetTicks( ) - player->GetStartedDownloadingTicks( ) ) / 1000;
 			float Rate = (float)MapSize / 1024 / Seconds;
 			CONSOLE_Print( "[GAME: " + m_GameName + "] map download finished for player [" + player->GetName( ) + "] in " + UTIL_ToString( Seconds, 1 ) + " seconds" );
-			SendAllChat( m_GHost->m_Language->PlayerDownloadedTheMap( player->GetName( ), UTIL_ToString( Seconds, 1 ), UTIL_ToString( Rate, 1 ) ) );
+			SendAllChat( m_Language->PlayerDownloadedTheMap( player->GetName( ), UTIL_ToString( Seconds, 1 ), UTIL_ToString( Rate, 1 ) ) );
 			player->SetDownloadFinished( true );
 			player->SetFinishedDownloadingTime( GetTime( ) );
+			m_MapDownloads->Add( 1 );
+
+			if( Seconds > 0 )
+				m_MapDownloadRate->Observe( (uint64_t)Rate );
 
 			// add to database
 
-			m_GHost->m_Callables.push_back( m_GHost->m_DB->ThreadedDownloadAdd( m_Map->GetMapPath( ), MapSize, player->GetName( ), player->GetExternalIPString( ), player->GetSpoofed( ) ? 1 : 0, player->GetSpoofedRealm( ), GetTicks( ) - player->GetStartedDownloadingTicks( ) ) );
+			m_GHost->OrphanCallable( m_GHost->m_DB->ThreadedDownloadAdd( m_Map->GetMapPath( ), MapSize, player->GetName( ), player->GetExternalIPString( ), player->GetSpoofed( ) ? 1 : 0, player->GetSpoofedRealm( ), GetTicks( ) - player->GetStartedDownloadingTicks( ) ) );
 		}
 	}
 
@@ -3201,7 +3414,7 @@ void CBaseGame :: EventPlayerPongToHost( CGamePlayer *player, uint32_t pong )
 	{
 		// send a chat message because we don't normally do so when a player leaves the lobby
 
-		SendAllChat( m_GHost->m_Language->AutokickingPlayerForExcessivePing( player->GetName( ), UTIL_ToString( player->GetPing( m_GHost->m_LCPings ) ) ) );
+		SendAllChat( m_Language->AutokickingPlayerForExcessivePing( player->GetName( ), UTIL_ToString( player->GetPing( m_GHost->m_LCPings ) ) ) );
 		player->SetDeleteMe( true );
 		player->SetLeftReason( "was autokicked for excessive ping of " + UTIL_ToString( player->GetPing( m_GHost->m_LCPings ) ) );
 		player->SetLeftCode( PLAYERLEAVE_LOBBY );
@@ -3217,7 +3430,7 @@ void CBaseGame :: EventGameRefreshed( string server )
 		// but since we unqueue game refreshes when rehosting, the only way this can happen is due to network delay
 		// it's a risk we're willing to take but can result in a false positive here
 
-		SendAllChat( m_GHost->m_Language->RehostWasSuccessful( ) );
+		SendAllChat( m_Language->RehostWasSuccessful( ) );
 		m_RefreshRehosted = false;
 	}
 }
@@ -3426,6 +3639,11 @@ void CBaseGame :: EventGameLoaded( )
 {
 	CONSOLE_Print( "[GAME: " + m_GameName + "] finished loading with " + UTIL_ToString( GetNumHumanPlayers( ) ) + " players" );
 
+	// the replay header can't grow anymore so the replay can start compressing its data as the game goes on
+
+	if( m_Replay )
+		m_Replay->StartStreaming( m_GameName, m_StatString );
+
 	// send shortest, longest, and personal load times to each player
 
 	CGamePlayer *Shortest = NULL;
@@ -3442,12 +3660,12 @@ void CBaseGame :: EventGameLoaded( )
 
 	if( Shortest && Longest )
 	{
-		SendAllChat( m_GHost->m_Language->ShortestLoadByPlayer( Shortest->GetName( ), UTIL_ToString( (float)( Shortest->GetFinishedLoadingTicks( ) - m_StartedLoadingTicks ) / 1000, 2 ) ) );
-		SendAllChat( m_GHost->m_Language->LongestLoadByPlayer( Longest->GetName( ), UTIL_ToString( (float)( Longest->GetFinishedLoadingTicks( ) - m_StartedLoadingTicks ) / 1000, 2 ) ) );
+		SendAllChat( m_Language->ShortestLoadByPlayer( Shortest->GetName( ), UTIL_ToString( (float)( Shortest->GetFinishedLoadingTicks( ) - m_StartedLoadingTicks ) / 1000, 2 ) ) );
+		SendAllChat( m_Language->LongestLoadByPlayer( Longest->GetName( ), UTIL_ToString( (float)( Longest->GetFinishedLoadingTicks( ) - m_StartedLoadingTicks ) / 1000, 2 ) ) );
 	}
 
 	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
-		SendChat( *i, m_GHost->m_Language->YourLoadingTimeWas( UTIL_ToString( (float)( (*i)->GetFinishedLoadingTicks( ) - m_StartedLoadingTicks ) / 1000, 2 ) ) );
+		SendChat( *i, m_Language->YourLoadingTimeWas( UTIL_ToString( (float)( (*i)->GetFinishedLoadingTicks( ) - m_StartedLoadingTicks ) / 1000, 2 ) ) );
 
 	// read from gameloaded if available
 
@@ -4051,93 +4269,6 @@ void CBaseGame :: ShuffleSlots( )
 	SendAllSlotInfo( );
 }
 
-vector<unsigned char> CBaseGame :: BalanceSlotsRecursive( vector<unsigned char> PlayerIDs, unsigned char *TeamSizes, double *PlayerScores, unsigned char StartTeam )
-{
-	// take a brute force approach to finding the best balance by iterating through every possible combination of players
-	// 1.) since the number of teams is arbitrary this algorithm must be recursive
-	// 2.) on the first recursion step every possible combination of players into two "teams" is checked, where the first team is the correct size and the second team contains everyone else
-	// 3.) on the next recursion step every possible combination of the remaining players into two more "teams" is checked, continuing until all the actual teams are accounted for
-	// 4.) for every possible combination, check the largest difference in total scores between any two actual teams
-	// 5.) minimize this value by choosing the combination of players with the smallest difference
-
-	vector<unsigned char> BestOrdering = PlayerIDs;
-	double BestDifference = -1.0;
-
-	for( unsigned char i = StartTeam; i < 12; i++ )
-	{
-		if( TeamSizes[i] > 0 )
-		{
-			unsigned char Mid = TeamSizes[i];
-
-			// the base case where only one actual team worth of players was passed to this function is handled by the behaviour of next_combination
-			// in this case PlayerIDs.begin( ) + Mid will actually be equal to PlayerIDs.end( ) and next_combination will return false
-
-			while( next_combination( PlayerIDs.begin( ), PlayerIDs.begin( ) + Mid, PlayerIDs.end( ) ) )
-			{
-				// we're splitting the players into every possible combination of two "teams" based on the midpoint Mid
-				// the first (left) team contains the correct number of players but the second (right) "team" might or might not
-				// for example, it could contain one, two, or more actual teams worth of players
-				// so recurse using the second "team" as the full set of players to perform the balancing on
-
-				vector<unsigned char> BestSubOrdering = BalanceSlotsRecursive( vector<unsigned char>( PlayerIDs.begin( ) + Mid, PlayerIDs.end( ) ), TeamSizes, PlayerScores, i + 1 );
-
-				// BestSubOrdering now contains the best ordering of all the remaining players (the "right team") given this particular combination of players into two "teams"
-				// in order to calculate the largest difference in total scores we need to recombine the subordering with the first team
-
-				vector<unsigned char> TestOrdering = vector<unsigned char>( PlayerIDs.begin( ), PlayerIDs.begin( ) + Mid );
-				TestOrdering.insert( TestOrdering.end( ), BestSubOrdering.begin( ), BestSubOrdering.end( ) );
-
-				// now calculate the team scores for all the teams that we know about (e.g. on subsequent recursion steps this will NOT be every possible team)
-
-				vector<unsigned char> :: iterator CurrentPID = TestOrdering.begin( );
-				double TeamScores[12];
-
-				for( unsigned char j = StartTeam; j < 12; j++ )
-				{
-					TeamScores[j] = 0.0;
-
-					for( unsigned char k = 0; k < TeamSizes[j]; k++ )
-					{
-						TeamScores[j] += PlayerScores[*CurrentPID];
-						CurrentPID++;
-					}
-				}
-
-				// find the largest difference in total scores between any two teams
-
-				double LargestDifference = 0.0;
-
-				for( unsigned char j = StartTeam; j < 12; j++ )
-				{
-					if( TeamSizes[j] > 0 )
-					{
-						for( unsigned char k = j + 1; k < 12; k++ )
-						{
-							if( TeamSizes[k] > 0 )
-							{
-								double Difference = abs( TeamScores[j] - TeamScores[k] );
-
-								if( Difference > LargestDifference )
-									LargestDifference = Difference;
-							}
-						}
-					}
-				}
-
-				// and minimize it
-
-				if( BestDifference < 0.0 || LargestDifference < BestDifference )
-				{
-					BestOrdering = TestOrdering;
-					BestDifference = LargestDifference;
-				}
-			}
-		}
-	}
-
-	return BestOrdering;
-}
-
 void CBaseGame :: BalanceSlots( )
 {
 	if( !( m_Map->GetMapOptions( ) & MAPOPT_FIXEDPLAYERSETTINGS ) )
@@ -4186,49 +4317,21 @@ void CBaseGame :: BalanceSlots( )
 	sort( PlayerIDs.begin( ), PlayerIDs.end( ) );
 
 	// balancing the teams is a variation of the bin packing problem which is NP
-	// we can have up to 12 players and/or teams so the scope of the problem is sometimes small enough to process quickly
-	// let's try to figure out roughly how much work this is going to take
-	// examples:
-	//  2 teams of 4 =     70 ~    5ms *** ok
-	//  2 teams of 5 =    252 ~    5ms *** ok
-	//  2 teams of 6 =    924 ~   20ms *** ok
-	//  3 teams of 2 =     90 ~    5ms *** ok
-	//  3 teams of 3 =   1680 ~   25ms *** ok
-	//  3 teams of 4 =  34650 ~  250ms *** will cause a lag spike
-	//  4 teams of 2 =   2520 ~   30ms *** ok
-	//  4 teams of 3 = 369600 ~ 3500ms *** unacceptable
-
-	uint32_t AlgorithmCost = 0;
-	uint32_t PlayersLeft = PlayerIDs.size( );
+	// we can have up to 12 players and/or teams, the balancer prunes most of the possible combinations but it still gives up after bot_balancetimelimit milliseconds
+	// in that case we use the best combination it found so far which is never worse than putting the strongest remaining player on the weakest team
 
-	for( unsigned char i = 0; i < 12; i++ )
-	{
-		if( TeamSizes[i] > 0 )
-		{
-			if( AlgorithmCost == 0 )
-				AlgorithmCost = nCr( PlayersLeft, TeamSizes[i] );
-			else
-				AlgorithmCost *= nCr( PlayersLeft, TeamSizes[i] );
-
-			PlayersLeft -= TeamSizes[i];
-		}
-	}
+	uint32_t StartTicks = GetTicks( );
+	vector<unsigned char> BestOrdering = m_GHost->m_TeamBalancer->Balance( PlayerIDs, TeamSizes, PlayerScores );
+	uint32_t EndTicks = GetTicks( );
 
-	if( AlgorithmCost > 40000 )
+	if( BestOrdering.size( ) != PlayerIDs.size( ) )
 	{
-		// the cost is too high, don't run the algorithm
-		// a possible alternative: stop after enough iterations and/or time has passed
-
-		CONSOLE_Print( "[GAME: " + m_GameName + "] shuffling slots instead of balancing - the algorithm is too slow (with a cost of " + UTIL_ToString( AlgorithmCost ) + ") for this team configuration" );
-		SendAllChat( m_GHost->m_Language->ShufflingPlayers( ) );
+		CONSOLE_Print( "[GAME: " + m_GameName + "] shuffling slots instead of balancing - the balancer returned an invalid ordering (this shouldn't happen)" );
+		SendAllChat( m_Language->ShufflingPlayers( ) );
 		ShuffleSlots( );
 		return;
 	}
 
-	uint32_t StartTicks = GetTicks( );
-	vector<unsigned char> BestOrdering = BalanceSlotsRecursive( PlayerIDs, TeamSizes, PlayerScores, 0 );
-	uint32_t EndTicks = GetTicks( );
-
 	// the BestOrdering assumes the teams are in slot order although this may not be the case
 	// so put the players on the correct teams regardless of slot order
 
@@ -4258,7 +4361,7 @@ void CBaseGame :: BalanceSlots( )
 			else
 			{
 				CONSOLE_Print( "[GAME: " + m_GameName + "] shuffling slots instead of balancing - the balancing algorithm tried to do an invalid swap (this shouldn't happen)" );
-				SendAllChat( m_GHost->m_Language->ShufflingPlayers( ) );
+				SendAllChat( m_Language->ShufflingPlayers( ) );
 				ShuffleSlots( );
 				return;
 			}
@@ -4268,8 +4371,11 @@ void CBaseGame :: BalanceSlots( )
 		}
 	}
 
-	CONSOLE_Print( "[GAME: " + m_GameName + "] balancing slots completed in " + UTIL_ToString( EndTicks - StartTicks ) + "ms (with a cost of " + UTIL_ToString( AlgorithmCost ) + ")" );
-	SendAllChat( m_GHost->m_Language->BalancingSlotsCompleted( ) );
+	if( m_GHost->m_TeamBalancer->GetTimedOut( ) )
+		CONSOLE_Print( "[GAME: " + m_GameName + "] balancing slots stopped after " + UTIL_ToString( EndTicks - StartTicks ) + "ms (" + UTIL_ToString( m_GHost->m_TeamBalancer->GetNodes( ) ) + " nodes searched), using the best combination found so far" );
+	else
+		CONSOLE_Print( "[GAME: " + m_GameName + "] balancing slots completed in " + UTIL_ToString( EndTicks - StartTicks ) + "ms (" + UTIL_ToString( m_GHost->m_TeamBalancer->GetNodes( ) ) + " nodes searched)" );
+	SendAllChat( m_Language->BalancingSlotsCompleted( ) );
 	SendAllSlotInfo( );
 
 	for( unsigned char i = 0; i < 12; i++ )
@@ -4294,7 +4400,7 @@ void CBaseGame :: BalanceSlots( )
 		}
 
 		if( TeamHasPlayers )
-			SendAllChat( m_GHost->m_Language->TeamCombinedScore( UTIL_ToString( i + 1 ), UTIL_ToString( TeamScore, 2 ) ) );
+			SendAllChat( m_Language->TeamCombinedScore( UTIL_ToString( i + 1 ), UTIL_ToString( TeamScore, 2 ) ) );
 	}
 }
 
@@ -4308,7 +4414,7 @@ void CBaseGame :: AddToSpoofed( string server, string name, bool sendMessage )
 		Player->SetSpoofed( true );
 
 		if( sendMessage )
-			SendAllChat( m_GHost->m_Language->SpoofCheckAcceptedFor( server, name ) );
+			SendAllChat( m_Language->SpoofCheckAcceptedFor( server, name ) );
 	}
 }
 
@@ -4397,7 +4503,7 @@ void CBaseGame :: StartCountDown( bool force )
 
 			if( m_HCLCommandString.size( ) > GetSlotsOccupied( ) )
 			{
-				SendAllChat( m_GHost->m_Language->TheHCLIsTooLongUseForceToStart( ) );
+				SendAllChat( m_Language->TheHCLIsTooLongUseForceToStart( ) );
 				return;
 			}
 
@@ -4422,7 +4528,7 @@ void CBaseGame :: StartCountDown( bool force )
 			}
 
 			if( !StillDownloading.empty( ) )
-				SendAllChat( m_GHost->m_Language->PlayersStillDownloading( StillDownloading ) );
+				SendAllChat( m_Language->PlayersStillDownloading( StillDownloading ) );
 
 			// check if everyone is spoof checked
 
@@ -4442,7 +4548,7 @@ void CBaseGame :: StartCountDown( bool force )
 				}
 
 				if( !NotSpoofChecked.empty( ) )
-					SendAllChat( m_GHost->m_Language->PlayersNotYetSpoofChecked( NotSpoofChecked ) );
+					SendAllChat( m_Language->PlayersNotYetSpoofChecked( NotSpoofChecked ) );
 			}
 
 			// check if everyone has been pinged enough (3 times) that the autokicker would have kicked them by now
@@ -4462,7 +4568,7 @@ void CBaseGame :: StartCountDown( bool force )
 			}
 
 			if( !NotPinged.empty( ) )
-				SendAllChat( m_GHost->m_Language->PlayersNotYetPinged( NotPinged ) );
+				SendAllChat( m_Language->PlayersNotYetPinged( NotPinged ) );
 
 			// if no problems found start the game
 
@@ -4509,7 +4615,7 @@ void CBaseGame :: StartCountDownAuto( bool requireSpoofChecks )
 
 		if( !StillDownloading.empty( ) )
 		{
-			SendAllChat( m_GHost->m_Language->PlayersStillDownloading( StillDownloading ) );
+			SendAllChat( m_Language->PlayersStillDownloading( StillDownloading ) );
 			return;
 		}
 
@@ -4531,7 +4637,7 @@ void CBaseGame :: StartCountDownAuto( bool requireSpoofChecks )
 			}
 
 			if( !NotSpoofChecked.empty( ) )
-				SendAllChat( m_GHost->m_Language->PlayersNotYetSpoofChecked( NotSpoofChecked ) );
+				SendAllChat( m_Language->PlayersNotYetSpoofChecked( NotSpoofChecked ) );
 		}
 
 		// check if everyone has been pinged enough (3 times) that the autokicker would have kicked them by now
@@ -4552,7 +4658,7 @@ void CBaseGame :: StartCountDownAuto( bool requireSpoofChecks )
 
 		if( !NotPinged.empty( ) )
 		{
-			SendAllChat( m_GHost->m_Language->PlayersNotYetPingedAutoStart( NotPinged ) );
+			SendAllChat( m_Language->PlayersNotYetPingedAutoStart( NotPinged ) );
 			return;
 		}
 
@@ -4660,17 +4766,50 @@ void CBaseGame :: DeleteFakePlayer( )
 
 
 
+uint32_t CBaseGame :: GetMapDownloadWindow( CGamePlayer *player )
+{
+	// the number of unacknowledged map parts a downloader may have in flight
+	// 100 parts (about 140 KB) per round trip is plenty for an average connection
+	// a player with a low ping empties the window long before the next download cycle so give them a bigger one (up to 400 parts at 25 ms and below)
+
+	uint32_t Ping = player->GetPing( m_GHost->m_LCPings );
+
+	if( player->GetNumPings( ) == 0 || Ping >= 100 )
+		return 100;
+
+	return 100 * 100 / max( Ping, (uint32_t)25 );
+}
+
 void CBaseGame :: DoGameUpdate(bool reset) {
+    // the row is only queued here, CGHost writes the rows of every game in one batch
+
+    GameListRow Row;
+    Row.HostCounter = m_GameId;
+    Row.Reset = reset;
+    Row.Lobby = 0;
+    Row.Duration = 0;
+    Row.Players = 0;
+    Row.Total = 0;
+
     if( !reset ) {
-        if( m_GameLoading || m_GameLoaded )
-	    
-            m_GameUpdates.push_back( PairedGameUpdate( string( ), m_GHost->m_DB->ThreadedGameUpdate( m_GameId, 0, "", m_GameTicks / 1000, m_GameName, m_OwnerName, m_CreatorName, "", m_Players.size( ), m_StartPlayers, GetPlayerListOfGame( ) ) ) );
-        else
-            m_GameUpdates.push_back( PairedGameUpdate( string( ), m_GHost->m_DB->ThreadedGameUpdate( m_GameId, 1, "", GetTime( ) - m_CreationTime, m_GameName, m_OwnerName, m_CreatorName, "", m_Players.size( ), ( GetSlotsOpen( ) + GetNumHumanPlayers( ) ), GetPlayerListOfGame( ) ) ) );
-     }
-     else
-	    m_GameUpdates.push_back( PairedGameUpdate( string( ), m_GHost->m_DB->ThreadedGameUpdate( m_GameId, 0, "", 0, "", "", "", "", 0, 0, GetPlayerListOfGame( ))));
+        Row.GameName = m_GameName;
+        Row.OwnerName = m_OwnerName;
+        Row.CreatorName = m_CreatorName;
+        Row.Players = m_Players.size( );
+        Row.PlayerList = GetPlayerListOfGame( );
+
+        if( m_GameLoading || m_GameLoaded ) {
+            Row.Duration = m_GameTicks / 1000;
+            Row.Total = m_StartPlayers;
+        }
+        else {
+            Row.Lobby = 1;
+            Row.Duration = GetTime( ) - m_CreationTime;
+            Row.Total = GetSlotsOpen( ) + GetNumHumanPlayers( );
+        }
+    }
 
+    RunOnMainThread( boost :: bind( &CGHost :: QueueGameListRow, m_GHost, Row ) );
     m_LastGameUpdateTime = GetTime( );
 }
 
@@ -4706,9 +4845,10 @@ bool CBaseGame :: IsRootAdmin( string username )
     bool IsRootAdmin = false;
     transform( username.begin( ), username.end( ), username.begin( ), (int(*)(int))tolower );
     
-    if(m_GHost->m_AdminList.find(username) != m_GHost->m_AdminList.end()) {
-        IsRootAdmin = m_GHost->m_AdminList[username] > 9;
-    }
+    map<string, uint32_t> :: const_iterator i = m_AdminList->find( username );
+
+    if( i != m_AdminList->end( ) )
+        IsRootAdmin = i->second > 9;
     
     return IsRootAdmin;
 }
@@ -4718,9 +4858,10 @@ bool CBaseGame :: IsAdmin( string username )
     bool IsAdmin = false;
     transform( username.begin( ), username.end( ), username.begin( ), (int(*)(int))tolower );
     
-    if(m_GHost->m_AdminList.find(username) != m_GHost->m_AdminList.end()) {
-        IsAdmin = m_GHost->m_AdminList[username] > 4;
-    }
+    map<string, uint32_t> :: const_iterator i = m_AdminList->find( username );
+
+    if( i != m_AdminList->end( ) )
+        IsAdmin = i->second > 4;
     
     return IsAdmin;
 }
@@ -4730,9 +4871,10 @@ bool CBaseGame :: IsPremium( string username )
     bool IsPremium = false;
     transform( username.begin( ), username.end( ), username.begin( ), (int(*)(int))tolower );
     
-    if(m_GHost->m_AdminList.find(username) != m_GHost->m_AdminList.end()) {
-        IsPremium = m_GHost->m_AdminList[username] > 2;
-    }
+    map<string, uint32_t> :: const_iterator i = m_AdminList->find( username );
+
+    if( i != m_AdminList->end( ) )
+        IsPremium = i->second > 2;
     
     return IsPremium;
 }
@@ -4872,49 +5014,95 @@ void CBaseGame :: ShowTeamScores( CGamePlayer *player )
 
 
 
-CDBBan *CBaseGame :: IsBannedName( string name )
+void CBaseGame :: EventPlayerIdFound( CGamePlayer *player, uint32_t id )
 {
-    transform( name.begin( ), name.end( ), name.begin( ), ::tolower );
+	if( id != 0 )
+	{
+		SendChat( player, "Welcome back " + player->GetName( ) + "! Enjoy your stay and good luck for your game :-)" );
+		player->SetPlayerId( id );
 
-    for( vector<CDBBan *> :: iterator i = m_GHost->m_BanList.begin( ); i != m_GHost->m_BanList.end( ); ++i )
-    {
-        string bannedName = (*i)->GetName( );
-        transform( bannedName.begin( ), bannedName.end( ), bannedName.begin( ), ::tolower );
-        if( bannedName == name )
-            return *i;
-    }
+		if( m_GHost->m_ShowStatsOnJoin )
+			RequestPlayerStats( player, m_GHost->m_AliasId );
+
+		double Score;
 
-    return NULL;
+		if( m_GHost->m_ProfileCache->GetScore( player->GetName( ), player->GetJoinedRealm( ), m_GHost->m_AliasId, &Score ) )
+			player->SetScore( Score );
+		else
+			m_PairedGetPlayerScores.push_back( m_GHost->m_DB->ThreadedGetPlayerScore( m_GHost->m_AliasId, id ) );
+	}
+	else
+	{
+		SendChat( player, "Hey you are new here! Please stand by, we shortly create an unique identifier for your." );
+		m_PairedCreatePlayerIds.push_back( m_GHost->m_DB->ThreadedCreatePlayerId( player->GetName( ), player->GetExternalIPString( ), player->GetJoinedRealm( ) ) );
+	}
 }
 
-CDBBan *CBaseGame :: IsBannedIP( string ip )
+void CBaseGame :: RequestPlayerStats( CGamePlayer *player, uint32_t aliasId )
 {
-    transform( ip.begin( ), ip.end( ), ip.begin( ), ::tolower ); //transform in case it's a hostname
-    for( vector<CDBBan *> :: iterator i = m_GHost->m_BanList.begin( ); i != m_GHost->m_BanList.end( ); ++i )
-    {
-        if( (*i)->GetIP( )[0] == ':' )
-        {
-            string BanIP = (*i)->GetIP( ).substr( 1 );
-            size_t len = BanIP.length( );
+	map<string, string> Stats;
 
-            if( ip.length( ) >= len && ip.substr( 0, len ) == BanIP )
-            {
-                return *i;
-            }
-            else if( BanIP.length( ) >= 3 && BanIP[0] == 'h' && ip.length( ) >= 3 && ip[0] == 'h' && ip.substr( 1 ).find( BanIP.substr( 1 ) ) != string::npos )
-            {
+	if( m_GHost->m_ProfileCache->GetStats( player->GetName( ), player->GetJoinedRealm( ), aliasId, &Stats ) )
+		ShowPlayerStats( player, aliasId, Stats );
+	else
+		m_PairedGPS.push_back( PairedGPS( player->GetName( ), m_GHost->m_DB->ThreadedGetPlayerStats( aliasId, player->GetPlayerId( ) ) ) );
+}
 
-                return *i;
-            }
-        }
+void CBaseGame :: ShowPlayerStats( CGamePlayer *player, uint32_t aliasId, map<string, string> stats )
+{
+	string StatsTemplate;
+	string AliasName;
+	map<uint32_t, string> :: iterator Template = m_GHost->m_StatsTemplates.find( aliasId );
+	map<uint32_t, string> :: iterator Alias = m_GHost->m_Aliases.find( aliasId );
 
-        if( (*i)->GetIP( ) == ip )
-        {
-            return *i;
-        }
-    }
+	if( Template != m_GHost->m_StatsTemplates.end( ) )
+		StatsTemplate = Template->second;
+
+	if( Alias != m_GHost->m_Aliases.end( ) )
+		AliasName = Alias->second;
+
+	for( map<string, string> :: iterator i = stats.begin( ); i != stats.end( ); i++ )
+		UTIL_Replace( StatsTemplate, "{" + i->first + "}", i->second );
+
+	if( stats.find( "VALUE_01" ) != stats.end( ) )
+		SendAllChat( StatsTemplate );
+	else
+		SendAllChat( player->GetName( ) + " has not played any " + AliasName + " yet." );
+}
 
-    return NULL;
+void CBaseGame :: PrefetchProfiles( )
+{
+	m_ProfilesPrefetched = true;
+	vector<uint32_t> PlayerIds;
+
+	for( vector<CGamePlayer *> :: iterator i = m_Players.begin( ); i != m_Players.end( ); i++ )
+	{
+		if( (*i)->GetDeleteMe( ) || (*i)->GetPlayerId( ) == 0 )
+			continue;
+
+		map<string, string> Stats;
+
+		if( !m_GHost->m_ProfileCache->GetStats( (*i)->GetName( ), (*i)->GetJoinedRealm( ), m_GHost->m_AliasId, &Stats ) )
+			PlayerIds.push_back( (*i)->GetPlayerId( ) );
+	}
+
+	if( PlayerIds.empty( ) )
+		return;
+
+	CCallableGetPlayerStatsBatch *Callable = m_GHost->m_DB->ThreadedGetPlayerStatsBatch( m_GHost->m_AliasId, PlayerIds );
+
+	if( Callable )
+		m_PlayerStatsPrefetches.push_back( Callable );
+}
+
+CDBBan *CBaseGame :: IsBannedName( string name )
+{
+    return m_GHost->m_BanIndex->FindName( name );
+}
+
+CDBBan *CBaseGame :: IsBannedIP( string ip )
+{
+    return m_GHost->m_BanIndex->FindIP( ip );
 }
 
 string CBaseGame :: GetLobbyTime( )
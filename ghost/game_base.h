@@ -24,11 +24,15 @@
 #include "gameslot.h"
 #include "ghostdb.h"
 
+#include <boost/thread/mutex.hpp>
+#include <boost/function.hpp>
+
 //
 // CBaseGame
 //
 
 class CTCPServer;
+class CTCPSocket;
 class CGameProtocol;
 class CPotentialPlayer;
 class CGamePlayer;
@@ -42,17 +46,37 @@ class CIncomingMapSize;
 class CCallableScoreCheck;
 class CCallableGetPlayerId;
 class CCallableCreatePlayerId;
-class CCallableGameUpdate;
 class CCallableGetPlayerScore;
 class CCallableGetPlayerStats;
+class CCallableGetPlayerStatsBatch;
+class CMetricCounter;
+class CMetricHistogram;
+class CTimer;
+class CGProxyLog;
+class CCommandPacket;
+class CLanguage;
+class CGameThread;
+class CTimerWheel;
+class CSocketPoller;
+template <class T> class CPool;
+
+// a game is updated when one of its sockets has work, when its next action packet is due, and at least this often (in microseconds)
+// everything else the game does on a timer (pings, refreshes, countdowns, timeouts, ...) is checked during these updates
+
+#define GAME_HOUSEKEEPING_INTERVAL		50000
+
+// the maximum number of recycled packets (and actions) each game keeps for reuse
+
+#define GAME_POOL_MAX_FREE				512
 
 typedef pair<string,CCallableGetPlayerStats *> PairedGPS;
-typedef pair<string,CCallableGameUpdate *> PairedGameUpdate;
+typedef pair<string,uint32_t> CachedPlayerId;
 
 class CBaseGame
 {
 public:
 	CGHost *m_GHost;
+	boost :: shared_ptr<CLanguage> m_Language;		// our snapshot of m_GHost->m_Language, replaced by the main thread through SetSnapshots
 
 protected:
 	CTCPServer *m_Socket;							// listening socket
@@ -61,11 +85,12 @@ protected:
 	vector<CPotentialPlayer *> m_Potentials;		// vector of potential players (connections that haven't sent a W3GS_REQJOIN packet yet)
 	vector<CGamePlayer *> m_Players;				// vector of players
 	vector<CCallableScoreCheck *> m_ScoreChecks;
-        vector<PairedGameUpdate> m_GameUpdates;
 	vector<CCallableGetPlayerId *> m_PairedGetPlayerIds;		// vector of paired threaded database get player ids in progress
 	vector<CCallableCreatePlayerId *> m_PairedCreatePlayerIds;		// vector of paired threaded database get player ids in progress
 	vector<CCallableGetPlayerScore *> m_PairedGetPlayerScores;		// vector of paired threaded database get player scores in progress
         vector<PairedGPS> m_PairedGPS;
+	vector<CachedPlayerId> m_CachedPlayerIds;		// player ids found in the profile cache on join, handled in the next update like the database ones
+	vector<CCallableGetPlayerStatsBatch *> m_PlayerStatsPrefetches;	// stats of the whole lobby being loaded into the profile cache
 	queue<CIncomingAction *> m_Actions;				// queue of actions to be sent
 	vector<string> m_Reserved;						// vector of player names with reserved slots (from the !hold command)
 	set<string> m_IgnoredNames;						// set of player names to NOT print ban messages for when joining because they've already been printed
@@ -77,6 +102,7 @@ protected:
 	CReplay *m_Replay;								// replay
 	bool m_Exiting;									// set to true and this class will be deleted next update
 	bool m_Saving;									// if we're currently saving game data to the database
+	bool m_ProfilesPrefetched;						// if we've prefetched the stats of the players since the lobby filled up
 	uint16_t m_HostPort;							// the port to host games on
 	unsigned char m_GameState;						// game state, public or private
 	unsigned char m_VirtualHostPID;					// virtual host's PID
@@ -102,8 +128,8 @@ protected:
 	uint32_t m_LastPingTime;						// GetTime when the last ping was sent
 	uint32_t m_LastRefreshTime;						// GetTime when the last game refresh was sent
 	uint32_t m_LastDownloadTicks;					// GetTicks when the last map download cycle was performed
-	uint32_t m_DownloadCounter;						// # of map bytes downloaded in the last second
-	uint32_t m_LastDownloadCounterResetTicks;		// GetTicks when the download counter was last reset
+	uint32_t m_DownloadRotation;					// the downloader to start with in the next map download cycle (modulo the number of downloaders)
+	uint32_t m_LastDownloadCounterResetTicks;		// GetTicks when the slot info was last checked for changes
 	uint32_t m_LastAnnounceTime;					// GetTime when the last announce message was sent
 	uint32_t m_AnnounceInterval;					// how many seconds to wait between sending the m_AnnounceMessage
 	uint32_t m_LastAutoStartTime;					// the last time we tried to auto start the game
@@ -113,14 +139,31 @@ protected:
 	uint32_t m_StartedLoadingTicks;					// GetTicks when the game started loading
 	uint32_t m_StartPlayers;						// number of players when the game started
 	uint32_t m_LastLagScreenResetTime;				// GetTime when the "lag" screen was last reset
-	uint32_t m_LastActionSentTicks;					// GetTicks when the last action packet was sent
-	uint32_t m_LastActionLateBy;					// the number of ticks we were late sending the last action packet by
+	uint64_t m_LastActionSentTicks;					// GetMicroTicks when the last action packet was sent
+	uint64_t m_LastActionLateBy;					// the number of microseconds we were late sending the last action packet by
 	uint32_t m_StartedLaggingTime;					// GetTime when the last lag screen started
 	uint32_t m_LastLagScreenTime;					// GetTime when the last lag screen was active (continuously updated)
 	uint32_t m_LastReservedSeen;					// GetTime when the last reserved player was seen in the lobby
 	uint32_t m_StartedKickVoteTime;					// GetTime when the kick vote was started
 	uint32_t m_GameOverTime;						// GetTime when the game was over
 	uint32_t m_LastPlayerLeaveTicks;				// GetTicks when the most recent player left the game
+	string m_MetricsLabels;							// the labels of this game's own metrics (removed when the game is deleted)
+	CMetricHistogram *m_ActionLateness;				// how late each action packet was sent
+	CMetricCounter *m_ActionOverruns;				// the number of action packets which were late by more than the latency
+	CMetricCounter *m_MapDownloadBytes;				// shared by every game
+	CMetricCounter *m_MapDownloads;					// shared by every game
+	CMetricHistogram *m_MapDownloadRate;			// shared by every game
+	CTimer *m_ActionTimer;							// due when the next action packet should be sent (only scheduled while the game is running)
+	CTimer *m_HousekeepingTimer;					// due when the game hasn't been updated for GAME_HOUSEKEEPING_INTERVAL
+	CGProxyLog *m_GProxyLog;						// the packets sent to GProxy++ players which haven't been acked yet
+	CPool<CCommandPacket> *m_PacketPool;			// the packets received from the game's players are recycled here after they're processed
+	CPool<CIncomingAction> *m_ActionPool;			// the actions received from the game's players are recycled here after they're sent and recorded
+	CMetricHistogram *m_TickAllocations;			// shared by every game
+	boost :: shared_ptr<const map<string, uint32_t> > m_AdminList;	// our snapshot of m_GHost->m_AdminList
+	CGameThread *m_GameThread;						// the game thread running us (NULL while we're running on the main thread), only written by the main thread
+	CTimerWheel *m_TimerWheel;						// the timer wheel of the thread running us
+	boost :: mutex m_DescriptionMutex;
+	string m_DescriptionSnapshot;					// GetDescription as of our last update on a game thread, for the main thread
 	double m_MinimumScore;							// the minimum allowed score for matchmaking mode
 	double m_MaximumScore;							// the maximum allowed score for matchmaking mode
 	bool m_SlotInfoChanged;							// if the slot info has changed and hasn't been sent to the players yet (optimization)
@@ -154,6 +197,9 @@ public:
 	virtual uint16_t GetHostPort( )					{ return m_HostPort; }
 	virtual unsigned char GetGameState( )			{ return m_GameState; }
 	virtual unsigned char GetGProxyEmptyActions( )	{ return m_GProxyEmptyActions; }
+	virtual CGProxyLog *GetGProxyLog( )				{ return m_GProxyLog; }
+	virtual CPool<CCommandPacket> *GetPacketPool( )	{ return m_PacketPool; }
+	virtual CPool<CIncomingAction> *GetActionPool( )	{ return m_ActionPool; }
 	virtual string GetGameName( )					{ return m_GameName; }
 	virtual string GetLastGameName( )				{ return m_LastGameName; }
 	virtual string GetVirtualHostName( )			{ return m_VirtualHostName; }
@@ -168,6 +214,8 @@ public:
 	virtual bool GetGameLoading( )					{ return m_GameLoading; }
 	virtual bool GetGameLoaded( )					{ return m_GameLoaded; }
 	virtual bool GetLagging( )						{ return m_Lagging; }
+	virtual CMap *GetMap( )							{ return m_Map; }
+	virtual CGameThread *GetGameThread( )			{ return m_GameThread; }
 
 	virtual void SetEnforceSlots( vector<CGameSlot> nEnforceSlots )		{ m_EnforceSlots = nEnforceSlots; }
 	virtual void SetEnforcePlayers( vector<PIDPlayer> nEnforcePlayers )	{ m_EnforcePlayers = nEnforcePlayers; }
@@ -177,25 +225,40 @@ public:
 	virtual void SetMaximumScore( double nMaximumScore )				{ m_MaximumScore = nMaximumScore; }
 	virtual void SetRefreshError( bool nRefreshError )					{ m_RefreshError = nRefreshError; }
 	virtual void SetMatchMaking( bool nMatchMaking )					{ m_MatchMaking = nMatchMaking; }
+	virtual void SetGameThread( CGameThread *nGameThread )				{ m_GameThread = nGameThread; }
 
-	virtual uint32_t GetNextTimedActionTicks( );
+	virtual bool GetUpdateDue( );
 	virtual uint32_t GetSlotsOccupied( );
 	virtual uint32_t GetSlotsOpen( );
 	virtual uint32_t GetNumPlayers( );
 	virtual uint32_t GetNumHumanPlayers( );
 	virtual string GetDescription( );
+	virtual string GetDescriptionSnapshot( );
+	virtual void UpdateDescriptionSnapshot( );
 
 	virtual void SetAnnounce( uint32_t interval, string message );
 
 	// processing functions
 
-	virtual unsigned int SetFD( void *fd, void *send_fd, int *nfds );
-	virtual bool Update( void *fd, void *send_fd );
-	virtual void UpdatePost( void *send_fd );
+	virtual bool Update( );
+	virtual void UpdatePost( );
+	virtual void UpdateTimers( );
+
+	// moving between threads (see CGameThread)
+	// RunOnMainThread is called by the thread running us, RunOnGameThread by the main thread, both run the task right away while we're running on the main thread
+
+	virtual void SetTimerWheel( CTimerWheel *nTimerWheel );
+	virtual void DetachSockets( );
+	virtual void AttachSockets( CSocketPoller *poller );
+	virtual void RunOnMainThread( boost :: function<void( )> task );
+	virtual void RunOnGameThread( boost :: function<void( )> task );
+	virtual void SetSnapshots( boost :: shared_ptr<CLanguage> language, boost :: shared_ptr<const map<string, uint32_t> > adminList );
+	virtual bool GProxyReconnect( CTCPSocket *socket, unsigned char PID, uint32_t reconnectKey, uint32_t lastPacket );
 
 	// generic functions to send packets to players
 
 	virtual void Send( CGamePlayer *player, BYTEARRAY data );
+	virtual void Send( CGamePlayer *player, SHAREDBYTEARRAY data );
 	virtual void Send( unsigned char PID, BYTEARRAY data );
 	virtual void Send( BYTEARRAY PIDs, BYTEARRAY data );
 	virtual void SendAll( BYTEARRAY data );
@@ -270,7 +333,6 @@ public:
 	virtual void OpenAllSlots( );
 	virtual void CloseAllSlots( );
 	virtual void ShuffleSlots( );
-	virtual vector<unsigned char> BalanceSlotsRecursive( vector<unsigned char> PlayerIDs, unsigned char *TeamSizes, double *PlayerScores, unsigned char StartTeam );
 	virtual void BalanceSlots( );
 	virtual void AddToSpoofed( string server, string name, bool sendMessage );
 	virtual void AddToReserved( string name );
@@ -289,11 +351,16 @@ public:
 	virtual void DeleteFakePlayer( );
     
         virtual void DoGameUpdate(bool reset);
+	virtual uint32_t GetMapDownloadWindow( CGamePlayer *player );
         virtual vector<PlayerOfPlayerList> GetPlayerListOfGame( );
         virtual bool IsRootAdmin( string username );
         virtual bool IsAdmin( string username );
         virtual bool IsPremium( string username );
         virtual void ShowTeamScores( CGamePlayer *player );
+	virtual void EventPlayerIdFound( CGamePlayer *player, uint32_t id );
+	virtual void RequestPlayerStats( CGamePlayer *player, uint32_t aliasId );
+	virtual void ShowPlayerStats( CGamePlayer *player, uint32_t aliasId, map<string, string> stats );
+	virtual void PrefetchProfiles( );
         CDBBan *IsBannedName( string name );
         CDBBan *IsBannedIP( string ip );
         string GetLobbyTime();
@@ -29,6 +29,11 @@
 #include "gameprotocol.h"
 #include "gpsprotocol.h"
 #include "game_base.h"
+#include "gproxylog.h"
+#include "metrics.h"
+#include "pool.h"
+
+#include <boost/bind.hpp>
 
 //
 // CPotentialPlayer
@@ -51,7 +56,7 @@ CPotentialPlayer :: ~CPotentialPlayer( )
 
 	while( !m_Packets.empty( ) )
 	{
-		delete m_Packets.front( );
+		m_Game->GetPacketPool( )->Put( m_Packets.front( ) );
 		m_Packets.pop( );
 	}
 
@@ -76,7 +81,7 @@ string CPotentialPlayer :: GetExternalIPString( )
 	return string( );
 }
 
-bool CPotentialPlayer :: Update( void *fd )
+bool CPotentialPlayer :: Update( )
 {
 	if( m_DeleteMe )
 		return true;
@@ -85,7 +90,7 @@ bool CPotentialPlayer :: Update( void *fd )
             return false;
         }
 
-	m_Socket->DoRecv( (fd_set *)fd );
+	m_Socket->DoRecv( );
 	ExtractPackets( );
 	ProcessPackets( );
 
@@ -101,45 +106,53 @@ void CPotentialPlayer :: ExtractPackets( )
 		return;
 
 	// extract as many packets as possible from the socket's receive buffer and put them in the m_Packets queue
+	// the buffer is scanned in place and only consumed once at the end so each received byte is copied exactly once (into its packet)
+	// the packets are recycled through the game's packet pool so their byte arrays are reused as well
 
-	string *RecvBuffer = m_Socket->GetBytes( );
-	BYTEARRAY Bytes = UTIL_CreateByteArray( (unsigned char *)RecvBuffer->c_str( ), RecvBuffer->size( ) );
+	unsigned char *Data = m_Socket->GetRecvData( );
+	uint32_t Size = m_Socket->GetRecvSize( );
+	uint32_t Offset = 0;
 
 	// a packet is at least 4 bytes so loop as long as the buffer contains 4 bytes
 
-	while( Bytes.size( ) >= 4 )
+	while( Size - Offset >= 4 )
 	{
-		if( Bytes[0] == W3GS_HEADER_CONSTANT || Bytes[0] == GPS_HEADER_CONSTANT )
+		unsigned char *Packet = Data + Offset;
+
+		if( Packet[0] == W3GS_HEADER_CONSTANT || Packet[0] == GPS_HEADER_CONSTANT )
 		{
 			// bytes 2 and 3 contain the length of the packet
 
-			uint16_t Length = UTIL_ByteArrayToUInt16( Bytes, false, 2 );
+			uint16_t Length = UTIL_ByteArrayToUInt16( Packet + 2, false );
 
 			if( Length >= 4 )
 			{
-				if( Bytes.size( ) >= Length )
+				if( Size - Offset >= Length )
 				{
-					m_Packets.push( new CCommandPacket( Bytes[0], Bytes[1], BYTEARRAY( Bytes.begin( ), Bytes.begin( ) + Length ) ) );
-					*RecvBuffer = RecvBuffer->substr( Length );
-					Bytes = BYTEARRAY( Bytes.begin( ) + Length, Bytes.end( ) );
+					CCommandPacket *NewPacket = m_Game->GetPacketPool( )->Get( );
+					NewPacket->Set( Packet[0], Packet[1], Packet, Length );
+					m_Packets.push( NewPacket );
+					Offset += Length;
 				}
 				else
-					return;
+					break;
 			}
 			else
 			{
 				m_Error = true;
 				m_ErrorString = "received invalid packet from player (bad length)";
-				return;
+				break;
 			}
 		}
 		else
 		{
 			m_Error = true;
 			m_ErrorString = "received invalid packet from player (bad header constant)";
-			return;
+			break;
 		}
 	}
+
+	m_Socket->ConsumeRecvBytes( Offset );
 }
 
 void CPotentialPlayer :: ProcessPackets( )
@@ -171,12 +184,12 @@ void CPotentialPlayer :: ProcessPackets( )
 				// EventPlayerJoined creates the new player, NULLs the socket, and sets the delete flag on this object so it'll be deleted shortly
 				// any unprocessed packets will be copied to the new CGamePlayer in the constructor or discarded if we get deleted because the game is full
 
-				delete Packet;
+				m_Game->GetPacketPool( )->Put( Packet );
 				return;
 			}
 		}
 
-		delete Packet;
+		m_Game->GetPacketPool( )->Put( Packet );
 	}
 }
 
@@ -186,6 +199,12 @@ void CPotentialPlayer :: Send( BYTEARRAY data )
 		m_Socket->PutBytes( data );
 }
 
+void CPotentialPlayer :: Send( SHAREDBYTEARRAY data )
+{
+	if( m_Socket )
+		m_Socket->PutBytes( data );
+}
+
 //
 // CGamePlayer
 //
@@ -229,6 +248,7 @@ CGamePlayer :: CGamePlayer( CGameProtocol *nProtocol, CBaseGame *nGame, CTCPSock
 	m_GProxy = false;
 	m_GProxyDisconnectNoticeSent = false;
 	m_GProxyReconnectKey = GetTicks( );
+	m_GProxyReader = -1;
 	m_LastGProxyAckTime = 0;
         m_PlayerId = 0;
         m_LeftTime = 0;
@@ -285,6 +305,7 @@ CGamePlayer :: CGamePlayer( CPotentialPlayer *potential, unsigned char nPID, str
 	m_GProxy = false;
 	m_GProxyDisconnectNoticeSent = false;
 	m_GProxyReconnectKey = GetTicks( );
+	m_GProxyReader = -1;
 	m_LastGProxyAckTime = 0;
         m_PlayerId = 0;
         m_LeftTime = 0;
@@ -294,7 +315,8 @@ CGamePlayer :: CGamePlayer( CPotentialPlayer *potential, unsigned char nPID, str
 
 CGamePlayer :: ~CGamePlayer( )
 {
-
+	if( m_GProxyReader != -1 )
+		m_Game->GetGProxyLog( )->RemoveReader( m_GProxyReader );
 }
 
 string CGamePlayer :: GetNameTerminated( )
@@ -333,7 +355,7 @@ uint32_t CGamePlayer :: GetPing( bool LCPing )
 		return AvgPing;
 }
 
-bool CGamePlayer :: Update( void *fd )
+bool CGamePlayer :: Update( )
 {
 	// wait 4 seconds after joining before sending the /whois or /w
 	// if we send the /whois too early battle.net may not have caught up with where the player is and return erroneous results
@@ -342,22 +364,9 @@ bool CGamePlayer :: Update( void *fd )
 	{
 		// todotodo: we could get kicked from battle.net for sending a command with invalid characters, do some basic checking
 
-		for( vector<CBNET *> :: iterator i = m_Game->m_GHost->m_BNETs.begin( ); i != m_Game->m_GHost->m_BNETs.end( ); i++ )
-		{
-			if( (*i)->GetServer( ) == m_JoinedRealm )
-			{
-				if( m_Game->GetGameState( ) == GAME_PUBLIC )
-				{
-					if( (*i)->GetPasswordHashType( ) == "pvpgn" )
-						(*i)->QueueChatCommand( "/whereis " + m_Name );
-					else
-						(*i)->QueueChatCommand( "/whois " + m_Name );
-				}
-				else if( m_Game->GetGameState( ) == GAME_PRIVATE )
-					(*i)->QueueChatCommand( m_Game->m_GHost->m_Language->SpoofCheckByReplying( ), m_Name, true );
-			}
-		}
+		// the battle.net connections belong to the main thread
 
+		m_Game->RunOnMainThread( boost :: bind( &CGHost :: QueueSpoofCheck, m_Game->m_GHost, m_JoinedRealm, m_Name, m_Game->GetGameState( ) ) );
 		m_WhoisSent = true;
 	}
 
@@ -381,7 +390,7 @@ bool CGamePlayer :: Update( void *fd )
 
 	// base class update
 
-	CPotentialPlayer :: Update( fd );
+	CPotentialPlayer :: Update( );
 	bool Deleting;
 
 	if( m_GProxy && m_Game->GetGameLoaded( ) )
@@ -413,49 +422,57 @@ void CGamePlayer :: ExtractPackets( )
 		return;
 
 	// extract as many packets as possible from the socket's receive buffer and put them in the m_Packets queue
+	// the buffer is scanned in place and only consumed once at the end so each received byte is copied exactly once (into its packet)
+	// the packets are recycled through the game's packet pool so their byte arrays are reused as well
 
-	string *RecvBuffer = m_Socket->GetBytes( );
-	BYTEARRAY Bytes = UTIL_CreateByteArray( (unsigned char *)RecvBuffer->c_str( ), RecvBuffer->size( ) );
+	unsigned char *Data = m_Socket->GetRecvData( );
+	uint32_t Size = m_Socket->GetRecvSize( );
+	uint32_t Offset = 0;
 
 	// a packet is at least 4 bytes so loop as long as the buffer contains 4 bytes
 
-	while( Bytes.size( ) >= 4 )
+	while( Size - Offset >= 4 )
 	{
-		if( Bytes[0] == W3GS_HEADER_CONSTANT || Bytes[0] == GPS_HEADER_CONSTANT )
+		unsigned char *Packet = Data + Offset;
+
+		if( Packet[0] == W3GS_HEADER_CONSTANT || Packet[0] == GPS_HEADER_CONSTANT )
 		{
 			// bytes 2 and 3 contain the length of the packet
 
-			uint16_t Length = UTIL_ByteArrayToUInt16( Bytes, false, 2 );
+			uint16_t Length = UTIL_ByteArrayToUInt16( Packet + 2, false );
 
 			if( Length >= 4 )
 			{
-				if( Bytes.size( ) >= Length )
+				if( Size - Offset >= Length )
 				{
-					m_Packets.push( new CCommandPacket( Bytes[0], Bytes[1], BYTEARRAY( Bytes.begin( ), Bytes.begin( ) + Length ) ) );
+					CCommandPacket *NewPacket = m_Game->GetPacketPool( )->Get( );
+					NewPacket->Set( Packet[0], Packet[1], Packet, Length );
+					m_Packets.push( NewPacket );
 
-					if( Bytes[0] == W3GS_HEADER_CONSTANT )
+					if( Packet[0] == W3GS_HEADER_CONSTANT )
 						m_TotalPacketsReceived++;
 
-					*RecvBuffer = RecvBuffer->substr( Length );
-					Bytes = BYTEARRAY( Bytes.begin( ) + Length, Bytes.end( ) );
+					Offset += Length;
 				}
 				else
-					return;
+					break;
 			}
 			else
 			{
 				m_Error = true;
 				m_ErrorString = "received invalid packet from player (bad length)";
-				return;
+				break;
 			}
 		}
 		else
 		{
 			m_Error = true;
 			m_ErrorString = "received invalid packet from player (bad header constant)";
-			return;
+			break;
 		}
 	}
+
+	m_Socket->ConsumeRecvBytes( Offset );
 }
 
 void CGamePlayer :: ProcessPackets( )
@@ -503,7 +520,7 @@ void CGamePlayer :: ProcessPackets( )
 				break;
 
 			case CGameProtocol :: W3GS_OUTGOING_ACTION:
-				Action = m_Protocol->RECEIVE_W3GS_OUTGOING_ACTION( Packet->GetData( ), m_PID );
+				Action = m_Protocol->RECEIVE_W3GS_OUTGOING_ACTION( Packet->GetData( ), m_PID, m_Game->GetActionPool( ) );
 
 				if( Action )
 					m_Game->EventPlayerAction( this, Action );
@@ -541,7 +558,7 @@ void CGamePlayer :: ProcessPackets( )
 				break;
 
 			case CGameProtocol :: W3GS_MAPSIZE:
-				MapSize = m_Protocol->RECEIVE_W3GS_MAPSIZE( Packet->GetData( ), m_Game->m_GHost->m_Map->GetMapSize( ) );
+				MapSize = m_Protocol->RECEIVE_W3GS_MAPSIZE( Packet->GetData( ), m_Game->GetMap( )->GetMapSize( ) );
 
 				if( MapSize )
 					m_Game->EventPlayerMapSize( this, MapSize );
@@ -605,29 +622,27 @@ void CGamePlayer :: ProcessPackets( )
 			else if( Packet->GetID( ) == CGPSProtocol :: GPS_ACK && Data.size( ) == 8 )
 			{
 				uint32_t LastPacket = UTIL_ByteArrayToUInt32( Data, false, 4 );
-				uint32_t PacketsAlreadyUnqueued = m_TotalPacketsSent - m_GProxyBuffer.size( );
 
-				if( LastPacket > PacketsAlreadyUnqueued )
+				if( m_GProxyReader != -1 )
 				{
-					uint32_t PacketsToUnqueue = LastPacket - PacketsAlreadyUnqueued;
+					uint32_t PacketsAlreadyUnqueued = m_TotalPacketsSent - m_Game->GetGProxyLog( )->GetPending( m_GProxyReader );
 
-					if( PacketsToUnqueue > m_GProxyBuffer.size( ) )
-						PacketsToUnqueue = m_GProxyBuffer.size( );
-
-					while( PacketsToUnqueue > 0 )
-					{
-						m_GProxyBuffer.pop( );
-						PacketsToUnqueue--;
-					}
+					if( LastPacket >= PacketsAlreadyUnqueued )
+						m_Game->GetGProxyLog( )->Ack( m_GProxyReader, LastPacket - PacketsAlreadyUnqueued );
 				}
 			}
 		}
 
-		delete Packet;
+		m_Game->GetPacketPool( )->Put( Packet );
 	}
 }
 
 void CGamePlayer :: Send( BYTEARRAY data )
+{
+	Send( UTIL_CreateSharedByteArray( data ) );
+}
+
+void CGamePlayer :: Send( SHAREDBYTEARRAY data )
 {
 	// must start counting packet total from beginning of connection
 	// but we can avoid buffering packets until we know the client is using GProxy++ since that'll be determined before the game starts
@@ -636,45 +651,45 @@ void CGamePlayer :: Send( BYTEARRAY data )
 	m_TotalPacketsSent++;
 
 	if( m_GProxy && m_Game->GetGameLoaded( ) )
-		m_GProxyBuffer.push( data );
+	{
+		if( m_GProxyReader == -1 )
+			m_GProxyReader = m_Game->GetGProxyLog( )->AddReader( );
+
+		if( m_GProxyReader != -1 )
+			m_Game->GetGProxyLog( )->Append( m_GProxyReader, data );
+	}
 
 	CPotentialPlayer :: Send( data );
 }
 
+bool CGamePlayer :: GetGProxyCanResume( uint32_t LastPacket )
+{
+	// if some of our unacked packets had to be dropped from the resend log we can only resume if GProxy++ received them before it was disconnected
+
+	if( m_GProxyReader == -1 || m_Game->GetGProxyLog( )->GetDropped( m_GProxyReader ) == 0 )
+		return true;
+
+	return LastPacket >= m_TotalPacketsSent - m_Game->GetGProxyLog( )->GetPending( m_GProxyReader );
+}
+
 void CGamePlayer :: EventGProxyReconnect( CTCPSocket *NewSocket, uint32_t LastPacket )
 {
 	delete m_Socket;
 	m_Socket = NewSocket;
 	m_Socket->PutBytes( m_Game->m_GHost->m_GPSProtocol->SEND_GPSS_RECONNECT( m_TotalPacketsReceived ) );
 
-	uint32_t PacketsAlreadyUnqueued = m_TotalPacketsSent - m_GProxyBuffer.size( );
+	// resend the remaining packets straight from the game's resend log, they stay in the log until they're acked
 
-	if( LastPacket > PacketsAlreadyUnqueued )
+	if( m_GProxyReader != -1 )
 	{
-		uint32_t PacketsToUnqueue = LastPacket - PacketsAlreadyUnqueued;
+		uint32_t PacketsAlreadyUnqueued = m_TotalPacketsSent - m_Game->GetGProxyLog( )->GetPending( m_GProxyReader );
 
-		if( PacketsToUnqueue > m_GProxyBuffer.size( ) )
-			PacketsToUnqueue = m_GProxyBuffer.size( );
+		if( LastPacket >= PacketsAlreadyUnqueued )
+			m_Game->GetGProxyLog( )->Ack( m_GProxyReader, LastPacket - PacketsAlreadyUnqueued );
 
-		while( PacketsToUnqueue > 0 )
-		{
-			m_GProxyBuffer.pop( );
-			PacketsToUnqueue--;
-		}
-	}
-
-	// send remaining packets from buffer, preserve buffer
-
-	queue<BYTEARRAY> TempBuffer;
-
-	while( !m_GProxyBuffer.empty( ) )
-	{
-		m_Socket->PutBytes( m_GProxyBuffer.front( ) );
-		TempBuffer.push( m_GProxyBuffer.front( ) );
-		m_GProxyBuffer.pop( );
+		m_Game->GetGProxyLog( )->Resend( m_GProxyReader, m_Socket );
 	}
 
-	m_GProxyBuffer = TempBuffer;
 	m_GProxyDisconnectNoticeSent = false;
-	m_Game->SendAllChat( m_Game->m_GHost->m_Language->PlayerReconnectedWithGProxy( m_Name ) );
+	m_Game->SendAllChat( m_Game->m_Language->PlayerReconnectedWithGProxy( m_Name ) );
 }
@@ -66,13 +66,14 @@ public:
 
 	// processing functions
 
-	virtual bool Update( void *fd );
+	virtual bool Update( );
 	virtual void ExtractPackets( );
 	virtual void ProcessPackets( );
 
 	// other functions
 
 	virtual void Send( BYTEARRAY data );
+	virtual void Send( SHAREDBYTEARRAY data );
 };
 
 //
@@ -123,7 +124,7 @@ private:
 	bool m_LeftMessageSent;						// if the playerleave message has been sent or not
 	bool m_GProxy;								// if the player is using GProxy++
 	bool m_GProxyDisconnectNoticeSent;			// if a disconnection notice has been sent or not when using GProxy++
-	queue<BYTEARRAY> m_GProxyBuffer;
+	int m_GProxyReader;							// our reader in the game's GProxy++ resend log (-1 until the first packet is logged)
 	uint32_t m_GProxyReconnectKey;
 	uint32_t m_LastGProxyAckTime;
         uint32_t m_PlayerId;
@@ -221,13 +222,15 @@ public:
 
 	// processing functions
 
-	virtual bool Update( void *fd );
+	virtual bool Update( );
 	virtual void ExtractPackets( );
 	virtual void ProcessPackets( );
 
 	// other functions
 
 	virtual void Send( BYTEARRAY data );
+	virtual void Send( SHAREDBYTEARRAY data );
+	virtual bool GetGProxyCanResume( uint32_t LastPacket );
 	virtual void EventGProxyReconnect( CTCPSocket *NewSocket, uint32_t LastPacket );
 };
 
@@ -24,6 +24,9 @@
 #include "gameplayer.h"
 #include "gameprotocol.h"
 #include "game_base.h"
+#include "map.h"
+#include "metrics.h"
+#include "pool.h"
 
 //
 // CGameProtocol
@@ -104,7 +107,7 @@ bool CGameProtocol :: RECEIVE_W3GS_GAMELOADED_SELF( BYTEARRAY data )
 	return false;
 }
 
-CIncomingAction *CGameProtocol :: RECEIVE_W3GS_OUTGOING_ACTION( BYTEARRAY data, unsigned char PID )
+CIncomingAction *CGameProtocol :: RECEIVE_W3GS_OUTGOING_ACTION( BYTEARRAY &data, unsigned char PID, CPool<CIncomingAction> *pool )
 {
 	// DEBUG_Print( "RECEIVED W3GS_OUTGOING_ACTION" );
 	// DEBUG_Print( data );
@@ -114,11 +117,13 @@ CIncomingAction *CGameProtocol :: RECEIVE_W3GS_OUTGOING_ACTION( BYTEARRAY data,
 	// 4 bytes					-> CRC
 	// remainder of packet		-> Action
 
+	// the action comes from the game's pool and goes back to it once it's been sent and recorded
+
 	if( PID != 255 && ValidateLength( data ) && data.size( ) >= 8 )
 	{
-		BYTEARRAY CRC = BYTEARRAY( data.begin( ) + 4, data.begin( ) + 8 );
-		BYTEARRAY Action = BYTEARRAY( data.begin( ) + 8, data.end( ) );
-		return new CIncomingAction( PID, CRC, Action );
+		CIncomingAction *Action = pool->Get( );
+		Action->Set( PID, &data[4], 4, &data[0] + 8, data.size( ) - 8 );
+		return Action;
 	}
 
 	return NULL;
@@ -481,7 +486,7 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_COUNTDOWN_END( )
 	return packet;
 }
 
-BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *> actions, uint16_t sendInterval )
+BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION( const vector<CIncomingAction *> &actions, uint16_t sendInterval )
 {
 	BYTEARRAY packet;
 	packet.push_back( W3GS_HEADER_CONSTANT );				// W3GS header constant
@@ -496,18 +501,16 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *> a
 	{
 		BYTEARRAY subpacket;
 
-		while( !actions.empty( ) )
+		for( vector<CIncomingAction *> :: const_iterator i = actions.begin( ); i != actions.end( ); i++ )
 		{
-			CIncomingAction *Action = actions.front( );
-			actions.pop( );
-			subpacket.push_back( Action->GetPID( ) );
-			UTIL_AppendByteArray( subpacket, (uint16_t)Action->GetAction( )->size( ), false );
-			UTIL_AppendByteArrayFast( subpacket, *Action->GetAction( ) );
+			subpacket.push_back( (*i)->GetPID( ) );
+			UTIL_AppendByteArray( subpacket, (uint16_t)(*i)->GetAction( )->size( ), false );
+			UTIL_AppendByteArrayFast( subpacket, *(*i)->GetAction( ) );
 		}
 
 		// calculate crc (we only care about the first 2 bytes though)
 
-		BYTEARRAY crc32 = UTIL_CreateByteArray( m_GHost->m_CRC->FullCRC( (unsigned char *)string( subpacket.begin( ), subpacket.end( ) ).c_str( ), subpacket.size( ) ), false );
+		BYTEARRAY crc32 = UTIL_CreateByteArray( m_GHost->m_CRC->FullCRC( &subpacket[0], subpacket.size( ) ), false );
 		crc32.resize( 2 );
 
 		// finish subpacket
@@ -817,14 +820,17 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_STARTDOWNLOAD( unsigned char fromPID )
 	return packet;
 }
 
-BYTEARRAY CGameProtocol :: SEND_W3GS_MAPPART( unsigned char fromPID, unsigned char toPID, uint32_t start, string *mapData )
+BYTEARRAY CGameProtocol :: SEND_W3GS_MAPPART( unsigned char fromPID, unsigned char toPID, uint32_t start, CMap *map )
 {
 	unsigned char Unknown[] = { 1, 0, 0, 0 };
 
+	const unsigned char *MapData = map->GetMapData( );
+	uint32_t MapDataSize = map->GetMapDataSize( );
 	BYTEARRAY packet;
 
-	if( start < mapData->size( ) )
+	if( start < MapDataSize )
 	{
+		packet.reserve( 18 + 1442 );
 		packet.push_back( W3GS_HEADER_CONSTANT );				// W3GS header constant
 		packet.push_back( W3GS_MAPPART );						// W3GS_MAPPART
 		packet.push_back( 0 );									// packet length will be assigned later
@@ -838,18 +844,16 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_MAPPART( unsigned char fromPID, unsigned ch
 
 		uint32_t End = start + 1442;
 
-		if( End > mapData->size( ) )
-			End = mapData->size( );
+		if( End > MapDataSize )
+			End = MapDataSize;
 
-		// calculate crc
+		// crc (precalculated when the map was loaded)
 
-		BYTEARRAY crc32 = UTIL_CreateByteArray( m_GHost->m_CRC->FullCRC( (unsigned char *)mapData->c_str( ) + start, End - start ), false );
-		UTIL_AppendByteArrayFast( packet, crc32 );
+		UTIL_AppendByteArray( packet, map->GetMapPartCRC( start ), false );
 
 		// map data
 
-		BYTEARRAY Data = UTIL_CreateByteArray( (unsigned char *)mapData->c_str( ) + start, End - start );
-		UTIL_AppendByteArrayFast( packet, Data );
+		packet.insert( packet.end( ), MapData + start, MapData + End );
 		AssignLength( packet );
 	}
 	else
@@ -860,7 +864,7 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_MAPPART( unsigned char fromPID, unsigned ch
 	return packet;
 }
 
-BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION2( queue<CIncomingAction *> actions )
+BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION2( const vector<CIncomingAction *> &actions )
 {
 	BYTEARRAY packet;
 	packet.push_back( W3GS_HEADER_CONSTANT );				// W3GS header constant
@@ -876,18 +880,16 @@ BYTEARRAY CGameProtocol :: SEND_W3GS_INCOMING_ACTION2( queue<CIncomingAction *>
 	{
 		BYTEARRAY subpacket;
 
-		while( !actions.empty( ) )
+		for( vector<CIncomingAction *> :: const_iterator i = actions.begin( ); i != actions.end( ); i++ )
 		{
-			CIncomingAction *Action = actions.front( );
-			actions.pop( );
-			subpacket.push_back( Action->GetPID( ) );
-			UTIL_AppendByteArray( subpacket, (uint16_t)Action->GetAction( )->size( ), false );
-			UTIL_AppendByteArrayFast( subpacket, *Action->GetAction( ) );
+			subpacket.push_back( (*i)->GetPID( ) );
+			UTIL_AppendByteArray( subpacket, (uint16_t)(*i)->GetAction( )->size( ), false );
+			UTIL_AppendByteArrayFast( subpacket, *(*i)->GetAction( ) );
 		}
 
 		// calculate crc (we only care about the first 2 bytes though)
 
-		BYTEARRAY crc32 = UTIL_CreateByteArray( m_GHost->m_CRC->FullCRC( (unsigned char *)string( subpacket.begin( ), subpacket.end( ) ).c_str( ), subpacket.size( ) ), false );
+		BYTEARRAY crc32 = UTIL_CreateByteArray( m_GHost->m_CRC->FullCRC( &subpacket[0], subpacket.size( ) ), false );
 		crc32.resize( 2 );
 
 		// finish subpacket
@@ -977,6 +979,11 @@ CIncomingJoinPlayer :: ~CIncomingJoinPlayer( )
 // CIncomingAction
 //
 
+CIncomingAction :: CIncomingAction( )
+{
+	m_PID = 255;
+}
+
 CIncomingAction :: CIncomingAction( unsigned char nPID, BYTEARRAY &nCRC, BYTEARRAY &nAction )
 {
 	m_PID = nPID;
@@ -989,6 +996,13 @@ CIncomingAction :: ~CIncomingAction( )
 
 }
 
+void CIncomingAction :: Set( unsigned char nPID, unsigned char *crc, uint32_t crcLength, unsigned char *action, uint32_t actionLength )
+{
+	m_PID = nPID;
+	m_CRC.assign( crc, crc + crcLength );
+	m_Action.assign( action, action + actionLength );
+}
+
 //
 // CIncomingChatPlayer
 //
@@ -55,6 +55,8 @@ class CIncomingJoinPlayer;
 class CIncomingAction;
 class CIncomingChatPlayer;
 class CIncomingMapSize;
+class CMap;
+template <class T> class CPool;
 
 class CGameProtocol
 {
@@ -109,7 +111,7 @@ public:
 	CIncomingJoinPlayer *RECEIVE_W3GS_REQJOIN( BYTEARRAY data );
 	uint32_t RECEIVE_W3GS_LEAVEGAME( BYTEARRAY data );
 	bool RECEIVE_W3GS_GAMELOADED_SELF( BYTEARRAY data );
-	CIncomingAction *RECEIVE_W3GS_OUTGOING_ACTION( BYTEARRAY data, unsigned char PID );
+	CIncomingAction *RECEIVE_W3GS_OUTGOING_ACTION( BYTEARRAY &data, unsigned char PID, CPool<CIncomingAction> *pool );
 	uint32_t RECEIVE_W3GS_OUTGOING_KEEPALIVE( BYTEARRAY data );
 	CIncomingChatPlayer *RECEIVE_W3GS_CHAT_TO_HOST( BYTEARRAY data );
 	bool RECEIVE_W3GS_SEARCHGAME( BYTEARRAY data, unsigned char war3Version );
@@ -128,7 +130,7 @@ public:
 	BYTEARRAY SEND_W3GS_SLOTINFO( vector<CGameSlot> &slots, uint32_t randomSeed, unsigned char layoutStyle, unsigned char playerSlots );
 	BYTEARRAY SEND_W3GS_COUNTDOWN_START( );
 	BYTEARRAY SEND_W3GS_COUNTDOWN_END( );
-	BYTEARRAY SEND_W3GS_INCOMING_ACTION( queue<CIncomingAction *> actions, uint16_t sendInterval );
+	BYTEARRAY SEND_W3GS_INCOMING_ACTION( const vector<CIncomingAction *> &actions, uint16_t sendInterval );
 	BYTEARRAY SEND_W3GS_CHAT_FROM_HOST( unsigned char fromPID, BYTEARRAY toPIDs, unsigned char flag, BYTEARRAY flagExtra, string message );
 	BYTEARRAY SEND_W3GS_START_LAG( vector<CGamePlayer *> players, bool loadInGame = false );
 	BYTEARRAY SEND_W3GS_STOP_LAG( CGamePlayer *player, bool loadInGame = false );
@@ -139,8 +141,8 @@ public:
 	BYTEARRAY SEND_W3GS_DECREATEGAME( );
 	BYTEARRAY SEND_W3GS_MAPCHECK( string mapPath, BYTEARRAY mapSize, BYTEARRAY mapInfo, BYTEARRAY mapCRC, BYTEARRAY mapSHA1 );
 	BYTEARRAY SEND_W3GS_STARTDOWNLOAD( unsigned char fromPID );
-	BYTEARRAY SEND_W3GS_MAPPART( unsigned char fromPID, unsigned char toPID, uint32_t start, string *mapData );
-	BYTEARRAY SEND_W3GS_INCOMING_ACTION2( queue<CIncomingAction *> actions );
+	BYTEARRAY SEND_W3GS_MAPPART( unsigned char fromPID, unsigned char toPID, uint32_t start, CMap *map );
+	BYTEARRAY SEND_W3GS_INCOMING_ACTION2( const vector<CIncomingAction *> &actions );
 
 	// other functions
 
@@ -182,6 +184,7 @@ private:
 	BYTEARRAY m_Action;
 
 public:
+	CIncomingAction( );
 	CIncomingAction( unsigned char nPID, BYTEARRAY &nCRC, BYTEARRAY &nAction );
 	~CIncomingAction( );
 
@@ -189,6 +192,10 @@ public:
 	BYTEARRAY GetCRC( )		{ return m_CRC; }
 	BYTEARRAY *GetAction( )	{ return &m_Action; }
 	uint32_t GetLength( )	{ return m_Action.size( ) + 3; }
+
+	// reuses the CRC's and action's capacity when the action is recycled by a pool
+
+	void Set( unsigned char nPID, unsigned char *crc, uint32_t crcLength, unsigned char *action, uint32_t actionLength );
 };
 
 //
@@ -0,0 +1,389 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#include "ghost.h"
+#include "util.h"
+#include "socket.h"
+#include "gameplayer.h"
+#include "gpsprotocol.h"
+#include "game_base.h"
+#include "gamethreads.h"
+#include "metrics.h"
+#include "timerwheel.h"
+
+#include <boost/bind.hpp>
+
+//
+// CGameThread
+//
+
+CGameThread :: CGameThread( CGHost *nGHost, CGameThreads *nGameThreads, uint32_t id )
+{
+	m_GHost = nGHost;
+	m_GameThreads = nGameThreads;
+	m_Thread = NULL;
+	m_Poller = CSocketPoller :: Create( gSocketPoller->GetName( ) );
+	m_TimerWheel = new CTimerWheel( GetMicroTicks( ) );
+	m_Exiting = false;
+	m_NumGames = 0;
+	m_MetricsLabels = CMetrics :: Label( "thread", UTIL_ToString( id ) );
+	m_GamesGauge = gMetrics->Gauge( "ghost_gamethread_games", "Running games owned by each game thread.", m_MetricsLabels );
+}
+
+CGameThread :: ~CGameThread( )
+{
+	Stop( );
+
+	// every game has been handed back (and every socket detached) by now
+
+	delete m_TimerWheel;
+	delete m_Poller;
+	gMetrics->Remove( "ghost_gamethread_games", m_MetricsLabels );
+}
+
+void CGameThread :: Start( )
+{
+	m_Thread = new boost :: thread( boost :: bind( &CGameThread :: ThreadLoop, this ) );
+}
+
+void CGameThread :: Post( CBaseGame *game, GameTask task )
+{
+	{
+		boost :: mutex :: scoped_lock Lock( m_Mutex );
+		m_Tasks.push_back( QueuedGameTask( game, task ) );
+	}
+
+	m_Poller->Wake( );
+}
+
+void CGameThread :: Wake( )
+{
+	m_Poller->Wake( );
+}
+
+void CGameThread :: Stop( )
+{
+	if( !m_Thread )
+		return;
+
+	{
+		boost :: mutex :: scoped_lock Lock( m_Mutex );
+		m_Exiting = true;
+	}
+
+	m_Poller->Wake( );
+	m_Thread->join( );
+	delete m_Thread;
+	m_Thread = NULL;
+}
+
+void CGameThread :: ThreadLoop( )
+{
+	while( true )
+	{
+		m_GameThreads->Park( );
+
+		{
+			boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+			if( m_Exiting )
+				break;
+		}
+
+		// this is the main loop of CGHost :: Update for our games only, i.e. block until a timer is due or a socket has work
+		// a poller which can't be woken up by the other threads only blocks for a short while so the posted tasks don't have to wait too long
+
+		uint64_t Now = GetMicroTicks( );
+		uint64_t NextDeadline = m_TimerWheel->GetNextDeadline( Now, m_Poller->GetCanWake( ) ? 500000 : 10000 );
+		m_Poller->Wait( NextDeadline > Now ? NextDeadline - Now : 0 );
+		m_TimerWheel->Expire( GetMicroTicks( ) );
+		RunTasks( );
+
+		for( vector<CBaseGame *> :: iterator i = m_Games.begin( ); i != m_Games.end( ); )
+		{
+			if( !(*i)->GetUpdateDue( ) )
+			{
+				i++;
+				continue;
+			}
+
+			if( (*i)->Update( ) )
+			{
+				// the game is over, hand it back to the main thread which deletes it
+				// from here on we must not touch it any more
+
+				CBaseGame *Game = *i;
+				i = m_Games.erase( i );
+				Game->DetachSockets( );
+				Game->SetTimerWheel( NULL );
+				m_GameThreads->PostMain( boost :: bind( &CGHost :: DeleteGame, m_GHost, Game ) );
+			}
+			else
+			{
+				(*i)->UpdateTimers( );
+				(*i)->UpdatePost( );
+				(*i)->UpdateDescriptionSnapshot( );
+				i++;
+			}
+		}
+
+		m_GamesGauge->Set( m_Games.size( ) );
+	}
+
+	// we're exiting, hand every game back so the main thread can delete them
+
+	for( vector<CBaseGame *> :: iterator i = m_Games.begin( ); i != m_Games.end( ); i++ )
+	{
+		(*i)->DetachSockets( );
+		(*i)->SetTimerWheel( NULL );
+	}
+
+	m_Games.clear( );
+}
+
+void CGameThread :: RunTasks( )
+{
+	vector<QueuedGameTask> Tasks;
+
+	{
+		boost :: mutex :: scoped_lock Lock( m_Mutex );
+		Tasks.swap( m_Tasks );
+	}
+
+	for( vector<QueuedGameTask> :: iterator i = Tasks.begin( ); i != Tasks.end( ); i++ )
+	{
+		if( !i->first || find( m_Games.begin( ), m_Games.end( ), i->first ) != m_Games.end( ) )
+			i->second( );
+	}
+}
+
+void CGameThread :: Adopt( CBaseGame *game )
+{
+	// the game was detached from the main thread by CGameThreads :: Add, it's updated right away because its timers aren't scheduled
+
+	game->AttachSockets( m_Poller );
+	game->SetTimerWheel( m_TimerWheel );
+	m_Games.push_back( game );
+}
+
+void CGameThread :: GProxyReconnect( CBaseGame *game, CTCPSocket *socket, unsigned char PID, uint32_t reconnectKey, uint32_t lastPacket )
+{
+	socket->Attach( m_Poller );
+
+	// the game might have ended (or the player might have left) since the main thread looked it up
+
+	if( find( m_Games.begin( ), m_Games.end( ), game ) != m_Games.end( ) && game->GProxyReconnect( socket, PID, reconnectKey, lastPacket ) )
+		return;
+
+	socket->PutBytes( m_GHost->m_GPSProtocol->SEND_GPSS_REJECT( REJECTGPS_NOTFOUND ) );
+	socket->DoSend( );
+	delete socket;
+}
+
+//
+// CGameThreads
+//
+
+CGameThreads :: CGameThreads( CGHost *nGHost, uint32_t numThreads )
+{
+	m_GHost = nGHost;
+	m_Paused = false;
+	m_Stopped = false;
+	m_NumParked = 0;
+
+	for( uint32_t i = 0; i < numThreads; i++ )
+	{
+		CGameThread *Thread = new CGameThread( m_GHost, this, i + 1 );
+
+		try
+		{
+			Thread->Start( );
+		}
+		catch( const boost :: thread_resource_error &tre )
+		{
+			CONSOLE_Print( "[GAMETHREADS] error spawning game thread #" + UTIL_ToString( i + 1 ) + " [" + string( tre.what( ) ) + "], continuing with " + UTIL_ToString( m_Threads.size( ) ) + " threads" );
+			delete Thread;
+			break;
+		}
+
+		m_Threads.push_back( Thread );
+	}
+}
+
+CGameThreads :: ~CGameThreads( )
+{
+	Stop( );
+
+	for( vector<CGameThread *> :: iterator i = m_Threads.begin( ); i != m_Threads.end( ); i++ )
+		delete *i;
+}
+
+void CGameThreads :: Add( CBaseGame *game )
+{
+	if( m_Threads.empty( ) || m_Stopped )
+		return;
+
+	// give the game to the thread with the fewest games
+	// the game's timers and sockets are taken off the main thread here and picked up by the game thread when it runs the Adopt task
+
+	CGameThread *Thread = m_Threads[0];
+
+	for( vector<CGameThread *> :: iterator i = m_Threads.begin( ); i != m_Threads.end( ); i++ )
+	{
+		if( (*i)->GetNumGames( ) < Thread->GetNumGames( ) )
+			Thread = *i;
+	}
+
+	game->SetTimerWheel( NULL );
+	game->DetachSockets( );
+	game->SetGameThread( Thread );
+	Thread->SetNumGames( Thread->GetNumGames( ) + 1 );
+
+	// remember where the GProxy++ players are so we don't have to ask the game threads when one of them reconnects
+
+	BYTEARRAY PIDs = game->GetPIDs( );
+
+	for( BYTEARRAY :: iterator i = PIDs.begin( ); i != PIDs.end( ); i++ )
+	{
+		CGamePlayer *Player = game->GetPlayerFromPID( *i );
+
+		if( Player && Player->GetGProxy( ) )
+			m_Routes[GProxyReconnectRoute( *i, Player->GetGProxyReconnectKey( ) )] = game;
+	}
+
+	Thread->Post( NULL, boost :: bind( &CGameThread :: Adopt, Thread, game ) );
+}
+
+void CGameThreads :: Remove( CBaseGame *game )
+{
+	CGameThread *Thread = game->GetGameThread( );
+
+	if( !Thread )
+		return;
+
+	for( map<GProxyReconnectRoute, CBaseGame *> :: iterator i = m_Routes.begin( ); i != m_Routes.end( ); )
+	{
+		if( i->second == game )
+			m_Routes.erase( i++ );
+		else
+			i++;
+	}
+
+	Thread->SetNumGames( Thread->GetNumGames( ) - 1 );
+	game->SetGameThread( NULL );
+}
+
+CBaseGame *CGameThreads :: FindReconnectGame( unsigned char PID, uint32_t reconnectKey )
+{
+	map<GProxyReconnectRoute, CBaseGame *> :: iterator i = m_Routes.find( GProxyReconnectRoute( PID, reconnectKey ) );
+
+	if( i != m_Routes.end( ) )
+		return i->second;
+
+	return NULL;
+}
+
+void CGameThreads :: GProxyReconnect( CBaseGame *game, CTCPSocket *socket, unsigned char PID, uint32_t reconnectKey, uint32_t lastPacket )
+{
+	// the socket was accepted by the main thread, it's handed over to the game's thread which does the rest
+
+	CGameThread *Thread = game->GetGameThread( );
+	socket->Detach( );
+	Thread->Post( NULL, boost :: bind( &CGameThread :: GProxyReconnect, Thread, game, socket, PID, reconnectKey, lastPacket ) );
+}
+
+void CGameThreads :: Stop( )
+{
+	if( m_Stopped )
+		return;
+
+	for( vector<CGameThread *> :: iterator i = m_Threads.begin( ); i != m_Threads.end( ); i++ )
+		(*i)->Stop( );
+
+	m_Stopped = true;
+}
+
+void CGameThreads :: PostMain( GameTask task )
+{
+	{
+		boost :: mutex :: scoped_lock Lock( m_MainMutex );
+		m_MainTasks.push_back( task );
+	}
+
+	gSocketPoller->Wake( );
+}
+
+void CGameThreads :: RunMainTasks( )
+{
+	vector<GameTask> Tasks;
+
+	{
+		boost :: mutex :: scoped_lock Lock( m_MainMutex );
+		Tasks.swap( m_MainTasks );
+	}
+
+	for( vector<GameTask> :: iterator i = Tasks.begin( ); i != Tasks.end( ); i++ )
+		(*i)( );
+}
+
+void CGameThreads :: Pause( )
+{
+	if( m_Threads.empty( ) || m_Stopped )
+		return;
+
+	{
+		boost :: mutex :: scoped_lock Lock( m_PauseMutex );
+		m_Paused = true;
+	}
+
+	for( vector<CGameThread *> :: iterator i = m_Threads.begin( ); i != m_Threads.end( ); i++ )
+		(*i)->Wake( );
+
+	boost :: mutex :: scoped_lock Lock( m_PauseMutex );
+
+	while( m_NumParked < m_Threads.size( ) )
+		m_PauseChanged.wait( Lock );
+}
+
+void CGameThreads :: Resume( )
+{
+	{
+		boost :: mutex :: scoped_lock Lock( m_PauseMutex );
+		m_Paused = false;
+	}
+
+	m_PauseChanged.notify_all( );
+}
+
+void CGameThreads :: Park( )
+{
+	boost :: mutex :: scoped_lock Lock( m_PauseMutex );
+
+	if( !m_Paused )
+		return;
+
+	m_NumParked++;
+	m_PauseChanged.notify_all( );
+
+	while( m_Paused )
+		m_PauseChanged.wait( Lock );
+
+	m_NumParked--;
+}
@@ -0,0 +1,135 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#ifndef GAMETHREADS_H
+#define GAMETHREADS_H
+
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+
+//
+// CGameThread
+//
+
+// once a game has started it's handed to one game thread which runs it from then on, i.e. its sockets, its timers and its updates all belong to that thread
+// each game thread runs an event loop just like the main thread's with its own socket poller and timer wheel, the lobby and everything else stays on the main thread
+// the threads never touch each other's games, anything a game needs from the main thread (battle.net, the game list, deleting the game) is posted to the main thread as a task
+// and the main thread reaches into a running game only by posting a task to the game's thread (e.g. new snapshots of the language and the admin list)
+
+class CGHost;
+class CGameThreads;
+class CBaseGame;
+class CTCPSocket;
+class CSocketPoller;
+class CTimerWheel;
+class CMetricGauge;
+
+typedef boost :: function<void( )> GameTask;
+typedef pair<CBaseGame *, GameTask> QueuedGameTask;
+
+class CGameThread
+{
+private:
+	CGHost *m_GHost;
+	CGameThreads *m_GameThreads;
+	boost :: thread *m_Thread;
+	CSocketPoller *m_Poller;						// the sockets of our games (the poller of the main thread's backend)
+	CTimerWheel *m_TimerWheel;						// the action and housekeeping timers of our games
+	vector<CBaseGame *> m_Games;					// the games we're running (only touched by this thread)
+	boost :: mutex m_Mutex;
+	vector<QueuedGameTask> m_Tasks;					// tasks posted by the other threads, run in order before our games are updated
+	bool m_Exiting;
+	uint32_t m_NumGames;							// the number of games assigned to us (only touched by the main thread, for balancing)
+	string m_MetricsLabels;
+	CMetricGauge *m_GamesGauge;
+
+public:
+	CGameThread( CGHost *nGHost, CGameThreads *nGameThreads, uint32_t id );
+	~CGameThread( );
+
+	CSocketPoller *GetPoller( )						{ return m_Poller; }
+	uint32_t GetNumGames( )							{ return m_NumGames; }
+	void SetNumGames( uint32_t nNumGames )			{ m_NumGames = nNumGames; }
+
+	// a task posted for a game is dropped if the game isn't running on this thread by the time the task would run (e.g. it was just handed back to be deleted)
+	// a task posted for no game always runs
+
+	void Post( CBaseGame *game, GameTask task );
+	void Wake( );
+	void Start( );
+	void Stop( );
+	void ThreadLoop( );
+
+	// these run on the thread itself
+
+	void RunTasks( );
+	void Adopt( CBaseGame *game );
+	void GProxyReconnect( CBaseGame *game, CTCPSocket *socket, unsigned char PID, uint32_t reconnectKey, uint32_t lastPacket );
+};
+
+//
+// CGameThreads
+//
+
+// owns the game threads and the main thread's task queue
+// except for PostMain every function is only called by the main thread
+
+typedef pair<unsigned char, uint32_t> GProxyReconnectRoute;
+
+class CGameThreads
+{
+private:
+	CGHost *m_GHost;
+	vector<CGameThread *> m_Threads;
+	map<GProxyReconnectRoute, CBaseGame *> m_Routes;	// the PID and reconnect key of every GProxy++ player in a running game (they don't change once the game has started)
+	boost :: mutex m_MainMutex;
+	vector<GameTask> m_MainTasks;					// tasks posted by the game threads for the main thread
+	boost :: mutex m_PauseMutex;
+	boost :: condition_variable m_PauseChanged;
+	bool m_Paused;
+	bool m_Stopped;
+	uint32_t m_NumParked;							// the number of threads waiting for Resume
+
+public:
+	CGameThreads( CGHost *nGHost, uint32_t numThreads );
+	~CGameThreads( );
+
+	uint32_t GetNumThreads( )						{ return m_Threads.size( ); }
+
+	void Add( CBaseGame *game );
+	void Remove( CBaseGame *game );
+	CBaseGame *FindReconnectGame( unsigned char PID, uint32_t reconnectKey );
+	void GProxyReconnect( CBaseGame *game, CTCPSocket *socket, unsigned char PID, uint32_t reconnectKey, uint32_t lastPacket );
+	void Stop( );
+
+	// the main thread's task queue, anyone can post and the main thread runs the tasks once per loop
+
+	void PostMain( GameTask task );
+	void RunMainTasks( );
+
+	// stops every game thread between two loops (e.g. while the config they read is being replaced)
+	// the game threads call Park at the top of every loop
+
+	void Pause( );
+	void Resume( );
+	void Park( );
+};
+
+#endif
@@ -31,11 +31,19 @@
 #include "map.h"
 #include "packed.h"
 #include "savegame.h"
+#include "replay.h"
 #include "gameplayer.h"
 #include "gameprotocol.h"
 #include "gpsprotocol.h"
 #include "game_base.h"
 #include "game.h"
+#include "gamethreads.h"
+#include "profilecache.h"
+#include "balancer.h"
+#include "metrics.h"
+#include "timerwheel.h"
+
+#include <boost/bind.hpp>
 
 #include <signal.h>
 #include <stdlib.h>
@@ -66,6 +74,7 @@ string gCFGFile;
 string gLogFile;
 uint32_t gLogMethod;
 ofstream *gLog = NULL;
+boost :: mutex gLogMutex;			// CONSOLE_Print is called from the database and game threads too
 CGHost *gGHost = NULL;
 
 uint32_t GetTime( )
@@ -100,6 +109,30 @@ uint32_t GetTicks( )
 #endif
 }
 
+uint64_t GetMicroTicks( )
+{
+	// a monotonic clock for measuring short intervals and scheduling the game timers, unlike GetTicks it doesn't wrap
+
+#ifdef WIN32
+	LARGE_INTEGER Frequency;
+	LARGE_INTEGER Counter;
+	QueryPerformanceFrequency( &Frequency );
+	QueryPerformanceCounter( &Counter );
+	return (uint64_t)( Counter.QuadPart / ( Frequency.QuadPart / 1000000.0 ) );
+#elif __APPLE__
+	static mach_timebase_info_data_t info = { 0, 0 };
+
+	if( info.denom == 0 )
+		mach_timebase_info( &info );
+
+	return mach_absolute_time( ) * info.numer / info.denom / 1000;
+#else
+	struct timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return (uint64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+#endif
+}
+
 void SignalCatcher2( int s )
 {
 	CONSOLE_Print( "[!!!] caught signal " + UTIL_ToString( s ) + ", exiting NOW" );
@@ -130,6 +163,7 @@ void SignalCatcher( int s )
 
 void CONSOLE_Print( string message )
 {
+	boost :: mutex :: scoped_lock Lock( gLogMutex );
 	cout << message << endl;
 
 	// logging
@@ -351,22 +385,89 @@ int main( int argc, char **argv )
 
 CGHost :: CGHost( CConfig *CFG )
 {
-    
+	// the socket poller must exist before any socket is created because sockets register themselves with it
+	// bot_socketpoller can be set to "select" to force the portable backend, otherwise epoll is used where available
+
+	gSocketPoller = CSocketPoller :: Create( CFG->GetString( "bot_socketpoller", string( ) ) );
+	CONSOLE_Print( "[GHOST] using socket poller [" + gSocketPoller->GetName( ) + "]" );
+
+	// the metrics registry is created just as early because sockets, games and database callables record into it
+	// it's served over HTTP on bot_metricsaddress:bot_metricsport for a Prometheus server to scrape, a port of 0 disables the endpoint (the metrics are still recorded)
+
+	gMetrics = new CMetrics( );
+	m_LoopWaitTime = gMetrics->Histogram( "ghost_loop_wait_seconds", "Time spent waiting on the socket poller per main loop iteration.", string( ), CMetrics :: MicrosecondBuckets( ), 1000000.0 );
+	m_LoopWorkTime = gMetrics->Histogram( "ghost_loop_work_seconds", "Time spent updating the games, battle.net connections and database callables per main loop iteration.", string( ), CMetrics :: MicrosecondBuckets( ), 1000000.0 );
+	uint16_t MetricsPort = CFG->GetInt( "bot_metricsport", 0 );
+
+	if( MetricsPort > 0 )
+	{
+		string MetricsAddress = CFG->GetString( "bot_metricsaddress", "127.0.0.1" );
+		m_MetricsServer = new CMetricsServer( );
+
+		if( m_MetricsServer->Listen( MetricsAddress, MetricsPort ) )
+			CONSOLE_Print( "[GHOST] serving metrics on " + MetricsAddress + ":" + UTIL_ToString( MetricsPort ) );
+		else
+		{
+			CONSOLE_Print( "[GHOST] error listening for metrics requests on " + MetricsAddress + ":" + UTIL_ToString( MetricsPort ) );
+			delete m_MetricsServer;
+			m_MetricsServer = NULL;
+		}
+	}
+	else
+		m_MetricsServer = NULL;
+
+	// the games schedule their action packets (and a housekeeping update) here, the main loop sleeps until the earliest one is due
+
+	m_TimerWheel = new CTimerWheel( GetMicroTicks( ) );
+
+	// the started games can be run by a number of game threads, each with its own event loop, 0 disables this and runs every game on the main thread
+	// the lobby always stays on the main thread
+
+	uint32_t GameThreads = CFG->GetInt( "bot_gamethreads", 0 );
+
+	if( GameThreads > 0 )
+	{
+		m_GameThreads = new CGameThreads( this, GameThreads );
+		CONSOLE_Print( "[GHOST] using " + UTIL_ToString( m_GameThreads->GetNumThreads( ) ) + " game threads" );
+	}
+	else
+		m_GameThreads = NULL;
+
+	// players' ids, scores and stats are cached for bot_profilecachettl seconds (0 disables the cache)
+
+	m_ProfileCache = new CProfileCache( CFG->GetInt( "bot_profilecachettl", 600 ), CFG->GetInt( "bot_profilecachesize", 2000 ) );
+
+	// balancing the slots blocks the main loop so the search is limited to bot_balancetimelimit milliseconds, it can be spread over bot_balancethreads threads
+
+	m_TeamBalancer = new CTeamBalancer( CFG->GetInt( "bot_balancethreads", 1 ), CFG->GetInt( "bot_balancetimelimit", 250 ) );
+	m_ReplayWriter = new CReplayWriter( );
 	m_UDPSocket = new CUDPSocket( );
 	m_UDPSocket->SetBroadcastTarget( CFG->GetString( "udp_broadcasttarget", string( ) ) );
 	m_UDPSocket->SetDontRoute( CFG->GetInt( "udp_dontroute", 0 ) == 0 ? false : true );
 	m_ReconnectSocket = NULL;
+
+	// each game keeps the packets its GProxy++ players haven't acked yet in one shared log of at most bot_reconnectbuffersize kilobytes
+
+	m_ReconnectBufferSize = CFG->GetInt( "bot_reconnectbuffersize", 8192 );
 	m_GPSProtocol = new CGPSProtocol( );
 	m_CRC = new CCRC32( );
 	m_CRC->Initialize( );
 	m_SHA = new CSHA1( );
 	m_CurrentGame = NULL;
+	m_Map = NULL;
+	m_AutoHostMap = NULL;
+	m_MapLoad = NULL;
         m_CallableGetGameId = NULL;
         m_CallableGetBotConfig = NULL;
         m_CallableGetBotConfigText = NULL;
         m_CallableGetLanguages = NULL;
         m_CallableGetStatsTemplates = NULL;
         m_CallableBanList = NULL;
+        m_BanIndex = new CBanIndex( m_BanList );
+        m_CallableGameListUpdate = NULL;
+        m_DownloadTokens = 0;
+        m_LastDownloadTokenTicks = GetTicks( );
+        m_LastGameListFlush = GetTime( );
         m_NewGameId = 0;
         m_LastGameIdUpdate = GetTime( );
 	CONSOLE_Print( "[GHOST] opening primary database" );
@@ -448,7 +549,7 @@ CGHost :: CGHost( CConfig *CFG )
 	}
 #endif
 
-	m_Language = NULL;
+	m_AdminList = boost :: shared_ptr<const map<string, uint32_t> >( new map<string, uint32_t>( ) );
 	m_Exiting = false;
 	m_ExitingNice = false;
 	m_Enabled = true;
@@ -471,6 +572,21 @@ CGHost :: CGHost( CConfig *CFG )
 
 CGHost :: ~CGHost( )
 {
+	// stop the game threads before anything they use is deleted
+	// they hand their games back to us and whatever they posted for us (e.g. deleting the games which just ended) is run here
+
+	if( m_GameThreads )
+	{
+		m_GameThreads->Stop( );
+		m_GameThreads->RunMainTasks( );
+
+		for( vector<CBaseGame *> :: iterator i = m_Games.begin( ); i != m_Games.end( ); i++ )
+			m_GameThreads->Remove( *i );
+
+		delete m_GameThreads;
+		m_GameThreads = NULL;
+	}
+
 	delete m_UDPSocket;
 	delete m_ReconnectSocket;
 
@@ -491,6 +607,15 @@ CGHost :: ~CGHost( )
 
 	delete m_DB;
 
+	for( vector<CDBBan *> :: iterator i = m_BanList.begin( ); i != m_BanList.end( ); i++ )
+		delete *i;
+
+	delete m_BanIndex;
+
+	// the games have handed their replays over by now, wait for them to be written
+
+	delete m_ReplayWriter;
+
 	// warning: we don't delete any entries of m_Callables here because we can't be guaranteed that the associated threads have terminated
 	// this is fine if the program is currently exiting because the OS will clean up after us
 	// but if you try to recreate the CGHost object within a single session you will probably leak resources!
@@ -498,10 +623,27 @@ CGHost :: ~CGHost( )
 	if( !m_Callables.empty( ) )
 		CONSOLE_Print( "[GHOST] warning - " + UTIL_ToString( m_Callables.size( ) ) + " orphaned callables were leaked (this is not an error)" );
 
-	delete m_Language;
+	delete m_MapLoad;
 	delete m_Map;
 	delete m_AutoHostMap;
 	delete m_SaveGame;
+	delete m_ProfileCache;
+	delete m_TeamBalancer;
+	delete m_MetricsServer;
+
+	// every game (and with it every game timer) has been deleted by now
+
+	delete m_TimerWheel;
+
+	// every socket has been deleted (and unregistered) by now
+
+	delete gSocketPoller;
+	gSocketPoller = NULL;
+
+	// nothing records into the metrics registry any more
+
+	delete gMetrics;
+	gMetrics = NULL;
 }
 
 bool CGHost :: Update( long usecBlock )
@@ -562,17 +704,22 @@ bool CGHost :: Update( long usecBlock )
 	}
 
 	// update callables
+	// the database hands back the orphaned callables which have completed (and wakes us up when one does) so we don't poll all of them
+
+	vector<CBaseCallable *> CompletedCallables = m_DB->GetCompletedCallables( );
 
-	for( vector<CBaseCallable *> :: iterator i = m_Callables.begin( ); i != m_Callables.end( ); )
+	for( vector<CBaseCallable *> :: iterator i = CompletedCallables.begin( ); i != CompletedCallables.end( ); i++ )
 	{
-		if( (*i)->GetReady( ) )
-		{
-			m_DB->RecoverCallable( *i );
-			delete *i;
-			i = m_Callables.erase( i );
-		}
-		else
-			i++;
+		// a game which was deleted before its result was saved orphans the callable, the result has been committed by now
+
+		CCallableGameResultAdd *GameResultAdd = dynamic_cast<CCallableGameResultAdd *>( *i );
+
+		if( GameResultAdd )
+			InvalidateProfiles( GameResultAdd->GetGameResult( ) );
+
+		m_DB->RecoverCallable( *i );
+		m_Callables.erase( remove( m_Callables.begin( ), m_Callables.end( ), *i ), m_Callables.end( ) );
+		delete *i;
 	}
 
 	// create the GProxy++ reconnect listener
@@ -602,87 +749,27 @@ bool CGHost :: Update( long usecBlock )
 		}
 	}
 
-	unsigned int NumFDs = 0;
-
-	// take every socket we own and throw it in one giant select statement so we can block on all sockets
-
-	int nfds = 0;
-	fd_set fd;
-	fd_set send_fd;
-	FD_ZERO( &fd );
-	FD_ZERO( &send_fd );
+	// every socket we own (battle.net, the current game, all running games' players, and the GProxy++ reconnect sockets) registered itself with the socket poller when it was created
+	// so all we need to do is wait on the poller, which flags the sockets with pending work before the updates below consume them
 
-	// 1. all battle.net sockets
+	// before we wait on the poller we need to determine how long to block for
+	// the games keep their next action packet and their next housekeeping update in the timer wheel so we block until exactly the earliest of them
+	// note: we still use the passed usecBlock as a hard maximum and if a timer is already overdue we just check the sockets without blocking
 
-	for( vector<CBNET *> :: iterator i = m_BNETs.begin( ); i != m_BNETs.end( ); i++ )
-		NumFDs += (*i)->SetFD( &fd, &send_fd, &nfds );
-
-	// 2. the current game's server and player sockets
-
-	if( m_CurrentGame )
-		NumFDs += m_CurrentGame->SetFD( &fd, &send_fd, &nfds );
-
-	// 3. all running games' player sockets
-
-	for( vector<CBaseGame *> :: iterator i = m_Games.begin( ); i != m_Games.end( ); i++ )
-		NumFDs += (*i)->SetFD( &fd, &send_fd, &nfds );
-
-	// 4. the GProxy++ reconnect socket(s)
-
-	if( m_Reconnect && m_ReconnectSocket )
-	{
-		m_ReconnectSocket->SetFD( &fd, &send_fd, &nfds );
-		NumFDs++;
-	}
+	uint64_t Now = GetMicroTicks( );
+	uint64_t NextDeadline = m_TimerWheel->GetNextDeadline( Now, usecBlock );
+	usecBlock = NextDeadline > Now ? NextDeadline - Now : 0;
 
-	for( vector<CTCPSocket *> :: iterator i = m_ReconnectSockets.begin( ); i != m_ReconnectSockets.end( ); i++ )
-	{
-		(*i)->SetFD( &fd, &send_fd, &nfds );
-		NumFDs++;
-	}
-
-	// before we call select we need to determine how long to block for
-	// previously we just blocked for a maximum of the passed usecBlock microseconds
-	// however, in an effort to make game updates happen closer to the desired latency setting we now use a dynamic block interval
-	// note: we still use the passed usecBlock as a hard maximum
-
-	for( vector<CBaseGame *> :: iterator i = m_Games.begin( ); i != m_Games.end( ); i++ )
-	{
-		if( (*i)->GetNextTimedActionTicks( ) * 1000 < usecBlock )
-			usecBlock = (*i)->GetNextTimedActionTicks( ) * 1000;
-	}
-
-	// always block for at least 1ms just in case something goes wrong
-	// this prevents the bot from sucking up all the available CPU if a game keeps asking for immediate updates
-	// it's a bit ridiculous to include this check since, in theory, the bot is programmed well enough to never make this mistake
-	// however, considering who programmed it, it's worthwhile to do it anyway
-
-	if( usecBlock < 1000 )
-		usecBlock = 1000;
-
-	struct timeval tv;
-	tv.tv_sec = 0;
-	tv.tv_usec = usecBlock;
-
-	struct timeval send_tv;
-	send_tv.tv_sec = 0;
-	send_tv.tv_usec = 0;
-
-#ifdef WIN32
-	select( 1, &fd, NULL, NULL, &tv );
-	select( 1, NULL, &send_fd, NULL, &send_tv );
-#else
-	select( nfds + 1, &fd, NULL, NULL, &tv );
-	select( nfds + 1, NULL, &send_fd, NULL, &send_tv );
-#endif
+	uint64_t WaitStart = GetMicroTicks( );
+	gSocketPoller->Wait( usecBlock );
+	uint64_t WorkStart = GetMicroTicks( );
+	m_LoopWaitTime->Observe( WorkStart - WaitStart );
+	m_TimerWheel->Expire( WorkStart );
 
-	if( NumFDs == 0 )
-	{
-		// we don't have any sockets (i.e. we aren't connected to battle.net maybe due to a lost connection and there aren't any games running)
-		// select will return immediately and we'll chew up the CPU if we let it loop so just sleep for 50ms to kill some time
+	// run whatever the game threads posted for us (battle.net messages, game list rows, games to delete, ...)
 
-		MILLISLEEP( 50 );
-	}
+	if( m_GameThreads )
+		m_GameThreads->RunMainTasks( );
 
 	bool AdminExit = false;
 	bool BNETExit = false;
@@ -691,7 +778,7 @@ bool CGHost :: Update( long usecBlock )
 
 	if( m_CurrentGame )
 	{
-		if( m_CurrentGame->Update( &fd, &send_fd ) )
+		if( m_CurrentGame->Update( ) )
 		{
 			CONSOLE_Print( "[GHOST] deleting current game [" + m_CurrentGame->GetGameName( ) + "]" );
 			delete m_CurrentGame;
@@ -704,14 +791,25 @@ bool CGHost :: Update( long usecBlock )
 			}
 		}
 		else if( m_CurrentGame )
-			m_CurrentGame->UpdatePost( &send_fd );
+		{
+			m_CurrentGame->UpdateTimers( );
+			m_CurrentGame->UpdatePost( );
+		}
 	}
 
 	// update running games
+	// only the games with due timers or pending socket work are updated, with many games running most of them are idle on any given loop
+	// the games which have been handed to a game thread are updated there
 
 	for( vector<CBaseGame *> :: iterator i = m_Games.begin( ); i != m_Games.end( ); )
 	{
-		if( (*i)->Update( &fd, &send_fd ) )
+		if( (*i)->GetGameThread( ) || !(*i)->GetUpdateDue( ) )
+		{
+			i++;
+			continue;
+		}
+
+		if( (*i)->Update( ) )
 		{
 			CONSOLE_Print( "[GHOST] deleting game [" + (*i)->GetGameName( ) + "]" );
 			EventGameDeleted( *i );
@@ -720,27 +818,47 @@ bool CGHost :: Update( long usecBlock )
 		}
 		else
 		{
-			(*i)->UpdatePost( &send_fd );
+			(*i)->UpdateTimers( );
+			(*i)->UpdatePost( );
 			i++;
 		}
 	}
 
+	// hand the games which just started to the game threads, from now on we only talk to them through tasks
+
+	if( m_GameThreads )
+	{
+		for( vector<CBaseGame *> :: iterator i = m_Games.begin( ); i != m_Games.end( ); i++ )
+		{
+			if( !(*i)->GetGameThread( ) )
+				m_GameThreads->Add( *i );
+		}
+	}
+
 	// update battle.net connections
 
 	for( vector<CBNET *> :: iterator i = m_BNETs.begin( ); i != m_BNETs.end( ); i++ )
 	{
-		if( (*i)->Update( &fd, &send_fd ) )
+		if( (*i)->Update( ) )
 			BNETExit = true;
 	}
 
+	// answer metrics requests
+
+	if( m_MetricsServer )
+		m_MetricsServer->Update( );
+
 	// update GProxy++ reliable reconnect sockets
 
 	if( m_Reconnect && m_ReconnectSocket )
 	{
-		CTCPSocket *NewSocket = m_ReconnectSocket->Accept( &fd );
+		CTCPSocket *NewSocket = m_ReconnectSocket->Accept( );
 
 		if( NewSocket )
+		{
+			NewSocket->SetMetricsClass( "reconnect" );
 			m_ReconnectSockets.push_back( NewSocket );
+		}
 	}
 
 	for( vector<CTCPSocket *> :: iterator i = m_ReconnectSockets.begin( ); i != m_ReconnectSockets.end( ); )
@@ -752,70 +870,70 @@ bool CGHost :: Update( long usecBlock )
 			continue;
 		}
 
-		(*i)->DoRecv( &fd );
-		string *RecvBuffer = (*i)->GetBytes( );
-		BYTEARRAY Bytes = UTIL_CreateByteArray( (unsigned char *)RecvBuffer->c_str( ), RecvBuffer->size( ) );
+		(*i)->DoRecv( );
+		unsigned char *Bytes = (*i)->GetRecvData( );
 
 		// a packet is at least 4 bytes
 
-		if( Bytes.size( ) >= 4 )
+		if( (*i)->GetRecvSize( ) >= 4 )
 		{
 			if( Bytes[0] == GPS_HEADER_CONSTANT )
 			{
 				// bytes 2 and 3 contain the length of the packet
 
-				uint16_t Length = UTIL_ByteArrayToUInt16( Bytes, false, 2 );
+				uint16_t Length = UTIL_ByteArrayToUInt16( Bytes + 2, false );
 
 				if( Length >= 4 )
 				{
-					if( Bytes.size( ) >= Length )
+					if( (*i)->GetRecvSize( ) >= Length )
 					{
 						if( Bytes[1] == CGPSProtocol :: GPS_RECONNECT && Length == 13 )
 						{
 							unsigned char PID = Bytes[4];
-							uint32_t ReconnectKey = UTIL_ByteArrayToUInt32( Bytes, false, 5 );
-							uint32_t LastPacket = UTIL_ByteArrayToUInt32( Bytes, false, 9 );
+							uint32_t ReconnectKey = UTIL_ByteArrayToUInt32( Bytes + 5, false );
+							uint32_t LastPacket = UTIL_ByteArrayToUInt32( Bytes + 9, false );
+							(*i)->ConsumeRecvBytes( Length );
 
 							// look for a matching player in a running game
+							// the games running on a game thread can't be asked directly so we look them up by the player's PID and reconnect key and hand the socket over
 
-							CGamePlayer *Match = NULL;
-
-							for( vector<CBaseGame *> :: iterator j = m_Games.begin( ); j != m_Games.end( ); j++ )
+							if( m_GameThreads )
 							{
-								if( (*j)->GetGameLoaded( ) )
-								{
-									CGamePlayer *Player = (*j)->GetPlayerFromPID( PID );
+								CBaseGame *Game = m_GameThreads->FindReconnectGame( PID, ReconnectKey );
 
-									if( Player && Player->GetGProxy( ) && Player->GetGProxyReconnectKey( ) == ReconnectKey )
-									{
-										Match = Player;
-										break;
-									}
+								if( Game && Game->GetGameThread( ) )
+								{
+									m_GameThreads->GProxyReconnect( Game, *i, PID, ReconnectKey, LastPacket );
+									i = m_ReconnectSockets.erase( i );
+									continue;
 								}
 							}
 
-							if( Match )
-							{
-								// reconnect successful!
+							bool Reconnected = false;
 
-								*RecvBuffer = RecvBuffer->substr( Length );
-								Match->EventGProxyReconnect( *i, LastPacket );
-								i = m_ReconnectSockets.erase( i );
-								continue;
+							for( vector<CBaseGame *> :: iterator j = m_Games.begin( ); j != m_Games.end( ); j++ )
+							{
+								if( !(*j)->GetGameThread( ) && (*j)->GProxyReconnect( *i, PID, ReconnectKey, LastPacket ) )
+								{
+									Reconnected = true;
+									break;
+								}
 							}
-							else
+
+							if( !Reconnected )
 							{
 								(*i)->PutBytes( m_GPSProtocol->SEND_GPSS_REJECT( REJECTGPS_NOTFOUND ) );
-								(*i)->DoSend( &send_fd );
+								(*i)->DoSend( );
 								delete *i;
-								i = m_ReconnectSockets.erase( i );
-								continue;
 							}
+
+							i = m_ReconnectSockets.erase( i );
+							continue;
 						}
 						else
 						{
 							(*i)->PutBytes( m_GPSProtocol->SEND_GPSS_REJECT( REJECTGPS_INVALID ) );
-							(*i)->DoSend( &send_fd );
+							(*i)->DoSend( );
 							delete *i;
 							i = m_ReconnectSockets.erase( i );
 							continue;
@@ -825,7 +943,7 @@ bool CGHost :: Update( long usecBlock )
 				else
 				{
 					(*i)->PutBytes( m_GPSProtocol->SEND_GPSS_REJECT( REJECTGPS_INVALID ) );
-					(*i)->DoSend( &send_fd );
+					(*i)->DoSend( );
 					delete *i;
 					i = m_ReconnectSockets.erase( i );
 					continue;
@@ -834,14 +952,14 @@ bool CGHost :: Update( long usecBlock )
 			else
 			{
 				(*i)->PutBytes( m_GPSProtocol->SEND_GPSS_REJECT( REJECTGPS_INVALID ) );
-				(*i)->DoSend( &send_fd );
+				(*i)->DoSend( );
 				delete *i;
 				i = m_ReconnectSockets.erase( i );
 				continue;
 			}
 		}
 
-		(*i)->DoSend( &send_fd );
+		(*i)->DoSend( );
 		i++;
 	}
 
@@ -852,7 +970,7 @@ bool CGHost :: Update( long usecBlock )
 		// copy all the checks from CGHost :: CreateGame here because we don't want to spam the chat when there's an error
 		// instead we fail silently and try again soon
 
-		if( !m_ExitingNice && m_Enabled && !m_CurrentGame && m_Games.size( ) < m_MaxGames && m_Games.size( ) < m_AutoHostMaximumGames )
+		if( !m_ExitingNice && m_Enabled && !m_CurrentGame && m_AutoHostMap && m_Games.size( ) < m_MaxGames && m_Games.size( ) < m_AutoHostMaximumGames )
 		{
 			if( m_AutoHostMap->GetValid( ) )
 			{
@@ -934,7 +1052,18 @@ bool CGHost :: Update( long usecBlock )
 
     if( m_CallableGetBotConfig && m_CallableGetBotConfig->GetReady( )) {
         map<string, string> configs = m_CallableGetBotConfig->GetResult( );
+
+        // the game threads read the config values while they're running their games so they wait until we're done replacing them
+
+        if( m_GameThreads )
+            m_GameThreads->Pause( );
+
         ParseConfigValues( configs );
+
+        if( m_GameThreads )
+            m_GameThreads->Resume( );
+
+        PublishSnapshots( );
          
         m_DB->RecoverCallable( m_CallableGetBotConfig );
         delete m_CallableGetBotConfig;
@@ -943,7 +1072,14 @@ bool CGHost :: Update( long usecBlock )
 
     if( m_CallableGetBotConfigText && m_CallableGetBotConfigText->GetReady( )) {
         map<string, vector<string>> texts = m_CallableGetBotConfigText->GetResult( );
+
+        if( m_GameThreads )
+            m_GameThreads->Pause( );
+
         ParseConfigTexts( texts );
+
+        if( m_GameThreads )
+            m_GameThreads->Resume( );
         
         m_DB->RecoverCallable( m_CallableGetBotConfigText );
         delete m_CallableGetBotConfigText;
@@ -952,6 +1088,16 @@ bool CGHost :: Update( long usecBlock )
 
     if( m_CallableGetLanguages && m_CallableGetLanguages->GetReady( )) {
         m_Translations = m_CallableGetLanguages->GetResult( );
+
+        // the games might be using the current language right now so the translations go into a copy
+
+        if( m_Language )
+        {
+            boost :: shared_ptr<CLanguage> Language( new CLanguage( *m_Language ) );
+            Language->SetTranslations( m_Translations );
+            m_Language = Language;
+            PublishSnapshots( );
+        }
         
         m_DB->RecoverCallable( m_CallableGetLanguages );
         delete m_CallableGetLanguages;
@@ -960,8 +1106,11 @@ bool CGHost :: Update( long usecBlock )
 
     if( m_CallableGetMapConfig && m_CallableGetMapConfig->GetReady( )) {
         if(! m_CurrentGame ){
-            m_Map = new CMap( this, m_CallableGetMapConfig->GetResult( ) );
-            m_AutoHostMap = new CMap( *m_Map );
+            // the map is read and hashed on another thread, the old map stays in use until it's done
+            // if we're still loading an older config wait for that to finish (this only happens if the config changes very quickly)
+
+            delete m_MapLoad;
+            m_MapLoad = new CMapLoad( this, m_CallableGetMapConfig->GetResult( ) );
             
             m_SaveGame = new CSaveGame( );
         }
@@ -970,10 +1119,23 @@ bool CGHost :: Update( long usecBlock )
         delete m_CallableGetMapConfig;
         m_CallableGetMapConfig = NULL;
     }
+
+    if( m_MapLoad && m_MapLoad->GetReady( ) ) {
+        // games have their own copy of the map so the old one can be deleted right away
+
+        delete m_Map;
+        delete m_AutoHostMap;
+        m_Map = m_MapLoad->GetMap( );
+        m_AutoHostMap = new CMap( *m_Map );
+
+        delete m_MapLoad;
+        m_MapLoad = NULL;
+    }
     
     if( m_CallableAdminLists && m_CallableAdminLists->GetReady( )) {
-        m_AdminList = m_CallableAdminLists->GetResult( );
-        CONSOLE_Print("[OHSystem] Loaded " + UTIL_ToString(m_AdminList.size()) + " users.");
+        m_AdminList = boost :: shared_ptr<const map<string, uint32_t> >( new map<string, uint32_t>( m_CallableAdminLists->GetResult( ) ) );
+        CONSOLE_Print("[OHSystem] Loaded " + UTIL_ToString(m_AdminList->size()) + " users.");
+        PublishSnapshots( );
         
         m_DB->RecoverCallable( m_CallableAdminLists );
         delete m_CallableAdminLists;
@@ -981,7 +1143,14 @@ bool CGHost :: Update( long usecBlock )
     }
     
     if( m_CallableGetAliases && m_CallableGetAliases->GetReady( )) {
+        if( m_GameThreads )
+            m_GameThreads->Pause( );
+
         m_Aliases = m_CallableGetAliases->GetResult( );
+
+        if( m_GameThreads )
+            m_GameThreads->Resume( );
+
         CONSOLE_Print("[OHSystem] Loaded " + UTIL_ToString(m_Aliases.size()) + " aliases.");
         
         m_DB->RecoverCallable( m_CallableGetAliases );
@@ -990,7 +1159,14 @@ bool CGHost :: Update( long usecBlock )
     }
     
     if( m_CallableGetStatsTemplates && m_CallableGetStatsTemplates->GetReady( )) {
+        if( m_GameThreads )
+            m_GameThreads->Pause( );
+
         m_StatsTemplates = m_CallableGetStatsTemplates->GetResult( );
+
+        if( m_GameThreads )
+            m_GameThreads->Resume( );
+
         CONSOLE_Print("[OHSystem] Loaded " + UTIL_ToString(m_StatsTemplates.size()) + " stats templates.");
 
         m_DB->RecoverCallable( m_CallableGetStatsTemplates );
@@ -1006,14 +1182,38 @@ bool CGHost :: Update( long usecBlock )
     }
 	
     if( m_CallableBanList && m_CallableBanList->GetReady( )) {
+        // the old bans are only referenced by the old index so they can go now
+
+        for( vector<CDBBan *> :: iterator i = m_BanList.begin( ); i != m_BanList.end( ); ++i )
+            delete *i;
+
+        delete m_BanIndex;
         m_BanList = m_CallableBanList->GetResult( );
+        m_BanIndex = new CBanIndex( m_BanList );
         CONSOLE_Print("[OHSystem] Loaded " + UTIL_ToString(m_BanList.size()) + " bans");
 
         m_DB->RecoverCallable( m_CallableBanList );
         delete m_CallableBanList;
         m_CallableBanList = NULL;
     }
-        
+
+	// write the queued oh_gamelist rows in one batch every 3 seconds
+	// only one batch is in flight at a time, rows queued in the meantime simply wait for the next one
+
+	if( m_CallableGameListUpdate && m_CallableGameListUpdate->GetReady( ) )
+	{
+		m_DB->RecoverCallable( m_CallableGameListUpdate );
+		delete m_CallableGameListUpdate;
+		m_CallableGameListUpdate = NULL;
+	}
+
+	if( !m_CallableGameListUpdate && GetTime( ) - m_LastGameListFlush >= 3 )
+	{
+		FlushGameListRows( );
+		m_LastGameListFlush = GetTime( );
+	}
+
+	m_LoopWorkTime->Observe( GetMicroTicks( ) - WorkStart );
     return m_Exiting || AdminExit || BNETExit;
 }
 
@@ -1095,6 +1295,83 @@ void CGHost :: EventGameDeleted( CBaseGame *game )
 	}
 }
 
+void CGHost :: DeleteGame( CBaseGame *game )
+{
+	// posted by a game thread when one of its games is over, the game has already been handed back to us
+
+	CONSOLE_Print( "[GHOST] deleting game [" + game->GetGameName( ) + "]" );
+	EventGameDeleted( game );
+
+	if( m_GameThreads )
+		m_GameThreads->Remove( game );
+
+	m_Games.erase( remove( m_Games.begin( ), m_Games.end( ), game ), m_Games.end( ) );
+	delete game;
+}
+
+void CGHost :: PublishSnapshots( )
+{
+	// the games only ever see the language and the admin list through their snapshots
+	// the running games get the new ones with their next update, i.e. never in the middle of one
+
+	if( m_CurrentGame )
+		m_CurrentGame->SetSnapshots( m_Language, m_AdminList );
+
+	for( vector<CBaseGame *> :: iterator i = m_Games.begin( ); i != m_Games.end( ); i++ )
+		(*i)->RunOnGameThread( boost :: bind( &CBaseGame :: SetSnapshots, *i, m_Language, m_AdminList ) );
+}
+
+void CGHost :: QueueBNETChatCommand( string chatCommand )
+{
+	for( vector<CBNET *> :: iterator i = m_BNETs.begin( ); i != m_BNETs.end( ); i++ )
+		(*i)->QueueChatCommand( chatCommand );
+}
+
+void CGHost :: QueueBNETWhisper( string user, string message )
+{
+	for( vector<CBNET *> :: iterator i = m_BNETs.begin( ); i != m_BNETs.end( ); i++ )
+		(*i)->QueueChatCommand( message, user, true );
+}
+
+void CGHost :: QueueSpoofCheck( string server, string name, unsigned char gameState )
+{
+	for( vector<CBNET *> :: iterator i = m_BNETs.begin( ); i != m_BNETs.end( ); i++ )
+	{
+		if( (*i)->GetServer( ) == server )
+		{
+			if( gameState == GAME_PUBLIC )
+			{
+				if( (*i)->GetPasswordHashType( ) == "pvpgn" )
+					(*i)->QueueChatCommand( "/whereis " + name );
+				else
+					(*i)->QueueChatCommand( "/whois " + name );
+			}
+			else if( gameState == GAME_PRIVATE )
+				(*i)->QueueChatCommand( m_Language->SpoofCheckByReplying( ), name, true );
+		}
+	}
+}
+
+void CGHost :: UnqueueSpoofCheck( string server, string name )
+{
+	// remove any queued spoofcheck messages for this player
+
+	for( vector<CBNET *> :: iterator i = m_BNETs.begin( ); i != m_BNETs.end( ); i++ )
+	{
+		if( (*i)->GetServer( ) == server )
+		{
+			// hackhack: there must be a better way to do this
+
+			if( (*i)->GetPasswordHashType( ) == "pvpgn" )
+				(*i)->UnqueueChatCommand( "/whereis " + name );
+			else
+				(*i)->UnqueueChatCommand( "/whois " + name );
+
+			(*i)->UnqueueChatCommand( "/w " + name + " " + m_Language->SpoofCheckByReplying( ) );
+		}
+	}
+}
+
 void CGHost :: ReloadConfigs( )
 {
     m_CallableGetBotConfig = m_DB->ThreadedGetBotConfigs( );
@@ -1102,6 +1379,23 @@ void CGHost :: ReloadConfigs( )
     m_CallableGetLanguages = m_DB->ThreadedGetLanguages( );
 }
 
+void CGHost :: OrphanCallable( CBaseCallable *callable )
+{
+	// the callable is deleted by Update once the database reports it as completed
+
+	m_Callables.push_back( callable );
+	m_DB->OrphanCallable( callable );
+}
+
+void CGHost :: InvalidateProfiles( CDBGameResult *result )
+{
+	// the game result has been committed so the players' scores and stats have changed, drop whatever the profile cache remembers about them
+	// this has to wait for the commit, otherwise a lookup in the meantime would cache the old stats again
+
+	for( vector<CDBGamePlayer> :: iterator i = result->m_GamePlayers.begin( ); i != result->m_GamePlayers.end( ); i++ )
+		m_ProfileCache->Invalidate( i->GetName( ) );
+}
+
 void CGHost :: ExtractScripts( )
 {
 	string PatchMPQFileName = m_Warcraft3Path + "War3Patch.mpq";
@@ -1172,6 +1466,97 @@ void CGHost :: ExtractScripts( )
 		CONSOLE_Print( "[GHOST] warning - unable to load MPQ file [" + PatchMPQFileName + "] - error code " + UTIL_ToString( GetLastError( ) ) );
 }
 
+void CGHost :: RefillDownloadTokens( )
+{
+	// token bucket for the map download speed limit
+	// it holds at most one second's worth of data so an idle period doesn't turn into a burst
+
+	uint32_t Ticks = GetTicks( );
+	uint64_t Rate = (uint64_t)m_MaxDownloadSpeed * 1024;
+	uint64_t Tokens = m_DownloadTokens + Rate * ( Ticks - m_LastDownloadTokenTicks ) / 1000;
+	m_DownloadTokens = (uint32_t)min( Tokens, Rate );
+	m_LastDownloadTokenTicks = Ticks;
+}
+
+void CGHost :: QueueGameListRow( GameListRow row )
+{
+	// every game only ever has one row pending
+	// a reset supersedes anything queued before it, an update replaces an earlier update but must not replace a pending reset
+
+	for( vector<GameListRow> :: iterator i = m_GameListRows.begin( ); i != m_GameListRows.end( ); )
+	{
+		if( i->HostCounter == row.HostCounter && ( row.Reset || !i->Reset ) )
+			i = m_GameListRows.erase( i );
+		else
+			i++;
+	}
+
+	m_GameListRows.push_back( row );
+}
+
+void CGHost :: ForgetGameListRow( uint32_t hostCounter )
+{
+	// the game is being deleted so an update which is still pending would only write its row (and its signature) back
+	// a pending reset is kept because it deletes the row
+
+	for( vector<GameListRow> :: iterator i = m_GameListRows.begin( ); i != m_GameListRows.end( ); )
+	{
+		if( i->HostCounter == hostCounter && !i->Reset )
+			i = m_GameListRows.erase( i );
+		else
+			i++;
+	}
+
+	m_GameListSignatures.erase( hostCounter );
+}
+
+void CGHost :: FlushGameListRows( )
+{
+	if( m_GameListRows.empty( ) )
+		return;
+
+	vector<GameListRow> Rows;
+
+	for( vector<GameListRow> :: iterator i = m_GameListRows.begin( ); i != m_GameListRows.end( ); i++ )
+	{
+		if( i->Reset )
+		{
+			// a reset also deletes every lobby row so forget those too, the lobbies will be rewritten on their next update
+
+			for( map<uint32_t, string> :: iterator j = m_GameListSignatures.begin( ); j != m_GameListSignatures.end( ); )
+			{
+				if( j->first == i->HostCounter || j->second[0] == '1' )
+					m_GameListSignatures.erase( j++ );
+				else
+					j++;
+			}
+
+			Rows.push_back( *i );
+			continue;
+		}
+
+		// the duration changes every update so it's only compared in 30 second steps, everything else has to match exactly
+
+		string Signature = UTIL_ToString( i->Lobby ) + "|" + UTIL_ToString( i->Duration / 30 ) + "|" + i->GameName + "|" + i->OwnerName + "|" + UTIL_ToString( i->Players ) + "|" + UTIL_ToString( i->Total ) + "|";
+
+		for( vector<PlayerOfPlayerList> :: iterator j = i->PlayerList.begin( ); j != i->PlayerList.end( ); j++ )
+			Signature += UTIL_ToString( j->Slot ) + "," + UTIL_ToString( j->Team ) + "," + UTIL_ToString( j->Color ) + "," + j->Username + "," + j->Realm + "," + UTIL_ToString( j->Ping ) + "," + j->IP + "," + UTIL_ToString( j->LeftTime ) + "," + j->LeftReason + "#";
+
+		map<uint32_t, string> :: iterator Found = m_GameListSignatures.find( i->HostCounter );
+
+		if( Found != m_GameListSignatures.end( ) && Found->second == Signature )
+			continue;
+
+		m_GameListSignatures[i->HostCounter] = Signature;
+		Rows.push_back( *i );
+	}
+
+	m_GameListRows.clear( );
+
+	if( !Rows.empty( ) )
+		m_CallableGameListUpdate = m_DB->ThreadedGameUpdate( Rows );
+}
+
 void CGHost :: CreateGame( CMap *map, unsigned char gameState, bool saveGame, string gameName, string ownerName, string creatorName, string creatorServer, bool whisper )
 {
 	if( !m_Enabled )
@@ -1320,7 +1705,7 @@ void CGHost :: CreateGame( CMap *map, unsigned char gameState, bool saveGame, st
 			(*i)->HoldClan( m_CurrentGame );
 	}
         
-        m_Callables.push_back(m_DB->ThreadedUpdateGameInfo(m_NewGameId, gameName));
+        OrphanCallable(m_DB->ThreadedUpdateGameInfo(m_NewGameId, gameName));
         m_NewGameId = 0;
 	m_LastGameIdUpdate = GetTime();
 }
@@ -1332,8 +1717,8 @@ void CGHost :: ParseConfigValues( map<string, string> configs )
     for(config_iterator iterator = configs.begin(); iterator != configs.end(); iterator++)
     {
         if(iterator->first == "bot_language") {
-            delete m_Language;
-            m_Language = new CLanguage( iterator->second );
+            m_Language = boost :: shared_ptr<CLanguage>( new CLanguage( iterator->second ) );
+            m_Language->SetTranslations( m_Translations );
         } else if(iterator->first == "bot_tft") {
             m_TFT = UTIL_ToUInt32(iterator->second) == 0 ? false : true;
         } else if(iterator->first == "bot_bindaddress") {
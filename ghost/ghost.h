@@ -35,10 +35,19 @@ class CCRC32;
 class CSHA1;
 class CBNET;
 class CBaseGame;
+class CGameThreads;
+class CTeamBalancer;
+class CMetricsServer;
+class CTimerWheel;
+class CMetricHistogram;
+class CReplayWriter;
+class CProfileCache;
 class CGHostDB;
 class CBaseCallable;
+class CDBGameResult;
 class CLanguage;
 class CMap;
+class CMapLoad;
 class CSaveGame;
 class CConfig;
 class CCallableBanList;
@@ -51,6 +60,9 @@ class CCallableAdminList;
 class CCallableGetAliases;
 class CCallableGetStatsTemplates;
 class CDBBan;
+class CBanIndex;
+class CCallableGameUpdate;
+struct GameListRow;
 
 class CGHost
 {
@@ -64,6 +76,14 @@ public:
 	vector<CBNET *> m_BNETs;				// all our battle.net connections (there can be more than one)
 	CBaseGame *m_CurrentGame;				// this game is still in the lobby state
 	vector<CBaseGame *> m_Games;			// these games are in progress
+	CGameThreads *m_GameThreads;			// the threads running the started games (NULL if disabled)
+	CTimerWheel *m_TimerWheel;				// the games' action and housekeeping timers
+	CReplayWriter *m_ReplayWriter;			// background thread for compressing and saving replays
+	CProfileCache *m_ProfileCache;			// players' ids, scores and stats from the database
+	CTeamBalancer *m_TeamBalancer;			// for balancing the slots at game start with matchmaking
+	CMetricsServer *m_MetricsServer;		// serves gMetrics over HTTP (NULL if disabled)
+	CMetricHistogram *m_LoopWaitTime;		// time spent waiting on the socket poller per main loop iteration
+	CMetricHistogram *m_LoopWorkTime;		// time spent working per main loop iteration
 	CGHostDB *m_DB;							// database
 	CGHostDB *m_DBLocal;					// local database (for temporary data)
         CCallableGetGameId *m_CallableGetGameId;
@@ -75,11 +95,16 @@ public:
         CCallableGetAliases *m_CallableGetAliases;
         CCallableGetStatsTemplates *m_CallableGetStatsTemplates;
         CCallableBanList *m_CallableBanList;
+        CCallableGameUpdate *m_CallableGameListUpdate;	// the oh_gamelist batch currently being written (NULL if none)
+        vector<GameListRow> m_GameListRows;				// oh_gamelist rows waiting for the next batch (at most one per game)
+        map<uint32_t, string> m_GameListSignatures;		// what the database holds for each game's row, used to skip rows that haven't changed
+        uint32_t m_LastGameListFlush;					// GetTime when the last oh_gamelist batch was sent
 	vector<CBaseCallable *> m_Callables;	// vector of orphaned callables waiting to die
 	vector<BYTEARRAY> m_LocalAddresses;		// vector of local IP addresses
-	CLanguage *m_Language;					// language
+	boost :: shared_ptr<CLanguage> m_Language;	// language (replaced, never changed, because the games keep a snapshot of it)
 	CMap *m_Map;							// the currently loaded map
 	CMap *m_AutoHostMap;					// the map to use when autohosting
+	CMapLoad *m_MapLoad;					// the map being loaded in the background (replaces m_Map and m_AutoHostMap when it's done)
 	CSaveGame *m_SaveGame;					// the save game to use
 	vector<PIDPlayer> m_EnforcePlayers;		// vector of pids to force players to use in the next game (used with saved games)
 	bool m_Exiting;							// set to true to force ghost to shutdown next update (used by SignalCatcher)
@@ -106,6 +131,7 @@ public:
 	bool m_Reconnect;						// config value: GProxy++ reliable reconnects enabled or not
 	uint16_t m_ReconnectPort;				// config value: the port to listen for GProxy++ reliable reconnects on
 	uint32_t m_ReconnectWaitTime;			// config value: the maximum number of minutes to wait for a GProxy++ reliable reconnect
+	uint32_t m_ReconnectBufferSize;			// config value: the maximum number of kilobytes of unacked packets each game keeps for GProxy++ reliable reconnects
 	uint32_t m_MaxGames;					// config value: maximum number of games in progress
 	char m_CommandTrigger;					// config value: the command trigger inside games
 	string m_MapCFGPath;					// config value: map cfg path
@@ -126,6 +152,8 @@ public:
 	bool m_PingDuringDownloads;				// config value: ping during map downloads or not
 	uint32_t m_MaxDownloaders;				// config value: maximum number of map downloaders at the same time
 	uint32_t m_MaxDownloadSpeed;			// config value: maximum total map download speed in KB/sec
+	uint32_t m_DownloadTokens;				// # of map bytes that may be sent right now (refilled at m_MaxDownloadSpeed and shared by every lobby)
+	uint32_t m_LastDownloadTokenTicks;		// GetTicks when m_DownloadTokens was last refilled
 	bool m_LCPings;							// config value: use LC style pings (divide actual pings by two)
 	uint32_t m_AutoKickPing;				// config value: auto kick players with ping higher than this
 	uint32_t m_BanMethod;					// config value: ban method (ban by name/ip/both)
@@ -148,11 +176,12 @@ public:
         vector<string> m_GameOver;
         map<int, map<string, string>> m_BNetCollection;
         map<string, map<uint32_t, string>> m_Translations;
-        map<string, uint32_t> m_AdminList;
+        boost :: shared_ptr<const map<string, uint32_t> > m_AdminList;	// replaced, never changed, because the games keep a snapshot of it
         map<uint32_t, string> m_Aliases;
         uint32_t m_AliasId;
         map<uint32_t, string> m_StatsTemplates;
         vector<CDBBan *> m_BanList;
+        CBanIndex *m_BanIndex;					// index over m_BanList for checking joining players
         uint32_t m_LastListRefresh;
 	string m_AutoHostSplitter;
         uint32_t m_BanLastTime;
@@ -181,10 +210,25 @@ public:
 	void EventBNETEmote( CBNET *bnet, string user, string message );
 	void EventGameDeleted( CBaseGame *game );
 
+	// the running games' access to the main thread (see CGameThread)
+
+	void DeleteGame( CBaseGame *game );
+	void PublishSnapshots( );
+	void QueueBNETChatCommand( string chatCommand );
+	void QueueBNETWhisper( string user, string message );
+	void QueueSpoofCheck( string server, string name, unsigned char gameState );
+	void UnqueueSpoofCheck( string server, string name );
+
 	// other functions
 
+	void OrphanCallable( CBaseCallable *callable );
+	void InvalidateProfiles( CDBGameResult *result );
 	void ExtractScripts( );
     void ReloadConfigs( );
+	void RefillDownloadTokens( );
+	void QueueGameListRow( GameListRow row );
+	void ForgetGameListRow( uint32_t hostCounter );
+	void FlushGameListRows( );
 	void CreateGame( CMap *map, unsigned char gameState, bool saveGame, string gameName, string ownerName, string creatorName, string creatorServer, bool whisper );
     
     // configs
@@ -21,6 +21,7 @@
 #include "ghost.h"
 #include "util.h"
 #include "config.h"
+#include "socket.h"
 #include "ghostdb.h"
 
 #include <initializer_list>
@@ -44,6 +45,47 @@ void CGHostDB :: RecoverCallable( CBaseCallable *callable )
 
 }
 
+void CGHostDB :: CompleteCallable( CBaseCallable *callable )
+{
+	bool Orphaned = false;
+
+	{
+		// the callable must be marked as ready under the lock, otherwise OrphanCallable could miss it
+
+		boost :: mutex :: scoped_lock Lock( m_CompletedMutex );
+		callable->SetReady( true );
+
+		// after this point the callable may be deleted by its owner (if it has one) so we only compare the pointer
+
+		if( m_Orphans.erase( callable ) > 0 )
+		{
+			m_Completed.push_back( callable );
+			Orphaned = true;
+		}
+	}
+
+	if( Orphaned && gSocketPoller )
+		gSocketPoller->Wake( );
+}
+
+void CGHostDB :: OrphanCallable( CBaseCallable *callable )
+{
+	boost :: mutex :: scoped_lock Lock( m_CompletedMutex );
+
+	if( callable->GetReady( ) )
+		m_Completed.push_back( callable );
+	else
+		m_Orphans.insert( callable );
+}
+
+vector<CBaseCallable *> CGHostDB :: GetCompletedCallables( )
+{
+	vector<CBaseCallable *> Completed;
+	boost :: mutex :: scoped_lock Lock( m_CompletedMutex );
+	Completed.swap( m_Completed );
+	return Completed;
+}
+
 bool CGHostDB :: Begin( )
 {
 	return true;
@@ -221,7 +263,7 @@ map<uint32_t, string> CGHostDB :: GetAliases( )
 
 void CGHostDB :: CreateThread( CBaseCallable *callable )
 {
-	callable->SetReady( true );
+	CompleteCallable( callable );
 }
 
 map<string, string> CGHostDB :: GetMapConfig( string configname )
@@ -229,7 +271,7 @@ map<string, string> CGHostDB :: GetMapConfig( string configname )
     return {};
 }
 
-string CGHostDB :: GameUpdate( uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist )
+string CGHostDB :: GameUpdate( vector<GameListRow> rows )
 {
     return "";
 }
@@ -319,6 +361,12 @@ CCallableGamePlayerAdd *CGHostDB :: ThreadedGamePlayerAdd( uint32_t gameid, stri
 	return NULL;
 }
 
+CCallableGameResultAdd *CGHostDB :: ThreadedGameResultAdd( CDBGameResult *result )
+{
+	delete result;
+	return NULL;
+}
+
 CCallableGamePlayerSummaryCheck *CGHostDB :: ThreadedGamePlayerSummaryCheck( string name )
 {
 	return NULL;
@@ -404,7 +452,7 @@ CCallableGetMapConfig *CGHostDB :: ThreadedGetMapConfig( string configname )
 	return NULL;
 }
 
-CCallableGameUpdate *CGHostDB :: ThreadedGameUpdate( uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist )
+CCallableGameUpdate *CGHostDB :: ThreadedGameUpdate( vector<GameListRow> rows )
 {
     return NULL;
 }
@@ -429,6 +477,11 @@ CCallableGetPlayerScore *CGHostDB :: ThreadedGetPlayerScore( uint32_t aliasid, u
         return NULL;
 }
 
+CCallableGetPlayerStatsBatch *CGHostDB :: ThreadedGetPlayerStatsBatch( uint32_t aliasid, vector<uint32_t> playerids )
+{
+	return NULL;
+}
+
 CCallableUpdateGameInfo *CGHostDB :: ThreadedUpdateGameInfo( uint32_t gameid, string gamename )
 {
         return NULL;
@@ -505,6 +558,11 @@ CCallableGameAdd :: ~CCallableGameAdd( )
 
 }
 
+CCallableGameResultAdd :: ~CCallableGameResultAdd( )
+{
+	delete m_GameResult;
+}
+
 CCallableGamePlayerAdd :: ~CCallableGamePlayerAdd( )
 {
 
@@ -610,6 +668,11 @@ CCallableGetPlayerScore :: ~CCallableGetPlayerScore( )
 
 }
 
+CCallableGetPlayerStatsBatch :: ~CCallableGetPlayerStatsBatch( )
+{
+
+}
+
 CCallableUpdateGameInfo :: ~CCallableUpdateGameInfo( )
 {
 
@@ -635,6 +698,126 @@ CDBBan :: ~CDBBan( )
 
 }
 
+//
+// CBanIndex
+//
+
+CBanIndex :: CBanIndex( vector<CDBBan *> bans )
+{
+	m_Bans = bans;
+	m_PrefixNodes.push_back( BanPrefixNode( ) );
+	m_PrefixNodes[0].Ban = BANINDEX_NONE;
+
+	for( uint32_t i = 0; i < m_Bans.size( ); i++ )
+	{
+		string Name = m_Bans[i]->GetName( );
+		string IP = m_Bans[i]->GetIP( );
+		transform( Name.begin( ), Name.end( ), Name.begin( ), ::tolower );
+
+		// insert only keeps the first ban for each key
+
+		m_Names.insert( make_pair( Name, i ) );
+
+		if( IP.empty( ) )
+			continue;
+
+		m_IPs.insert( make_pair( IP, i ) );
+
+		if( IP[0] == ':' )
+		{
+			string BanIP = IP.substr( 1 );
+			uint32_t Node = 0;
+
+			for( string :: iterator j = BanIP.begin( ); j != BanIP.end( ); j++ )
+			{
+				map<unsigned char, uint32_t> :: iterator Child = m_PrefixNodes[Node].Children.find( *j );
+
+				if( Child == m_PrefixNodes[Node].Children.end( ) )
+				{
+					m_PrefixNodes[Node].Children[*j] = m_PrefixNodes.size( );
+					Node = m_PrefixNodes.size( );
+					m_PrefixNodes.push_back( BanPrefixNode( ) );
+					m_PrefixNodes[Node].Ban = BANINDEX_NONE;
+				}
+				else
+					Node = Child->second;
+			}
+
+			if( m_PrefixNodes[Node].Ban == BANINDEX_NONE )
+				m_PrefixNodes[Node].Ban = i;
+
+			if( BanIP.size( ) >= 3 && BanIP[0] == 'h' )
+				m_Hostnames.push_back( make_pair( i, BanIP.substr( 1 ) ) );
+		}
+	}
+}
+
+CBanIndex :: ~CBanIndex( )
+{
+
+}
+
+CDBBan *CBanIndex :: FindName( string name )
+{
+	transform( name.begin( ), name.end( ), name.begin( ), ::tolower );
+	boost :: unordered_map<string, uint32_t> :: iterator i = m_Names.find( name );
+
+	if( i != m_Names.end( ) )
+		return m_Bans[i->second];
+
+	return NULL;
+}
+
+CDBBan *CBanIndex :: FindIP( string ip )
+{
+	// transform in case it's a hostname
+
+	transform( ip.begin( ), ip.end( ), ip.begin( ), ::tolower );
+	uint32_t First = BANINDEX_NONE;
+
+	boost :: unordered_map<string, uint32_t> :: iterator Exact = m_IPs.find( ip );
+
+	if( Exact != m_IPs.end( ) )
+		First = Exact->second;
+
+	// every node along the IP address's path through the prefix tree is a prefix ban that matches
+	// the empty prefix (a ban of just ":") matches everything
+
+	uint32_t Node = 0;
+
+	for( string :: size_type i = 0; ; i++ )
+	{
+		First = min( First, m_PrefixNodes[Node].Ban );
+
+		if( i == ip.size( ) )
+			break;
+
+		map<unsigned char, uint32_t> :: iterator Child = m_PrefixNodes[Node].Children.find( ip[i] );
+
+		if( Child == m_PrefixNodes[Node].Children.end( ) )
+			break;
+
+		Node = Child->second;
+	}
+
+	if( ip.size( ) >= 3 && ip[0] == 'h' )
+	{
+		for( vector<pair<uint32_t, string> > :: iterator i = m_Hostnames.begin( ); i != m_Hostnames.end( ); i++ )
+		{
+			if( i->first < First && ip.find( i->second, 1 ) != string :: npos )
+			{
+				First = i->first;
+				break;
+			}
+		}
+	}
+
+	if( First != BANINDEX_NONE )
+		return m_Bans[First];
+
+	return NULL;
+}
+
 //
 // CDBGame
 //
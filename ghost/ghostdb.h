@@ -21,6 +21,9 @@
 #ifndef GHOSTDB_H
 #define GHOSTDB_H
 
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+
 //
 // CGHostDB
 //
@@ -37,6 +40,7 @@ class CCallableBanAdd;
 class CCallableBanRemove;
 class CCallableBanList;
 class CCallableGameAdd;
+class CCallableGameResultAdd;
 class CCallableGamePlayerAdd;
 class CCallableGamePlayerSummaryCheck;
 class CCallableDotAGameAdd;
@@ -58,13 +62,16 @@ class CCallableGetAliases;
 class CCallableGetStatsTemplates;
 class CCallableGetPlayerStats;
 class CCallableGetPlayerScore;
+class CCallableGetPlayerStatsBatch;
 class CCallableUpdateGameInfo;
 class CDBBan;
 class CDBGame;
+class CDBGameResult;
 class CDBGamePlayer;
 class CDBGamePlayerSummary;
 class CDBDotAPlayerSummary;
 struct PlayerOfPlayerList;
+struct GameListRow;
 
 typedef pair<uint32_t,string> VarP;
 
@@ -73,6 +80,9 @@ class CGHostDB
 protected:
 	bool m_HasError;
 	string m_Error;
+	boost :: mutex m_CompletedMutex;
+	set<CBaseCallable *> m_Orphans;				// orphaned callables which haven't completed yet
+	vector<CBaseCallable *> m_Completed;		// orphaned callables which have completed, waiting for the main thread to delete them
 
 public:
 	CGHostDB( CConfig *CFG );
@@ -84,6 +94,14 @@ public:
 
 	virtual void RecoverCallable( CBaseCallable *callable );
 
+	// completion of threaded callables
+	// the database marks a callable as ready in CompleteCallable (from whichever thread ran it)
+	// an orphaned callable is moved to the completed list at that point and the main thread is woken up to delete it
+
+	void CompleteCallable( CBaseCallable *callable );
+	void OrphanCallable( CBaseCallable *callable );
+	vector<CBaseCallable *> GetCompletedCallables( );
+
 	// standard (non-threaded) database functions
 
 	virtual bool Begin( );
@@ -121,7 +139,7 @@ public:
         virtual map<string, vector<string> > GetBotConfigTexts( );
         virtual map<string, map<uint32_t, string> > GetLanguages( );
         virtual map<string, string> GetMapConfig( string configname );
-        virtual string GameUpdate( uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist );
+        virtual string GameUpdate( vector<GameListRow> rows );
         virtual map<uint32_t, string> GetAliases( );
         virtual map<uint32_t, string> GetStatsTemplates( );
         virtual map<string, string> GetPlayerStats( uint32_t aliasid, uint32_t playerid );
@@ -144,6 +162,7 @@ public:
 	virtual CCallableBanList *ThreadedBanList( string server );
 	virtual CCallableGameAdd *ThreadedGameAdd( string server, string map, string gamename, string ownername, uint32_t duration, uint32_t gamestate, string creatorname, string creatorserver, uint32_t gameid, uint32_t aliasid, vector<string> lobbylog, vector<string> gamelog, string elochange );
 	virtual CCallableGamePlayerAdd *ThreadedGamePlayerAdd( uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour, uint32_t playerid );
+	virtual CCallableGameResultAdd *ThreadedGameResultAdd( CDBGameResult *result );
 	virtual CCallableGamePlayerSummaryCheck *ThreadedGamePlayerSummaryCheck( string name );
 	virtual CCallableDotAGameAdd *ThreadedDotAGameAdd( uint32_t gameid, uint32_t winner, uint32_t min, uint32_t sec );
 	virtual CCallableDotAPlayerAdd *ThreadedDotAPlayerAdd( uint32_t gameid, uint32_t colour, uint32_t kills, uint32_t deaths, uint32_t creepkills, uint32_t creepdenies, uint32_t assists, uint32_t gold, uint32_t neutralkills, string item1, string item2, string item3, string item4, string item5, string item6, string skill1, string skill2, string skill3, string skill4, string skill5, string skill6, string hero, uint32_t newcolour, uint32_t towerkills, uint32_t raxkills, uint32_t courierkills, uint32_t level );
@@ -161,11 +180,12 @@ public:
         virtual CCallableGetBotConfigTexts *ThreadedGetBotConfigTexts( );
         virtual CCallableGetLanguages *ThreadedGetLanguages( );
         virtual CCallableGetMapConfig *ThreadedGetMapConfig( string configname );
-        virtual CCallableGameUpdate *ThreadedGameUpdate( uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist );
+        virtual CCallableGameUpdate *ThreadedGameUpdate( vector<GameListRow> rows );
         virtual CCallableGetAliases *ThreadedGetAliases( );
         virtual CCallableGetStatsTemplates *ThreadedGetStatsTemplates( );
         virtual CCallableGetPlayerStats *ThreadedGetPlayerStats( uint32_t aliasid, uint32_t playerid );
         virtual CCallableGetPlayerScore *ThreadedGetPlayerScore( uint32_t aliasid, uint32_t playerid );
+        virtual CCallableGetPlayerStatsBatch *ThreadedGetPlayerStatsBatch( uint32_t aliasid, vector<uint32_t> playerids );
         virtual CCallableUpdateGameInfo * ThreadedUpdateGameInfo( uint32_t gameid, string gamename );
 };
 
@@ -189,7 +209,7 @@ public:
 //  - the RecoverCallable function allows the database to recover some of the callable's resources to be reused later (e.g. MySQL connections)
 //  - note that this will NOT free the callable's memory, you must do that yourself after calling the RecoverCallable function
 //  - be careful not to leak any callables, it's NOT safe to delete a callable even if you decide that you don't want the result anymore
-//  - you should deliver any to-be-orphaned callables to the main vector in CGHost so they can be properly deleted when ready even if you don't care about the result anymore
+//  - you should deliver any to-be-orphaned callables to CGHost :: OrphanCallable so they can be properly deleted when ready even if you don't care about the result anymore
 //  - e.g. if a player does a stats check immediately before a game is deleted you can't just delete the callable on game deletion unless it's ready
 
 class CBaseCallable
@@ -212,6 +232,7 @@ public:
 	virtual string GetError( )				{ return m_Error; }
 	virtual bool GetReady( )				{ return m_Ready; }
 	virtual void SetReady( bool nReady )	{ m_Ready = nReady; }
+	virtual void SetError( string nError )	{ m_Error = nError; }
 	virtual uint32_t GetElapsed( )			{ return m_Ready ? m_EndTicks - m_StartTicks : 0; }
 };
 
@@ -437,6 +458,24 @@ public:
 	virtual void SetResult( uint32_t nResult )	{ m_Result = nResult; }
 };
 
+// saves everything about a finished game (the game, its players, the DotA or W3MMD stats and the logs) in one transaction
+// the callable owns the result and deletes it, the callable's result is the game id or zero if nothing was saved
+
+class CCallableGameResultAdd : virtual public CBaseCallable
+{
+protected:
+	CDBGameResult *m_GameResult;
+	uint32_t m_Result;
+
+public:
+	CCallableGameResultAdd( CDBGameResult *nGameResult ) : CBaseCallable( ), m_GameResult( nGameResult ), m_Result( 0 ) { }
+	virtual ~CCallableGameResultAdd( );
+
+	virtual CDBGameResult *GetGameResult( )		{ return m_GameResult; }
+	virtual uint32_t GetResult( )				{ return m_Result; }
+	virtual void SetResult( uint32_t nResult )	{ m_Result = nResult; }
+};
+
 class CCallableGamePlayerSummaryCheck : virtual public CBaseCallable
 {
 protected:
@@ -556,7 +595,9 @@ public:
 	CCallableScoreCheck( string nCategory, string nName, string nServer ) : CBaseCallable( ), m_Category( nCategory ), m_Name( nName ), m_Server( nServer ), m_Result( 0.0 ) { }
 	virtual ~CCallableScoreCheck( );
 
+	virtual string GetCategory( )				{ return m_Category; }
 	virtual string GetName( )					{ return m_Name; }
+	virtual string GetServer( )					{ return m_Server; }
 	virtual double GetResult( )					{ return m_Result; }
 	virtual void SetResult( double nResult )	{ m_Result = nResult; }
 };
@@ -709,22 +750,11 @@ public:
 class CCallableGameUpdate : virtual public CBaseCallable
 {
 protected:
-    uint32_t m_Hostcounter;
-    uint32_t m_Lobby;
-    string m_MapType;
-    uint32_t m_Duration;
-    string m_Map;
-    string m_GameName;
-    string m_OwnerName;
-    string m_CreatorName;
-    bool m_Add;
-    uint32_t m_Players;
-    uint32_t m_Total;
-    vector<PlayerOfPlayerList> m_Playerlist;
+    vector<GameListRow> m_Rows;
     string m_Result;
 
 public:
-    CCallableGameUpdate( uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist ) : CBaseCallable( ), m_Map(map), m_GameName(gamename), m_OwnerName(ownername), m_CreatorName(creatorname), m_Playerlist(playerlist), m_Hostcounter(hostcounter), m_Lobby(lobby), m_MapType(map_type), m_Players(players), m_Total(total), m_Duration(duration) { }
+    CCallableGameUpdate( vector<GameListRow> rows ) : CBaseCallable( ), m_Rows( rows ) { }
     virtual ~CCallableGameUpdate( );
 
     virtual string GetResult( ) {
@@ -795,6 +825,25 @@ public:
         virtual void SetResult( double nResult ) { m_Result = nResult; }
 };
 
+// the stats of several players in one query (used to fill the profile cache when a lobby fills up)
+// players without any stats are missing from the result
+
+class CCallableGetPlayerStatsBatch : virtual public CBaseCallable
+{
+protected:
+	uint32_t m_AliasId;
+	vector<uint32_t> m_PlayerIds;
+	map<uint32_t, map<string, string> > m_Result;
+
+public:
+	CCallableGetPlayerStatsBatch( uint32_t nAliasId, vector<uint32_t> nPlayerIds ) : CBaseCallable( ), m_AliasId( nAliasId ), m_PlayerIds( nPlayerIds ) { }
+	virtual ~CCallableGetPlayerStatsBatch( );
+
+	virtual uint32_t GetAliasId( )											{ return m_AliasId; }
+	virtual map<uint32_t, map<string, string> > GetResult( )				{ return m_Result; }
+	virtual void SetResult( map<uint32_t, map<string, string> > nResult )	{ m_Result = nResult; }
+};
+
 class CCallableUpdateGameInfo : virtual public CBaseCallable
 {
 protected:
@@ -834,6 +883,42 @@ public:
 	string GetReason( )		{ return m_Reason; }
 };
 
+//
+// CBanIndex
+//
+
+// an index over the ban list so checking a joining player doesn't have to walk (and lowercase) every single ban
+// it's rebuilt whenever the ban list is refreshed and doesn't own the bans
+// every lookup returns the first matching ban in ban list order, exactly like walking the list would
+//  - names are matched case insensitively through a hash map
+//  - IP addresses are matched exactly through a hash map
+//  - ":" bans match every IP address starting with the rest of the ban, they're stored in a prefix tree
+//  - ":h" bans also match every hostname (starting with "h") containing the rest of the ban, there are only ever a few of these so they're just scanned
+
+struct BanPrefixNode {
+	map<unsigned char, uint32_t> Children;		// node indexes in CBanIndex :: m_PrefixNodes
+	uint32_t Ban;								// the first ban ending at this node (BANINDEX_NONE if none)
+};
+
+#define BANINDEX_NONE	0xFFFFFFFF
+
+class CBanIndex
+{
+private:
+	vector<CDBBan *> m_Bans;
+	boost :: unordered_map<string, uint32_t> m_Names;		// lowercase name -> first ban
+	boost :: unordered_map<string, uint32_t> m_IPs;			// IP address -> first ban
+	vector<BanPrefixNode> m_PrefixNodes;					// the prefix tree, the root is m_PrefixNodes[0]
+	vector<pair<uint32_t, string> > m_Hostnames;			// ban, hostname pattern (without the leading "h")
+
+public:
+	CBanIndex( vector<CDBBan *> bans );
+	~CBanIndex( );
+
+	CDBBan *FindName( string name );
+	CDBBan *FindIP( string ip );
+};
+
 //
 // CDBGame
 //
@@ -1106,4 +1191,67 @@ struct PlayerOfPlayerList  {
     uint8_t Slot;
 };
 
+// one game's row in oh_gamelist, the rows of every game are collected by CGHost and written in a single batch
+// a reset row deletes the game's row (and any lobby rows) instead of updating it
+
+struct GameListRow  {
+    uint32_t HostCounter;
+    bool Reset;
+    uint32_t Lobby;
+    string MapType;
+    uint32_t Duration;
+    string GameName;
+    string OwnerName;
+    string CreatorName;
+    string Map;
+    uint32_t Players;
+    uint32_t Total;
+    vector<PlayerOfPlayerList> PlayerList;
+};
+
+// one row in oh_w3mmdplayers
+
+struct W3MMDPlayerRow  {
+    uint32_t PID;
+    string Name;
+    string Flag;
+    uint32_t Leaver;
+    uint32_t Practicing;
+};
+
+//
+// CDBGameResult
+//
+
+// everything we save when a game is over, it's collected on the main thread and written by a single CCallableGameResultAdd
+// the stats classes add their part in CStats :: Save
+
+class CDBGameResult
+{
+public:
+	string m_Server;
+	string m_Map;
+	string m_GameName;
+	string m_OwnerName;
+	uint32_t m_Duration;
+	uint32_t m_GameState;
+	string m_CreatorName;
+	string m_CreatorServer;
+	uint32_t m_GameID;
+	uint32_t m_AliasID;
+	vector<string> m_LobbyLog;
+	vector<string> m_GameLog;
+	string m_EloChange;
+	vector<CDBGamePlayer> m_GamePlayers;
+	vector<CDBDotAGame> m_DotAGames;			// empty unless it's a DotA game, there's never more than one
+	vector<CDBDotAPlayer> m_DotAPlayers;
+	string m_W3MMDCategory;
+	vector<W3MMDPlayerRow> m_W3MMDPlayers;
+	map<VarP,int32_t> m_W3MMDVarInts;
+	map<VarP,double> m_W3MMDVarReals;
+	map<VarP,string> m_W3MMDVarStrings;
+
+	CDBGameResult( string nServer, string nMap, string nGameName, string nOwnerName, uint32_t nDuration, uint32_t nGameState, string nCreatorName, string nCreatorServer, uint32_t nGameID, uint32_t nAliasID, vector<string> nLobbyLog, vector<string> nGameLog, string nEloChange ) : m_Server( nServer ), m_Map( nMap ), m_GameName( nGameName ), m_OwnerName( nOwnerName ), m_Duration( nDuration ), m_GameState( nGameState ), m_CreatorName( nCreatorName ), m_CreatorServer( nCreatorServer ), m_GameID( nGameID ), m_AliasID( nAliasID ), m_LobbyLog( nLobbyLog ), m_GameLog( nGameLog ), m_EloChange( nEloChange ) { }
+};
+
 #endif
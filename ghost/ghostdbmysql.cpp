@@ -23,6 +23,7 @@
 #include "config.h"
 #include "ghostdb.h"
 #include "ghostdbmysql.h"
+#include "metrics.h"
 
 #include <signal.h>
 
@@ -31,8 +32,335 @@
 #endif
 
 #include <mysql/mysql.h>
+#include <mysql/mysqld_error.h>
 #include <boost/thread.hpp>
+#include <boost/bind.hpp>
 #include <initializer_list>
+#include <typeinfo>
+
+#ifdef __GNUC__
+ #include <cxxabi.h>
+#endif
+
+//
+// CMySQLStatements
+//
+
+// a per connection cache of server side prepared statements for the queries we run the most
+// each statement is only prepared the first time a connection runs its query, after that only the parameters are sent
+// the server forgets every statement when MYSQL_OPT_RECONNECT reconnects so we compare the connection's thread id each time and start over when it changes
+// a connection is only ever used by one thread at a time, the mutex just protects the map of connections
+
+class CMySQLStatements
+{
+private:
+	struct Connection
+	{
+		unsigned long ThreadID;
+		map<string, MYSQL_STMT *> Statements;
+
+		Connection( ) : ThreadID( 0 ) { }
+	};
+
+	static boost :: mutex m_Mutex;
+	static map<void *, Connection> m_Connections;
+
+	static Connection *GetConnection( void *conn );
+	static void CloseStatements( Connection *connection );
+
+public:
+	static MYSQL_STMT *Get( void *conn, string *error, const string &query );
+	static void Forget( void *conn, const string &query );
+	static void Close( void *conn );
+};
+
+boost :: mutex CMySQLStatements :: m_Mutex;
+map<void *, CMySQLStatements :: Connection> CMySQLStatements :: m_Connections;
+
+CMySQLStatements :: Connection *CMySQLStatements :: GetConnection( void *conn )
+{
+	// map nodes don't move so the pointer stays valid after we release the lock
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	return &m_Connections[conn];
+}
+
+void CMySQLStatements :: CloseStatements( Connection *connection )
+{
+	for( map<string, MYSQL_STMT *> :: iterator i = connection->Statements.begin( ); i != connection->Statements.end( ); i++ )
+		mysql_stmt_close( i->second );
+
+	connection->Statements.clear( );
+}
+
+MYSQL_STMT *CMySQLStatements :: Get( void *conn, string *error, const string &query )
+{
+	Connection *C = GetConnection( conn );
+	unsigned long ThreadID = mysql_thread_id( (MYSQL *)conn );
+
+	if( C->ThreadID != ThreadID )
+	{
+		// this is a new connection or it reconnected since we last used it, either way the server doesn't know our statements anymore
+
+		CloseStatements( C );
+		C->ThreadID = ThreadID;
+	}
+
+	map<string, MYSQL_STMT *> :: iterator i = C->Statements.find( query );
+
+	if( i != C->Statements.end( ) )
+		return i->second;
+
+	MYSQL_STMT *Statement = mysql_stmt_init( (MYSQL *)conn );
+
+	if( !Statement )
+	{
+		*error = mysql_error( (MYSQL *)conn );
+		return NULL;
+	}
+
+	if( mysql_stmt_prepare( Statement, query.c_str( ), query.size( ) ) != 0 )
+	{
+		*error = mysql_stmt_error( Statement );
+		mysql_stmt_close( Statement );
+		return NULL;
+	}
+
+	C->Statements[query] = Statement;
+	return Statement;
+}
+
+void CMySQLStatements :: Forget( void *conn, const string &query )
+{
+	Connection *C = GetConnection( conn );
+	map<string, MYSQL_STMT *> :: iterator i = C->Statements.find( query );
+
+	if( i != C->Statements.end( ) )
+	{
+		mysql_stmt_close( i->second );
+		C->Statements.erase( i );
+	}
+}
+
+void CMySQLStatements :: Close( void *conn )
+{
+	// this must be called before the connection is closed because closing a statement may talk to the server
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	map<void *, Connection> :: iterator i = m_Connections.find( conn );
+
+	if( i != m_Connections.end( ) )
+	{
+		CloseStatements( &i->second );
+		m_Connections.erase( i );
+	}
+}
+
+//
+// CMySQLBinds
+//
+
+// the parameters or the result columns of a prepared statement
+// the values live in a deque so the pointers handed to MySQL stay valid while more values are added
+// string results start with a small buffer and are fetched again if they didn't fit (see MySQLFetchStatement)
+
+#define MYSQLBINDS_STRING_SIZE 256
+
+class CMySQLBinds
+{
+public:
+	struct Value
+	{
+		uint32_t UInt32;
+		double Double;
+		string String;
+		unsigned long Length;
+		my_bool IsNull;
+		my_bool Error;
+
+		Value( ) : UInt32( 0 ), Double( 0.0 ), Length( 0 ), IsNull( 0 ), Error( 0 ) { }
+	};
+
+	deque<Value> m_Values;
+	vector<MYSQL_BIND> m_Binds;
+
+	MYSQL_BIND *GetBinds( )						{ return m_Binds.empty( ) ? NULL : &m_Binds[0]; }
+	uint32_t GetUInt32( unsigned int column )	{ return m_Values[column].IsNull ? 0 : m_Values[column].UInt32; }
+	double GetDouble( unsigned int column )		{ return m_Values[column].IsNull ? 0.0 : m_Values[column].Double; }
+	string GetString( unsigned int column )		{ return m_Values[column].IsNull ? string( ) : m_Values[column].String.substr( 0, m_Values[column].Length ); }
+
+	MYSQL_BIND *Add( enum_field_types type )
+	{
+		m_Values.push_back( Value( ) );
+		m_Binds.push_back( MYSQL_BIND( ) );
+		MYSQL_BIND *Bind = &m_Binds.back( );
+		memset( Bind, 0, sizeof( MYSQL_BIND ) );
+		Bind->buffer_type = type;
+		Bind->length = &m_Values.back( ).Length;
+		Bind->is_null = &m_Values.back( ).IsNull;
+		Bind->error = &m_Values.back( ).Error;
+		return Bind;
+	}
+
+	void AddUInt32( uint32_t value )
+	{
+		MYSQL_BIND *Bind = Add( MYSQL_TYPE_LONG );
+		m_Values.back( ).UInt32 = value;
+		Bind->buffer = &m_Values.back( ).UInt32;
+		Bind->is_unsigned = 1;
+	}
+
+	void AddString( const string &value )
+	{
+		MYSQL_BIND *Bind = Add( MYSQL_TYPE_STRING );
+		m_Values.back( ).String = value;
+		m_Values.back( ).Length = value.size( );
+		Bind->buffer = (void *)m_Values.back( ).String.data( );
+		Bind->buffer_length = value.size( );
+	}
+
+	void AddUInt32Result( )
+	{
+		MYSQL_BIND *Bind = Add( MYSQL_TYPE_LONG );
+		Bind->buffer = &m_Values.back( ).UInt32;
+		Bind->is_unsigned = 1;
+	}
+
+	void AddDoubleResult( )
+	{
+		MYSQL_BIND *Bind = Add( MYSQL_TYPE_DOUBLE );
+		Bind->buffer = &m_Values.back( ).Double;
+	}
+
+	void AddStringResult( )
+	{
+		MYSQL_BIND *Bind = Add( MYSQL_TYPE_STRING );
+		m_Values.back( ).String.resize( MYSQLBINDS_STRING_SIZE );
+		Bind->buffer = &m_Values.back( ).String[0];
+		Bind->buffer_length = MYSQLBINDS_STRING_SIZE;
+	}
+};
+
+//
+// CMySQLWorkers
+//
+
+// a fixed number of worker threads which run the MySQL callables from a bounded queue
+// each worker owns one long lived connection so we no longer spawn a thread (and maybe open a connection) for every query
+// when a worker is done it completes the callable through the database which hands orphaned callables back to the main thread
+
+class CMySQLWorkers
+{
+public:
+	boost :: mutex m_Mutex;
+	boost :: condition_variable m_JobQueued;		// signalled when a callable is queued (or we're exiting)
+	CGHostDB *m_DB;									// the database which completes the callables
+	queue<CMySQLCallable *> m_Jobs;
+	CMetricGauge *m_QueuedJobs;						// m_Jobs.size( ) for the metrics endpoint
+	vector<boost :: thread *> m_Threads;
+	uint32_t m_MaxJobs;
+	uint32_t m_NumConnections;
+	bool m_Exiting;
+	string m_Server;
+	string m_Database;
+	string m_User;
+	string m_Password;
+	uint16_t m_Port;
+
+	CMySQLWorkers( CGHostDB *nDB, uint32_t maxJobs, string nServer, string nDatabase, string nUser, string nPassword, uint16_t nPort ) : m_DB( nDB ), m_MaxJobs( maxJobs ), m_NumConnections( 0 ), m_Exiting( false ), m_Server( nServer ), m_Database( nDatabase ), m_User( nUser ), m_Password( nPassword ), m_Port( nPort )
+	{
+		m_QueuedJobs = gMetrics->Gauge( "ghost_db_queued_callables", "MySQL callables waiting for a worker." );
+	}
+
+	void *Connect( );
+	void ThreadLoop( void *connection );
+};
+
+void *CMySQLWorkers :: Connect( )
+{
+	// open a worker's connection, this is only needed once because MYSQL_OPT_RECONNECT takes care of reconnecting
+
+	MYSQL *Connection = mysql_init( NULL );
+
+	if( !Connection )
+		return NULL;
+
+	my_bool Reconnect = true;
+	mysql_options( Connection, MYSQL_OPT_RECONNECT, &Reconnect );
+
+	if( !( mysql_real_connect( Connection, m_Server.c_str( ), m_User.c_str( ), m_Password.c_str( ), m_Database.c_str( ), m_Port, NULL, 0 ) ) )
+	{
+		CONSOLE_Print( string( "[MYSQL] worker unable to connect - " ) + mysql_error( Connection ) );
+		mysql_close( Connection );
+		return NULL;
+	}
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	m_NumConnections++;
+	return Connection;
+}
+
+void CMySQLWorkers :: ThreadLoop( void *connection )
+{
+#ifndef WIN32
+	// disable SIGPIPE since this is a new thread and it doesn't inherit the spawning thread's signal handlers
+
+	signal( SIGPIPE, SIG_IGN );
+#endif
+
+	mysql_thread_init( );
+	void *Connection = connection;
+
+	while( true )
+	{
+		CMySQLCallable *Callable = NULL;
+
+		{
+			boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+			// when exiting we still drain the queue so queued writes (e.g. game results) aren't lost
+
+			while( !m_Exiting && m_Jobs.empty( ) )
+				m_JobQueued.wait( Lock );
+
+			if( m_Jobs.empty( ) )
+				break;
+
+			Callable = m_Jobs.front( );
+			m_Jobs.pop( );
+			m_QueuedJobs->Set( m_Jobs.size( ) );
+		}
+
+		if( !Connection )
+			Connection = Connect( );
+
+		// if we still don't have a connection the callable will try to open one itself and report the error
+		// either way it hands back whatever connection it ended up with before we mark it as ready (after that its owner may delete it)
+		// we don't keep a connection the callable opened by itself since it may never have connected, we'll try again on the next callable
+
+		bool HadConnection = Connection != NULL;
+		Callable->SetConnection( Connection );
+		Callable->Run( &Connection );
+		m_DB->CompleteCallable( Callable );
+
+		if( !HadConnection && Connection )
+		{
+			CMySQLStatements :: Close( Connection );
+			mysql_close( (MYSQL *)Connection );
+			Connection = NULL;
+		}
+	}
+
+	if( Connection )
+	{
+		CMySQLStatements :: Close( Connection );
+		mysql_close( (MYSQL *)Connection );
+		boost :: mutex :: scoped_lock Lock( m_Mutex );
+		m_NumConnections--;
+	}
+
+	mysql_thread_end( );
+}
 
 //
 // CGHostDBMySQL
@@ -46,7 +374,7 @@ CGHostDBMySQL :: CGHostDBMySQL( CConfig *CFG ) : CGHostDB( CFG )
 	m_Password = CFG->GetString( "db_mysql_password", string( ) );
 	m_Port = CFG->GetInt( "db_mysql_port", 0 );
 	m_BotID = CFG->GetInt( "db_mysql_botid", 0 );
-	m_NumConnections = 1;
+	m_Workers = NULL;
 	m_OutstandingCallables = 0;
 
 	mysql_library_init( 0, NULL, NULL );
@@ -75,17 +403,70 @@ CGHostDBMySQL :: CGHostDBMySQL( CConfig *CFG ) : CGHostDB( CFG )
 		return;
 	}
 
-	m_IdleConnections.push( Connection );
+	// start the worker threads, the first one gets the connection we just opened and the rest connect when they run their first callable
+	// db_mysql_queuesize limits the number of callables waiting for a worker, when it's full new callables fail immediately instead of blocking the caller
+
+	uint32_t NumThreads = CFG->GetInt( "db_mysql_threads", 8 );
+	uint32_t MaxJobs = CFG->GetInt( "db_mysql_queuesize", 1000 );
+
+	if( NumThreads == 0 )
+		NumThreads = 1;
+
+	if( MaxJobs == 0 )
+		MaxJobs = 1;
+
+	m_Workers = new CMySQLWorkers( this, MaxJobs, m_Server, m_Database, m_User, m_Password, m_Port );
+	m_Workers->m_NumConnections = 1;
+
+	for( uint32_t i = 0; i < NumThreads; i++ )
+	{
+		try
+		{
+			m_Workers->m_Threads.push_back( new boost :: thread( boost :: bind( &CMySQLWorkers :: ThreadLoop, m_Workers, i == 0 ? Connection : NULL ) ) );
+		}
+		catch( const boost :: thread_resource_error &tre )
+		{
+			CONSOLE_Print( "[MYSQL] error spawning worker thread #" + UTIL_ToString( i + 1 ) + " [" + string( tre.what( ) ) + "]" );
+
+			if( i == 0 )
+			{
+				mysql_close( Connection );
+				m_Workers->m_NumConnections = 0;
+			}
+
+			break;
+		}
+	}
+
+	if( m_Workers->m_Threads.empty( ) )
+	{
+		m_HasError = true;
+		m_Error = "error spawning MySQL worker threads";
+		return;
+	}
+
+	CONSOLE_Print( "[MYSQL] started " + UTIL_ToString( m_Workers->m_Threads.size( ) ) + " worker threads with a queue size of " + UTIL_ToString( MaxJobs ) );
 }
 
 CGHostDBMySQL :: ~CGHostDBMySQL( )
 {
-	CONSOLE_Print( "[MYSQL] closing " + UTIL_ToString( m_IdleConnections.size( ) ) + "/" + UTIL_ToString( m_NumConnections ) + " idle MySQL connections" );
-
-	while( !m_IdleConnections.empty( ) )
+	if( m_Workers )
 	{
-		mysql_close( (MYSQL *)m_IdleConnections.front( ) );
-		m_IdleConnections.pop( );
+		{
+			boost :: mutex :: scoped_lock Lock( m_Workers->m_Mutex );
+			CONSOLE_Print( "[MYSQL] waiting for " + UTIL_ToString( m_Workers->m_Jobs.size( ) ) + " queued callables and closing " + UTIL_ToString( m_Workers->m_NumConnections ) + " MySQL connections" );
+			m_Workers->m_Exiting = true;
+		}
+
+		m_Workers->m_JobQueued.notify_all( );
+
+		for( vector<boost :: thread *> :: iterator i = m_Workers->m_Threads.begin( ); i != m_Workers->m_Threads.end( ); i++ )
+		{
+			(*i)->join( );
+			delete *i;
+		}
+
+		delete m_Workers;
 	}
 
 	if( m_OutstandingCallables > 0 )
@@ -96,7 +477,18 @@ CGHostDBMySQL :: ~CGHostDBMySQL( )
 
 string CGHostDBMySQL :: GetStatus( )
 {
-	return "DB STATUS --- Connections: " + UTIL_ToString( m_IdleConnections.size( ) ) + "/" + UTIL_ToString( m_NumConnections ) + " idle. Outstanding callables: " + UTIL_ToString( m_OutstandingCallables ) + ".";
+	if( !m_Workers )
+		return "DB STATUS --- Not connected.";
+
+	uint32_t OutstandingCallables;
+
+	{
+		boost :: mutex :: scoped_lock Lock( m_CallablesMutex );
+		OutstandingCallables = m_OutstandingCallables;
+	}
+
+	boost :: mutex :: scoped_lock Lock( m_Workers->m_Mutex );
+	return "DB STATUS --- Workers: " + UTIL_ToString( m_Workers->m_Threads.size( ) ) + ". Connections: " + UTIL_ToString( m_Workers->m_NumConnections ) + ". Queued callables: " + UTIL_ToString( m_Workers->m_Jobs.size( ) ) + "/" + UTIL_ToString( m_Workers->m_MaxJobs ) + ". Outstanding callables: " + UTIL_ToString( OutstandingCallables ) + ".";
 }
 
 void CGHostDBMySQL :: RecoverCallable( CBaseCallable *callable )
@@ -105,19 +497,20 @@ void CGHostDBMySQL :: RecoverCallable( CBaseCallable *callable )
 
 	if( MySQLCallable )
 	{
-		if( m_IdleConnections.size( ) > 30 )
-		{
-			mysql_close( (MYSQL *)MySQLCallable->GetConnection( ) );
-			m_NumConnections--;
-		}
-		else
-			m_IdleConnections.push( MySQLCallable->GetConnection( ) );
+		// the connection belongs to the worker which ran the callable so there's nothing to recover except the error
+
+		boost :: mutex :: scoped_lock Lock( m_CallablesMutex );
 
 		if( m_OutstandingCallables == 0 )
 			CONSOLE_Print( "[MYSQL] recovered a mysql callable with zero outstanding" );
 		else
 			m_OutstandingCallables--;
 
+		CallableMetrics &Metrics = GetCallableMetrics( callable );
+		Metrics.Outstanding->Add( -1 );
+		Metrics.Duration->Observe( callable->GetElapsed( ) );
+		Lock.unlock( );
+
 		if( !MySQLCallable->GetError( ).empty( ) )
 			CONSOLE_Print( "[MYSQL] error --- " + MySQLCallable->GetError( ) );
 	}
@@ -125,544 +518,452 @@ void CGHostDBMySQL :: RecoverCallable( CBaseCallable *callable )
 		CONSOLE_Print( "[MYSQL] tried to recover a non-mysql callable" );
 }
 
+CGHostDBMySQL :: CallableMetrics &CGHostDBMySQL :: GetCallableMetrics( CBaseCallable *callable )
+{
+	// the metrics are labelled with the callable's class name without the CMySQLCallable prefix, e.g. "BanCheck"
+	// the caller holds m_CallablesMutex so we only go to the registry once per type
+
+	string Name = typeid( *callable ).name( );
+	map<string, CallableMetrics> :: iterator i = m_CallableMetrics.find( Name );
+
+	if( i != m_CallableMetrics.end( ) )
+		return i->second;
+
+	string Type = Name;
+
+#ifdef __GNUC__
+	int Status = 0;
+	char *Demangled = abi :: __cxa_demangle( Name.c_str( ), NULL, NULL, &Status );
+
+	if( Demangled )
+	{
+		Type = Demangled;
+		free( Demangled );
+	}
+#endif
+
+	if( Type.compare( 0, 6, "class " ) == 0 )
+		Type = Type.substr( 6 );
+
+	if( Type.compare( 0, 14, "CMySQLCallable" ) == 0 )
+		Type = Type.substr( 14 );
+
+	CallableMetrics &Metrics = m_CallableMetrics[Name];
+	Metrics.Outstanding = gMetrics->Gauge( "ghost_db_outstanding_callables", "MySQL callables which have been created but not recovered yet.", CMetrics :: Label( "callable", Type ) );
+	Metrics.Duration = gMetrics->Histogram( "ghost_db_query_duration_seconds", "How long MySQL callables took to run on a worker.", CMetrics :: Label( "callable", Type ), CMetrics :: MillisecondBuckets( ), 1000.0 );
+	return Metrics;
+}
+
 void CGHostDBMySQL :: CreateThread( CBaseCallable *callable )
 {
-	try
+	CMySQLCallable *MySQLCallable = dynamic_cast<CMySQLCallable *>( callable );
+
+	if( MySQLCallable )
 	{
-		boost :: thread Thread( boost :: ref( *callable ) );
+		// the running games create (and recover) callables on their own threads
+
+		boost :: mutex :: scoped_lock Lock( m_CallablesMutex );
+		m_OutstandingCallables++;
+		GetCallableMetrics( callable ).Outstanding->Add( 1 );
 	}
-	catch( boost :: thread_resource_error tre )
+
+	if( !MySQLCallable || !m_Workers )
 	{
-		CONSOLE_Print( "[MYSQL] error spawning thread on attempt #1 [" + string( tre.what( ) ) + "], pausing execution and trying again in 50ms" );
-		MILLISLEEP( 50 );
+		CompleteCallable( callable );
+		return;
+	}
 
-		try
-		{
-			boost :: thread Thread( boost :: ref( *callable ) );
-		}
-		catch( boost :: thread_resource_error tre2 )
+	{
+		boost :: mutex :: scoped_lock Lock( m_Workers->m_Mutex );
+
+		if( m_Workers->m_Jobs.size( ) >= m_Workers->m_MaxJobs )
 		{
-			CONSOLE_Print( "[MYSQL] error spawning thread on attempt #2 [" + string( tre2.what( ) ) + "], giving up" );
-			callable->SetReady( true );
+			// we're called from the event loops so we can't wait for a worker here
+			// the callable fails right away and its owner sees the error like any other query error
+
+			Lock.unlock( );
+			CONSOLE_Print( "[MYSQL] error - the callable queue is full (" + UTIL_ToString( m_Workers->m_MaxJobs ) + "), rejecting callable" );
+			callable->SetError( "the callable queue is full" );
+			CompleteCallable( callable );
+			return;
 		}
+
+		m_Workers->m_Jobs.push( MySQLCallable );
+		m_Workers->m_QueuedJobs->Set( m_Workers->m_Jobs.size( ) );
 	}
+
+	m_Workers->m_JobQueued.notify_one( );
 }
 
 CCallableAdminCount *CGHostDBMySQL :: ThreadedAdminCount( string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableAdminCount *Callable = new CMySQLCallableAdminCount( server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableAdminCount *Callable = new CMySQLCallableAdminCount( server, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableAdminCheck *CGHostDBMySQL :: ThreadedAdminCheck( string server, string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableAdminCheck *Callable = new CMySQLCallableAdminCheck( server, user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableAdminCheck *Callable = new CMySQLCallableAdminCheck( server, user, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableAdminAdd *CGHostDBMySQL :: ThreadedAdminAdd( string server, string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableAdminAdd *Callable = new CMySQLCallableAdminAdd( server, user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableAdminAdd *Callable = new CMySQLCallableAdminAdd( server, user, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableAdminRemove *CGHostDBMySQL :: ThreadedAdminRemove( string server, string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableAdminRemove *Callable = new CMySQLCallableAdminRemove( server, user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableAdminRemove *Callable = new CMySQLCallableAdminRemove( server, user, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableAdminList *CGHostDBMySQL :: ThreadedAdminList( string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableAdminList *Callable = new CMySQLCallableAdminList( server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableAdminList *Callable = new CMySQLCallableAdminList( server, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableBanCount *CGHostDBMySQL :: ThreadedBanCount( string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableBanCount *Callable = new CMySQLCallableBanCount( server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableBanCount *Callable = new CMySQLCallableBanCount( server, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableBanCheck *CGHostDBMySQL :: ThreadedBanCheck( string server, string user, string ip )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableBanCheck *Callable = new CMySQLCallableBanCheck( server, user, ip, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableBanCheck *Callable = new CMySQLCallableBanCheck( server, user, ip, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableBanAdd *CGHostDBMySQL :: ThreadedBanAdd( string server, string user, string ip, string gamename, string admin, string reason, uint32_t banlength )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableBanAdd *Callable = new CMySQLCallableBanAdd( server, user, ip, gamename, admin, reason, banlength, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableBanAdd *Callable = new CMySQLCallableBanAdd( server, user, ip, gamename, admin, reason, banlength, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableBanRemove *CGHostDBMySQL :: ThreadedBanRemove( string server, string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableBanRemove *Callable = new CMySQLCallableBanRemove( server, user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableBanRemove *Callable = new CMySQLCallableBanRemove( server, user, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableBanRemove *CGHostDBMySQL :: ThreadedBanRemove( string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableBanRemove *Callable = new CMySQLCallableBanRemove( string( ), user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableBanRemove *Callable = new CMySQLCallableBanRemove( string( ), user, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableBanList *CGHostDBMySQL :: ThreadedBanList( string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableBanList *Callable = new CMySQLCallableBanList( server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableBanList *Callable = new CMySQLCallableBanList( server, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGameAdd *CGHostDBMySQL :: ThreadedGameAdd( string server, string map, string gamename, string ownername, uint32_t duration, uint32_t gamestate, string creatorname, string creatorserver , uint32_t gameid, uint32_t aliasid, vector<string> lobbylog, vector<string> gamelog, string elochange)
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
+	CCallableGameAdd *Callable = new CMySQLCallableGameAdd( server, map, gamename, ownername, duration, gamestate, creatorname, creatorserver, gameid, aliasid, lobbylog, gamelog, elochange, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CreateThread( Callable );
+	return Callable;
+}
 
-	CCallableGameAdd *Callable = new CMySQLCallableGameAdd( server, map, gamename, ownername, duration, gamestate, creatorname, creatorserver, gameid, aliasid, lobbylog, gamelog, elochange, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+CCallableGameResultAdd *CGHostDBMySQL :: ThreadedGameResultAdd( CDBGameResult *result )
+{
+	CCallableGameResultAdd *Callable = new CMySQLCallableGameResultAdd( result, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGamePlayerAdd *CGHostDBMySQL :: ThreadedGamePlayerAdd( uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour, uint32_t playerid )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableGamePlayerAdd *Callable = new CMySQLCallableGamePlayerAdd( gameid, name, ip, spoofed, spoofedrealm, reserved, loadingtime, left, leftreason, team, colour, playerid, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableGamePlayerAdd *Callable = new CMySQLCallableGamePlayerAdd( gameid, name, ip, spoofed, spoofedrealm, reserved, loadingtime, left, leftreason, team, colour, playerid, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGamePlayerSummaryCheck *CGHostDBMySQL :: ThreadedGamePlayerSummaryCheck( string name )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableGamePlayerSummaryCheck *Callable = new CMySQLCallableGamePlayerSummaryCheck( name, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableGamePlayerSummaryCheck *Callable = new CMySQLCallableGamePlayerSummaryCheck( name, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableDotAGameAdd *CGHostDBMySQL :: ThreadedDotAGameAdd( uint32_t gameid, uint32_t winner, uint32_t min, uint32_t sec )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableDotAGameAdd *Callable = new CMySQLCallableDotAGameAdd( gameid, winner, min, sec, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableDotAGameAdd *Callable = new CMySQLCallableDotAGameAdd( gameid, winner, min, sec, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableDotAPlayerAdd *CGHostDBMySQL :: ThreadedDotAPlayerAdd( uint32_t gameid, uint32_t colour, uint32_t kills, uint32_t deaths, uint32_t creepkills, uint32_t creepdenies, uint32_t assists, uint32_t gold, uint32_t neutralkills, string item1, string item2, string item3, string item4, string item5, string item6, string skill1, string skill2, string skill3, string skill4, string skill5, string skill6, string hero, uint32_t newcolour, uint32_t towerkills, uint32_t raxkills, uint32_t courierkills, uint32_t level )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableDotAPlayerAdd *Callable = new CMySQLCallableDotAPlayerAdd( gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, skill1, skill2, skill3, skill4, skill5, skill6, hero, newcolour, towerkills, raxkills, courierkills, level, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableDotAPlayerAdd *Callable = new CMySQLCallableDotAPlayerAdd( gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, skill1, skill2, skill3, skill4, skill5, skill6, hero, newcolour, towerkills, raxkills, courierkills, level, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableDotAPlayerSummaryCheck *CGHostDBMySQL :: ThreadedDotAPlayerSummaryCheck( string name )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableDotAPlayerSummaryCheck *Callable = new CMySQLCallableDotAPlayerSummaryCheck( name, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableDotAPlayerSummaryCheck *Callable = new CMySQLCallableDotAPlayerSummaryCheck( name, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableDownloadAdd *CGHostDBMySQL :: ThreadedDownloadAdd( string map, uint32_t mapsize, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t downloadtime )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableDownloadAdd *Callable = new CMySQLCallableDownloadAdd( map, mapsize, name, ip, spoofed, spoofedrealm, downloadtime, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableDownloadAdd *Callable = new CMySQLCallableDownloadAdd( map, mapsize, name, ip, spoofed, spoofedrealm, downloadtime, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableScoreCheck *CGHostDBMySQL :: ThreadedScoreCheck( string category, string name, string server )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableScoreCheck *Callable = new CMySQLCallableScoreCheck( category, name, server, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableScoreCheck *Callable = new CMySQLCallableScoreCheck( category, name, server, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableW3MMDPlayerAdd *CGHostDBMySQL :: ThreadedW3MMDPlayerAdd( string category, uint32_t gameid, uint32_t pid, string name, string flag, uint32_t leaver, uint32_t practicing )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableW3MMDPlayerAdd *Callable = new CMySQLCallableW3MMDPlayerAdd( category, gameid, pid, name, flag, leaver, practicing, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableW3MMDPlayerAdd *Callable = new CMySQLCallableW3MMDPlayerAdd( category, gameid, pid, name, flag, leaver, practicing, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableW3MMDVarAdd *CGHostDBMySQL :: ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,int32_t> var_ints )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableW3MMDVarAdd *Callable = new CMySQLCallableW3MMDVarAdd( gameid, var_ints, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableW3MMDVarAdd *Callable = new CMySQLCallableW3MMDVarAdd( gameid, var_ints, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableW3MMDVarAdd *CGHostDBMySQL :: ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,double> var_reals )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableW3MMDVarAdd *Callable = new CMySQLCallableW3MMDVarAdd( gameid, var_reals, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableW3MMDVarAdd *Callable = new CMySQLCallableW3MMDVarAdd( gameid, var_reals, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableW3MMDVarAdd *CGHostDBMySQL :: ThreadedW3MMDVarAdd( uint32_t gameid, map<VarP,string> var_strings )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableW3MMDVarAdd *Callable = new CMySQLCallableW3MMDVarAdd( gameid, var_strings, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableW3MMDVarAdd *Callable = new CMySQLCallableW3MMDVarAdd( gameid, var_strings, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGetPlayerId *CGHostDBMySQL :: ThreadedGetPlayerId( string user )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableGetPlayerId *Callable = new CMySQLCallableGetPlayerId( user, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableGetPlayerId *Callable = new CMySQLCallableGetPlayerId( user, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableCreatePlayerId *CGHostDBMySQL :: ThreadedCreatePlayerId( string user, string ip, string realm )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableCreatePlayerId *Callable = new CMySQLCallableCreatePlayerId( user, ip, realm, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableCreatePlayerId *Callable = new CMySQLCallableCreatePlayerId( user, ip, realm, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGetGameId *CGHostDBMySQL :: ThreadedGetGameId( )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableGetGameId *Callable = new CMySQLCallableGetGameId( Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableGetGameId *Callable = new CMySQLCallableGetGameId( NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGetBotConfigs *CGHostDBMySQL :: ThreadedGetBotConfigs( )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableGetBotConfigs *Callable = new CMySQLCallableGetBotConfigs( Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableGetBotConfigs *Callable = new CMySQLCallableGetBotConfigs( NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGetBotConfigTexts *CGHostDBMySQL :: ThreadedGetBotConfigTexts( )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableGetBotConfigTexts *Callable = new CMySQLCallableGetBotConfigTexts( Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableGetBotConfigTexts *Callable = new CMySQLCallableGetBotConfigTexts( NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGetLanguages *CGHostDBMySQL :: ThreadedGetLanguages( )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableGetLanguages *Callable = new CMySQLCallableGetLanguages( Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableGetLanguages *Callable = new CMySQLCallableGetLanguages( NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGetMapConfig *CGHostDBMySQL :: ThreadedGetMapConfig( string m_ConfigName )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableGetMapConfig *Callable = new CMySQLCallableGetMapConfig( m_ConfigName, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableGetMapConfig *Callable = new CMySQLCallableGetMapConfig( m_ConfigName, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
-CCallableGameUpdate *CGHostDBMySQL :: ThreadedGameUpdate( uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist )
+CCallableGameUpdate *CGHostDBMySQL :: ThreadedGameUpdate( vector<GameListRow> rows )
 {
-    void *Connection = GetIdleConnection( );
-
-    if( !Connection )
-        ++m_NumConnections;
-
-    CCallableGameUpdate *Callable = new CMySQLCallableGameUpdate( hostcounter, lobby, map_type, duration, gamename, ownername, creatorname, map, players, total,  playerlist, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+    CCallableGameUpdate *Callable = new CMySQLCallableGameUpdate( rows, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
     CreateThread( Callable );
-    ++m_OutstandingCallables;
     return Callable;
 }
 
 CCallableGetAliases *CGHostDBMySQL :: ThreadedGetAliases( )
 {
-	void *Connection = GetIdleConnection( );
-
-	if( !Connection )
-		m_NumConnections++;
-
-	CCallableGetAliases *Callable = new CMySQLCallableGetAliases( Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CCallableGetAliases *Callable = new CMySQLCallableGetAliases( NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
 	CreateThread( Callable );
-	m_OutstandingCallables++;
 	return Callable;
 }
 
 CCallableGetStatsTemplates *CGHostDBMySQL :: ThreadedGetStatsTemplates( )
 {
-        void *Connection = GetIdleConnection( );
-
-        if( !Connection )
-                m_NumConnections++;
-
-        CCallableGetStatsTemplates *Callable = new CMySQLCallableGetStatsTemplates( Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+        CCallableGetStatsTemplates *Callable = new CMySQLCallableGetStatsTemplates( NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
         CreateThread( Callable );
-        m_OutstandingCallables++;
         return Callable;
 }
 
 CCallableGetPlayerStats *CGHostDBMySQL :: ThreadedGetPlayerStats( uint32_t aliasid, uint32_t playerid )
 {
-        void *Connection = GetIdleConnection( );
-
-        if( !Connection )
-                m_NumConnections++;
-
-        CCallableGetPlayerStats *Callable = new CMySQLCallableGetPlayerStats( aliasid, playerid, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+        CCallableGetPlayerStats *Callable = new CMySQLCallableGetPlayerStats( aliasid, playerid, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
         CreateThread( Callable );
-        m_OutstandingCallables++;
         return Callable;
 }
 
 CCallableGetPlayerScore *CGHostDBMySQL :: ThreadedGetPlayerScore( uint32_t aliasid, uint32_t playerid )
 {
-        void *Connection = GetIdleConnection( );
-
-        if( !Connection )
-                m_NumConnections++;
-
-        CCallableGetPlayerScore *Callable = new CMySQLCallableGetPlayerScore( aliasid, playerid, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+        CCallableGetPlayerScore *Callable = new CMySQLCallableGetPlayerScore( aliasid, playerid, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
         CreateThread( Callable );
-        m_OutstandingCallables++;
         return Callable;
 }
 
-CCallableUpdateGameInfo *CGHostDBMySQL :: ThreadedUpdateGameInfo( uint32_t gameid, string gamename )
+CCallableGetPlayerStatsBatch *CGHostDBMySQL :: ThreadedGetPlayerStatsBatch( uint32_t aliasid, vector<uint32_t> playerids )
 {
-        void *Connection = GetIdleConnection( );
-
-        if( !Connection )
-                m_NumConnections++;
+	CCallableGetPlayerStatsBatch *Callable = new CMySQLCallableGetPlayerStatsBatch( aliasid, playerids, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+	CreateThread( Callable );
+	return Callable;
+}
 
-        CCallableUpdateGameInfo *Callable = new CMySQLCallableUpdateGameInfo( gameid, gamename, Connection, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
+CCallableUpdateGameInfo *CGHostDBMySQL :: ThreadedUpdateGameInfo( uint32_t gameid, string gamename )
+{
+        CCallableUpdateGameInfo *Callable = new CMySQLCallableUpdateGameInfo( gameid, gamename, NULL, m_BotID, m_Server, m_Database, m_User, m_Password, m_Port );
         CreateThread( Callable );
-        m_OutstandingCallables++;
         return Callable;
 }
 
-void *CGHostDBMySQL :: GetIdleConnection( )
+//
+// unprototyped global helper functions
+//
+
+string MySQLEscapeString( void *conn, string str )
+{
+	char *to = new char[str.size( ) * 2 + 1];
+	unsigned long size = mysql_real_escape_string( (MYSQL *)conn, to, str.c_str( ), str.size( ) );
+	string result( to, size );
+	delete [] to;
+	return result;
+}
+
+vector<string> MySQLFetchRow( MYSQL_RES *res )
 {
-	void *Connection = NULL;
+	vector<string> Result;
+
+	MYSQL_ROW Row = mysql_fetch_row( res );
 
-	if( !m_IdleConnections.empty( ) )
+	if( Row )
 	{
-		Connection = m_IdleConnections.front( );
-		m_IdleConnections.pop( );
+		unsigned long *Lengths;
+		Lengths = mysql_fetch_lengths( res );
+
+		for( unsigned int i = 0; i < mysql_num_fields( res ); i++ )
+		{
+			if( Row[i] )
+				Result.push_back( string( Row[i], Lengths[i] ) );
+			else
+				Result.push_back( string( ) );
+		}
 	}
 
-	return Connection;
+	return Result;
 }
 
-//
-// unprototyped global helper functions
-//
+MYSQL_STMT *MySQLExecuteStatement( void *conn, string *error, const string &query, CMySQLBinds &params, CMySQLBinds *results )
+{
+	// run one of the cached prepared statements, on success the whole result (if any) has been stored on our side
+	// the caller fetches the rows with MySQLFetchStatement and then frees them with mysql_stmt_free_result
+	// if the server says it doesn't know the statement (or it has to be prepared again because a table changed) we prepare it again and retry once
+	// that's safe because the statement never ran, we don't retry when the connection was lost since we can't tell if an insert went through
+
+	for( int Attempt = 0; Attempt < 2; Attempt++ )
+	{
+		MYSQL_STMT *Statement = CMySQLStatements :: Get( conn, error, query );
+
+		if( !Statement )
+			return NULL;
+
+		if( mysql_stmt_bind_param( Statement, params.GetBinds( ) ) == 0 && mysql_stmt_execute( Statement ) == 0 )
+		{
+			if( !results )
+				return Statement;
+
+			if( mysql_stmt_bind_result( Statement, results->GetBinds( ) ) == 0 && mysql_stmt_store_result( Statement ) == 0 )
+				return Statement;
+		}
+
+		unsigned int Error = mysql_stmt_errno( Statement );
+		*error = mysql_stmt_error( Statement );
+
+		if( Error != ER_UNKNOWN_STMT_HANDLER && Error != ER_NEED_REPREPARE )
+		{
+			mysql_stmt_free_result( Statement );
+			return NULL;
+		}
+
+		CMySQLStatements :: Forget( conn, query );
+	}
 
-string MySQLEscapeString( void *conn, string str )
-{
-	char *to = new char[str.size( ) * 2 + 1];
-	unsigned long size = mysql_real_escape_string( (MYSQL *)conn, to, str.c_str( ), str.size( ) );
-	string result( to, size );
-	delete [] to;
-	return result;
+	return NULL;
 }
 
-vector<string> MySQLFetchRow( MYSQL_RES *res )
+bool MySQLFetchStatement( MYSQL_STMT *stmt, CMySQLBinds &results )
 {
-	vector<string> Result;
-
-	MYSQL_ROW Row = mysql_fetch_row( res );
+	int Status = mysql_stmt_fetch( stmt );
 
-	if( Row )
+	if( Status == MYSQL_DATA_TRUNCATED )
 	{
-		unsigned long *Lengths;
-		Lengths = mysql_fetch_lengths( res );
+		// fetch the string columns that didn't fit into their buffer again with a buffer that's big enough
 
-		for( unsigned int i = 0; i < mysql_num_fields( res ); i++ )
+		for( unsigned int i = 0; i < results.m_Binds.size( ); i++ )
 		{
-			if( Row[i] )
-				Result.push_back( string( Row[i], Lengths[i] ) );
-			else
-				Result.push_back( string( ) );
+			CMySQLBinds :: Value &Column = results.m_Values[i];
+			MYSQL_BIND &Bind = results.m_Binds[i];
+
+			if( Bind.buffer_type != MYSQL_TYPE_STRING || Column.IsNull || Column.Length <= Bind.buffer_length )
+				continue;
+
+			Column.String.resize( Column.Length );
+			Bind.buffer = &Column.String[0];
+			Bind.buffer_length = Column.Length;
+			mysql_stmt_fetch_column( stmt, &Bind, i, 0 );
 		}
+
+		// the buffers moved so we have to bind them again before the next fetch
+
+		mysql_stmt_bind_result( stmt, results.GetBinds( ) );
+		return true;
 	}
 
-	return Result;
+	return Status == 0;
 }
 
 //
@@ -827,36 +1128,33 @@ uint32_t MySQLBanCount( void *conn, string *error, uint32_t botid, string server
 CDBBan *MySQLBanCheck( void *conn, string *error, uint32_t botid, string server, string user, string ip )
 {
 	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
-	string EscServer = MySQLEscapeString( conn, server );
-	string EscUser = MySQLEscapeString( conn, user );
-	string EscIP = MySQLEscapeString( conn, ip );
 	CDBBan *Ban = NULL;
 	string Query;
+	CMySQLBinds Params;
+	Params.AddString( server );
+	Params.AddString( user );
 
 	if( ip.empty( ) )
-		Query = "SELECT name, ip, DATE(date), gamename, admin, reason FROM bans WHERE server='" + EscServer + "' AND name='" + EscUser + "'";
-	else
-		Query = "SELECT name, ip, DATE(date), gamename, admin, reason FROM bans WHERE (server='" + EscServer + "' AND name='" + EscUser + "') OR ip='" + EscIP + "'";
-
-	if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-		*error = mysql_error( (MYSQL *)conn );
+		Query = "SELECT name, ip, DATE(date), gamename, admin, reason FROM bans WHERE server=? AND name=?";
 	else
 	{
-		MYSQL_RES *Result = mysql_store_result( (MYSQL *)conn );
+		Query = "SELECT name, ip, DATE(date), gamename, admin, reason FROM bans WHERE (server=? AND name=?) OR ip=?";
+		Params.AddString( ip );
+	}
 
-		if( Result )
-		{
-			vector<string> Row = MySQLFetchRow( Result );
+	CMySQLBinds Results;
 
-			if( Row.size( ) == 6 )
-				Ban = new CDBBan( server, Row[0], Row[1], Row[2], Row[3], Row[4], Row[5] );
-			/* else
-				*error = "error checking ban [" + server + " : " + user + "] - row doesn't have 6 columns"; */
+	for( int i = 0; i < 6; i++ )
+		Results.AddStringResult( );
 
-			mysql_free_result( Result );
-		}
-		else
-			*error = mysql_error( (MYSQL *)conn );
+	MYSQL_STMT *Statement = MySQLExecuteStatement( conn, error, Query, Params, &Results );
+
+	if( Statement )
+	{
+		if( MySQLFetchStatement( Statement, Results ) )
+			Ban = new CDBBan( server, Results.GetString( 0 ), Results.GetString( 1 ), Results.GetString( 2 ), Results.GetString( 3 ), Results.GetString( 4 ), Results.GetString( 5 ) );
+
+		mysql_stmt_free_result( Statement );
 	}
 
 	return Ban;
@@ -981,20 +1279,212 @@ uint32_t MySQLGameAdd( void *conn, string *error, uint32_t botid, string server,
 	return gameid;
 }
 
+uint32_t MySQLGameResultAdd( void *conn, string *error, uint32_t botid, CDBGameResult *result )
+{
+	// everything is written with one multi row insert per table inside a single transaction so a game is either saved completely or not at all
+	// the queries are built first so we don't hold the transaction open while escaping strings
+
+	vector<string> Queries;
+	string GameID = UTIL_ToString( result->m_GameID );
+	string BotID = UTIL_ToString( botid );
+
+	Queries.push_back( "UPDATE oh_games SET  `gamestatus` = '1', server='" + MySQLEscapeString( conn, result->m_Server ) + "', map='" + MySQLEscapeString( conn, result->m_Map ) + "', datetime=NOW(), gamename='" + MySQLEscapeString( conn, result->m_GameName ) + "', ownername='" + MySQLEscapeString( conn, result->m_OwnerName ) + "', duration='" + UTIL_ToString( result->m_Duration ) + "', gamestate='" + UTIL_ToString( result->m_GameState ) + "', creatorname='" + MySQLEscapeString( conn, result->m_CreatorName ) + "', creatorserver='" + MySQLEscapeString( conn, result->m_CreatorName ) + "', alias_id='" + UTIL_ToString( result->m_AliasID ) + "', elochange = '" + MySQLEscapeString( conn, result->m_EloChange ) + "' WHERE id='" + GameID + "'" );
+
+	string LobbyLog;
+	string GameLog;
+
+	for( vector<string> :: iterator i = result->m_LobbyLog.begin( ); i != result->m_LobbyLog.end( ); i++ )
+		LobbyLog.append( (*i) + '\n' );
+
+	for( vector<string> :: iterator i = result->m_GameLog.begin( ); i != result->m_GameLog.end( ); i++ )
+		GameLog.append( (*i) + '\n' );
+
+	Queries.push_back( "INSERT INTO oh_lobby_game_logs ( gameid, botid, lobbylog, gamelog ) VALUES ( " + GameID + ", " + BotID + ", '" + MySQLEscapeString( conn, LobbyLog ) + "', '" + MySQLEscapeString( conn, GameLog ) + "' )" );
+
+	if( !result->m_GamePlayers.empty( ) )
+	{
+		string Query = "INSERT INTO oh_gameplayers ( botid, player_id, gameid, name, ip, spoofed, reserved, loadingtime, `left`, leftreason, team, colour, spoofedrealm ) VALUES ";
+
+		for( vector<CDBGamePlayer> :: iterator i = result->m_GamePlayers.begin( ); i != result->m_GamePlayers.end( ); i++ )
+		{
+			string Name = i->GetName( );
+			transform( Name.begin( ), Name.end( ), Name.begin( ), (int(*)(int))tolower );
+
+			if( i != result->m_GamePlayers.begin( ) )
+				Query += ", ";
+
+			Query += "( " + BotID + ", " + UTIL_ToString( i->GetPlayerId( ) ) + ", " + GameID + ", '" + MySQLEscapeString( conn, Name ) + "', '" + MySQLEscapeString( conn, i->GetIP( ) ) + "', " + UTIL_ToString( i->GetSpoofed( ) ) + ", " + UTIL_ToString( i->GetReserved( ) ) + ", " + UTIL_ToString( i->GetLoadingTime( ) ) + ", " + UTIL_ToString( i->GetLeft( ) ) + ", '" + MySQLEscapeString( conn, i->GetLeftReason( ) ) + "', " + UTIL_ToString( i->GetTeam( ) ) + ", " + UTIL_ToString( i->GetColour( ) ) + ", '" + MySQLEscapeString( conn, i->GetSpoofedRealm( ) ) + "' )";
+		}
+
+		Queries.push_back( Query );
+	}
+
+	for( vector<CDBDotAGame> :: iterator i = result->m_DotAGames.begin( ); i != result->m_DotAGames.end( ); i++ )
+		Queries.push_back( "INSERT INTO oh_dotagames ( botid, gameid, winner, min, sec ) VALUES ( " + BotID + ", " + GameID + ", " + UTIL_ToString( i->GetWinner( ) ) + ", " + UTIL_ToString( i->GetMin( ) ) + ", " + UTIL_ToString( i->GetSec( ) ) + " )" );
+
+	if( !result->m_DotAPlayers.empty( ) )
+	{
+		string Query = "INSERT INTO oh_dotaplayers ( botid, gameid, colour, kills, deaths, creepkills, creepdenies, assists, gold, neutralkills, item1, item2, item3, item4, item5, item6, spell1, spell2, spell3, spell4, spell5, spell6, hero, newcolour, towerkills, raxkills, courierkills, level ) VALUES ";
+
+		for( vector<CDBDotAPlayer> :: iterator i = result->m_DotAPlayers.begin( ); i != result->m_DotAPlayers.end( ); i++ )
+		{
+			if( i != result->m_DotAPlayers.begin( ) )
+				Query += ", ";
+
+			Query += "( " + BotID + ", " + GameID + ", " + UTIL_ToString( i->GetColour( ) ) + ", " + UTIL_ToString( i->GetKills( ) ) + ", " + UTIL_ToString( i->GetDeaths( ) ) + ", " + UTIL_ToString( i->GetCreepKills( ) ) + ", " + UTIL_ToString( i->GetCreepDenies( ) ) + ", " + UTIL_ToString( i->GetAssists( ) ) + ", " + UTIL_ToString( i->GetGold( ) ) + ", " + UTIL_ToString( i->GetNeutralKills( ) );
+
+			for( unsigned int j = 0; j < 6; j++ )
+				Query += ", '" + MySQLEscapeString( conn, i->GetItem( j ) ) + "'";
+
+			for( unsigned int j = 0; j < 6; j++ )
+				Query += ", '" + MySQLEscapeString( conn, i->GetSkill( j ) ) + "'";
+
+			Query += ", '" + MySQLEscapeString( conn, i->GetHero( ) ) + "', " + UTIL_ToString( i->GetNewColour( ) ) + ", " + UTIL_ToString( i->GetTowerKills( ) ) + ", " + UTIL_ToString( i->GetRaxKills( ) ) + ", " + UTIL_ToString( i->GetCourierKills( ) ) + ", " + UTIL_ToString( i->GetLevel( ) ) + " )";
+		}
+
+		Queries.push_back( Query );
+	}
+
+	if( !result->m_W3MMDPlayers.empty( ) )
+	{
+		string EscCategory = MySQLEscapeString( conn, result->m_W3MMDCategory );
+		string Query = "INSERT INTO oh_w3mmdplayers ( botid, category, gameid, pid, name, flag, leaver, practicing ) VALUES ";
+
+		for( vector<W3MMDPlayerRow> :: iterator i = result->m_W3MMDPlayers.begin( ); i != result->m_W3MMDPlayers.end( ); i++ )
+		{
+			string Name = i->Name;
+			transform( Name.begin( ), Name.end( ), Name.begin( ), (int(*)(int))tolower );
+
+			if( i != result->m_W3MMDPlayers.begin( ) )
+				Query += ", ";
+
+			Query += "( " + BotID + ", '" + EscCategory + "', " + GameID + ", " + UTIL_ToString( i->PID ) + ", '" + MySQLEscapeString( conn, Name ) + "', '" + MySQLEscapeString( conn, i->Flag ) + "', " + UTIL_ToString( i->Leaver ) + ", " + UTIL_ToString( i->Practicing ) + " )";
+		}
+
+		Queries.push_back( Query );
+	}
+
+	if( !result->m_W3MMDVarInts.empty( ) )
+	{
+		string Query = "INSERT INTO oh_w3mmdvars ( botid, gameid, pid, varname, value_int ) VALUES ";
+
+		for( map<VarP,int32_t> :: iterator i = result->m_W3MMDVarInts.begin( ); i != result->m_W3MMDVarInts.end( ); i++ )
+		{
+			if( i != result->m_W3MMDVarInts.begin( ) )
+				Query += ", ";
+
+			Query += "( " + BotID + ", " + GameID + ", " + UTIL_ToString( i->first.first ) + ", '" + MySQLEscapeString( conn, i->first.second ) + "', " + UTIL_ToString( i->second ) + " )";
+		}
+
+		Queries.push_back( Query );
+	}
+
+	if( !result->m_W3MMDVarReals.empty( ) )
+	{
+		string Query = "INSERT INTO oh_w3mmdvars ( botid, gameid, pid, varname, value_real ) VALUES ";
+
+		for( map<VarP,double> :: iterator i = result->m_W3MMDVarReals.begin( ); i != result->m_W3MMDVarReals.end( ); i++ )
+		{
+			if( i != result->m_W3MMDVarReals.begin( ) )
+				Query += ", ";
+
+			Query += "( " + BotID + ", " + GameID + ", " + UTIL_ToString( i->first.first ) + ", '" + MySQLEscapeString( conn, i->first.second ) + "', " + UTIL_ToString( i->second, 10 ) + " )";
+		}
+
+		Queries.push_back( Query );
+	}
+
+	if( !result->m_W3MMDVarStrings.empty( ) )
+	{
+		string Query = "INSERT INTO oh_w3mmdvars ( botid, gameid, pid, varname, value_string ) VALUES ";
+
+		for( map<VarP,string> :: iterator i = result->m_W3MMDVarStrings.begin( ); i != result->m_W3MMDVarStrings.end( ); i++ )
+		{
+			if( i != result->m_W3MMDVarStrings.begin( ) )
+				Query += ", ";
+
+			Query += "( " + BotID + ", " + GameID + ", " + UTIL_ToString( i->first.first ) + ", '" + MySQLEscapeString( conn, i->first.second ) + "', '" + MySQLEscapeString( conn, i->second ) + "' )";
+		}
+
+		Queries.push_back( Query );
+	}
+
+	// if the connection dropped in the middle of the transaction MYSQL_OPT_RECONNECT would silently resend the statement on a new session in autocommit mode
+	// the statements sent before would be rolled back by the server and the rest committed one by one, i.e. we'd save part of the game
+	// so reconnecting is turned off until the transaction is over and the session's thread id is checked after every statement as well
+
+	my_bool Reconnect = false;
+	mysql_options( (MYSQL *)conn, MYSQL_OPT_RECONNECT, &Reconnect );
+	unsigned long ThreadID = mysql_thread_id( (MYSQL *)conn );
+	bool Success = true;
+
+	if( mysql_autocommit( (MYSQL *)conn, 0 ) != 0 )
+	{
+		*error = mysql_error( (MYSQL *)conn );
+		Success = false;
+	}
+
+	for( vector<string> :: iterator i = Queries.begin( ); Success && i != Queries.end( ); i++ )
+	{
+		if( mysql_real_query( (MYSQL *)conn, i->c_str( ), i->size( ) ) != 0 )
+		{
+			*error = mysql_error( (MYSQL *)conn );
+			Success = false;
+		}
+		else if( mysql_thread_id( (MYSQL *)conn ) != ThreadID )
+		{
+			*error = "the connection was reset during the transaction";
+			Success = false;
+		}
+	}
+
+	if( Success && mysql_thread_id( (MYSQL *)conn ) != ThreadID )
+	{
+		*error = "the connection was reset during the transaction";
+		Success = false;
+	}
+
+	if( Success && mysql_commit( (MYSQL *)conn ) != 0 )
+	{
+		*error = mysql_error( (MYSQL *)conn );
+		Success = false;
+	}
+
+	if( !Success )
+		mysql_rollback( (MYSQL *)conn );
+
+	// the connection goes back to the worker so it has to reconnect and be in autocommit mode again for the next callable
+
+	Reconnect = true;
+	mysql_options( (MYSQL *)conn, MYSQL_OPT_RECONNECT, &Reconnect );
+	mysql_autocommit( (MYSQL *)conn, 1 );
+	return Success ? result->m_GameID : 0;
+}
+
 uint32_t MySQLGamePlayerAdd( void *conn, string *error, uint32_t botid, uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour, uint32_t playerid )
 {
 	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
 	uint32_t RowID = 0;
-	string EscName = MySQLEscapeString( conn, name );
-	string EscIP = MySQLEscapeString( conn, ip );
-	string EscSpoofedRealm = MySQLEscapeString( conn, spoofedrealm );
-	string EscLeftReason = MySQLEscapeString( conn, leftreason );
-	string Query = "INSERT INTO oh_gameplayers ( botid, player_id, gameid, name, ip, spoofed, reserved, loadingtime, `left`, leftreason, team, colour, spoofedrealm ) VALUES ( " + UTIL_ToString( botid ) + ", " + UTIL_ToString(playerid) + ", " + UTIL_ToString( gameid ) + ", '" + EscName + "', '" + EscIP + "', " + UTIL_ToString( spoofed ) + ", " + UTIL_ToString( reserved ) + ", " + UTIL_ToString( loadingtime ) + ", " + UTIL_ToString( left ) + ", '" + EscLeftReason + "', " + UTIL_ToString( team ) + ", " + UTIL_ToString( colour ) + ", '" + EscSpoofedRealm + "' )";
-
-	if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-		*error = mysql_error( (MYSQL *)conn );
-	else
-		RowID = mysql_insert_id( (MYSQL *)conn );
+	string Query = "INSERT INTO oh_gameplayers ( botid, player_id, gameid, name, ip, spoofed, reserved, loadingtime, `left`, leftreason, team, colour, spoofedrealm ) VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )";
+	CMySQLBinds Params;
+	Params.AddUInt32( botid );
+	Params.AddUInt32( playerid );
+	Params.AddUInt32( gameid );
+	Params.AddString( name );
+	Params.AddString( ip );
+	Params.AddUInt32( spoofed );
+	Params.AddUInt32( reserved );
+	Params.AddUInt32( loadingtime );
+	Params.AddUInt32( left );
+	Params.AddString( leftreason );
+	Params.AddUInt32( team );
+	Params.AddUInt32( colour );
+	Params.AddString( spoofedrealm );
+
+	MYSQL_STMT *Statement = MySQLExecuteStatement( conn, error, Query, Params, NULL );
+
+	if( Statement )
+		RowID = mysql_stmt_insert_id( Statement );
 
 	return RowID;
 }
@@ -1334,32 +1824,21 @@ bool MySQLW3MMDVarAdd( void *conn, string *error, uint32_t botid, uint32_t gamei
 uint32_t MySQLGetPlayerId( void *conn, string *error, uint32_t botid, string user )
 {
     transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
-    string EscLowerName = MySQLEscapeString( conn, user );
     uint32_t RowID = 0;
-    string Query = "SELECT id FROM oh_stats_players WHERE player_lower = '" + EscLowerName + "'";
-
-    if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-        *error = mysql_error( (MYSQL *)conn );
-    else
-    {
-        MYSQL_RES *Result = mysql_store_result( (MYSQL *)conn );
+    string Query = "SELECT id FROM oh_stats_players WHERE player_lower = ?";
+    CMySQLBinds Params;
+    Params.AddString( user );
+    CMySQLBinds Results;
+    Results.AddUInt32Result( );
 
-        if( Result )
-        {
-            vector<string> Row = MySQLFetchRow( Result );
+    MYSQL_STMT *Statement = MySQLExecuteStatement( conn, error, Query, Params, &Results );
 
-            if( Row.size( ) == 1 )
-            {
-                RowID = UTIL_ToUInt32(Row[0]);
-                Row = MySQLFetchRow( Result );
-            }
+    if( Statement )
+    {
+        if( MySQLFetchStatement( Statement, Results ) )
+            RowID = Results.GetUInt32( 0 );
 
-            mysql_free_result( Result );
-        }
-        else
-        {
-            CONSOLE_Print(user + " has no id yet, creating one.");
-        }
+        mysql_stmt_free_result( Statement );
     }
 
     return RowID;
@@ -1367,20 +1846,21 @@ uint32_t MySQLGetPlayerId( void *conn, string *error, uint32_t botid, string use
 
 uint32_t MySQLCreatePlayerId( void *conn, string *error, uint32_t botid, string user, string ip, string realm )
 {
-    string EscName = MySQLEscapeString( conn, user );
-	transform( user.begin( ), user.end( ), user.begin( ), (int(*)(int))tolower );
-    string EscLowerName = MySQLEscapeString( conn, user );
-    string EscIP = MySQLEscapeString( conn, ip );
-    string EscRealm = MySQLEscapeString( conn, realm );
-    
+    string LowerName = user;
+    transform( LowerName.begin( ), LowerName.end( ), LowerName.begin( ), (int(*)(int))tolower );
     uint32_t RowID = 0;
-    string Query = "INSERT INTO oh_stats_players (player, player_lower, ip, realm, player_language) VALUES ('"+EscName+"','"+EscLowerName+"','"+EscIP+"','"+EscRealm+"', 'en');";
+    string Query = "INSERT INTO oh_stats_players (player, player_lower, ip, realm, player_language) VALUES (?, ?, ?, ?, 'en')";
+    CMySQLBinds Params;
+    Params.AddString( user );
+    Params.AddString( LowerName );
+    Params.AddString( ip );
+    Params.AddString( realm );
+
+    MYSQL_STMT *Statement = MySQLExecuteStatement( conn, error, Query, Params, NULL );
+
+    if( Statement )
+        RowID = mysql_stmt_insert_id( Statement );
 
-    if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-        *error = mysql_error( (MYSQL *)conn );
-    else
-        RowID = mysql_insert_id( (MYSQL *)conn );
-    
     return RowID;
 }
 
@@ -1512,6 +1992,7 @@ map<string, map<uint32_t, string> > MySQLGetLanguages( void *conn, string *error
             
 			while( Row.size( ) == 3 )
 			{
+				m_Languages[Row[1]][UTIL_ToUInt32( Row[0] )] = Row[2];
 				Row = MySQLFetchRow( Result );
 			}
 
@@ -1557,32 +2038,73 @@ map<string, string> MySQLGetMapConfig( void *conn, string *error, uint32_t botid
 	return m_Configs;
 }
 
-string MySQLGameUpdate( void *conn, string *error, uint32_t botid, uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist )
+string MySQLGameUpdate( void *conn, string *error, uint32_t botid, vector<GameListRow> rows )
 {
-    if( !gamename.empty( ) ) {
-        string EscMapType = MySQLEscapeString( conn, map_type );
-        string EscGameName = MySQLEscapeString( conn, gamename );
-        string EscOwnerName = MySQLEscapeString( conn, ownername );
-        string EscCreatorName = MySQLEscapeString( conn, creatorname );
-        string EscMap = MySQLEscapeString( conn, map );
-        string Users ="";
-        string Splitter =",";
-        string PlayerSlpitter="#";
-        for( vector<PlayerOfPlayerList> :: iterator i = playerlist.begin( ); i != playerlist.end( ); ++i ) {
-            Users += UTIL_ToString(i->Slot)+Splitter+UTIL_ToString(i->Team)+Splitter+UTIL_ToString(i->Color)+Splitter+i->Username+Splitter+i->Realm+Splitter+UTIL_ToString(i->Ping)+Splitter+i->IP+Splitter+UTIL_ToString(i->LeftTime)+Splitter+i->LeftReason+PlayerSlpitter;
+    // the rows are written with at most two queries no matter how many games there are
+    // first the reset rows are deleted (along with any lobby rows, as before) and then every other row is upserted
+    // CGHost makes sure a game never has an upsert queued before its own reset so doing the deletes first doesn't lose anything
+    // both are prepared statements, the query text only depends on the number of rows so there's one cached statement per row count
+
+    string Splitter = ",";
+    string PlayerSplitter = "#";
+    string DeleteIDs;
+    string Values;
+    CMySQLBinds DeleteParams;
+    CMySQLBinds ValueParams;
+    DeleteParams.AddUInt32( botid );
+
+    for( vector<GameListRow> :: iterator i = rows.begin( ); i != rows.end( ); ++i )
+    {
+        if( i->Reset )
+        {
+            if( !DeleteIDs.empty( ) )
+                DeleteIDs += ", ";
+
+            DeleteIDs += "?";
+            DeleteParams.AddUInt32( i->HostCounter );
+            continue;
         }
-        string EscPlayerList = MySQLEscapeString( conn, Users );
 
-        string Query = "INSERT INTO oh_gamelist (botid, gameid, lobby, map_type, gamename, ownername, creatorname, map) VALUES ('" + UTIL_ToString( botid ) + "', '" + UTIL_ToString( hostcounter ) + "', '" + UTIL_ToString( lobby ) + "', '" + EscMapType + "', '" + EscGameName + "', '" + EscOwnerName + "', '" + EscCreatorName + "', '" + EscMap + "') ON DUPLICATE KEY UPDATE lobby = '" + UTIL_ToString( lobby ) + "', duration = '" + UTIL_ToString( duration ) + "', ownername = '" + EscOwnerName + "', players = '" + UTIL_ToString( players ) + "', total = '" + UTIL_ToString( total ) + "', users = '" + EscPlayerList + "'";
+        if( i->GameName.empty( ) )
+            continue;
+
+        string Users;
+
+        for( vector<PlayerOfPlayerList> :: iterator j = i->PlayerList.begin( ); j != i->PlayerList.end( ); ++j )
+            Users += UTIL_ToString(j->Slot)+Splitter+UTIL_ToString(j->Team)+Splitter+UTIL_ToString(j->Color)+Splitter+j->Username+Splitter+j->Realm+Splitter+UTIL_ToString(j->Ping)+Splitter+j->IP+Splitter+UTIL_ToString(j->LeftTime)+Splitter+j->LeftReason+PlayerSplitter;
+
+        if( !Values.empty( ) )
+            Values += ", ";
+
+        Values += "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        ValueParams.AddUInt32( botid );
+        ValueParams.AddUInt32( i->HostCounter );
+        ValueParams.AddUInt32( i->Lobby );
+        ValueParams.AddString( i->MapType );
+        ValueParams.AddString( i->GameName );
+        ValueParams.AddString( i->OwnerName );
+        ValueParams.AddString( i->CreatorName );
+        ValueParams.AddString( i->Map );
+        ValueParams.AddUInt32( i->Duration );
+        ValueParams.AddUInt32( i->Players );
+        ValueParams.AddUInt32( i->Total );
+        ValueParams.AddString( Users );
+    }
 
-        if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-            *error = mysql_error( (MYSQL *)conn );
-    } else {
-        string Query = "DELETE FROM oh_gamelist WHERE botid = " + UTIL_ToString( botid ) + " AND ( gameid = " + UTIL_ToString( hostcounter ) + " OR lobby = 1 )";
+    if( !DeleteIDs.empty( ) )
+    {
+        string Query = "DELETE FROM oh_gamelist WHERE botid = ? AND ( gameid IN ( " + DeleteIDs + " ) OR lobby = 1 )";
 
-        if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-            *error = mysql_error( (MYSQL *)conn );
+        if( !MySQLExecuteStatement( conn, error, Query, DeleteParams, NULL ) )
+            return "";
+    }
+
+    if( !Values.empty( ) )
+    {
+        string Query = "INSERT INTO oh_gamelist (botid, gameid, lobby, map_type, gamename, ownername, creatorname, map, duration, players, total, users) VALUES " + Values + " ON DUPLICATE KEY UPDATE lobby = VALUES(lobby), duration = VALUES(duration), ownername = VALUES(ownername), players = VALUES(players), total = VALUES(total), users = VALUES(users)";
+        MySQLExecuteStatement( conn, error, Query, ValueParams, NULL );
     }
+
     return "";
 }
 
@@ -1648,67 +2170,81 @@ map<uint32_t, string> MySQLGetStatsTemplates( void *conn, string *error, uint32_
     return m_Templates;
 }
 
+// the stats columns for one alias (or summed over every alias when aliasid is 0) in the order of PlayerStatsKeys
+// the keys are what the stats templates use as {KEY} placeholders
+
+static const char *PlayerStatsKeys[] = { "VALUE_01", "VALUE_02", "VALUE_03", "VALUE_04", "VALUE_05", "VALUE_06", "VALUE_07", "VALUE_08", "VALUE_09", "VALUE_10", "VALUE_11", "VALUE_12", "VALUE_13", "REALM", "STREAK", "MAXSTREAK", "LOSINGSTREAK", "MAXLOSINGSTREAK", "ZERODEATHS", "WINPRECENTAGE", "NAME", "STAYPERCENTAGE", "PLAYTIME" };
+static const unsigned int NumPlayerStatsKeys = sizeof( PlayerStatsKeys ) / sizeof( PlayerStatsKeys[0] );
+
+string MySQLPlayerStatsColumns( uint32_t aliasid )
+{
+    if( aliasid != 0 )
+        return "games as 'VALUE_01', score as 'VALUE_02', `wins` as 'VALUE_03', `losses` as 'VALUE_04', `draw` as 'VALUE_05', `kills` as 'VALUE_06', `deaths` as 'VALUE_07', `assists` as 'VALUE_08', `creeps` as 'VALUE_09', `denies` as 'VALUE_10', `neutrals` as 'VALUE_11', `towers` as 'VALUE_12', `rax` as 'VALUE_13', `realm` as 'REALM', `streak` as 'STREAK', `maxstreak` as 'MAXSTREAK', `losingstreak` as 'LOSINGSTREAK', `maxlosingstreak` as 'MAXLOSINGSTREAK', `zerodeaths` as 'ZERODEATHS', TRUNCATE(((`wins`*100)/`games`), 2) AS 'WINPRECENTAGE', player, leaver, `playtime`";
+    else
+        return "SUM(games) as 'VALUE_01', SUM(score) as 'VALUE_02', SUM(`wins`) as 'VALUE_03', SUM(`losses`) as 'VALUE_04', SUM(`draw`) as 'VALUE_05', SUM(`kills`) as 'VALUE_06', SUM(`deaths`) as 'VALUE_07', SUM(`assists`) as 'VALUE_08', SUM(`creeps`) as 'VALUE_09', SUM(`denies`) as 'VALUE_10', SUM(`neutrals`) as 'VALUE_11', SUM(`towers`) as 'VALUE_12', SUM(`rax`) as 'VALUE_13', `realm` as 'REALM', MAX(`streak`) as 'STREAK', MAX(`maxstreak`) as 'MAXSTREAK', MAX(`losingstreak`) as 'LOSINGSTREAK', MAX(`maxlosingstreak`) as 'MAXLOSINGSTREAK', SUM(`zerodeaths`) as 'ZERODEATHS', TRUNCATE(((SUM(`wins`)*100)/SUM(`games`)), 2) AS 'WINPRECENTAGE', player, SUM(leaver), SUM(`playtime`)";
+}
+
 map<string, string> MySQLGetPlayerStats( void *conn, string *error, uint32_t botid, uint32_t aliasid, uint32_t playerid )
 {
     map<string, string> m_Stats;
-    string Query = "";
-    if(aliasid != 0) {
-        Query = "SELECT games as 'VALUE_01', score as 'VALUE_02', `wins` as 'VALUE_03', `losses` as 'VALUE_04', `draw` as 'VALUE_05', `kills` as 'VALUE_06', `deaths` as 'VALUE_07', `assists` as 'VALUE_08', `creeps` as 'VALUE_09', `denies` as 'VALUE_10', `neutrals` as 'VALUE_11', `towers` as 'VALUE_12', `rax` as 'VALUE_13', `realm` as 'REALM', `streak` as 'STREAK', `maxstreak` as 'MAXSTREAK', `losingstreak` as 'LOSINGSTREAK', `maxlosingstreak` as 'MAXLOSINGSTREAK', `zerodeaths` as 'ZERODEATHS', TRUNCATE(((`wins`*100)/`games`), 2) AS 'WINPRECENTAGE', player, leaver, `playtime` FROM oh_stats_global WHERE `alias_id` = " + UTIL_ToString(aliasid) + " AND `pid` = " + UTIL_ToString(playerid) + ";";
-    } else {
-        Query = "SELECT SUM(games) as 'VALUE_01', SUM(score) as 'VALUE_02', SUM(`wins`) as 'VALUE_03', SUM(`losses`) as 'VALUE_04', SUM(`draw`) as 'VALUE_05', SUM(`kills`) as 'VALUE_06', SUM(`deaths`) as 'VALUE_07', SUM(`assists`) as 'VALUE_08', SUM(`creeps`) as 'VALUE_09', SUM(`denies`) as 'VALUE_10', SUM(`neutrals`) as 'VALUE_11', SUM(`towers`) as 'VALUE_12', SUM(`rax`) as 'VALUE_13', `realm` as 'REALM', MAX(`streak`) as 'STREAK', MAX(`maxstreak`) as 'MAXSTREAK', MAX(`losingstreak`) as 'LOSINGSTREAK', MAX(`maxlosingstreak`) as 'MAXLOSINGSTREAK', SUM(`zerodeaths`) as 'ZERODEATHS', TRUNCATE(((SUM(`wins`)*100)/SUM(`games`)), 2) AS 'WINPRECENTAGE', player, SUM(leaver), SUM(`playtime`) FROM oh_stats_global WHERE `pid` = " + UTIL_ToString(playerid) + ";";
-    }
+    string Query = "SELECT " + MySQLPlayerStatsColumns( aliasid ) + " FROM oh_stats_global WHERE ";
+    CMySQLBinds Params;
 
-    if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
-        *error = mysql_error( (MYSQL *)conn );
-    else
+    if( aliasid != 0 )
     {
-        MYSQL_RES *Result = mysql_store_result( (MYSQL *)conn );
+        Query += "`alias_id` = ? AND ";
+        Params.AddUInt32( aliasid );
+    }
 
-        if( Result )
-        {
-            vector<string> Row = MySQLFetchRow( Result );
-            if( Row.size( ) == 23 )
-            {
-                m_Stats["VALUE_01"] = Row[0];
-                m_Stats["VALUE_02"] = Row[1];
-                m_Stats["VALUE_03"] = Row[2];
-                m_Stats["VALUE_04"] = Row[3];
-                m_Stats["VALUE_05"] = Row[4];
-                m_Stats["VALUE_06"] = Row[5];
-                m_Stats["VALUE_07"] = Row[6];
-                m_Stats["VALUE_08"] = Row[7];
-                m_Stats["VALUE_09"] = Row[8];
-                m_Stats["VALUE_10"] = Row[9];
-                m_Stats["VALUE_11"] = Row[10];
-                m_Stats["VALUE_12"] = Row[11];
-                m_Stats["VALUE_13"] = Row[12];
-                m_Stats["REALM"] = Row[13];
-                m_Stats["STREAK"] = Row[14];
-                m_Stats["MAXSTREAK"] = Row[15];
-                m_Stats["LOSINGSTREAK"] = Row[16];
-                m_Stats["MAXLOSINGSTREAK"] = Row[17];
-                m_Stats["ZERODEATHS"] = Row[18];
-                m_Stats["WINPRECENTAGE"] = Row[19];
-                m_Stats["NAME"] = Row[20];
-                m_Stats["STAYPERCENTAGE"] = Row[21];
-                m_Stats["PLAYTIME"] = Row[22];
-                
-                Row = MySQLFetchRow( Result );
-            }
+    Query += "`pid` = ?";
+    Params.AddUInt32( playerid );
 
-            mysql_free_result( Result );
+    // every column is fetched as a string, the server converts the numbers the same way it does for a normal query
+
+    CMySQLBinds Results;
+
+    for( unsigned int i = 0; i < NumPlayerStatsKeys; i++ )
+        Results.AddStringResult( );
+
+    MYSQL_STMT *Statement = MySQLExecuteStatement( conn, error, Query, Params, &Results );
+
+    if( Statement )
+    {
+        if( MySQLFetchStatement( Statement, Results ) )
+        {
+            for( unsigned int i = 0; i < NumPlayerStatsKeys; i++ )
+                m_Stats[PlayerStatsKeys[i]] = Results.GetString( i );
         }
-        else
-            *error = mysql_error( (MYSQL *)conn );
+
+        mysql_stmt_free_result( Statement );
     }
 
     return m_Stats;
 }
 
-double MySQLGetPlayerScore( void *conn, string *error, uint32_t botid, uint32_t aliasid, uint32_t playerid )
+map<uint32_t, map<string, string> > MySQLGetPlayerStatsBatch( void *conn, string *error, uint32_t botid, uint32_t aliasid, vector<uint32_t> playerids )
 {
-    double m_Score = 1000.00;
-    string Query = "SELECT score FROM oh_stats_global WHERE `alias_id` = " + UTIL_ToString(aliasid) + " AND `pid` = " + UTIL_ToString(playerid) + ";";
+    map<uint32_t, map<string, string> > Stats;
+
+    if( playerids.empty( ) )
+        return Stats;
+
+    string PlayerIds;
+
+    for( vector<uint32_t> :: iterator i = playerids.begin( ); i != playerids.end( ); i++ )
+    {
+        if( !PlayerIds.empty( ) )
+            PlayerIds += ", ";
+
+        PlayerIds += UTIL_ToString( *i );
+    }
+
+    string Query = "SELECT pid, " + MySQLPlayerStatsColumns( aliasid ) + " FROM oh_stats_global WHERE ";
+
+    if( aliasid != 0 )
+        Query += "`alias_id` = " + UTIL_ToString( aliasid ) + " AND `pid` IN ( " + PlayerIds + " )";
+    else
+        Query += "`pid` IN ( " + PlayerIds + " ) GROUP BY pid";
 
     if( mysql_real_query( (MYSQL *)conn, Query.c_str( ), Query.size( ) ) != 0 )
         *error = mysql_error( (MYSQL *)conn );
@@ -1719,9 +2255,14 @@ double MySQLGetPlayerScore( void *conn, string *error, uint32_t botid, uint32_t
         if( Result )
         {
             vector<string> Row = MySQLFetchRow( Result );
-            if( Row.size( ) == 1 )
+
+            while( Row.size( ) == NumPlayerStatsKeys + 1 )
             {
-                m_Score = UTIL_ToDouble(Row[0]);
+                map<string, string> &PlayerStats = Stats[UTIL_ToUInt32( Row[0] )];
+
+                for( unsigned int i = 0; i < NumPlayerStatsKeys; i++ )
+                    PlayerStats[PlayerStatsKeys[i]] = Row[i + 1];
+
                 Row = MySQLFetchRow( Result );
             }
 
@@ -1731,6 +2272,29 @@ double MySQLGetPlayerScore( void *conn, string *error, uint32_t botid, uint32_t
             *error = mysql_error( (MYSQL *)conn );
     }
 
+    return Stats;
+}
+
+double MySQLGetPlayerScore( void *conn, string *error, uint32_t botid, uint32_t aliasid, uint32_t playerid )
+{
+    double m_Score = 1000.00;
+    string Query = "SELECT score FROM oh_stats_global WHERE `alias_id` = ? AND `pid` = ?";
+    CMySQLBinds Params;
+    Params.AddUInt32( aliasid );
+    Params.AddUInt32( playerid );
+    CMySQLBinds Results;
+    Results.AddDoubleResult( );
+
+    MYSQL_STMT *Statement = MySQLExecuteStatement( conn, error, Query, Params, &Results );
+
+    if( Statement )
+    {
+        if( MySQLFetchStatement( Statement, Results ) )
+            m_Score = Results.GetDouble( 0 );
+
+        mysql_stmt_free_result( Statement );
+    }
+
     return m_Score;
 }
 
@@ -1753,14 +2317,7 @@ void CMySQLCallable :: Init( )
 {
 	CBaseCallable :: Init( );
 
-#ifndef WIN32
-	// disable SIGPIPE since this is (or should be) a new thread and it doesn't inherit the spawning thread's signal handlers
-	// MySQL should automatically disable SIGPIPE when we initialize it but we do so anyway here
-
-	signal( SIGPIPE, SIG_IGN );
-#endif
-
-	mysql_thread_init( );
+	// note: the worker thread running this callable has already disabled SIGPIPE and called mysql_thread_init
 
 	if( !m_Connection )
 	{
@@ -1779,9 +2336,12 @@ void CMySQLCallable :: Init( )
 
 void CMySQLCallable :: Close( )
 {
-	mysql_thread_end( );
+	if( m_ConnectionSlot )
+		*m_ConnectionSlot = m_Connection;
+
+	// the worker marks the callable as ready through CGHostDB :: CompleteCallable once we return
 
-	CBaseCallable :: Close( );
+	m_EndTicks = GetTicks( );
 }
 
 void CMySQLCallableAdminCount :: operator( )( )
@@ -1899,6 +2459,16 @@ void CMySQLCallableGameAdd :: operator( )( )
 	Close( );
 }
 
+void CMySQLCallableGameResultAdd :: operator( )( )
+{
+	Init( );
+
+	if( m_Error.empty( ) )
+		m_Result = MySQLGameResultAdd( m_Connection, &m_Error, m_SQLBotID, m_GameResult );
+
+	Close( );
+}
+
 void CMySQLCallableGamePlayerAdd :: operator( )( )
 {
 	Init( );
@@ -2071,7 +2641,7 @@ void CMySQLCallableGameUpdate :: operator( )( )
     Init( );
 
     if( m_Error.empty( ) )
-        m_Result = MySQLGameUpdate( m_Connection, &m_Error, m_SQLBotID, m_Hostcounter, m_Lobby, m_MapType, m_Duration, m_GameName, m_OwnerName, m_CreatorName, m_Map, m_Players, m_Total, m_Playerlist );
+        m_Result = MySQLGameUpdate( m_Connection, &m_Error, m_SQLBotID, m_Rows );
 
     Close( );
 }
@@ -2106,6 +2676,16 @@ void CMySQLCallableGetPlayerStats :: operator( )( )
         Close( );
 }
 
+void CMySQLCallableGetPlayerStatsBatch :: operator( )( )
+{
+	Init( );
+
+	if( m_Error.empty( ) )
+		m_Result = MySQLGetPlayerStatsBatch( m_Connection, &m_Error, m_SQLBotID, m_AliasId, m_PlayerIds );
+
+	Close( );
+}
+
 void CMySQLCallableGetPlayerScore :: operator( )( )
 {
         Init( );
@@ -23,10 +23,16 @@
 #ifndef GHOSTDBMYSQL_H
 #define GHOSTDBMYSQL_H
 
+#include <boost/thread/mutex.hpp>
+
 //
 // CGHostDBMySQL
 //
 
+class CMySQLWorkers;
+class CMetricGauge;
+class CMetricHistogram;
+
 class CGHostDBMySQL : public CGHostDB
 {
 private:
@@ -36,10 +42,20 @@ private:
 	string m_Password;
 	uint16_t m_Port;
 	uint32_t m_BotID;
-	queue<void *> m_IdleConnections;
-	uint32_t m_NumConnections;
+	CMySQLWorkers *m_Workers;				// the worker threads which run the callables, each one owns a connection
+	boost :: mutex m_CallablesMutex;		// the callables are created and recovered by the game threads too
 	uint32_t m_OutstandingCallables;
 
+	struct CallableMetrics
+	{
+		CMetricGauge *Outstanding;
+		CMetricHistogram *Duration;
+	};
+
+	map<string, CallableMetrics> m_CallableMetrics;	// callable type -> its metrics
+
+	CallableMetrics &GetCallableMetrics( CBaseCallable *callable );
+
 public:
 	CGHostDBMySQL( CConfig *CFG );
 	virtual ~CGHostDBMySQL( );
@@ -63,6 +79,7 @@ public:
 	virtual CCallableBanRemove *ThreadedBanRemove( string user );
 	virtual CCallableBanList *ThreadedBanList( string server );
 	virtual CCallableGameAdd *ThreadedGameAdd( string server, string map, string gamename, string ownername, uint32_t duration, uint32_t gamestate, string creatorname, string creatorserver, uint32_t gameid, uint32_t aliasid, vector<string> lobbylog, vector<string> gamelog, string elochange );
+	virtual CCallableGameResultAdd *ThreadedGameResultAdd( CDBGameResult *result );
 	virtual CCallableGamePlayerAdd *ThreadedGamePlayerAdd( uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour, uint32_t playerid );
 	virtual CCallableGamePlayerSummaryCheck *ThreadedGamePlayerSummaryCheck( string name );
 	virtual CCallableDotAGameAdd *ThreadedDotAGameAdd( uint32_t gameid, uint32_t winner, uint32_t min, uint32_t sec );
@@ -83,14 +100,13 @@ public:
         virtual CCallableGetBotConfigTexts *ThreadedGetBotConfigTexts( );
         virtual CCallableGetLanguages *ThreadedGetLanguages( );
         virtual CCallableGetMapConfig *ThreadedGetMapConfig( string configname );
-        virtual CCallableGameUpdate *ThreadedGameUpdate( uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist );
+        virtual CCallableGameUpdate *ThreadedGameUpdate( vector<GameListRow> rows );
         virtual CCallableGetAliases *ThreadedGetAliases( );
         virtual CCallableGetStatsTemplates *ThreadedGetStatsTemplates( );
         virtual CCallableGetPlayerStats *ThreadedGetPlayerStats( uint32_t aliasid, uint32_t playerid ); 
         virtual CCallableGetPlayerScore *ThreadedGetPlayerScore( uint32_t aliasid, uint32_t playerid ); 
+	virtual CCallableGetPlayerStatsBatch *ThreadedGetPlayerStatsBatch( uint32_t aliasid, vector<uint32_t> playerids );
         virtual CCallableUpdateGameInfo *ThreadedUpdateGameInfo( uint32_t gameid, string gamename );   
- 
-	virtual void *GetIdleConnection( );
 };
 
 //
@@ -109,6 +125,7 @@ bool MySQLBanRemove( void *conn, string *error, uint32_t botid, string server, s
 bool MySQLBanRemove( void *conn, string *error, uint32_t botid, string user );
 vector<CDBBan *> MySQLBanList( void *conn, string *error, uint32_t botid, string server );
 uint32_t MySQLGameAdd( void *conn, string *error, uint32_t botid, string server, string map, string gamename, string ownername, uint32_t duration, uint32_t gamestate, string creatorname, string creatorserver, uint32_t gameid, uint32_t aliasid, vector<string> lobbylog, vector<string> gamelog, string elochange );
+uint32_t MySQLGameResultAdd( void *conn, string *error, uint32_t botid, CDBGameResult *result );
 uint32_t MySQLGamePlayerAdd( void *conn, string *error, uint32_t botid, uint32_t gameid, string name, string ip, uint32_t spoofed, string spoofedrealm, uint32_t reserved, uint32_t loadingtime, uint32_t left, string leftreason, uint32_t team, uint32_t colour, uint32_t playerid );
 CDBGamePlayerSummary *MySQLGamePlayerSummaryCheck( void *conn, string *error, uint32_t botid, string name );
 uint32_t MySQLDotAGameAdd( void *conn, string *error, uint32_t botid, uint32_t gameid, uint32_t winner, uint32_t min, uint32_t sec );
@@ -127,11 +144,12 @@ map<string, string> MySQLGetBotConfigs( void *conn, string *error, uint32_t boti
 map<string, vector<string> > MySQLGetBotConfigTexts( void *conn, string *error, uint32_t botid );
 map<string, map<uint32_t, string> > MySQLGetLanguages( void *conn, string *error, uint32_t botid );
 map<string, string> MySQLGetMapConfig( void *conn, string *error, uint32_t botid, string configname);
-string MySQLGameUpdate( void *conn, string *error, uint32_t botid, uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist );
+string MySQLGameUpdate( void *conn, string *error, uint32_t botid, vector<GameListRow> rows );
 map<uint32_t, string> MySQLGetAliases( void *conn, string *error, uint32_t botid );
 map<uint32_t, string> MySQLGetStatsTemplates( void *conn, string *error, uint32_t botid );
 map<string, string> MySQLGetPlayerStats( void *conn, string *error, uint32_t botid, uint32_t aliasid, uint32_t playerid );
 double MySQLGetPlayerScore( void *conn, string *error, uint32_t botid, uint32_t aliasid, uint32_t playerid );
+map<uint32_t, map<string, string> > MySQLGetPlayerStatsBatch( void *conn, string *error, uint32_t botid, uint32_t aliasid, vector<uint32_t> playerids );
 void MySQLUpdateGameInfo( uint32_t gameid, string gamename );
 
 
@@ -149,13 +167,16 @@ protected:
 	string m_SQLPassword;
 	uint16_t m_SQLPort;
 	uint32_t m_SQLBotID;
+	void **m_ConnectionSlot;					// where to hand the connection back to the worker thread, this must happen before the callable is marked as ready
 
 public:
-	CMySQLCallable( void *nConnection, uint32_t nSQLBotID, string nSQLServer, string nSQLDatabase, string nSQLUser, string nSQLPassword, uint16_t nSQLPort ) : CBaseCallable( ), m_Connection( nConnection ), m_SQLBotID( nSQLBotID ), m_SQLServer( nSQLServer ), m_SQLDatabase( nSQLDatabase ), m_SQLUser( nSQLUser ), m_SQLPassword( nSQLPassword ), m_SQLPort( nSQLPort ) { }
+	CMySQLCallable( void *nConnection, uint32_t nSQLBotID, string nSQLServer, string nSQLDatabase, string nSQLUser, string nSQLPassword, uint16_t nSQLPort ) : CBaseCallable( ), m_Connection( nConnection ), m_SQLBotID( nSQLBotID ), m_SQLServer( nSQLServer ), m_SQLDatabase( nSQLDatabase ), m_SQLUser( nSQLUser ), m_SQLPassword( nSQLPassword ), m_SQLPort( nSQLPort ), m_ConnectionSlot( NULL ) { }
 	virtual ~CMySQLCallable( ) { }
 
-	virtual void *GetConnection( )	{ return m_Connection; }
+	virtual void *GetConnection( )					{ return m_Connection; }
+	virtual void SetConnection( void *nConnection )	{ m_Connection = nConnection; }
 
+	virtual void Run( void **connectionSlot )		{ m_ConnectionSlot = connectionSlot; (*this)( ); }
 	virtual void Init( );
 	virtual void Close( );
 };
@@ -281,6 +302,17 @@ public:
 	virtual void Close( ) { CMySQLCallable :: Close( ); }
 };
 
+class CMySQLCallableGameResultAdd : public CCallableGameResultAdd, public CMySQLCallable
+{
+public:
+	CMySQLCallableGameResultAdd( CDBGameResult *nGameResult, void *nConnection, uint32_t nSQLBotID, string nSQLServer, string nSQLDatabase, string nSQLUser, string nSQLPassword, uint16_t nSQLPort ) : CBaseCallable( ), CCallableGameResultAdd( nGameResult ), CMySQLCallable( nConnection, nSQLBotID, nSQLServer, nSQLDatabase, nSQLUser, nSQLPassword, nSQLPort ) { }
+	virtual ~CMySQLCallableGameResultAdd( ) { }
+
+	virtual void operator( )( );
+	virtual void Init( ) { CMySQLCallable :: Init( ); }
+	virtual void Close( ) { CMySQLCallable :: Close( ); }
+};
+
 class CMySQLCallableGamePlayerAdd : public CCallableGamePlayerAdd, public CMySQLCallable
 {
 public:
@@ -455,7 +487,7 @@ public:
 class CMySQLCallableGameUpdate : public CCallableGameUpdate, public CMySQLCallable
 {
 public:
-    CMySQLCallableGameUpdate( uint32_t hostcounter, uint32_t lobby, string map_type, uint32_t duration, string gamename, string ownername, string creatorname, string map, uint32_t players, uint32_t total, vector<PlayerOfPlayerList> playerlist, void *nConnection, uint32_t nSQLBotID, string nSQLServer, string nSQLDatabase, string nSQLUser, string nSQLPassword, uint16_t nSQLPort ) : CBaseCallable( ), CCallableGameUpdate( hostcounter, lobby, map_type, duration, gamename, ownername, creatorname, map, players, total,  playerlist ), CMySQLCallable( nConnection, nSQLBotID, nSQLServer, nSQLDatabase, nSQLUser, nSQLPassword, nSQLPort ) { }
+    CMySQLCallableGameUpdate( vector<GameListRow> rows, void *nConnection, uint32_t nSQLBotID, string nSQLServer, string nSQLDatabase, string nSQLUser, string nSQLPassword, uint16_t nSQLPort ) : CBaseCallable( ), CCallableGameUpdate( rows ), CMySQLCallable( nConnection, nSQLBotID, nSQLServer, nSQLDatabase, nSQLUser, nSQLPassword, nSQLPort ) { }
     virtual ~CMySQLCallableGameUpdate( ) { }
 
     virtual void operator( )( );
@@ -507,6 +539,16 @@ public:
         virtual void Close( ) { CMySQLCallable :: Close( ); }
 };
 
+class CMySQLCallableGetPlayerStatsBatch : public CCallableGetPlayerStatsBatch, public CMySQLCallable
+{
+public:
+	CMySQLCallableGetPlayerStatsBatch( uint32_t nAliasId, vector<uint32_t> nPlayerIds, void *nConnection, uint32_t nSQLBotID, string nSQLServer, string nSQLDatabase, string nSQLUser, string nSQLPassword, uint16_t nSQLPort ) : CBaseCallable( ), CCallableGetPlayerStatsBatch( nAliasId, nPlayerIds ), CMySQLCallable( nConnection, nSQLBotID, nSQLServer, nSQLDatabase, nSQLUser, nSQLPassword, nSQLPort ) { }
+
+	virtual void operator( )( );
+	virtual void Init( ) { CMySQLCallable :: Init( ); }
+	virtual void Close( ) { CMySQLCallable :: Close( ); }
+};
+
 class CMySQLCallableUpdateGameInfo : public CCallableUpdateGameInfo, public CMySQLCallable
 {
 public:
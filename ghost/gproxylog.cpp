@@ -0,0 +1,209 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#include "ghost.h"
+#include "socket.h"
+#include "metrics.h"
+#include "gproxylog.h"
+
+//
+// CGProxyLog
+//
+
+CGProxyLog :: CGProxyLog( uint32_t nMaxBytes, string nMetricsLabels )
+{
+	m_FirstSeq = 0;
+	m_Bytes = 0;
+	m_MaxBytes = nMaxBytes;
+
+	for( int i = 0; i < GPROXYLOG_MAX_READERS; i++ )
+	{
+		m_Readers[i].Active = false;
+		m_Readers[i].Cursor = 0;
+		m_Readers[i].Pending = 0;
+		m_Readers[i].Dropped = 0;
+	}
+
+	m_MetricsLabels = nMetricsLabels;
+	m_BytesGauge = gMetrics->Gauge( "ghost_gproxy_log_bytes", "Bytes of packets kept for GProxy++ reconnects.", m_MetricsLabels );
+	m_PacketsGauge = gMetrics->Gauge( "ghost_gproxy_log_packets", "Packets kept for GProxy++ reconnects.", m_MetricsLabels );
+	m_DroppedPackets = gMetrics->Counter( "ghost_gproxy_log_dropped_total", "Unacked packets dropped from the GProxy++ resend log because of bot_reconnectbuffersize." );
+	m_ResentPackets = gMetrics->Counter( "ghost_gproxy_resent_packets_total", "Packets resent to players after a GProxy++ reconnect." );
+}
+
+CGProxyLog :: ~CGProxyLog( )
+{
+	gMetrics->Remove( "ghost_gproxy_log_bytes", m_MetricsLabels );
+	gMetrics->Remove( "ghost_gproxy_log_packets", m_MetricsLabels );
+}
+
+void CGProxyLog :: Trim( )
+{
+	uint32_t Oldest = GetEndSeq( );
+
+	for( int i = 0; i < GPROXYLOG_MAX_READERS; i++ )
+	{
+		if( m_Readers[i].Active && m_Readers[i].Cursor < Oldest )
+			Oldest = m_Readers[i].Cursor;
+	}
+
+	while( m_FirstSeq < Oldest )
+	{
+		m_Bytes -= m_Entries.front( ).Data->size( );
+		m_Entries.pop_front( );
+		m_FirstSeq++;
+	}
+
+	UpdateGauges( );
+}
+
+void CGProxyLog :: UpdateGauges( )
+{
+	m_BytesGauge->Set( m_Bytes );
+	m_PacketsGauge->Set( m_Entries.size( ) );
+}
+
+int CGProxyLog :: AddReader( )
+{
+	for( int i = 0; i < GPROXYLOG_MAX_READERS; i++ )
+	{
+		if( !m_Readers[i].Active )
+		{
+			// entries which are already in the log might still have this reader's bit set from a previous reader but the cursor starts after them
+
+			m_Readers[i].Active = true;
+			m_Readers[i].Cursor = GetEndSeq( );
+			m_Readers[i].Pending = 0;
+			m_Readers[i].Dropped = 0;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void CGProxyLog :: RemoveReader( int reader )
+{
+	m_Readers[reader].Active = false;
+	Trim( );
+}
+
+void CGProxyLog :: Append( int reader, SHAREDBYTEARRAY data )
+{
+	Reader &R = m_Readers[reader];
+	uint64_t Bit = (uint64_t)1 << reader;
+
+	if( !m_Entries.empty( ) && m_Entries.back( ).Data == data && !( m_Entries.back( ).Readers & Bit ) )
+		m_Entries.back( ).Readers |= Bit;
+	else
+	{
+		Entry NewEntry;
+		NewEntry.Data = data;
+		NewEntry.Readers = Bit;
+		m_Entries.push_back( NewEntry );
+		m_Bytes += data->size( );
+	}
+
+	if( R.Pending == 0 )
+		R.Cursor = GetEndSeq( ) - 1;
+
+	R.Pending++;
+
+	// drop the oldest entries until we're back under the limit, the newest entry is always kept
+
+	while( m_Bytes > m_MaxBytes && m_Entries.size( ) > 1 )
+	{
+		Entry &Oldest = m_Entries.front( );
+
+		for( int i = 0; i < GPROXYLOG_MAX_READERS; i++ )
+		{
+			if( m_Readers[i].Active && m_Readers[i].Cursor == m_FirstSeq )
+			{
+				if( Oldest.Readers & ( (uint64_t)1 << i ) )
+				{
+					m_Readers[i].Pending--;
+					m_Readers[i].Dropped++;
+					m_DroppedPackets->Add( 1 );
+				}
+
+				m_Readers[i].Cursor++;
+			}
+		}
+
+		m_Bytes -= Oldest.Data->size( );
+		m_Entries.pop_front( );
+		m_FirstSeq++;
+	}
+
+	UpdateGauges( );
+}
+
+void CGProxyLog :: Ack( int reader, uint32_t packets )
+{
+	Reader &R = m_Readers[reader];
+	uint64_t Bit = (uint64_t)1 << reader;
+
+	if( packets > R.Pending )
+		packets = R.Pending;
+
+	R.Dropped = 0;
+
+	while( packets > 0 )
+	{
+		if( m_Entries[R.Cursor - m_FirstSeq].Readers & Bit )
+		{
+			R.Pending--;
+			packets--;
+		}
+
+		R.Cursor++;
+	}
+
+	// move the cursor up to the reader's next packet so it doesn't hold back the trimming
+
+	if( R.Pending == 0 )
+		R.Cursor = GetEndSeq( );
+	else
+	{
+		while( !( m_Entries[R.Cursor - m_FirstSeq].Readers & Bit ) )
+			R.Cursor++;
+	}
+
+	Trim( );
+}
+
+uint32_t CGProxyLog :: Resend( int reader, CTCPSocket *socket )
+{
+	Reader &R = m_Readers[reader];
+	uint64_t Bit = (uint64_t)1 << reader;
+	uint32_t Packets = 0;
+
+	for( uint32_t i = R.Cursor - m_FirstSeq; i < m_Entries.size( ) && Packets < R.Pending; i++ )
+	{
+		if( m_Entries[i].Readers & Bit )
+		{
+			socket->PutBytes( m_Entries[i].Data );
+			Packets++;
+		}
+	}
+
+	m_ResentPackets->Add( Packets );
+	return Packets;
+}
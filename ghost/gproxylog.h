@@ -0,0 +1,99 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#ifndef GPROXYLOG_H
+#define GPROXYLOG_H
+
+//
+// CGProxyLog
+//
+
+// every packet sent to a GProxy++ player after the game has loaded has to be kept until the player acks it so it can be resent after a reconnect
+// 1.) the game keeps one log for all its GProxy++ players, each packet is stored once (numbered by its position in the log) no matter how many players it was sent to
+// 2.) each entry has a bit for every reader (player) it was sent to, a reader only keeps a cursor to its oldest unacked entry and the number of its packets after the cursor
+// 3.) the log is trimmed up to the oldest cursor after each ack, and the oldest entries are dropped (acked or not) when the log grows beyond its byte limit
+// 4.) a reader whose unacked packets were dropped can't be resumed unless GProxy++ tells us it received them anyway
+
+class CTCPSocket;
+class CMetricCounter;
+class CMetricGauge;
+
+#define GPROXYLOG_MAX_READERS	64
+
+class CGProxyLog
+{
+private:
+	struct Entry
+	{
+		SHAREDBYTEARRAY Data;
+		uint64_t Readers;					// bit n is set if the packet was sent to reader n
+	};
+
+	struct Reader
+	{
+		bool Active;
+		uint32_t Cursor;					// the sequence number of the reader's oldest unacked entry (or the end of the log)
+		uint32_t Pending;					// the number of the reader's packets in the log which haven't been acked
+		uint32_t Dropped;					// the number of the reader's unacked packets which were dropped from the log because of the byte limit
+	};
+
+	deque<Entry> m_Entries;
+	uint32_t m_FirstSeq;					// the sequence number of the first entry
+	uint32_t m_Bytes;
+	uint32_t m_MaxBytes;
+	Reader m_Readers[GPROXYLOG_MAX_READERS];
+	string m_MetricsLabels;
+	CMetricGauge *m_BytesGauge;
+	CMetricGauge *m_PacketsGauge;
+	CMetricCounter *m_DroppedPackets;
+	CMetricCounter *m_ResentPackets;
+
+	uint32_t GetEndSeq( )					{ return m_FirstSeq + m_Entries.size( ); }
+	void Trim( );
+	void UpdateGauges( );
+
+public:
+	CGProxyLog( uint32_t nMaxBytes, string nMetricsLabels );
+	~CGProxyLog( );
+
+	uint32_t GetBytes( )					{ return m_Bytes; }
+	uint32_t GetNumPackets( )				{ return m_Entries.size( ); }
+	uint32_t GetPending( int reader )		{ return m_Readers[reader].Pending; }
+	uint32_t GetDropped( int reader )		{ return m_Readers[reader].Dropped; }
+
+	// returns -1 if every reader is in use
+
+	int AddReader( );
+	void RemoveReader( int reader );
+
+	// packets sent to several readers in a row (e.g. with SendAll) share one entry
+
+	void Append( int reader, SHAREDBYTEARRAY data );
+
+	// acks the reader's oldest unacked packets, this also confirms every dropped packet since those were older
+
+	void Ack( int reader, uint32_t packets );
+
+	// queues every unacked packet of the reader on the socket (without copying them) and returns the number of packets
+
+	uint32_t Resend( int reader, CTCPSocket *socket );
+};
+
+#endif
@@ -36,6 +36,7 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <deque>
 #include <map>
 #include <queue>
 #include <set>
@@ -44,13 +45,19 @@
 
 using namespace std;
 
+// boost
+
+#include <boost/shared_ptr.hpp>
+
 typedef vector<unsigned char> BYTEARRAY;
+typedef boost :: shared_ptr<const BYTEARRAY> SHAREDBYTEARRAY;		// an immutable byte array which can be queued on many sockets (and GProxy++ buffers) without being copied
 typedef pair<unsigned char,string> PIDPlayer;
 
 // time
 
 uint32_t GetTime( );		// seconds
 uint32_t GetTicks( );		// milliseconds
+uint64_t GetMicroTicks( );	// microseconds
 
 #ifdef WIN32
  #define MILLISLEEP( x ) Sleep( x )
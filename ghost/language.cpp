@@ -23,1513 +23,1636 @@
 #include "config.h"
 #include "language.h"
 
+//
+// CMessageTemplate
+//
+
+CMessageTemplate :: CMessageTemplate( )
+{
+	m_Valid = false;
+}
+
+CMessageTemplate :: ~CMessageTemplate( )
+{
+
+}
+
+void CMessageTemplate :: Compile( const string &text, const vector<string> &tokens )
+{
+	m_Text.clear( );
+	m_Segments.clear( );
+	m_Valid = true;
+
+	string :: size_type Start = 0;
+	string :: size_type i = text.find( '$' );
+
+	while( i != string :: npos )
+	{
+		uint32_t Slot = MESSAGETEMPLATE_NOSLOT;
+
+		for( uint32_t j = 0; j < tokens.size( ); j++ )
+		{
+			if( text.compare( i, tokens[j].size( ), tokens[j] ) == 0 )
+			{
+				Slot = j;
+				break;
+			}
+		}
+
+		if( Slot == MESSAGETEMPLATE_NOSLOT )
+		{
+			i = text.find( '$', i + 1 );
+			continue;
+		}
+
+		Segment NewSegment;
+		NewSegment.Length = i - Start;
+		NewSegment.Slot = Slot;
+		m_Segments.push_back( NewSegment );
+		m_Text.append( text, Start, i - Start );
+		Start = i + tokens[Slot].size( );
+		i = text.find( '$', Start );
+	}
+
+	Segment LastSegment;
+	LastSegment.Length = text.size( ) - Start;
+	LastSegment.Slot = MESSAGETEMPLATE_NOSLOT;
+	m_Segments.push_back( LastSegment );
+	m_Text.append( text, Start, string :: npos );
+}
+
+uint32_t CMessageTemplate :: GetRenderedSize( const string **args ) const
+{
+	uint32_t Size = m_Text.size( );
+
+	for( vector<Segment> :: const_iterator i = m_Segments.begin( ); i != m_Segments.end( ); i++ )
+	{
+		if( i->Slot != MESSAGETEMPLATE_NOSLOT )
+			Size += args[i->Slot]->size( );
+	}
+
+	return Size;
+}
+
+void CMessageTemplate :: Render( string &out, const string **args ) const
+{
+	const char *Text = m_Text.data( );
+
+	for( vector<Segment> :: const_iterator i = m_Segments.begin( ); i != m_Segments.end( ); i++ )
+	{
+		out.append( Text, i->Length );
+		Text += i->Length;
+
+		if( i->Slot != MESSAGETEMPLATE_NOSLOT )
+			out += *args[i->Slot];
+	}
+}
+
 //
 // CLanguage
 //
 
+// the tokens of each message, in the order its method passes the arguments
+
+static const char *gLanguageTokens[] = {
+	"",											// there's no lang_0000
+	"$SERVER$ $GAMENAME$",						// lang_0001
+	"$SERVER$ $USER$",							// lang_0002
+	"$SERVER$ $USER$",							// lang_0003
+	"$SERVER$ $USER$",							// lang_0004
+	"",											// lang_0005
+	"$SERVER$ $VICTIM$",							// lang_0006
+	"$SERVER$ $VICTIM$",							// lang_0007
+	"$SERVER$ $VICTIM$",							// lang_0008
+	"$SERVER$ $USER$",							// lang_0009
+	"$SERVER$ $USER$",							// lang_0010
+	"$SERVER$ $VICTIM$ $DATE$ $ADMIN$ $REASON$",	// lang_0011
+	"$SERVER$ $VICTIM$",							// lang_0012
+	"$SERVER$",									// lang_0013
+	"$SERVER$",									// lang_0014
+	"$SERVER$ $COUNT$",							// lang_0015
+	"$SERVER$",									// lang_0016
+	"$SERVER$",									// lang_0017
+	"$SERVER$ $COUNT$",							// lang_0018
+	"",											// lang_0019
+	"$SERVER$ $USER$",							// lang_0020
+	"$SERVER$ $USER$",							// lang_0021
+	"$VICTIM$",									// lang_0022
+	"$VICTIM$",									// lang_0023
+	"$NUMBER$ $DESCRIPTION$",					// lang_0024
+	"$NUMBER$",									// lang_0025
+	"$DESCRIPTION$ $CURRENT$ $MAX$",				// lang_0026
+	"$CURRENT$ $MAX$",							// lang_0027
+	"",											// lang_0028
+	"$FILE$",									// lang_0029
+	"$FILE$",									// lang_0030
+	"$GAMENAME$ $USER$",							// lang_0031
+	"$GAMENAME$ $USER$",							// lang_0032
+	"$DESCRIPTION$",								// lang_0033
+	"$DESCRIPTION$",								// lang_0034
+	"",											// lang_0035
+	"$VERSION$",									// lang_0036
+	"$VERSION$",									// lang_0037
+	"$GAMENAME$ $DESCRIPTION$",					// lang_0038
+	"$GAMENAME$ $MAX$",							// lang_0039
+	"$DESCRIPTION$",								// lang_0040
+	"",											// lang_0041
+	"",											// lang_0042
+	"$USER$",									// lang_0043
+	"$USER$",									// lang_0044
+	"$USER$",									// lang_0045
+	"$USER$",									// lang_0046
+	"$USER$",									// lang_0047
+	"$USER$",									// lang_0048
+	"",											// lang_0049
+	"$VICTIM$",									// lang_0050
+	"$VICTIM$",									// lang_0051
+	"$SERVER$ $VICTIM$ $USER$",					// lang_0052
+	"$VICTIM$",									// lang_0053
+	"$USER$",									// lang_0054
+	"$VICTIM$",									// lang_0055
+	"$VICTIM$",									// lang_0056
+	"$MIN$",										// lang_0057
+	"$MAX$",										// lang_0058
+	"$LATENCY$",									// lang_0059
+	"$TOTAL$ $PING$",							// lang_0060
+	"$USER$ $FIRSTGAME$ $LASTGAME$ $TOTALGAMES$ $AVGLOADINGTIME$ $AVGSTAY$",	// lang_0061
+	"$USER$",									// lang_0062
+	"$VICTIM$ $PING$",							// lang_0063
+	"$SERVER$ $USER$",							// lang_0064
+	"$NOTSPOOFCHECKED$",							// lang_0065
+	"$HOSTNAME$",								// lang_0066
+	"$HOSTNAME$",								// lang_0067
+	"",											// lang_0068
+	"$NOTPINGED$",								// lang_0069
+	"",											// lang_0070
+	"$USER$ $LOADINGTIME$",						// lang_0071
+	"$USER$ $LOADINGTIME$",						// lang_0072
+	"$LOADINGTIME$",								// lang_0073
+	"$USER$ $TOTALGAMES$ $TOTALWINS$ $TOTALLOSSES$ $TOTALKILLS$ $TOTALDEATHS$ $TOTALCREEPKILLS$ $TOTALCREEPDENIES$ $TOTALASSISTS$ $TOTALNEUTRALKILLS$ $TOTALTOWERKILLS$ $TOTALRAXKILLS$ $TOTALCOURIERKILLS$ $AVGKILLS$ $AVGDEATHS$ $AVGCREEPKILLS$ $AVGCREEPDENIES$ $AVGASSISTS$ $AVGNEUTRALKILLS$ $AVGTOWERKILLS$ $AVGRAXKILLS$ $AVGCOURIERKILLS$",	// lang_0074
+	"$USER$",									// lang_0075
+	"$RESERVED$",								// lang_0076
+	"$OWNER$",									// lang_0077
+	"$USER$",									// lang_0078
+	"$ERROR$",									// lang_0079
+	"$ERROR$",									// lang_0080
+	"",											// lang_0081
+	"",											// lang_0082
+	"$DESCRIPTION$",								// lang_0083
+	"",											// lang_0084
+	"",											// lang_0085
+	"",											// lang_0086
+	"",											// lang_0087
+	"",											// lang_0088
+	"$STILLDOWNLOADING$",						// lang_0089
+	"",											// lang_0090
+	"",											// lang_0091
+	"",											// lang_0092
+	"$MAPCFG$",									// lang_0093
+	"",											// lang_0094
+	"",											// lang_0095
+	"$USER$",									// lang_0096
+	"$LATENCY$",									// lang_0097
+	"$SYNCLIMIT$",								// lang_0098
+	"$MIN$",										// lang_0099
+	"$MAX$",										// lang_0100
+	"$SYNCLIMIT$",								// lang_0101
+	"$GAMENAME$",								// lang_0102
+	"",											// lang_0103
+	"$ATTEMPT$",									// lang_0104
+	"$SERVER$",									// lang_0105
+	"$SERVER$",									// lang_0106
+	"$SERVER$",									// lang_0107
+	"$SERVER$",									// lang_0108
+	"$SERVER$",									// lang_0109
+	"$SERVER$ $GAMENAME$",						// lang_0110
+	"$SERVER$",									// lang_0111
+	"$USER$ $SECONDS$ $RATE$",					// lang_0112
+	"$GAMENAME$",								// lang_0113
+	"$OWNER$",									// lang_0114
+	"",											// lang_0115
+	"",											// lang_0116
+	"",											// lang_0117
+	"$VICTIM$",									// lang_0118
+	"$VICTIM$",									// lang_0119
+	"$OWNER$",									// lang_0120
+	"$VICTIM$",									// lang_0121
+	"$VICTIM$ $PING$ $FROM$ $ADMIN$ $OWNER$ $SPOOFED$ $SPOOFEDREALM$ $RESERVED$",	// lang_0122
+	"$VICTIM$",									// lang_0123
+	"",											// lang_0124
+	"$GAMENAME$",								// lang_0125
+	"",											// lang_0126
+	"",											// lang_0127
+	"$GAMENAME$",								// lang_0128
+	"$PLAYERS$ $PLAYERSLEFT$",					// lang_0129
+	"",											// lang_0130
+	"$PLAYERS$",									// lang_0131
+	"",											// lang_0132
+	"",											// lang_0133
+	"",											// lang_0134
+	"",											// lang_0135
+	"",											// lang_0136
+	"",											// lang_0137
+	"$FILE$",									// lang_0138
+	"$FILE$",									// lang_0139
+	"$GAMENAME$",								// lang_0140
+	"$GAMENAME$",								// lang_0141
+	"",											// lang_0142
+	"",											// lang_0143
+	"",											// lang_0144
+	"$VICTIM$",									// lang_0145
+	"$VICTIM$ $USER$",							// lang_0146
+	"$VICTIM$ $USER$",							// lang_0147
+	"$VICTIM$",									// lang_0148
+	"$PLAYER$",									// lang_0149
+	"",											// lang_0150
+	"",											// lang_0151
+	"$PLAYER$ $OTHERS$",							// lang_0152
+	"",											// lang_0153
+	"",											// lang_0154
+	"$VICTIM$",									// lang_0155
+	"$VICTIM$",									// lang_0156
+	"$VICTIM$ $USER$ $VOTESNEEDED$",				// lang_0157
+	"$VICTIM$",									// lang_0158
+	"$VICTIM$",									// lang_0159
+	"$VICTIM$",									// lang_0160
+	"$VICTIM$ $USER$ $VOTES$",					// lang_0161
+	"$VICTIM$",									// lang_0162
+	"$VICTIM$",									// lang_0163
+	"",											// lang_0164
+	"$COMMANDTRIGGER$",							// lang_0165
+	"$NOTPINGED$",								// lang_0166
+	"",											// lang_0167
+	"$SCORE$ $AVERAGE$",							// lang_0168
+	"$PLAYER$ $SCORE$",							// lang_0169
+	"$RATED$ $TOTAL$ $SPREAD$",					// lang_0170
+	"",											// lang_0171
+	"$MAPS$",									// lang_0172
+	"",											// lang_0173
+	"",											// lang_0174
+	"$MAPCONFIGS$",								// lang_0175
+	"",											// lang_0176
+	"$USER$",									// lang_0177
+	"",											// lang_0178
+	"",											// lang_0179
+	"",											// lang_0180
+	"",											// lang_0181
+	"$HCL$",										// lang_0182
+	"",											// lang_0183
+	"",											// lang_0184
+	"$HCL$",										// lang_0185
+	"",											// lang_0186
+	"",											// lang_0187
+	"$GAMENAME$",								// lang_0188
+	"$GAMENAME$",								// lang_0189
+	"",											// lang_0190
+	"$VICTIM$",									// lang_0191
+	"$VICTIM$ $IP$ $BANNEDNAME$",				// lang_0192
+	"$VICTIM$",									// lang_0193
+	"$VICTIM$ $IP$ $BANNEDNAME$",				// lang_0194
+	"$NUMBER$ $PLAYERS$",						// lang_0195
+	"$SERVERS$",									// lang_0196
+	"$TEAM$ $SCORE$",							// lang_0197
+	"",											// lang_0198
+	"$NAME$ $SCORE$ $AVERAGE$",					// lang_0199
+	"",											// lang_0200
+	"",											// lang_0201
+	"",											// lang_0202
+	"$SCORE$",									// lang_0203
+	"$NAME$ $SCORE$",							// lang_0204
+	"",											// lang_0205
+	"",											// lang_0206
+	"$GAMENAME$",								// lang_0207
+	"",											// lang_0208
+	"$FILE$",									// lang_0209
+	"$FILE$",									// lang_0210
+	"$TRIGGER$",									// lang_0211
+	"$OWNER$",									// lang_0212
+	"$OWNER$",									// lang_0213
+	"$SECONDS$",									// lang_0214
+	"",											// lang_0215
+	"$ERROR$",									// lang_0216
+	"",											// lang_0217
+	"$SECONDS$",									// lang_0218
+	"",											// lang_0219
+	"$NAME$",									// lang_0220
+};
+
+#define LANGUAGE_MESSAGES ( sizeof( gLanguageTokens ) / sizeof( *gLanguageTokens ) )
+
 CLanguage :: CLanguage( string nCFGFile )
 {
-	m_CFG = new CConfig( );
-	m_CFG->Read( nCFGFile );
+	CConfig CFG;
+	CFG.Read( nCFGFile );
+	m_Messages.resize( LANGUAGE_MESSAGES );
+
+	for( uint32_t i = 1; i < LANGUAGE_MESSAGES; i++ )
+	{
+		char Key[16];
+		sprintf( Key, "lang_%04u", i );
+		m_Messages[i].Compile( CFG.GetString( Key, Key ), UTIL_Tokenize( gLanguageTokens[i], ' ' ) );
+	}
 }
 
 CLanguage :: ~CLanguage( )
 {
-	delete m_CFG;
+
 }
 
-string CLanguage :: UnableToCreateGameTryAnotherName( string server, string gamename )
+void CLanguage :: SetTranslations( const map<string, map<uint32_t, string> > &translations )
 {
-	string Out = m_CFG->GetString( "lang_0001", "lang_0001" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
+	m_Translations.clear( );
+
+	for( map<string, map<uint32_t, string> > :: const_iterator i = translations.begin( ); i != translations.end( ); i++ )
+	{
+		vector<CMessageTemplate> &Messages = m_Translations[i->first];
+		Messages.resize( LANGUAGE_MESSAGES );
+
+		for( map<uint32_t, string> :: const_iterator j = i->second.begin( ); j != i->second.end( ); j++ )
+		{
+			if( j->first > 0 && j->first < LANGUAGE_MESSAGES )
+				Messages[j->first].Compile( j->second, UTIL_Tokenize( gLanguageTokens[j->first], ' ' ) );
+		}
+	}
+}
+
+string CLanguage :: Translate( const string &language, uint32_t id, const string **args )
+{
+	// fall back to the language file if there's no translation
+
+	map<string, vector<CMessageTemplate> > :: iterator i = m_Translations.find( language );
+
+	if( i != m_Translations.end( ) && id < i->second.size( ) && i->second[id].GetValid( ) )
+		return Render( i->second[id], args );
+
+	return Render( id, args );
+}
+
+string CLanguage :: Render( const CMessageTemplate &message, const string **args )
+{
+	string Out;
+	Out.reserve( message.GetRenderedSize( args ) );
+	message.Render( Out, args );
 	return Out;
 }
 
+string CLanguage :: Render( uint32_t id, const string **args )
+{
+	if( id >= m_Messages.size( ) )
+		return string( );
+
+	return Render( m_Messages[id], args );
+}
+
+string CLanguage :: UnableToCreateGameTryAnotherName( string server, string gamename )
+{
+	const string *Args[] = { &server, &gamename };
+	return Render( 1, Args );
+}
+
 string CLanguage :: UserIsAlreadyAnAdmin( string server, string user )
 {
-	string Out = m_CFG->GetString( "lang_0002", "lang_0002" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &server, &user };
+	return Render( 2, Args );
 }
 
 string CLanguage :: AddedUserToAdminDatabase( string server, string user )
 {
-	string Out = m_CFG->GetString( "lang_0003", "lang_0003" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &server, &user };
+	return Render( 3, Args );
 }
 
 string CLanguage :: ErrorAddingUserToAdminDatabase( string server, string user )
 {
-	string Out = m_CFG->GetString( "lang_0004", "lang_0004" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &server, &user };
+	return Render( 4, Args );
 }
 
 string CLanguage :: YouDontHaveAccessToThatCommand( )
 {
-	return m_CFG->GetString( "lang_0005", "lang_0005" );
+	return Render( 5, NULL );
 }
 
 string CLanguage :: UserIsAlreadyBanned( string server, string victim )
 {
-	string Out = m_CFG->GetString( "lang_0006", "lang_0006" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &server, &victim };
+	return Render( 6, Args );
 }
 
 string CLanguage :: BannedUser( string server, string victim )
 {
-	string Out = m_CFG->GetString( "lang_0007", "lang_0007" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &server, &victim };
+	return Render( 7, Args );
 }
 
 string CLanguage :: ErrorBanningUser( string server, string victim )
 {
-	string Out = m_CFG->GetString( "lang_0008", "lang_0008" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &server, &victim };
+	return Render( 8, Args );
 }
 
 string CLanguage :: UserIsAnAdmin( string server, string user )
 {
-	string Out = m_CFG->GetString( "lang_0009", "lang_0009" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &server, &user };
+	return Render( 9, Args );
 }
 
 string CLanguage :: UserIsNotAnAdmin( string server, string user )
 {
-	string Out = m_CFG->GetString( "lang_0010", "lang_0010" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &server, &user };
+	return Render( 10, Args );
 }
 
 string CLanguage :: UserWasBannedOnByBecause( string server, string victim, string date, string admin, string reason )
 {
-	string Out = m_CFG->GetString( "lang_0011", "lang_0011" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$DATE$", date );
-	UTIL_Replace( Out, "$ADMIN$", admin );
-	UTIL_Replace( Out, "$REASON$", reason );
-	return Out;
+	const string *Args[] = { &server, &victim, &date, &admin, &reason };
+	return Render( 11, Args );
 }
 
 string CLanguage :: UserIsNotBanned( string server, string victim )
 {
-	string Out = m_CFG->GetString( "lang_0012", "lang_0012" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &server, &victim };
+	return Render( 12, Args );
 }
 
 string CLanguage :: ThereAreNoAdmins( string server )
 {
-	string Out = m_CFG->GetString( "lang_0013", "lang_0013" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 13, Args );
 }
 
 string CLanguage :: ThereIsAdmin( string server )
 {
-	string Out = m_CFG->GetString( "lang_0014", "lang_0014" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 14, Args );
 }
 
 string CLanguage :: ThereAreAdmins( string server, string count )
 {
-	string Out = m_CFG->GetString( "lang_0015", "lang_0015" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$COUNT$", count );
-	return Out;
+	const string *Args[] = { &server, &count };
+	return Render( 15, Args );
 }
 
 string CLanguage :: ThereAreNoBannedUsers( string server )
 {
-	string Out = m_CFG->GetString( "lang_0016", "lang_0016" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 16, Args );
 }
 
 string CLanguage :: ThereIsBannedUser( string server )
 {
-	string Out = m_CFG->GetString( "lang_0017", "lang_0017" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 17, Args );
 }
 
 string CLanguage :: ThereAreBannedUsers( string server, string count )
 {
-	string Out = m_CFG->GetString( "lang_0018", "lang_0018" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$COUNT$", count );
-	return Out;
+	const string *Args[] = { &server, &count };
+	return Render( 18, Args );
 }
 
 string CLanguage :: YouCantDeleteTheRootAdmin( )
 {
-	return m_CFG->GetString( "lang_0019", "lang_0019" );
+	return Render( 19, NULL );
 }
 
 string CLanguage :: DeletedUserFromAdminDatabase( string server, string user )
 {
-	string Out = m_CFG->GetString( "lang_0020", "lang_0020" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &server, &user };
+	return Render( 20, Args );
 }
 
 string CLanguage :: ErrorDeletingUserFromAdminDatabase( string server, string user )
 {
-	string Out = m_CFG->GetString( "lang_0021", "lang_0021" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &server, &user };
+	return Render( 21, Args );
 }
 
 string CLanguage :: UnbannedUser( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0022", "lang_0022" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 22, Args );
 }
 
 string CLanguage :: ErrorUnbanningUser( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0023", "lang_0023" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 23, Args );
 }
 
 string CLanguage :: GameNumberIs( string number, string description )
 {
-	string Out = m_CFG->GetString( "lang_0024", "lang_0024" );
-	UTIL_Replace( Out, "$NUMBER$", number );
-	UTIL_Replace( Out, "$DESCRIPTION$", description );
-	return Out;
+	const string *Args[] = { &number, &description };
+	return Render( 24, Args );
 }
 
 string CLanguage :: GameNumberDoesntExist( string number )
 {
-	string Out = m_CFG->GetString( "lang_0025", "lang_0025" );
-	UTIL_Replace( Out, "$NUMBER$", number );
-	return Out;
+	const string *Args[] = { &number };
+	return Render( 25, Args );
 }
 
 string CLanguage :: GameIsInTheLobby( string description, string current, string max )
 {
-	string Out = m_CFG->GetString( "lang_0026", "lang_0026" );
-	UTIL_Replace( Out, "$DESCRIPTION$", description );
-	UTIL_Replace( Out, "$CURRENT$", current );
-	UTIL_Replace( Out, "$MAX$", max );
-	return Out;
+	const string *Args[] = { &description, &current, &max };
+	return Render( 26, Args );
 }
 
 string CLanguage :: ThereIsNoGameInTheLobby( string current, string max )
 {
-	string Out = m_CFG->GetString( "lang_0027", "lang_0027" );
-	UTIL_Replace( Out, "$CURRENT$", current );
-	UTIL_Replace( Out, "$MAX$", max );
-	return Out;
+	const string *Args[] = { &current, &max };
+	return Render( 27, Args );
 }
 
 string CLanguage :: UnableToLoadConfigFilesOutside( )
 {
-	return m_CFG->GetString( "lang_0028", "lang_0028" );
+	return Render( 28, NULL );
 }
 
 string CLanguage :: LoadingConfigFile( string file )
 {
-	string Out = m_CFG->GetString( "lang_0029", "lang_0029" );
-	UTIL_Replace( Out, "$FILE$", file );
-	return Out;
+	const string *Args[] = { &file };
+	return Render( 29, Args );
 }
 
 string CLanguage :: UnableToLoadConfigFileDoesntExist( string file )
 {
-	string Out = m_CFG->GetString( "lang_0030", "lang_0030" );
-	UTIL_Replace( Out, "$FILE$", file );
-	return Out;
+	const string *Args[] = { &file };
+	return Render( 30, Args );
 }
 
 string CLanguage :: CreatingPrivateGame( string gamename, string user )
 {
-	string Out = m_CFG->GetString( "lang_0031", "lang_0031" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &gamename, &user };
+	return Render( 31, Args );
 }
 
 string CLanguage :: CreatingPublicGame( string gamename, string user )
 {
-	string Out = m_CFG->GetString( "lang_0032", "lang_0032" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &gamename, &user };
+	return Render( 32, Args );
 }
 
 string CLanguage :: UnableToUnhostGameCountdownStarted( string description )
 {
-	string Out = m_CFG->GetString( "lang_0033", "lang_0033" );
-	UTIL_Replace( Out, "$DESCRIPTION$", description );
-	return Out;
+	const string *Args[] = { &description };
+	return Render( 33, Args );
 }
 
 string CLanguage :: UnhostingGame( string description )
 {
-	string Out = m_CFG->GetString( "lang_0034", "lang_0034" );
-	UTIL_Replace( Out, "$DESCRIPTION$", description );
-	return Out;
+	const string *Args[] = { &description };
+	return Render( 34, Args );
 }
 
 string CLanguage :: UnableToUnhostGameNoGameInLobby( )
 {
-	return m_CFG->GetString( "lang_0035", "lang_0035" );
+	return Render( 35, NULL );
 }
 
 string CLanguage :: VersionAdmin( string version )
 {
-	string Out = m_CFG->GetString( "lang_0036", "lang_0036" );
-	UTIL_Replace( Out, "$VERSION$", version );
-	return Out;
+	const string *Args[] = { &version };
+	return Render( 36, Args );
 }
 
 string CLanguage :: VersionNotAdmin( string version )
 {
-	string Out = m_CFG->GetString( "lang_0037", "lang_0037" );
-	UTIL_Replace( Out, "$VERSION$", version );
-	return Out;
+	const string *Args[] = { &version };
+	return Render( 37, Args );
 }
 
 string CLanguage :: UnableToCreateGameAnotherGameInLobby( string gamename, string description )
 {
-	string Out = m_CFG->GetString( "lang_0038", "lang_0038" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	UTIL_Replace( Out, "$DESCRIPTION$", description );
-	return Out;
+	const string *Args[] = { &gamename, &description };
+	return Render( 38, Args );
 }
 
 string CLanguage :: UnableToCreateGameMaxGamesReached( string gamename, string max )
 {
-	string Out = m_CFG->GetString( "lang_0039", "lang_0039" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	UTIL_Replace( Out, "$MAX$", max );
-	return Out;
+	const string *Args[] = { &gamename, &max };
+	return Render( 39, Args );
 }
 
 string CLanguage :: GameIsOver( string description )
 {
-	string Out = m_CFG->GetString( "lang_0040", "lang_0040" );
-	UTIL_Replace( Out, "$DESCRIPTION$", description );
-	return Out;
+	const string *Args[] = { &description };
+	return Render( 40, Args );
 }
 
 string CLanguage :: SpoofCheckByReplying( )
 {
-	return m_CFG->GetString( "lang_0041", "lang_0041" );
+	return Render( 41, NULL );
 }
 
 string CLanguage :: GameRefreshed( )
 {
-	return m_CFG->GetString( "lang_0042", "lang_0042" );
+	return Render( 42, NULL );
 }
 
 string CLanguage :: SpoofPossibleIsAway( string user )
 {
-	string Out = m_CFG->GetString( "lang_0043", "lang_0043" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 43, Args );
 }
 
 string CLanguage :: SpoofPossibleIsUnavailable( string user )
 {
-	string Out = m_CFG->GetString( "lang_0044", "lang_0044" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 44, Args );
 }
 
 string CLanguage :: SpoofPossibleIsRefusingMessages( string user )
 {
-	string Out = m_CFG->GetString( "lang_0045", "lang_0045" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 45, Args );
 }
 
 string CLanguage :: SpoofDetectedIsNotInGame( string user )
 {
-	string Out = m_CFG->GetString( "lang_0046", "lang_0046" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 46, Args );
 }
 
 string CLanguage :: SpoofDetectedIsInPrivateChannel( string user )
 {
-	string Out = m_CFG->GetString( "lang_0047", "lang_0047" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 47, Args );
 }
 
 string CLanguage :: SpoofDetectedIsInAnotherGame( string user )
 {
-	string Out = m_CFG->GetString( "lang_0048", "lang_0048" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 48, Args );
 }
 
 string CLanguage :: CountDownAborted( )
 {
-	return m_CFG->GetString( "lang_0049", "lang_0049" );
+	return Render( 49, NULL );
 }
 
 string CLanguage :: TryingToJoinTheGameButBanned( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0050", "lang_0050" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 50, Args );
 }
 
 string CLanguage :: UnableToBanNoMatchesFound( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0051", "lang_0051" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 51, Args );
 }
 
 string CLanguage :: PlayerWasBannedByPlayer( string server, string victim, string user )
 {
-	string Out = m_CFG->GetString( "lang_0052", "lang_0052" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &server, &victim, &user };
+	return Render( 52, Args );
 }
 
 string CLanguage :: UnableToBanFoundMoreThanOneMatch( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0053", "lang_0053" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 53, Args );
 }
 
 string CLanguage :: AddedPlayerToTheHoldList( string user )
 {
-	string Out = m_CFG->GetString( "lang_0054", "lang_0054" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 54, Args );
 }
 
 string CLanguage :: UnableToKickNoMatchesFound( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0055", "lang_0055" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 55, Args );
 }
 
 string CLanguage :: UnableToKickFoundMoreThanOneMatch( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0056", "lang_0056" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 56, Args );
 }
 
 string CLanguage :: SettingLatencyToMinimum( string min )
 {
-	string Out = m_CFG->GetString( "lang_0057", "lang_0057" );
-	UTIL_Replace( Out, "$MIN$", min );
-	return Out;
+	const string *Args[] = { &min };
+	return Render( 57, Args );
 }
 
 string CLanguage :: SettingLatencyToMaximum( string max )
 {
-	string Out = m_CFG->GetString( "lang_0058", "lang_0058" );
-	UTIL_Replace( Out, "$MAX$", max );
-	return Out;
+	const string *Args[] = { &max };
+	return Render( 58, Args );
 }
 
 string CLanguage :: SettingLatencyTo( string latency )
 {
-	string Out = m_CFG->GetString( "lang_0059", "lang_0059" );
-	UTIL_Replace( Out, "$LATENCY$", latency );
-	return Out;
+	const string *Args[] = { &latency };
+	return Render( 59, Args );
 }
 
 string CLanguage :: KickingPlayersWithPingsGreaterThan( string total, string ping )
 {
-	string Out = m_CFG->GetString( "lang_0060", "lang_0060" );
-	UTIL_Replace( Out, "$TOTAL$", total );
-	UTIL_Replace( Out, "$PING$", ping );
-	return Out;
+	const string *Args[] = { &total, &ping };
+	return Render( 60, Args );
 }
 
 string CLanguage :: HasPlayedGamesWithThisBot( string user, string firstgame, string lastgame, string totalgames, string avgloadingtime, string avgstay )
 {
-	string Out = m_CFG->GetString( "lang_0061", "lang_0061" );
-	UTIL_Replace( Out, "$USER$", user );
-	UTIL_Replace( Out, "$FIRSTGAME$", firstgame );
-	UTIL_Replace( Out, "$LASTGAME$", lastgame );
-	UTIL_Replace( Out, "$TOTALGAMES$", totalgames );
-	UTIL_Replace( Out, "$AVGLOADINGTIME$", avgloadingtime );
-	UTIL_Replace( Out, "$AVGSTAY$", avgstay );
-	return Out;
+	const string *Args[] = { &user, &firstgame, &lastgame, &totalgames, &avgloadingtime, &avgstay };
+	return Render( 61, Args );
 }
 
 string CLanguage :: HasntPlayedGamesWithThisBot( string user )
 {
-	string Out = m_CFG->GetString( "lang_0062", "lang_0062" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 62, Args );
 }
 
 string CLanguage :: AutokickingPlayerForExcessivePing( string victim, string ping )
 {
-	string Out = m_CFG->GetString( "lang_0063", "lang_0063" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$PING$", ping );
-	return Out;
+	const string *Args[] = { &victim, &ping };
+	return Render( 63, Args );
 }
 
 string CLanguage :: SpoofCheckAcceptedFor( string server, string user )
 {
-	string Out = m_CFG->GetString( "lang_0064", "lang_0064" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &server, &user };
+	return Render( 64, Args );
 }
 
 string CLanguage :: PlayersNotYetSpoofChecked( string notspoofchecked )
 {
-	string Out = m_CFG->GetString( "lang_0065", "lang_0065" );
-	UTIL_Replace( Out, "$NOTSPOOFCHECKED$", notspoofchecked );
-	return Out;
+	const string *Args[] = { &notspoofchecked };
+	return Render( 65, Args );
 }
 
 string CLanguage :: ManuallySpoofCheckByWhispering( string hostname )
 {
-	string Out = m_CFG->GetString( "lang_0066", "lang_0066" );
-	UTIL_Replace( Out, "$HOSTNAME$", hostname );
-	return Out;
+	const string *Args[] = { &hostname };
+	return Render( 66, Args );
 }
 
 string CLanguage :: SpoofCheckByWhispering( string hostname )
 {
-	string Out = m_CFG->GetString( "lang_0067", "lang_0067" );
-	UTIL_Replace( Out, "$HOSTNAME$", hostname );
-	return Out;
+	const string *Args[] = { &hostname };
+	return Render( 67, Args );
 }
 
 string CLanguage :: EveryoneHasBeenSpoofChecked( )
 {
-	return m_CFG->GetString( "lang_0068", "lang_0068" );
+	return Render( 68, NULL );
 }
 
 string CLanguage :: PlayersNotYetPinged( string notpinged )
 {
-	string Out = m_CFG->GetString( "lang_0069", "lang_0069" );
-	UTIL_Replace( Out, "$NOTPINGED$", notpinged );
-	return Out;
+	const string *Args[] = { &notpinged };
+	return Render( 69, Args );
 }
 
 string CLanguage :: EveryoneHasBeenPinged( )
 {
-	return m_CFG->GetString( "lang_0070", "lang_0070" );
+	return Render( 70, NULL );
 }
 
 string CLanguage :: ShortestLoadByPlayer( string user, string loadingtime )
 {
-	string Out = m_CFG->GetString( "lang_0071", "lang_0071" );
-	UTIL_Replace( Out, "$USER$", user );
-	UTIL_Replace( Out, "$LOADINGTIME$", loadingtime );
-	return Out;
+	const string *Args[] = { &user, &loadingtime };
+	return Render( 71, Args );
 }
 
 string CLanguage :: LongestLoadByPlayer( string user, string loadingtime )
 {
-	string Out = m_CFG->GetString( "lang_0072", "lang_0072" );
-	UTIL_Replace( Out, "$USER$", user );
-	UTIL_Replace( Out, "$LOADINGTIME$", loadingtime );
-	return Out;
+	const string *Args[] = { &user, &loadingtime };
+	return Render( 72, Args );
 }
 
 string CLanguage :: YourLoadingTimeWas( string loadingtime )
 {
-	string Out = m_CFG->GetString( "lang_0073", "lang_0073" );
-	UTIL_Replace( Out, "$LOADINGTIME$", loadingtime );
-	return Out;
+	const string *Args[] = { &loadingtime };
+	return Render( 73, Args );
 }
 
 string CLanguage :: HasPlayedDotAGamesWithThisBot( string user, string totalgames, string totalwins, string totallosses, string totalkills, string totaldeaths, string totalcreepkills, string totalcreepdenies, string totalassists, string totalneutralkills, string totaltowerkills, string totalraxkills, string totalcourierkills, string avgkills, string avgdeaths, string avgcreepkills, string avgcreepdenies, string avgassists, string avgneutralkills, string avgtowerkills, string avgraxkills, string avgcourierkills )
 {
-	string Out = m_CFG->GetString( "lang_0074", "lang_0074" );
-	UTIL_Replace( Out, "$USER$", user );
-	UTIL_Replace( Out, "$TOTALGAMES$", totalgames );
-	UTIL_Replace( Out, "$TOTALWINS$", totalwins );
-	UTIL_Replace( Out, "$TOTALLOSSES$", totallosses );
-	UTIL_Replace( Out, "$TOTALKILLS$", totalkills );
-	UTIL_Replace( Out, "$TOTALDEATHS$", totaldeaths );
-	UTIL_Replace( Out, "$TOTALCREEPKILLS$", totalcreepkills );
-	UTIL_Replace( Out, "$TOTALCREEPDENIES$", totalcreepdenies );
-	UTIL_Replace( Out, "$TOTALASSISTS$", totalassists );
-	UTIL_Replace( Out, "$TOTALNEUTRALKILLS$", totalneutralkills );
-	UTIL_Replace( Out, "$TOTALTOWERKILLS$", totaltowerkills );
-	UTIL_Replace( Out, "$TOTALRAXKILLS$", totalraxkills );
-	UTIL_Replace( Out, "$TOTALCOURIERKILLS$", totalcourierkills );
-	UTIL_Replace( Out, "$AVGKILLS$", avgkills );
-	UTIL_Replace( Out, "$AVGDEATHS$", avgdeaths );
-	UTIL_Replace( Out, "$AVGCREEPKILLS$", avgcreepkills );
-	UTIL_Replace( Out, "$AVGCREEPDENIES$", avgcreepdenies );
-	UTIL_Replace( Out, "$AVGASSISTS$", avgassists );
-	UTIL_Replace( Out, "$AVGNEUTRALKILLS$", avgneutralkills );
-	UTIL_Replace( Out, "$AVGTOWERKILLS$", avgtowerkills );
-	UTIL_Replace( Out, "$AVGRAXKILLS$", avgraxkills );
-	UTIL_Replace( Out, "$AVGCOURIERKILLS$", avgcourierkills );
-	return Out;
+	const string *Args[] = { &user, &totalgames, &totalwins, &totallosses, &totalkills, &totaldeaths, &totalcreepkills, &totalcreepdenies, &totalassists, &totalneutralkills, &totaltowerkills, &totalraxkills, &totalcourierkills, &avgkills, &avgdeaths, &avgcreepkills, &avgcreepdenies, &avgassists, &avgneutralkills, &avgtowerkills, &avgraxkills, &avgcourierkills };
+	return Render( 74, Args );
 }
 
 string CLanguage :: HasntPlayedDotAGamesWithThisBot( string user )
 {
-	string Out = m_CFG->GetString( "lang_0075", "lang_0075" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 75, Args );
 }
 
 string CLanguage :: WasKickedForReservedPlayer( string reserved )
 {
-	string Out = m_CFG->GetString( "lang_0076", "lang_0076" );
-	UTIL_Replace( Out, "$RESERVED$", reserved );
-	return Out;
+	const string *Args[] = { &reserved };
+	return Render( 76, Args );
 }
 
 string CLanguage :: WasKickedForOwnerPlayer( string owner )
 {
-	string Out = m_CFG->GetString( "lang_0077", "lang_0077" );
-	UTIL_Replace( Out, "$OWNER$", owner );
-	return Out;
+	const string *Args[] = { &owner };
+	return Render( 77, Args );
 }
 
 string CLanguage :: WasKickedByPlayer( string user )
 {
-	string Out = m_CFG->GetString( "lang_0078", "lang_0078" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 78, Args );
 }
 
 string CLanguage :: HasLostConnectionPlayerError( string error )
 {
-	string Out = m_CFG->GetString( "lang_0079", "lang_0079" );
-	UTIL_Replace( Out, "$ERROR$", error );
-	return Out;
+	const string *Args[] = { &error };
+	return Render( 79, Args );
 }
 
 string CLanguage :: HasLostConnectionSocketError( string error )
 {
-	string Out = m_CFG->GetString( "lang_0080", "lang_0080" );
-	UTIL_Replace( Out, "$ERROR$", error );
-	return Out;
+	const string *Args[] = { &error };
+	return Render( 80, Args );
 }
 
 string CLanguage :: HasLostConnectionClosedByRemoteHost( )
 {
-	return m_CFG->GetString( "lang_0081", "lang_0081" );
+	return Render( 81, NULL );
 }
 
 string CLanguage :: HasLeftVoluntarily( )
 {
-	return m_CFG->GetString( "lang_0082", "lang_0082" );
+	return Render( 82, NULL );
 }
 
 string CLanguage :: EndingGame( string description )
 {
-	string Out = m_CFG->GetString( "lang_0083", "lang_0083" );
-	UTIL_Replace( Out, "$DESCRIPTION$", description );
-	return Out;
+	const string *Args[] = { &description };
+	return Render( 83, Args );
 }
 
 string CLanguage :: HasLostConnectionTimedOut( )
 {
-	return m_CFG->GetString( "lang_0084", "lang_0084" );
+	return Render( 84, NULL );
 }
 
 string CLanguage :: GlobalChatMuted( )
 {
-	return m_CFG->GetString( "lang_0085", "lang_0085" );
+	return Render( 85, NULL );
 }
 
 string CLanguage :: GlobalChatUnmuted( )
 {
-	return m_CFG->GetString( "lang_0086", "lang_0086" );
+	return Render( 86, NULL );
 }
 
 string CLanguage :: ShufflingPlayers( )
 {
-	return m_CFG->GetString( "lang_0087", "lang_0087" );
+	return Render( 87, NULL );
 }
 
 string CLanguage :: UnableToLoadConfigFileGameInLobby( )
 {
-	return m_CFG->GetString( "lang_0088", "lang_0088" );
+	return Render( 88, NULL );
 }
 
 string CLanguage :: PlayersStillDownloading( string stilldownloading )
 {
-	string Out = m_CFG->GetString( "lang_0089", "lang_0089" );
-	UTIL_Replace( Out, "$STILLDOWNLOADING$", stilldownloading );
-	return Out;
+	const string *Args[] = { &stilldownloading };
+	return Render( 89, Args );
 }
 
 string CLanguage :: RefreshMessagesEnabled( )
 {
-	return m_CFG->GetString( "lang_0090", "lang_0090" );
+	return Render( 90, NULL );
 }
 
 string CLanguage :: RefreshMessagesDisabled( )
 {
-	return m_CFG->GetString( "lang_0091", "lang_0091" );
+	return Render( 91, NULL );
 }
 
 string CLanguage :: AtLeastOneGameActiveUseForceToShutdown( )
 {
-	return m_CFG->GetString( "lang_0092", "lang_0092" );
+	return Render( 92, NULL );
 }
 
 string CLanguage :: CurrentlyLoadedMapCFGIs( string mapcfg )
 {
-	string Out = m_CFG->GetString( "lang_0093", "lang_0093" );
-	UTIL_Replace( Out, "$MAPCFG$", mapcfg );
-	return Out;
+	const string *Args[] = { &mapcfg };
+	return Render( 93, Args );
 }
 
 string CLanguage :: LaggedOutDroppedByAdmin( )
 {
-	return m_CFG->GetString( "lang_0094", "lang_0094" );
+	return Render( 94, NULL );
 }
 
 string CLanguage :: LaggedOutDroppedByVote( )
 {
-	return m_CFG->GetString( "lang_0095", "lang_0095" );
+	return Render( 95, NULL );
 }
 
 string CLanguage :: PlayerVotedToDropLaggers( string user )
 {
-	string Out = m_CFG->GetString( "lang_0096", "lang_0096" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 96, Args );
 }
 
 string CLanguage :: LatencyIs( string latency )
 {
-	string Out = m_CFG->GetString( "lang_0097", "lang_0097" );
-	UTIL_Replace( Out, "$LATENCY$", latency );
-	return Out;
+	const string *Args[] = { &latency };
+	return Render( 97, Args );
 }
 
 string CLanguage :: SyncLimitIs( string synclimit )
 {
-	string Out = m_CFG->GetString( "lang_0098", "lang_0098" );
-	UTIL_Replace( Out, "$SYNCLIMIT$", synclimit );
-	return Out;
+	const string *Args[] = { &synclimit };
+	return Render( 98, Args );
 }
 
 string CLanguage :: SettingSyncLimitToMinimum( string min )
 {
-	string Out = m_CFG->GetString( "lang_0099", "lang_0099" );
-	UTIL_Replace( Out, "$MIN$", min );
-	return Out;
+	const string *Args[] = { &min };
+	return Render( 99, Args );
 }
 
 string CLanguage :: SettingSyncLimitToMaximum( string max )
 {
-	string Out = m_CFG->GetString( "lang_0100", "lang_0100" );
-	UTIL_Replace( Out, "$MAX$", max );
-	return Out;
+	const string *Args[] = { &max };
+	return Render( 100, Args );
 }
 
 string CLanguage :: SettingSyncLimitTo( string synclimit )
 {
-	string Out = m_CFG->GetString( "lang_0101", "lang_0101" );
-	UTIL_Replace( Out, "$SYNCLIMIT$", synclimit );
-	return Out;
+	const string *Args[] = { &synclimit };
+	return Render( 101, Args );
 }
 
 string CLanguage :: UnableToCreateGameNotLoggedIn( string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0102", "lang_0102" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &gamename };
+	return Render( 102, Args );
 }
 
 string CLanguage :: AdminLoggedIn( )
 {
-	return m_CFG->GetString( "lang_0103", "lang_0103" );
+	return Render( 103, NULL );
 }
 
 string CLanguage :: AdminInvalidPassword( string attempt )
 {
-	string Out = m_CFG->GetString( "lang_0104", "lang_0104" );
-	UTIL_Replace( Out, "$ATTEMPT$", attempt );
-	return Out;
+	const string *Args[] = { &attempt };
+	return Render( 104, Args );
 }
 
 string CLanguage :: ConnectingToBNET( string server )
 {
-	string Out = m_CFG->GetString( "lang_0105", "lang_0105" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 105, Args );
 }
 
 string CLanguage :: ConnectedToBNET( string server )
 {
-	string Out = m_CFG->GetString( "lang_0106", "lang_0106" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 106, Args );
 }
 
 string CLanguage :: DisconnectedFromBNET( string server )
 {
-	string Out = m_CFG->GetString( "lang_0107", "lang_0107" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 107, Args );
 }
 
 string CLanguage :: LoggedInToBNET( string server )
 {
-	string Out = m_CFG->GetString( "lang_0108", "lang_0108" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 108, Args );
 }
 
 string CLanguage :: BNETGameHostingSucceeded( string server )
 {
-	string Out = m_CFG->GetString( "lang_0109", "lang_0109" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 109, Args );
 }
 
 string CLanguage :: BNETGameHostingFailed( string server, string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0110", "lang_0110" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &server, &gamename };
+	return Render( 110, Args );
 }
 
 string CLanguage :: ConnectingToBNETTimedOut( string server )
 {
-	string Out = m_CFG->GetString( "lang_0111", "lang_0111" );
-	UTIL_Replace( Out, "$SERVER$", server );
-	return Out;
+	const string *Args[] = { &server };
+	return Render( 111, Args );
 }
 
 string CLanguage :: PlayerDownloadedTheMap( string user, string seconds, string rate )
 {
-	string Out = m_CFG->GetString( "lang_0112", "lang_0112" );
-	UTIL_Replace( Out, "$USER$", user );
-	UTIL_Replace( Out, "$SECONDS$", seconds );
-	UTIL_Replace( Out, "$RATE$", rate );
-	return Out;
+	const string *Args[] = { &user, &seconds, &rate };
+	return Render( 112, Args );
 }
 
 string CLanguage :: UnableToCreateGameNameTooLong( string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0113", "lang_0113" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &gamename };
+	return Render( 113, Args );
 }
 
 string CLanguage :: SettingGameOwnerTo( string owner )
 {
-	string Out = m_CFG->GetString( "lang_0114", "lang_0114" );
-	UTIL_Replace( Out, "$OWNER$", owner );
-	return Out;
+	const string *Args[] = { &owner };
+	return Render( 114, Args );
 }
 
 string CLanguage :: TheGameIsLocked( )
 {
-	return m_CFG->GetString( "lang_0115", "lang_0115" );
+	return Render( 115, NULL );
 }
 
 string CLanguage :: GameLocked( )
 {
-	return m_CFG->GetString( "lang_0116", "lang_0116" );
+	return Render( 116, NULL );
 }
 
 string CLanguage :: GameUnlocked( )
 {
-	return m_CFG->GetString( "lang_0117", "lang_0117" );
+	return Render( 117, NULL );
 }
 
 string CLanguage :: UnableToStartDownloadNoMatchesFound( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0118", "lang_0118" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 118, Args );
 }
 
 string CLanguage :: UnableToStartDownloadFoundMoreThanOneMatch( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0119", "lang_0119" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 119, Args );
 }
 
 string CLanguage :: UnableToSetGameOwner( string owner )
 {
-	string Out = m_CFG->GetString( "lang_0120", "lang_0120" );
-	UTIL_Replace( Out, "$OWNER$", owner );
-	return Out;
+	const string *Args[] = { &owner };
+	return Render( 120, Args );
 }
 
 string CLanguage :: UnableToCheckPlayerNoMatchesFound( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0121", "lang_0121" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 121, Args );
 }
 
 string CLanguage :: CheckedPlayer( string victim, string ping, string from, string admin, string owner, string spoofed, string spoofedrealm, string reserved )
 {
-	string Out = m_CFG->GetString( "lang_0122", "lang_0122" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$PING$", ping );
-	UTIL_Replace( Out, "$FROM$", from );
-	UTIL_Replace( Out, "$ADMIN$", admin );
-	UTIL_Replace( Out, "$OWNER$", owner );
-	UTIL_Replace( Out, "$SPOOFED$", spoofed );
-	UTIL_Replace( Out, "$SPOOFEDREALM$", spoofedrealm );
-	UTIL_Replace( Out, "$RESERVED$", reserved );
-	return Out;
+	const string *Args[] = { &victim, &ping, &from, &admin, &owner, &spoofed, &spoofedrealm, &reserved };
+	return Render( 122, Args );
 }
 
 string CLanguage :: UnableToCheckPlayerFoundMoreThanOneMatch( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0123", "lang_0123" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 123, Args );
 }
 
 string CLanguage :: TheGameIsLockedBNET( )
 {
-	return m_CFG->GetString( "lang_0124", "lang_0124" );
+	return Render( 124, NULL );
 }
 
 string CLanguage :: UnableToCreateGameDisabled( string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0125", "lang_0125" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &gamename };
+	return Render( 125, Args );
 }
 
 string CLanguage :: BotDisabled( )
 {
-	return m_CFG->GetString( "lang_0126", "lang_0126" );
+	return Render( 126, NULL );
 }
 
 string CLanguage :: BotEnabled( )
 {
-	return m_CFG->GetString( "lang_0127", "lang_0127" );
+	return Render( 127, NULL );
 }
 
 string CLanguage :: UnableToCreateGameInvalidMap( string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0128", "lang_0128" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &gamename };
+	return Render( 128, Args );
 }
 
 string CLanguage :: WaitingForPlayersBeforeAutoStart( string players, string playersleft )
 {
-	string Out = m_CFG->GetString( "lang_0129", "lang_0129" );
-	UTIL_Replace( Out, "$PLAYERS$", players );
-	UTIL_Replace( Out, "$PLAYERSLEFT$", playersleft );
-	return Out;
+	const string *Args[] = { &players, &playersleft };
+	return Render( 129, Args );
 }
 
 string CLanguage :: AutoStartDisabled( )
 {
-	return m_CFG->GetString( "lang_0130", "lang_0130" );
+	return Render( 130, NULL );
 }
 
 string CLanguage :: AutoStartEnabled( string players )
 {
-	string Out = m_CFG->GetString( "lang_0131", "lang_0131" );
-	UTIL_Replace( Out, "$PLAYERS$", players );
-	return Out;
+	const string *Args[] = { &players };
+	return Render( 131, Args );
 }
 
 string CLanguage :: AnnounceMessageEnabled( )
 {
-	return m_CFG->GetString( "lang_0132", "lang_0132" );
+	return Render( 132, NULL );
 }
 
 string CLanguage :: AnnounceMessageDisabled( )
 {
-	return m_CFG->GetString( "lang_0133", "lang_0133" );
+	return Render( 133, NULL );
 }
 
 string CLanguage :: AutoHostEnabled( )
 {
-	return m_CFG->GetString( "lang_0134", "lang_0134" );
+	return Render( 134, NULL );
 }
 
 string CLanguage :: AutoHostDisabled( )
 {
-	return m_CFG->GetString( "lang_0135", "lang_0135" );
+	return Render( 135, NULL );
 }
 
 string CLanguage :: UnableToLoadSaveGamesOutside( )
 {
-	return m_CFG->GetString( "lang_0136", "lang_0136" );
+	return Render( 136, NULL );
 }
 
 string CLanguage :: UnableToLoadSaveGameGameInLobby( )
 {
-	return m_CFG->GetString( "lang_0137", "lang_0137" );
+	return Render( 137, NULL );
 }
 
 string CLanguage :: LoadingSaveGame( string file )
 {
-	string Out = m_CFG->GetString( "lang_0138", "lang_0138" );
-	UTIL_Replace( Out, "$FILE$", file );
-	return Out;
+	const string *Args[] = { &file };
+	return Render( 138, Args );
 }
 
 string CLanguage :: UnableToLoadSaveGameDoesntExist( string file )
 {
-	string Out = m_CFG->GetString( "lang_0139", "lang_0139" );
-	UTIL_Replace( Out, "$FILE$", file );
-	return Out;
+	const string *Args[] = { &file };
+	return Render( 139, Args );
 }
 
 string CLanguage :: UnableToCreateGameInvalidSaveGame( string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0140", "lang_0140" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &gamename };
+	return Render( 140, Args );
 }
 
 string CLanguage :: UnableToCreateGameSaveGameMapMismatch( string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0141", "lang_0141" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &gamename };
+	return Render( 141, Args );
 }
 
 string CLanguage :: AutoSaveEnabled( )
 {
-	return m_CFG->GetString( "lang_0142", "lang_0142" );
+	return Render( 142, NULL );
 }
 
 string CLanguage :: AutoSaveDisabled( )
 {
-	return m_CFG->GetString( "lang_0143", "lang_0143" );
+	return Render( 143, NULL );
 }
 
 string CLanguage :: DesyncDetected( )
 {
-	return m_CFG->GetString( "lang_0144", "lang_0144" );
+	return Render( 144, NULL );
 }
 
 string CLanguage :: UnableToMuteNoMatchesFound( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0145", "lang_0145" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 145, Args );
 }
 
 string CLanguage :: MutedPlayer( string victim, string user )
 {
-	string Out = m_CFG->GetString( "lang_0146", "lang_0146" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &victim, &user };
+	return Render( 146, Args );
 }
 
 string CLanguage :: UnmutedPlayer( string victim, string user )
 {
-	string Out = m_CFG->GetString( "lang_0147", "lang_0147" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &victim, &user };
+	return Render( 147, Args );
 }
 
 string CLanguage :: UnableToMuteFoundMoreThanOneMatch( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0148", "lang_0148" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 148, Args );
 }
 
 string CLanguage :: PlayerIsSavingTheGame( string player )
 {
-	string Out = m_CFG->GetString( "lang_0149", "lang_0149" );
-	UTIL_Replace( Out, "$PLAYER$", player );
-	return Out;
+	const string *Args[] = { &player };
+	return Render( 149, Args );
 }
 
 string CLanguage :: UpdatingClanList( )
 {
-	return m_CFG->GetString( "lang_0150", "lang_0150" );
+	return Render( 150, NULL );
 }
 
 string CLanguage :: UpdatingFriendsList( )
 {
-	return m_CFG->GetString( "lang_0151", "lang_0151" );
+	return Render( 151, NULL );
 }
 
 string CLanguage :: MultipleIPAddressUsageDetected( string player, string others )
 {
-	string Out = m_CFG->GetString( "lang_0152", "lang_0152" );
-	UTIL_Replace( Out, "$PLAYER$", player );
-	UTIL_Replace( Out, "$OTHERS$", others );
-	return Out;
+	const string *Args[] = { &player, &others };
+	return Render( 152, Args );
 }
 
 string CLanguage :: UnableToVoteKickAlreadyInProgress( )
 {
-	return m_CFG->GetString( "lang_0153", "lang_0153" );
+	return Render( 153, NULL );
 }
 
 string CLanguage :: UnableToVoteKickNotEnoughPlayers( )
 {
-	return m_CFG->GetString( "lang_0154", "lang_0154" );
+	return Render( 154, NULL );
 }
 
 string CLanguage :: UnableToVoteKickNoMatchesFound( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0155", "lang_0155" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 155, Args );
 }
 
 string CLanguage :: UnableToVoteKickPlayerIsReserved( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0156", "lang_0156" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 156, Args );
 }
 
 string CLanguage :: StartedVoteKick( string victim, string user, string votesneeded )
 {
-	string Out = m_CFG->GetString( "lang_0157", "lang_0157" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$USER$", user );
-	UTIL_Replace( Out, "$VOTESNEEDED$", votesneeded );
-	return Out;
+	const string *Args[] = { &victim, &user, &votesneeded };
+	return Render( 157, Args );
 }
 
 string CLanguage :: UnableToVoteKickFoundMoreThanOneMatch( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0158", "lang_0158" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 158, Args );
 }
 
 string CLanguage :: VoteKickPassed( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0159", "lang_0159" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 159, Args );
 }
 
 string CLanguage :: ErrorVoteKickingPlayer( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0160", "lang_0160" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 160, Args );
 }
 
 string CLanguage :: VoteKickAcceptedNeedMoreVotes( string victim, string user, string votes )
 {
-	string Out = m_CFG->GetString( "lang_0161", "lang_0161" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$USER$", user );
-	UTIL_Replace( Out, "$VOTES$", votes );
-	return Out;
+	const string *Args[] = { &victim, &user, &votes };
+	return Render( 161, Args );
 }
 
 string CLanguage :: VoteKickCancelled( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0162", "lang_0162" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 162, Args );
 }
 
 string CLanguage :: VoteKickExpired( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0163", "lang_0163" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 163, Args );
 }
 
 string CLanguage :: WasKickedByVote( )
 {
-	return m_CFG->GetString( "lang_0164", "lang_0164" );
+	return Render( 164, NULL );
 }
 
 string CLanguage :: TypeYesToVote( string commandtrigger )
 {
-	string Out = m_CFG->GetString( "lang_0165", "lang_0165" );
-	UTIL_Replace( Out, "$COMMANDTRIGGER$", commandtrigger );
-	return Out;
+	const string *Args[] = { &commandtrigger };
+	return Render( 165, Args );
 }
 
 string CLanguage :: PlayersNotYetPingedAutoStart( string notpinged )
 {
-	string Out = m_CFG->GetString( "lang_0166", "lang_0166" );
-	UTIL_Replace( Out, "$NOTPINGED$", notpinged );
-	return Out;
+	const string *Args[] = { &notpinged };
+	return Render( 166, Args );
 }
 
 string CLanguage :: WasKickedForNotSpoofChecking( )
 {
-	return m_CFG->GetString( "lang_0167", "lang_0167" );
+	return Render( 167, NULL );
 }
 
 string CLanguage :: WasKickedForHavingFurthestScore( string score, string average )
 {
-	string Out = m_CFG->GetString( "lang_0168", "lang_0168" );
-	UTIL_Replace( Out, "$SCORE$", score );
-	UTIL_Replace( Out, "$AVERAGE$", average );
-	return Out;
+	const string *Args[] = { &score, &average };
+	return Render( 168, Args );
 }
 
 string CLanguage :: PlayerHasScore( string player, string score )
 {
-	string Out = m_CFG->GetString( "lang_0169", "lang_0169" );
-	UTIL_Replace( Out, "$PLAYER$", player );
-	UTIL_Replace( Out, "$SCORE$", score );
-	return Out;
+	const string *Args[] = { &player, &score };
+	return Render( 169, Args );
 }
 
 string CLanguage :: RatedPlayersSpread( string rated, string total, string spread )
 {
-	string Out = m_CFG->GetString( "lang_0170", "lang_0170" );
-	UTIL_Replace( Out, "$RATED$", rated );
-	UTIL_Replace( Out, "$TOTAL$", total );
-	UTIL_Replace( Out, "$SPREAD$", spread );
-	return Out;
+	const string *Args[] = { &rated, &total, &spread };
+	return Render( 170, Args );
 }
 
 string CLanguage :: ErrorListingMaps( )
 {
-	return m_CFG->GetString( "lang_0171", "lang_0171" );
+	return Render( 171, NULL );
 }
 
 string CLanguage :: FoundMaps( string maps )
 {
-	string Out = m_CFG->GetString( "lang_0172", "lang_0172" );
-	UTIL_Replace( Out, "$MAPS$", maps );
-	return Out;
+	const string *Args[] = { &maps };
+	return Render( 172, Args );
 }
 
 string CLanguage :: NoMapsFound( )
 {
-	return m_CFG->GetString( "lang_0173", "lang_0173" );
+	return Render( 173, NULL );
 }
 
 string CLanguage :: ErrorListingMapConfigs( )
 {
-	return m_CFG->GetString( "lang_0174", "lang_0174" );
+	return Render( 174, NULL );
 }
 
 string CLanguage :: FoundMapConfigs( string mapconfigs )
 {
-	string Out = m_CFG->GetString( "lang_0175", "lang_0175" );
-	UTIL_Replace( Out, "$MAPCONFIGS$", mapconfigs );
-	return Out;
+	const string *Args[] = { &mapconfigs };
+	return Render( 175, Args );
 }
 
 string CLanguage :: NoMapConfigsFound( )
 {
-	return m_CFG->GetString( "lang_0176", "lang_0176" );
+	return Render( 176, NULL );
 }
 
 string CLanguage :: PlayerFinishedLoading( string user )
 {
-	string Out = m_CFG->GetString( "lang_0177", "lang_0177" );
-	UTIL_Replace( Out, "$USER$", user );
-	return Out;
+	const string *Args[] = { &user };
+	return Render( 177, Args );
 }
 
 string CLanguage :: PleaseWaitPlayersStillLoading( )
 {
-	return m_CFG->GetString( "lang_0178", "lang_0178" );
+	return Render( 178, NULL );
 }
 
 string CLanguage :: MapDownloadsDisabled( )
 {
-	return m_CFG->GetString( "lang_0179", "lang_0179" );
+	return Render( 179, NULL );
 }
 
 string CLanguage :: MapDownloadsEnabled( )
 {
-	return m_CFG->GetString( "lang_0180", "lang_0180" );
+	return Render( 180, NULL );
 }
 
 string CLanguage :: MapDownloadsConditional( )
 {
-	return m_CFG->GetString( "lang_0181", "lang_0181" );
+	return Render( 181, NULL );
 }
 
 string CLanguage :: SettingHCL( string HCL )
 {
-	string Out = m_CFG->GetString( "lang_0182", "lang_0182" );
-	UTIL_Replace( Out, "$HCL$", HCL );
-	return Out;
+	const string *Args[] = { &HCL };
+	return Render( 182, Args );
 }
 
 string CLanguage :: UnableToSetHCLInvalid( )
 {
-	return m_CFG->GetString( "lang_0183", "lang_0183" );
+	return Render( 183, NULL );
 }
 
 string CLanguage :: UnableToSetHCLTooLong( )
 {
-	return m_CFG->GetString( "lang_0184", "lang_0184" );
+	return Render( 184, NULL );
 }
 
 string CLanguage :: TheHCLIs( string HCL )
 {
-	string Out = m_CFG->GetString( "lang_0185", "lang_0185" );
-	UTIL_Replace( Out, "$HCL$", HCL );
-	return Out;
+	const string *Args[] = { &HCL };
+	return Render( 185, Args );
 }
 
 string CLanguage :: TheHCLIsTooLongUseForceToStart( )
 {
-	return m_CFG->GetString( "lang_0186", "lang_0186" );
+	return Render( 186, NULL );
 }
 
 string CLanguage :: ClearingHCL( )
 {
-	return m_CFG->GetString( "lang_0187", "lang_0187" );
+	return Render( 187, NULL );
 }
 
 string CLanguage :: TryingToRehostAsPrivateGame( string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0188", "lang_0188" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &gamename };
+	return Render( 188, Args );
 }
 
 string CLanguage :: TryingToRehostAsPublicGame( string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0189", "lang_0189" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &gamename };
+	return Render( 189, Args );
 }
 
 string CLanguage :: RehostWasSuccessful( )
 {
-	return m_CFG->GetString( "lang_0190", "lang_0190" );
+	return Render( 190, NULL );
 }
 
 string CLanguage :: TryingToJoinTheGameButBannedByName( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0191", "lang_0191" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 191, Args );
 }
 
 string CLanguage :: TryingToJoinTheGameButBannedByIP( string victim, string ip, string bannedname )
 {
-	string Out = m_CFG->GetString( "lang_0192", "lang_0192" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$IP$", ip );
-	UTIL_Replace( Out, "$BANNEDNAME$", bannedname );
-	return Out;
+	const string *Args[] = { &victim, &ip, &bannedname };
+	return Render( 192, Args );
 }
 
 string CLanguage :: HasBannedName( string victim )
 {
-	string Out = m_CFG->GetString( "lang_0193", "lang_0193" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	return Out;
+	const string *Args[] = { &victim };
+	return Render( 193, Args );
 }
 
 string CLanguage :: HasBannedIP( string victim, string ip, string bannedname )
 {
-	string Out = m_CFG->GetString( "lang_0194", "lang_0194" );
-	UTIL_Replace( Out, "$VICTIM$", victim );
-	UTIL_Replace( Out, "$IP$", ip );
-	UTIL_Replace( Out, "$BANNEDNAME$", bannedname );
-	return Out;
+	const string *Args[] = { &victim, &ip, &bannedname };
+	return Render( 194, Args );
 }
 
 string CLanguage :: PlayersInGameState( string number, string players )
 {
-	string Out = m_CFG->GetString( "lang_0195", "lang_0195" );
-	UTIL_Replace( Out, "$NUMBER$", number );
-	UTIL_Replace( Out, "$PLAYERS$", players );
-	return Out;
+	const string *Args[] = { &number, &players };
+	return Render( 195, Args );
 }
 
 string CLanguage :: ValidServers( string servers )
 {
-	string Out = m_CFG->GetString( "lang_0196", "lang_0196" );
-	UTIL_Replace( Out, "$SERVERS$", servers );
-	return Out;
+	const string *Args[] = { &servers };
+	return Render( 196, Args );
 }
 
 string CLanguage :: TeamCombinedScore( string team, string score )
 {
-	string Out = m_CFG->GetString( "lang_0197", "lang_0197" );
-	UTIL_Replace( Out, "$TEAM$", team );
-	UTIL_Replace( Out, "$SCORE$", score );
-	return Out;
+	const string *Args[] = { &team, &score };
+	return Render( 197, Args );
 }
 
 string CLanguage :: BalancingSlotsCompleted( )
 {
-	return m_CFG->GetString( "lang_0198", "lang_0198" );
+	return Render( 198, NULL );
 }
 
 string CLanguage :: PlayerWasKickedForFurthestScore( string name, string score, string average )
 {
-	string Out = m_CFG->GetString( "lang_0199", "lang_0199" );
-	UTIL_Replace( Out, "$NAME$", name );
-	UTIL_Replace( Out, "$SCORE$", score );
-	UTIL_Replace( Out, "$AVERAGE$", average );
-	return Out;
+	const string *Args[] = { &name, &score, &average };
+	return Render( 199, Args );
 }
 
 string CLanguage :: LocalAdminMessagesEnabled( )
 {
-	return m_CFG->GetString( "lang_0200", "lang_0200" );
+	return Render( 200, NULL );
 }
 
 string CLanguage :: LocalAdminMessagesDisabled( )
 {
-	return m_CFG->GetString( "lang_0201", "lang_0201" );
+	return Render( 201, NULL );
 }
 
 string CLanguage :: WasDroppedDesync( )
 {
-	return m_CFG->GetString( "lang_0202", "lang_0202" );
+	return Render( 202, NULL );
 }
 
 string CLanguage :: WasKickedForHavingLowestScore( string score )
 {
-	string Out = m_CFG->GetString( "lang_0203", "lang_0203" );
-	UTIL_Replace( Out, "$SCORE$", score );
-	return Out;
+	const string *Args[] = { &score };
+	return Render( 203, Args );
 }
 
 string CLanguage :: PlayerWasKickedForLowestScore( string name, string score )
 {
-	string Out = m_CFG->GetString( "lang_0204", "lang_0204" );
-	UTIL_Replace( Out, "$NAME$", name );
-	UTIL_Replace( Out, "$SCORE$", score );
-	return Out;
+	const string *Args[] = { &name, &score };
+	return Render( 204, Args );
 }
 
 string CLanguage :: ReloadingConfigurationFiles( )
 {
-	return m_CFG->GetString( "lang_0205", "lang_0205" );
+	return Render( 205, NULL );
 }
 
 string CLanguage :: CountDownAbortedSomeoneLeftRecently( )
 {
-	return m_CFG->GetString( "lang_0206", "lang_0206" );
+	return Render( 206, NULL );
 }
 
 string CLanguage :: UnableToCreateGameMustEnforceFirst( string gamename )
 {
-	string Out = m_CFG->GetString( "lang_0207", "lang_0207" );
-	UTIL_Replace( Out, "$GAMENAME$", gamename );
-	return Out;
+	const string *Args[] = { &gamename };
+	return Render( 207, Args );
 }
 
 string CLanguage :: UnableToLoadReplaysOutside( )
 {
-	return m_CFG->GetString( "lang_0208", "lang_0208" );
+	return Render( 208, NULL );
 }
 
 string CLanguage :: LoadingReplay( string file )
 {
-	string Out = m_CFG->GetString( "lang_0209", "lang_0209" );
-	UTIL_Replace( Out, "$FILE$", file );
-	return Out;
+	const string *Args[] = { &file };
+	return Render( 209, Args );
 }
 
 string CLanguage :: UnableToLoadReplayDoesntExist( string file )
 {
-	string Out = m_CFG->GetString( "lang_0210", "lang_0210" );
-	UTIL_Replace( Out, "$FILE$", file );
-	return Out;
+	const string *Args[] = { &file };
+	return Render( 210, Args );
 }
 
 string CLanguage :: CommandTrigger( string trigger )
 {
-	string Out = m_CFG->GetString( "lang_0211", "lang_0211" );
-	UTIL_Replace( Out, "$TRIGGER$", trigger );
-	return Out;
+	const string *Args[] = { &trigger };
+	return Render( 211, Args );
 }
 
 string CLanguage :: CantEndGameOwnerIsStillPlaying( string owner )
 {
-	string Out = m_CFG->GetString( "lang_0212", "lang_0212" );
-	UTIL_Replace( Out, "$OWNER$", owner );
-	return Out;
+	const string *Args[] = { &owner };
+	return Render( 212, Args );
 }
 
 string CLanguage :: CantUnhostGameOwnerIsPresent( string owner )
 {
-	string Out = m_CFG->GetString( "lang_0213", "lang_0213" );
-	UTIL_Replace( Out, "$OWNER$", owner );
-	return Out;
+	const string *Args[] = { &owner };
+	return Render( 213, Args );
 }
 
 string CLanguage :: WasAutomaticallyDroppedAfterSeconds( string seconds )
 {
-	string Out = m_CFG->GetString( "lang_0214", "lang_0214" );
-	UTIL_Replace( Out, "$SECONDS$", seconds );
-	return Out;
+	const string *Args[] = { &seconds };
+	return Render( 214, Args );
 }
 
 string CLanguage :: HasLostConnectionTimedOutGProxy( )
 {
-	return m_CFG->GetString( "lang_0215", "lang_0215" );
+	return Render( 215, NULL );
 }
 
 string CLanguage :: HasLostConnectionSocketErrorGProxy( string error )
 {
-	string Out = m_CFG->GetString( "lang_0216", "lang_0216" );
-	UTIL_Replace( Out, "$ERROR$", error );
-	return Out;
+	const string *Args[] = { &error };
+	return Render( 216, Args );
 }
 
 string CLanguage :: HasLostConnectionClosedByRemoteHostGProxy( )
 {
-	return m_CFG->GetString( "lang_0217", "lang_0217" );
+	return Render( 217, NULL );
 }
 
 string CLanguage :: WaitForReconnectSecondsRemain( string seconds )
 {
-	string Out = m_CFG->GetString( "lang_0218", "lang_0218" );
-	UTIL_Replace( Out, "$SECONDS$", seconds );
-	return Out;
+	const string *Args[] = { &seconds };
+	return Render( 218, Args );
 }
 
 string CLanguage :: WasUnrecoverablyDroppedFromGProxy( )
 {
-	return m_CFG->GetString( "lang_0219", "lang_0219" );
+	return Render( 219, NULL );
 }
 
 string CLanguage :: PlayerReconnectedWithGProxy( string name )
 {
-	string Out = m_CFG->GetString( "lang_0220", "lang_0220" );
-	UTIL_Replace( Out, "$NAME$", name );
-	return Out;
+	const string *Args[] = { &name };
+	return Render( 220, Args );
 }
@@ -21,19 +21,64 @@
 #ifndef LANGUAGE_H
 #define LANGUAGE_H
 
+//
+// CMessageTemplate
+//
+
+// a message with $TOKEN$ placeholders, compiled once so it can be rendered in a single pass
+// 1.) Compile splits the text at every occurrence of one of the given tokens, the n-th token becomes slot n
+// 2.) Render appends the literal pieces and the arguments of the slots in order, so each argument is inserted exactly once and never scanned for tokens itself
+// 3.) anything which looks like a token but isn't one of the given tokens stays in the text as is
+
+#define MESSAGETEMPLATE_NOSLOT 0xFFFFFFFF
+
+class CMessageTemplate
+{
+private:
+	struct Segment
+	{
+		uint32_t Length;					// the length of the literal piece in m_Text
+		uint32_t Slot;						// the argument which follows it (or MESSAGETEMPLATE_NOSLOT)
+	};
+
+	string m_Text;							// the literal pieces without the tokens
+	vector<Segment> m_Segments;
+	bool m_Valid;
+
+public:
+	CMessageTemplate( );
+	~CMessageTemplate( );
+
+	bool GetValid( ) const					{ return m_Valid; }
+
+	void Compile( const string &text, const vector<string> &tokens );
+	uint32_t GetRenderedSize( const string **args ) const;
+	void Render( string &out, const string **args ) const;
+};
+
 //
 // CLanguage
 //
 
+// every message is compiled when the language file is loaded and is looked up by its id, e.g. id 1 is lang_0001
+// the translations from the database use the same ids and tokens
+
 class CLanguage
 {
 private:
-	CConfig *m_CFG;
+	vector<CMessageTemplate> m_Messages;					// indexed by message id
+	map<string, vector<CMessageTemplate> > m_Translations;	// language code -> translated messages, indexed by message id
+
+	string Render( const CMessageTemplate &message, const string **args );
+	string Render( uint32_t id, const string **args );
 
 public:
 	CLanguage( string nCFGFile );
 	~CLanguage( );
 
+	void SetTranslations( const map<string, map<uint32_t, string> > &translations );
+	string Translate( const string &language, uint32_t id, const string **args );
+
 	string UnableToCreateGameTryAnotherName( string server, string gamename );
 	string UserIsAlreadyAnAdmin( string server, string user );
 	string AddedUserToAdminDatabase( string server, string user );
@@ -28,9 +28,297 @@
 #define __STORMLIB_SELF__
 #include <stormlib/StormLib.h>
 
+#include <boost/bind.hpp>
+
+#include <sys/stat.h>
+
 #define ROTL(x,n) ((x)<<(n))|((x)>>(32-(n)))	// this won't work with signed types
 #define ROTR(x,n) ((x)>>(n))|((x)<<(32-(n)))	// this won't work with signed types
 
+//
+// CMapFile
+//
+
+map<string, boost :: weak_ptr<CMapFile> > CMapFile :: m_Registry;
+boost :: mutex CMapFile :: m_RegistryMutex;
+
+boost :: shared_ptr<CMapFile> CMapFile :: Open( string fileName )
+{
+	// reuse the copy of the file that's already loaded unless the file has changed since
+
+	struct stat FileStat;
+	uint32_t FileSize = 0;
+	uint32_t FileTime = 0;
+
+	if( stat( fileName.c_str( ), &FileStat ) == 0 )
+	{
+		FileSize = FileStat.st_size;
+		FileTime = FileStat.st_mtime;
+	}
+
+	boost :: mutex :: scoped_lock Lock( m_RegistryMutex );
+	map<string, boost :: weak_ptr<CMapFile> > :: iterator Found = m_Registry.find( fileName );
+
+	if( Found != m_Registry.end( ) )
+	{
+		boost :: shared_ptr<CMapFile> File = Found->second.lock( );
+
+		if( File && FileSize > 0 && File->m_Size == FileSize && File->m_FileTime == FileTime )
+		{
+			CONSOLE_Print( "[MAP] using already loaded map file [" + fileName + "]" );
+			return File;
+		}
+	}
+
+	boost :: shared_ptr<CMapFile> File( new CMapFile( fileName ) );
+	File->m_FileTime = FileTime;
+
+	// forget about the files nobody's using anymore while we're here
+
+	for( map<string, boost :: weak_ptr<CMapFile> > :: iterator i = m_Registry.begin( ); i != m_Registry.end( ); )
+	{
+		if( i->second.expired( ) )
+			m_Registry.erase( i++ );
+		else
+			i++;
+	}
+
+	m_Registry[fileName] = File;
+	return File;
+}
+
+CMapFile :: CMapFile( string fileName )
+{
+	m_FileTime = 0;
+	m_CRCThread = NULL;
+	m_CRCsReady = false;
+
+	// the file is read into memory rather than memory mapped
+	// admins replace map files in place and a mapping of a file which has been truncated or overwritten crashes the bot (SIGBUS) on the next MAPPART
+	// mapping it wouldn't save a copy on the way out either, every 1442 byte part is sent inside a W3GS_MAPPART packet along with its CRC so it can't go straight from the file to the socket (e.g. with sendfile)
+	// our copy never changes, a changed file gets a new CMapFile from the registry (see Open)
+
+	m_Buffer = UTIL_FileRead( fileName );
+	m_Data = (const unsigned char *)m_Buffer.c_str( );
+	m_Size = m_Buffer.size( );
+}
+
+CMapFile :: ~CMapFile( )
+{
+	WaitForCRCs( );
+}
+
+void CMapFile :: CalculateCRCs( CCRC32 *crc )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+	if( m_CRCThread || m_CRCsReady )
+		return;
+
+	// the caller usually has other things to do before it needs the CRCs (like reading the map MPQ) so calculate them on another thread
+
+	try
+	{
+		m_CRCThread = new boost :: thread( boost :: bind( &CMapFile :: DoCalculateCRCs, this, crc ) );
+	}
+	catch( const boost :: thread_resource_error &tre )
+	{
+		CONSOLE_Print( "[MAP] error spawning thread to calculate map CRCs [" + string( tre.what( ) ) + "], calculating them now" );
+		DoCalculateCRCs( crc );
+	}
+}
+
+void CMapFile :: WaitForCRCs( )
+{
+	// more than one thread can be waiting (e.g. a lobby sending MAPPART packets while CMapLoad loads the same file), only one of them may join the thread
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+	if( m_CRCThread )
+	{
+		m_CRCThread->join( );
+		delete m_CRCThread;
+		m_CRCThread = NULL;
+	}
+}
+
+void CMapFile :: DoCalculateCRCs( CCRC32 *crc )
+{
+	m_MapInfo = UTIL_CreateByteArray( (uint32_t)crc->FullCRC( (unsigned char *)m_Data, m_Size ), false );
+
+	// the map is sent to players in W3GS_MAPPART packets of 1442 bytes each and every packet carries the CRC of its part
+	// the parts are always the same so calculate their CRCs once here instead of for every packet sent to every downloader
+
+	m_PartCRCs.reserve( m_Size / 1442 + 1 );
+
+	for( uint32_t i = 0; i < m_Size; i += 1442 )
+		m_PartCRCs.push_back( crc->FullCRC( (unsigned char *)m_Data + i, min( (uint32_t)1442, m_Size - i ) ) );
+
+	// publish the CRCs, the readers which see this don't have to wait for (or lock anything because of) our thread
+
+	m_CRCsReady.store( true, boost :: memory_order_release );
+}
+
+bool CMapFile :: GetHashes( string hashesPath, BYTEARRAY &mapCRC, BYTEARRAY &mapSHA1 )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+	if( m_HashesPath.empty( ) || m_HashesPath != hashesPath )
+		return false;
+
+	mapCRC = m_MapCRC;
+	mapSHA1 = m_MapSHA1;
+	return true;
+}
+
+void CMapFile :: SetHashes( string hashesPath, BYTEARRAY mapCRC, BYTEARRAY mapSHA1 )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	m_HashesPath = hashesPath;
+	m_MapCRC = mapCRC;
+	m_MapSHA1 = mapSHA1;
+}
+
+//
+// CMapHasher
+//
+
+CMapHasher :: CMapHasher( )
+{
+	m_Finished = false;
+	m_CRC = 0;
+	m_SHA1 = new CSHA1( );
+	m_SHA1->Reset( );
+
+	try
+	{
+		m_CRCThread = new boost :: thread( boost :: bind( &CMapHasher :: CRCThread, this ) );
+	}
+	catch( const boost :: thread_resource_error &tre )
+	{
+		m_CRCThread = NULL;
+	}
+
+	try
+	{
+		m_SHA1Thread = new boost :: thread( boost :: bind( &CMapHasher :: SHA1Thread, this ) );
+	}
+	catch( const boost :: thread_resource_error &tre )
+	{
+		m_SHA1Thread = NULL;
+	}
+}
+
+CMapHasher :: ~CMapHasher( )
+{
+	BYTEARRAY MapCRC;
+	BYTEARRAY MapSHA1;
+	Finish( MapCRC, MapSHA1 );
+	delete m_SHA1;
+}
+
+bool CMapHasher :: GetPart( uint32_t index, uint32_t &type, SHAREDBYTEARRAY &data )
+{
+	// wait for the part to be added, returns false if every part has been hashed
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+	while( index >= m_Parts.size( ) && !m_Finished )
+		m_PartAdded.wait( Lock );
+
+	if( index >= m_Parts.size( ) )
+		return false;
+
+	type = m_Parts[index].first;
+	data = m_Parts[index].second;
+	return true;
+}
+
+void CMapHasher :: CRCThread( )
+{
+	uint32_t Val = 0;
+	uint32_t Type;
+	SHAREDBYTEARRAY Data;
+
+	for( uint32_t i = 0; GetPart( i, Type, Data ); i++ )
+	{
+		uint32_t DataVal = Data->empty( ) ? 0 : CMap :: XORRotateLeft( (unsigned char *)&(*Data)[0], Data->size( ) );
+
+		if( Type == MAPHASH_SCRIPT )
+			Val = Val ^ DataVal;
+		else if( Type == MAPHASH_SEPARATOR )
+		{
+			Val = ROTL( Val, 3 );
+			Val = ROTL( Val ^ 0x03F1379E, 3 );
+		}
+		else
+			Val = ROTL( Val ^ DataVal, 3 );
+	}
+
+	m_CRC = Val;
+}
+
+void CMapHasher :: SHA1Thread( )
+{
+	uint32_t Type;
+	SHAREDBYTEARRAY Data;
+
+	for( uint32_t i = 0; GetPart( i, Type, Data ); i++ )
+	{
+		if( !Data->empty( ) )
+			m_SHA1->Update( (unsigned char *)&(*Data)[0], Data->size( ) );
+	}
+
+	m_SHA1->Final( );
+}
+
+void CMapHasher :: Add( uint32_t type, SHAREDBYTEARRAY data )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	m_Parts.push_back( make_pair( type, data ) );
+	m_PartAdded.notify_all( );
+}
+
+void CMapHasher :: Finish( BYTEARRAY &mapCRC, BYTEARRAY &mapSHA1 )
+{
+	{
+		boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+		if( m_Finished )
+			return;
+
+		m_Finished = true;
+	}
+
+	m_PartAdded.notify_all( );
+
+	// if we couldn't spawn a worker do its work ourselves
+
+	if( m_CRCThread )
+	{
+		m_CRCThread->join( );
+		delete m_CRCThread;
+		m_CRCThread = NULL;
+	}
+	else
+		CRCThread( );
+
+	if( m_SHA1Thread )
+	{
+		m_SHA1Thread->join( );
+		delete m_SHA1Thread;
+		m_SHA1Thread = NULL;
+	}
+	else
+		SHA1Thread( );
+
+	mapCRC = UTIL_CreateByteArray( m_CRC, false );
+	unsigned char SHA1[20];
+	memset( SHA1, 0, sizeof( unsigned char ) * 20 );
+	m_SHA1->GetHash( SHA1 );
+	mapSHA1 = UTIL_CreateByteArray( SHA1, 20 );
+}
+
 //
 // CMap
 //
@@ -39,6 +327,8 @@ CMap :: CMap( CGHost *nGHost )
 {
 	CONSOLE_Print( "[MAP] using hardcoded Emerald Gardens map data for Warcraft 3 version 1.24 & 1.24b" );
 	m_GHost = nGHost;
+	m_GHostMapPath = m_GHost->m_MapPath;
+	m_GHostMapCFGPath = m_GHost->m_MapCFGPath;
 	m_Valid = true;
 	m_MapSize = UTIL_ExtractNumbers( "174 221 4 0", 4 );
 	m_MapInfo = UTIL_ExtractNumbers( "251 57 68 98", 4 );
@@ -72,9 +362,11 @@ CMap :: CMap( CGHost *nGHost )
 	m_Slots.push_back( CGameSlot( 0, 255, SLOTSTATUS_OPEN, 0, 11, 11, SLOTRACE_RANDOM | SLOTRACE_SELECTABLE ) );
 }
 
-CMap :: CMap( CGHost *nGHost, map<string, string> nConfig )
+CMap :: CMap( CGHost *nGHost, map<string, string> nConfig, string nGHostMapPath, string nGHostMapCFGPath )
 {
 	m_GHost = nGHost;
+	m_GHostMapPath = nGHostMapPath;
+	m_GHostMapCFGPath = nGHostMapCFGPath;
 	Load( nConfig );
 }
 
@@ -248,6 +540,37 @@ unsigned char CMap :: GetMapLayoutStyle( )
 	return 3;
 }
 
+// reads a file out of a map MPQ, returns an empty pointer if the MPQ isn't loaded or the file couldn't be read
+
+static SHAREDBYTEARRAY ReadMPQFile( HANDLE *mpq, string fileName )
+{
+	SHAREDBYTEARRAY Result;
+	HANDLE SubFile;
+
+	if( mpq && SFileOpenFileEx( *mpq, fileName.c_str( ), 0, &SubFile ) )
+	{
+		uint32_t FileLength = SFileGetFileSize( SubFile, NULL );
+
+		if( FileLength > 0 && FileLength != 0xFFFFFFFF )
+		{
+			BYTEARRAY *SubFileData = new BYTEARRAY( FileLength );
+			DWORD BytesRead = 0;
+
+			if( SFileReadFile( SubFile, &(*SubFileData)[0], FileLength, &BytesRead ) )
+			{
+				SubFileData->resize( BytesRead );
+				Result = SHAREDBYTEARRAY( SubFileData );
+			}
+			else
+				delete SubFileData;
+		}
+
+		SFileCloseFile( SubFile );
+	}
+
+	return Result;
+}
+
 void CMap :: Load( map<string, string> config )
 {
 	m_Valid = true;
@@ -256,16 +579,46 @@ void CMap :: Load( map<string, string> config )
 
 	m_MapLocalPath = config["map_localpath"];
         m_MapPath = config["map_path"];
-	m_MapData.clear( );
-        m_MapData = UTIL_FileRead( m_GHost->m_MapPath + m_MapLocalPath );
+	m_MapData = CMapFile :: Open( m_GHostMapPath + m_MapLocalPath );
+
+	if( m_MapData->GetSize( ) == 0 )
+		m_MapData.reset( );
+	else
+		m_MapData->CalculateCRCs( m_GHost->m_CRC );
+
+	uint32_t MapDataSize = GetMapDataSize( );
+
+	BYTEARRAY MapSize;
+	BYTEARRAY MapInfo;
+	BYTEARRAY MapCRC;
+	BYTEARRAY MapSHA1;
+	uint32_t MapOptions = 0;
+	BYTEARRAY MapWidth;
+	BYTEARRAY MapHeight;
+	uint32_t MapNumPlayers = 0;
+	uint32_t MapNumTeams = 0;
+	vector<CGameSlot> Slots;
+
+	// try the map metadata cache first, it has everything we'd otherwise need the map MPQ for (map_crc, map_sha1 and the war3map.w3i values)
+
+	string CacheFileName;
+	bool Cached = false;
+
+	if( m_MapData && !m_GHostMapCFGPath.empty( ) )
+	{
+		CacheFileName = UTIL_AddPathSeperator( m_GHostMapCFGPath ) + UTIL_FileSafeName( m_MapLocalPath ) + ".cache";
+		Cached = LoadCache( CacheFileName, MapCRC, MapSHA1, MapOptions, MapWidth, MapHeight, MapNumPlayers, MapNumTeams, Slots );
+	}
 
 	// load the map MPQ
 
-	string MapMPQFileName = m_GHost->m_MapPath + m_MapLocalPath;
+	string MapMPQFileName = m_GHostMapPath + m_MapLocalPath;
 	HANDLE MapMPQ;
 	bool MapMPQReady = false;
 
-	if( SFileOpenArchive( MapMPQFileName.c_str( ), 0, MPQ_OPEN_FORCE_MPQ_V1, &MapMPQ ) )
+	if( Cached )
+		CONSOLE_Print( "[MAP] using map metadata cache [" + CacheFileName + "], not loading MPQ file [" + MapMPQFileName + "]" );
+	else if( SFileOpenArchive( MapMPQFileName.c_str( ), 0, MPQ_OPEN_FORCE_MPQ_V1, &MapMPQ ) )
 	{
 		CONSOLE_Print( "[MAP] loading MPQ file [" + MapMPQFileName + "]" );
 		MapMPQReady = true;
@@ -275,209 +628,143 @@ void CMap :: Load( map<string, string> config )
 
 	// try to calculate map_size, map_info, map_crc, map_sha1
 
-	BYTEARRAY MapSize;
-	BYTEARRAY MapInfo;
-	BYTEARRAY MapCRC;
-	BYTEARRAY MapSHA1;
-
-	if( !m_MapData.empty( ) )
+	if( m_MapData )
 	{
-		m_GHost->m_SHA->Reset( );
-
 		// calculate map_size
 
-		MapSize = UTIL_CreateByteArray( (uint32_t)m_MapData.size( ), false );
+		MapSize = UTIL_CreateByteArray( MapDataSize, false );
 		CONSOLE_Print( "[MAP] calculated map_size = " + UTIL_ByteArrayToDecString( MapSize ) );
 
-		// calculate map_info (this is actually the CRC)
-
-		MapInfo = UTIL_CreateByteArray( (uint32_t)m_GHost->m_CRC->FullCRC( (unsigned char *)m_MapData.c_str( ), m_MapData.size( ) ), false );
-		CONSOLE_Print( "[MAP] calculated map_info = " + UTIL_ByteArrayToDecString( MapInfo ) );
-
 		// calculate map_crc (this is not the CRC) and map_sha1
 		// a big thank you to Strilanc for figuring the map_crc algorithm out
+		// the hashes only depend on the map file and common.j/blizzard.j so they're shared by everyone using the file
 
-		string CommonJ = UTIL_FileRead( m_GHost->m_MapPath + "common.j" );
-
-		if( CommonJ.empty( ) )
-			CONSOLE_Print( "[MAP] unable to calculate map_crc/sha1 - unable to read file [" + m_GHost->m_MapPath + "common.j]" );
+		if( Cached )
+		{
+			CONSOLE_Print( "[MAP] calculated map_crc = " + UTIL_ByteArrayToDecString( MapCRC ) + " (cached)" );
+			CONSOLE_Print( "[MAP] calculated map_sha1 = " + UTIL_ByteArrayToDecString( MapSHA1 ) + " (cached)" );
+			m_MapData->SetHashes( m_GHostMapPath, MapCRC, MapSHA1 );
+		}
+		else if( m_MapData->GetHashes( m_GHostMapPath, MapCRC, MapSHA1 ) )
+		{
+			CONSOLE_Print( "[MAP] calculated map_crc = " + UTIL_ByteArrayToDecString( MapCRC ) + " (already calculated for this file)" );
+			CONSOLE_Print( "[MAP] calculated map_sha1 = " + UTIL_ByteArrayToDecString( MapSHA1 ) + " (already calculated for this file)" );
+		}
 		else
 		{
-			string BlizzardJ = UTIL_FileRead( m_GHost->m_MapPath + "blizzard.j" );
+			string CommonJ = UTIL_FileRead( m_GHostMapPath + "common.j" );
 
-			if( BlizzardJ.empty( ) )
-				CONSOLE_Print( "[MAP] unable to calculate map_crc/sha1 - unable to read file [" + m_GHost->m_MapPath + "blizzard.j]" );
+			if( CommonJ.empty( ) )
+				CONSOLE_Print( "[MAP] unable to calculate map_crc/sha1 - unable to read file [" + m_GHostMapPath + "common.j]" );
 			else
 			{
-				uint32_t Val = 0;
-
-				// update: it's possible for maps to include their own copies of common.j and/or blizzard.j
-				// this code now overrides the default copies if required
-
-				bool OverrodeCommonJ = false;
-				bool OverrodeBlizzardJ = false;
+				string BlizzardJ = UTIL_FileRead( m_GHostMapPath + "blizzard.j" );
 
-				if( MapMPQReady )
+				if( BlizzardJ.empty( ) )
+					CONSOLE_Print( "[MAP] unable to calculate map_crc/sha1 - unable to read file [" + m_GHostMapPath + "blizzard.j]" );
+				else
 				{
-					HANDLE SubFile;
+					// the files are hashed on the hasher's worker threads while we read the next one out of the MPQ
+					// update: it's possible for maps to include their own copies of common.j and/or blizzard.j
+					// this code now overrides the default copies if required
 
-					// override common.j
+					CMapHasher Hasher;
+					SHAREDBYTEARRAY MapCommonJ = ReadMPQFile( MapMPQReady ? &MapMPQ : NULL, "Scripts\\common.j" );
 
-					if( SFileOpenFileEx( MapMPQ, "Scripts\\common.j", 0, &SubFile ) )
+					if( MapCommonJ )
 					{
-						uint32_t FileLength = SFileGetFileSize( SubFile, NULL );
-
-						if( FileLength > 0 && FileLength != 0xFFFFFFFF )
-						{
-							char *SubFileData = new char[FileLength];
-							DWORD BytesRead = 0;
-
-							if( SFileReadFile( SubFile, SubFileData, FileLength, &BytesRead ) )
-							{
-								CONSOLE_Print( "[MAP] overriding default common.j with map copy while calculating map_crc/sha1" );
-								OverrodeCommonJ = true;
-								Val = Val ^ XORRotateLeft( (unsigned char *)SubFileData, BytesRead );
-								m_GHost->m_SHA->Update( (unsigned char *)SubFileData, BytesRead );
-							}
-
-							delete [] SubFileData;
-						}
-
-						SFileCloseFile( SubFile );
+						CONSOLE_Print( "[MAP] overriding default common.j with map copy while calculating map_crc/sha1" );
+						Hasher.Add( MAPHASH_SCRIPT, MapCommonJ );
 					}
-				}
-
-				if( !OverrodeCommonJ )
-				{
-					Val = Val ^ XORRotateLeft( (unsigned char *)CommonJ.c_str( ), CommonJ.size( ) );
-					m_GHost->m_SHA->Update( (unsigned char *)CommonJ.c_str( ), CommonJ.size( ) );
-				}
-
-				if( MapMPQReady )
-				{
-					HANDLE SubFile;
+					else
+						Hasher.Add( MAPHASH_SCRIPT, SHAREDBYTEARRAY( new BYTEARRAY( CommonJ.begin( ), CommonJ.end( ) ) ) );
 
-					// override blizzard.j
+					SHAREDBYTEARRAY MapBlizzardJ = ReadMPQFile( MapMPQReady ? &MapMPQ : NULL, "Scripts\\blizzard.j" );
 
-					if( SFileOpenFileEx( MapMPQ, "Scripts\\blizzard.j", 0, &SubFile ) )
+					if( MapBlizzardJ )
 					{
-						uint32_t FileLength = SFileGetFileSize( SubFile, NULL );
-
-						if( FileLength > 0 && FileLength != 0xFFFFFFFF )
-						{
-							char *SubFileData = new char[FileLength];
-							DWORD BytesRead = 0;
-
-							if( SFileReadFile( SubFile, SubFileData, FileLength, &BytesRead ) )
-							{
-								CONSOLE_Print( "[MAP] overriding default blizzard.j with map copy while calculating map_crc/sha1" );
-								OverrodeBlizzardJ = true;
-								Val = Val ^ XORRotateLeft( (unsigned char *)SubFileData, BytesRead );
-								m_GHost->m_SHA->Update( (unsigned char *)SubFileData, BytesRead );
-							}
-
-							delete [] SubFileData;
-						}
-
-						SFileCloseFile( SubFile );
+						CONSOLE_Print( "[MAP] overriding default blizzard.j with map copy while calculating map_crc/sha1" );
+						Hasher.Add( MAPHASH_SCRIPT, MapBlizzardJ );
 					}
-				}
-
-				if( !OverrodeBlizzardJ )
-				{
-					Val = Val ^ XORRotateLeft( (unsigned char *)BlizzardJ.c_str( ), BlizzardJ.size( ) );
-					m_GHost->m_SHA->Update( (unsigned char *)BlizzardJ.c_str( ), BlizzardJ.size( ) );
-				}
+					else
+						Hasher.Add( MAPHASH_SCRIPT, SHAREDBYTEARRAY( new BYTEARRAY( BlizzardJ.begin( ), BlizzardJ.end( ) ) ) );
 
-				Val = ROTL( Val, 3 );
-				Val = ROTL( Val ^ 0x03F1379E, 3 );
-				m_GHost->m_SHA->Update( (unsigned char *)"\x9E\x37\xF1\x03", 4 );
+					Hasher.Add( MAPHASH_SEPARATOR, SHAREDBYTEARRAY( new BYTEARRAY( (unsigned char *)"\x9E\x37\xF1\x03", (unsigned char *)"\x9E\x37\xF1\x03" + 4 ) ) );
 
-				if( MapMPQReady )
-				{
-					vector<string> FileList;
-					FileList.push_back( "war3map.j" );
-					FileList.push_back( "scripts\\war3map.j" );
-					FileList.push_back( "war3map.w3e" );
-					FileList.push_back( "war3map.wpm" );
-					FileList.push_back( "war3map.doo" );
-					FileList.push_back( "war3map.w3u" );
-					FileList.push_back( "war3map.w3b" );
-					FileList.push_back( "war3map.w3d" );
-					FileList.push_back( "war3map.w3a" );
-					FileList.push_back( "war3map.w3q" );
-					bool FoundScript = false;
-
-					for( vector<string> :: iterator i = FileList.begin( ); i != FileList.end( ); i++ )
+					if( MapMPQReady )
 					{
-						// don't use scripts\war3map.j if we've already used war3map.j (yes, some maps have both but only war3map.j is used)
-
-						if( FoundScript && *i == "scripts\\war3map.j" )
-							continue;
-
-						HANDLE SubFile;
-
-						if( SFileOpenFileEx( MapMPQ, (*i).c_str( ), 0, &SubFile ) )
+						vector<string> FileList;
+						FileList.push_back( "war3map.j" );
+						FileList.push_back( "scripts\\war3map.j" );
+						FileList.push_back( "war3map.w3e" );
+						FileList.push_back( "war3map.wpm" );
+						FileList.push_back( "war3map.doo" );
+						FileList.push_back( "war3map.w3u" );
+						FileList.push_back( "war3map.w3b" );
+						FileList.push_back( "war3map.w3d" );
+						FileList.push_back( "war3map.w3a" );
+						FileList.push_back( "war3map.w3q" );
+						bool FoundScript = false;
+
+						for( vector<string> :: iterator i = FileList.begin( ); i != FileList.end( ); i++ )
 						{
-							uint32_t FileLength = SFileGetFileSize( SubFile, NULL );
+							// don't use scripts\war3map.j if we've already used war3map.j (yes, some maps have both but only war3map.j is used)
 
-							if( FileLength > 0 && FileLength != 0xFFFFFFFF )
-							{
-								char *SubFileData = new char[FileLength];
-								DWORD BytesRead = 0;
+							if( FoundScript && *i == "scripts\\war3map.j" )
+								continue;
 
-								if( SFileReadFile( SubFile, SubFileData, FileLength, &BytesRead ) )
-								{
-									if( *i == "war3map.j" || *i == "scripts\\war3map.j" )
-										FoundScript = true;
+							SHAREDBYTEARRAY SubFileData = ReadMPQFile( &MapMPQ, *i );
 
-									Val = ROTL( Val ^ XORRotateLeft( (unsigned char *)SubFileData, BytesRead ), 3 );
-									m_GHost->m_SHA->Update( (unsigned char *)SubFileData, BytesRead );
-									// DEBUG_Print( "*** found: " + *i );
-								}
+							if( SubFileData )
+							{
+								if( *i == "war3map.j" || *i == "scripts\\war3map.j" )
+									FoundScript = true;
 
-								delete [] SubFileData;
+								Hasher.Add( MAPHASH_FILE, SubFileData );
+								// DEBUG_Print( "*** found: " + *i );
+							}
+							else
+							{
+								// DEBUG_Print( "*** not found: " + *i );
 							}
-
-							SFileCloseFile( SubFile );
-						}
-						else
-						{
-							// DEBUG_Print( "*** not found: " + *i );
 						}
-					}
-
-					if( !FoundScript )
-						CONSOLE_Print( "[MAP] couldn't find war3map.j or scripts\\war3map.j in MPQ file, calculated map_crc/sha1 is probably wrong" );
 
-					MapCRC = UTIL_CreateByteArray( Val, false );
-					CONSOLE_Print( "[MAP] calculated map_crc = " + UTIL_ByteArrayToDecString( MapCRC ) );
+						if( !FoundScript )
+							CONSOLE_Print( "[MAP] couldn't find war3map.j or scripts\\war3map.j in MPQ file, calculated map_crc/sha1 is probably wrong" );
 
-					m_GHost->m_SHA->Final( );
-					unsigned char SHA1[20];
-					memset( SHA1, 0, sizeof( unsigned char ) * 20 );
-					m_GHost->m_SHA->GetHash( SHA1 );
-					MapSHA1 = UTIL_CreateByteArray( SHA1, 20 );
-					CONSOLE_Print( "[MAP] calculated map_sha1 = " + UTIL_ByteArrayToDecString( MapSHA1 ) );
+						Hasher.Finish( MapCRC, MapSHA1 );
+						CONSOLE_Print( "[MAP] calculated map_crc = " + UTIL_ByteArrayToDecString( MapCRC ) );
+						CONSOLE_Print( "[MAP] calculated map_sha1 = " + UTIL_ByteArrayToDecString( MapSHA1 ) );
+					}
+					else
+						CONSOLE_Print( "[MAP] unable to calculate map_crc/sha1 - map MPQ file not loaded" );
 				}
-				else
-					CONSOLE_Print( "[MAP] unable to calculate map_crc/sha1 - map MPQ file not loaded" );
 			}
+
+			if( !MapCRC.empty( ) && !MapSHA1.empty( ) )
+				m_MapData->SetHashes( m_GHostMapPath, MapCRC, MapSHA1 );
 		}
+
+		// calculate map_info (this is actually the CRC)
+		// it's been calculated on another thread in the meantime so this only waits if that thread isn't finished yet
+
+		MapInfo = m_MapData->GetMapInfo( );
+		CONSOLE_Print( "[MAP] calculated map_info = " + UTIL_ByteArrayToDecString( MapInfo ) );
 	}
 	else
 		CONSOLE_Print( "[MAP] no map data available, using config file for map_size, map_info, map_crc, map_sha1" );
 
 	// try to calculate map_width, map_height, map_slot<x>, map_numplayers, map_numteams
 
-	uint32_t MapOptions = 0;
-	BYTEARRAY MapWidth;
-	BYTEARRAY MapHeight;
-	uint32_t MapNumPlayers = 0;
-	uint32_t MapNumTeams = 0;
-	vector<CGameSlot> Slots;
-
-	if( !m_MapData.empty( ) )
+	if( Cached )
+	{
+		CONSOLE_Print( "[MAP] calculated map_options = " + UTIL_ToString( MapOptions ) + " (cached)" );
+		CONSOLE_Print( "[MAP] calculated map_width = " + UTIL_ByteArrayToDecString( MapWidth ) + " (cached)" );
+		CONSOLE_Print( "[MAP] calculated map_height = " + UTIL_ByteArrayToDecString( MapHeight ) + " (cached)" );
+		CONSOLE_Print( "[MAP] calculated map_numplayers = " + UTIL_ToString( MapNumPlayers ) + " (cached)" );
+		CONSOLE_Print( "[MAP] calculated map_numteams = " + UTIL_ToString( MapNumTeams ) + " (cached)" );
+	}
+	else if( m_MapData )
 	{
 		if( MapMPQReady )
 		{
@@ -713,6 +1000,12 @@ void CMap :: Load( map<string, string> config )
 	if( MapMPQReady )
 		SFileCloseArchive( MapMPQ );
 
+	// save what we calculated so the next load of this map doesn't need the MPQ
+	// if anything couldn't be calculated don't save anything, the config file has to fill in the gaps every time anyway
+
+	if( !Cached && !CacheFileName.empty( ) && !MapCRC.empty( ) && !MapSHA1.empty( ) && !MapWidth.empty( ) && !MapHeight.empty( ) )
+		SaveCache( CacheFileName, MapCRC, MapSHA1, MapOptions, MapWidth, MapHeight, MapNumPlayers, MapNumTeams, Slots );
+
 	if( MapSize.empty( ) )
 		MapSize = UTIL_ExtractNumbers( config["map_size"], 4 );
 	else if( config.find("map_size" ) != config.end() )
@@ -874,6 +1167,19 @@ void CMap :: Load( map<string, string> config )
 	CheckValid( );
 }
 
+uint32_t CMap :: GetMapPartCRC( uint32_t start )
+{
+	if( m_MapData && start % 1442 == 0 && start / 1442 < m_MapData->GetPartCRCs( )->size( ) )
+		return (*m_MapData->GetPartCRCs( ))[start / 1442];
+
+	// not one of the parts we know about, calculate it the slow way
+
+	if( start >= GetMapDataSize( ) )
+		return 0;
+
+	return m_GHost->m_CRC->FullCRC( (unsigned char *)GetMapData( ) + start, min( (uint32_t)1442, GetMapDataSize( ) - start ) );
+}
+
 void CMap :: CheckValid( )
 {
 	// todotodo: should this code fix any errors it sees rather than just warning the user?
@@ -883,7 +1189,7 @@ void CMap :: CheckValid( )
 		m_Valid = false;
 		CONSOLE_Print( "[MAP] invalid map_size detected" );
 	}
-	else if( !m_MapData.empty( ) && m_MapData.size( ) != UTIL_ByteArrayToUInt32( m_MapSize, false ) )
+	else if( m_MapData && m_MapData->GetSize( ) != UTIL_ByteArrayToUInt32( m_MapSize, false ) )
 	{
 		m_Valid = false;
 		CONSOLE_Print( "[MAP] invalid map_size detected - size mismatch with actual map data" );
@@ -959,6 +1265,114 @@ void CMap :: CheckValid( )
 	}
 }
 
+string CMap :: GetCacheStamp( string file )
+{
+	// the size and modification time of a file the cached values depend on, changing the file invalidates the cache
+
+	struct stat FileStat;
+
+	if( stat( file.c_str( ), &FileStat ) != 0 )
+		return "none";
+
+	return UTIL_ToString( (uint32_t)FileStat.st_size ) + " " + UTIL_ToString( (uint32_t)FileStat.st_mtime );
+}
+
+bool CMap :: LoadCache( string fileName, BYTEARRAY &mapCRC, BYTEARRAY &mapSHA1, uint32_t &mapOptions, BYTEARRAY &mapWidth, BYTEARRAY &mapHeight, uint32_t &mapNumPlayers, uint32_t &mapNumTeams, vector<CGameSlot> &slots )
+{
+	if( !UTIL_FileExists( fileName ) )
+		return false;
+
+	CConfig Cache;
+	Cache.Read( fileName );
+
+	// the cache is only valid for the exact map file it was made from (same size, modification time and map_info)
+	// map_crc and map_sha1 also depend on common.j and blizzard.j so those have to be unchanged too
+
+	if( Cache.GetInt( "cache_version", 0 ) != MAPCACHE_VERSION ||
+		Cache.GetString( "cache_map", string( ) ) != m_MapLocalPath ||
+		Cache.GetString( "cache_size", string( ) ) != UTIL_ToString( m_MapData->GetSize( ) ) ||
+		Cache.GetString( "cache_time", string( ) ) != UTIL_ToString( m_MapData->GetFileTime( ) ) ||
+		Cache.GetString( "cache_commonj", string( ) ) != GetCacheStamp( m_GHostMapPath + "common.j" ) ||
+		Cache.GetString( "cache_blizzardj", string( ) ) != GetCacheStamp( m_GHostMapPath + "blizzard.j" ) ||
+		Cache.GetString( "cache_map_info", string( ) ) != UTIL_ByteArrayToDecString( m_MapData->GetMapInfo( ) ) )
+	{
+		CONSOLE_Print( "[MAP] map metadata cache [" + fileName + "] is out of date, recalculating" );
+		return false;
+	}
+
+	BYTEARRAY CRC = UTIL_ExtractNumbers( Cache.GetString( "map_crc", string( ) ), 4 );
+	BYTEARRAY SHA1 = UTIL_ExtractNumbers( Cache.GetString( "map_sha1", string( ) ), 20 );
+	BYTEARRAY Width = UTIL_ExtractNumbers( Cache.GetString( "map_width", string( ) ), 2 );
+	BYTEARRAY Height = UTIL_ExtractNumbers( Cache.GetString( "map_height", string( ) ), 2 );
+	vector<CGameSlot> Slots;
+
+	for( uint32_t Slot = 1; Slot <= 12; Slot++ )
+	{
+		string SlotString = Cache.GetString( "map_slot" + UTIL_ToString( Slot ), string( ) );
+
+		if( SlotString.empty( ) )
+			break;
+
+		BYTEARRAY SlotData = UTIL_ExtractNumbers( SlotString, 9 );
+
+		if( SlotData.size( ) != 9 )
+			break;
+
+		Slots.push_back( CGameSlot( SlotData ) );
+	}
+
+	if( CRC.size( ) != 4 || SHA1.size( ) != 20 || Width.size( ) != 2 || Height.size( ) != 2 || Slots.size( ) != (uint32_t)Cache.GetInt( "map_numslots", -1 ) )
+	{
+		CONSOLE_Print( "[MAP] map metadata cache [" + fileName + "] is corrupt, recalculating" );
+		return false;
+	}
+
+	mapCRC = CRC;
+	mapSHA1 = SHA1;
+	mapOptions = Cache.GetInt( "map_options", 0 );
+	mapWidth = Width;
+	mapHeight = Height;
+	mapNumPlayers = Cache.GetInt( "map_numplayers", 0 );
+	mapNumTeams = Cache.GetInt( "map_numteams", 0 );
+	slots = Slots;
+	return true;
+}
+
+void CMap :: SaveCache( string fileName, BYTEARRAY mapCRC, BYTEARRAY mapSHA1, uint32_t mapOptions, BYTEARRAY mapWidth, BYTEARRAY mapHeight, uint32_t mapNumPlayers, uint32_t mapNumTeams, vector<CGameSlot> slots )
+{
+	// the cache uses the same format (and the same key names) as a map config file
+
+	string Cache;
+	Cache += "# map metadata cache for [" + m_MapLocalPath + "], generated automatically\n";
+	Cache += "# delete this file to force the bot to recalculate everything\n";
+	Cache += "cache_version = " + UTIL_ToString( MAPCACHE_VERSION ) + "\n";
+	Cache += "cache_map = " + m_MapLocalPath + "\n";
+	Cache += "cache_size = " + UTIL_ToString( m_MapData->GetSize( ) ) + "\n";
+	Cache += "cache_time = " + UTIL_ToString( m_MapData->GetFileTime( ) ) + "\n";
+	Cache += "cache_map_info = " + UTIL_ByteArrayToDecString( m_MapData->GetMapInfo( ) ) + "\n";
+	Cache += "cache_commonj = " + GetCacheStamp( m_GHostMapPath + "common.j" ) + "\n";
+	Cache += "cache_blizzardj = " + GetCacheStamp( m_GHostMapPath + "blizzard.j" ) + "\n";
+	Cache += "map_crc = " + UTIL_ByteArrayToDecString( mapCRC ) + "\n";
+	Cache += "map_sha1 = " + UTIL_ByteArrayToDecString( mapSHA1 ) + "\n";
+	Cache += "map_options = " + UTIL_ToString( mapOptions ) + "\n";
+	Cache += "map_width = " + UTIL_ByteArrayToDecString( mapWidth ) + "\n";
+	Cache += "map_height = " + UTIL_ByteArrayToDecString( mapHeight ) + "\n";
+	Cache += "map_numplayers = " + UTIL_ToString( mapNumPlayers ) + "\n";
+	Cache += "map_numteams = " + UTIL_ToString( mapNumTeams ) + "\n";
+	Cache += "map_numslots = " + UTIL_ToString( slots.size( ) ) + "\n";
+
+	uint32_t SlotNum = 1;
+
+	for( vector<CGameSlot> :: iterator i = slots.begin( ); i != slots.end( ); i++ )
+	{
+		Cache += "map_slot" + UTIL_ToString( SlotNum ) + " = " + UTIL_ByteArrayToDecString( (*i).GetByteArray( ) ) + "\n";
+		SlotNum++;
+	}
+
+	if( UTIL_FileWrite( fileName, (unsigned char *)Cache.c_str( ), Cache.size( ) ) )
+		CONSOLE_Print( "[MAP] saved map metadata cache [" + fileName + "]" );
+}
+
 uint32_t CMap :: XORRotateLeft( unsigned char *data, uint32_t length )
 {
 	// a big thank you to Strilanc for figuring this out
@@ -983,3 +1397,64 @@ uint32_t CMap :: XORRotateLeft( unsigned char *data, uint32_t length )
 
 	return Val;
 }
+
+//
+// CMapLoad
+//
+
+CMapLoad :: CMapLoad( CGHost *nGHost, map<string, string> nConfig )
+{
+	m_Map = NULL;
+	m_Ready = false;
+
+	// the map and mapcfg paths are copied here because ParseConfigValues can change them on the main thread while the map is loading
+
+	m_MapPath = nGHost->m_MapPath;
+	m_MapCFGPath = nGHost->m_MapCFGPath;
+
+	try
+	{
+		m_Thread = new boost :: thread( boost :: bind( &CMapLoad :: Load, this, nGHost, nConfig ) );
+	}
+	catch( const boost :: thread_resource_error &tre )
+	{
+		CONSOLE_Print( "[MAP] error spawning thread to load map [" + string( tre.what( ) ) + "], loading it now" );
+		m_Thread = NULL;
+		Load( nGHost, nConfig );
+	}
+}
+
+CMapLoad :: ~CMapLoad( )
+{
+	if( m_Thread )
+	{
+		m_Thread->join( );
+		delete m_Thread;
+	}
+
+	delete m_Map;
+}
+
+void CMapLoad :: Load( CGHost *nGHost, map<string, string> nConfig )
+{
+	CMap *Map = new CMap( nGHost, nConfig, m_MapPath, m_MapCFGPath );
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	m_Map = Map;
+	m_Ready = true;
+}
+
+bool CMapLoad :: GetReady( )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	return m_Ready;
+}
+
+CMap *CMapLoad :: GetMap( )
+{
+	// the caller takes ownership of the map
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	CMap *Map = m_Map;
+	m_Map = NULL;
+	return Map;
+}
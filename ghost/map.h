@@ -83,8 +83,103 @@
 #define MAPGAMETYPE_OBSONDEATH			1 << 21
 #define MAPGAMETYPE_OBSNONE				1 << 22
 
+#define MAPCACHE_VERSION				1			// bump this whenever the map metadata cache format or the values stored in it change
+
 #include "gameslot.h"
 
+#include <boost/weak_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+
+//
+// CMapFile
+//
+
+// the contents of a map file, read into memory once
+// along with everything calculated from the contents alone (map_info, the map part CRCs) and map_crc/map_sha1
+// the data never changes once loaded so it's shared by every CMap using the file instead of being duplicated
+// files are opened through a process wide registry (see Open) so loading a map that's already in use doesn't read or hash the file again
+// the CRCs are calculated on a separate thread (see CalculateCRCs), anything that needs them waits for that thread to finish
+// once they're published (m_CRCsReady) they never change again so they're read without taking m_Mutex, e.g. for every W3GS_MAPPART we send
+
+class CCRC32;
+class CSHA1;
+
+class CMapFile
+{
+private:
+	static map<string, boost :: weak_ptr<CMapFile> > m_Registry;	// file name -> the loaded copy of the file (if anyone's still using it)
+	static boost :: mutex m_RegistryMutex;							// maps are loaded on their own threads (see CMapLoad)
+
+	const unsigned char *m_Data;
+	uint32_t m_Size;
+	uint32_t m_FileTime;						// the file's modification time when it was loaded
+	string m_Buffer;							// the file's contents
+	BYTEARRAY m_MapInfo;						// the CRC of the whole file (empty until calculated)
+	vector<uint32_t> m_PartCRCs;				// the CRC of every 1442 byte part of the file, for W3GS_MAPPART
+	string m_HashesPath;						// the path common.j and blizzard.j were read from when calculating map_crc and map_sha1 (empty until calculated)
+	BYTEARRAY m_MapCRC;
+	BYTEARRAY m_MapSHA1;
+	boost :: thread *m_CRCThread;				// the thread calculating m_MapInfo and m_PartCRCs (NULL if they're calculated)
+	boost :: atomic<bool> m_CRCsReady;			// set (with release semantics) once m_MapInfo and m_PartCRCs have been calculated
+	boost :: mutex m_Mutex;						// the file is shared between the main thread and CMapLoad threads, guards m_CRCThread and the hashes
+
+	CMapFile( string fileName );
+	void DoCalculateCRCs( CCRC32 *crc );
+
+public:
+	~CMapFile( );
+
+	static boost :: shared_ptr<CMapFile> Open( string fileName );
+
+	const unsigned char *GetData( )			{ return m_Data; }
+	uint32_t GetSize( )						{ return m_Size; }
+	BYTEARRAY GetMapInfo( )					{ if( !m_CRCsReady.load( boost :: memory_order_acquire ) ) WaitForCRCs( ); return m_MapInfo; }
+	vector<uint32_t> *GetPartCRCs( )		{ if( !m_CRCsReady.load( boost :: memory_order_acquire ) ) WaitForCRCs( ); return &m_PartCRCs; }
+	uint32_t GetFileTime( )					{ return m_FileTime; }
+
+	void CalculateCRCs( CCRC32 *crc );
+	void WaitForCRCs( );
+	bool GetHashes( string hashesPath, BYTEARRAY &mapCRC, BYTEARRAY &mapSHA1 );
+	void SetHashes( string hashesPath, BYTEARRAY mapCRC, BYTEARRAY mapSHA1 );
+};
+
+//
+// CMapHasher
+//
+
+// calculates map_crc and map_sha1 from the files the caller reads out of the map MPQ one at a time
+// map_crc and map_sha1 are calculated at the same time on two worker threads, each going through the files in the order they were added
+// so the caller can read (and decompress) the next file while the previous ones are still being hashed
+
+#define MAPHASH_SCRIPT		1		// common.j or blizzard.j
+#define MAPHASH_SEPARATOR	2		// the constant between the scripts and the map's own files
+#define MAPHASH_FILE		3		// one of the map's own files (war3map.j and so on)
+
+class CMapHasher
+{
+private:
+	boost :: mutex m_Mutex;
+	boost :: condition_variable m_PartAdded;
+	vector<pair<uint32_t, SHAREDBYTEARRAY> > m_Parts;	// everything added so far (MAPHASH_* -> data), each worker keeps track of where it is itself
+	bool m_Finished;									// set when no more parts will be added
+	boost :: thread *m_CRCThread;
+	boost :: thread *m_SHA1Thread;
+	uint32_t m_CRC;
+	CSHA1 *m_SHA1;
+
+	bool GetPart( uint32_t index, uint32_t &type, SHAREDBYTEARRAY &data );
+	void CRCThread( );
+	void SHA1Thread( );
+
+public:
+	CMapHasher( );
+	~CMapHasher( );
+
+	void Add( uint32_t type, SHAREDBYTEARRAY data );
+	void Finish( BYTEARRAY &mapCRC, BYTEARRAY &mapSHA1 );
+};
+
 //
 // CMap
 //
@@ -118,15 +213,17 @@ private:
 	uint32_t m_MapDefaultPlayerScore;			// config value: map default player score (for matchmaking)
 	string m_MapLocalPath;						// config value: map local path
 	bool m_MapLoadInGame;
-	string m_MapData;							// the map data itself, for sending the map to players
+	boost :: shared_ptr<CMapFile> m_MapData;	// the map data itself, for sending the map to players
 	uint32_t m_MapNumPlayers;
 	uint32_t m_MapNumTeams;
 	vector<CGameSlot> m_Slots;
         string m_MapPath;
+	string m_GHostMapPath;						// the bot's map path when the map was created (maps are loaded on their own thread, see CMapLoad)
+	string m_GHostMapCFGPath;					// the bot's mapcfg path when the map was created
 
 public:
 	CMap( CGHost *nGHost );
-	CMap( CGHost *nGHost, map<string, string> nConfig );
+	CMap( CGHost *nGHost, map<string, string> nConfig, string nGHostMapPath, string nGHostMapCFGPath );
 	~CMap( );
 
 	bool GetValid( )						{ return m_Valid; }
@@ -152,14 +249,49 @@ public:
 	uint32_t GetMapDefaultPlayerScore( )	{ return m_MapDefaultPlayerScore; }
 	string GetMapLocalPath( )				{ return m_MapLocalPath; }
 	bool GetMapLoadInGame( )				{ return m_MapLoadInGame; }
-	string *GetMapData( )					{ return &m_MapData; }
+	const unsigned char *GetMapData( )		{ return m_MapData ? m_MapData->GetData( ) : NULL; }
+	uint32_t GetMapDataSize( )				{ return m_MapData ? m_MapData->GetSize( ) : 0; }
 	uint32_t GetMapNumPlayers( )			{ return m_MapNumPlayers; }
 	uint32_t GetMapNumTeams( )				{ return m_MapNumTeams; }
 	vector<CGameSlot> GetSlots( )			{ return m_Slots; }
 
+	uint32_t GetMapPartCRC( uint32_t start );
+
 	void Load( map<string, string> nConfig );
 	void CheckValid( );
-	uint32_t XORRotateLeft( unsigned char *data, uint32_t length );
+	static uint32_t XORRotateLeft( unsigned char *data, uint32_t length );
+
+private:
+	string GetCacheStamp( string file );
+	bool LoadCache( string fileName, BYTEARRAY &mapCRC, BYTEARRAY &mapSHA1, uint32_t &mapOptions, BYTEARRAY &mapWidth, BYTEARRAY &mapHeight, uint32_t &mapNumPlayers, uint32_t &mapNumTeams, vector<CGameSlot> &slots );
+	void SaveCache( string fileName, BYTEARRAY mapCRC, BYTEARRAY mapSHA1, uint32_t mapOptions, BYTEARRAY mapWidth, BYTEARRAY mapHeight, uint32_t mapNumPlayers, uint32_t mapNumTeams, vector<CGameSlot> slots );
+};
+
+//
+// CMapLoad
+//
+
+// loads a map on its own thread so a big map doesn't stall the main loop while it's being read and hashed
+// the main loop polls GetReady and takes the map with GetMap once it's loaded
+
+class CMapLoad
+{
+private:
+	CMap *m_Map;
+	boost :: thread *m_Thread;
+	boost :: mutex m_Mutex;
+	bool m_Ready;
+	string m_MapPath;							// copied from CGHost when the load starts
+	string m_MapCFGPath;
+
+	void Load( CGHost *nGHost, map<string, string> nConfig );
+
+public:
+	CMapLoad( CGHost *nGHost, map<string, string> nConfig );
+	~CMapLoad( );
+
+	bool GetReady( );
+	CMap *GetMap( );
 };
 
 #endif
@@ -0,0 +1,357 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#include "ghost.h"
+#include "util.h"
+#include "socket.h"
+#include "metrics.h"
+
+CMetrics *gMetrics = NULL;
+
+// prometheus wants plain numbers, drop the trailing zeros UTIL_ToString leaves behind
+
+string FormatMetricValue( double value )
+{
+	string Result = UTIL_ToString( value, 6 );
+
+	if( Result.find( '.' ) != string :: npos )
+	{
+		Result.erase( Result.find_last_not_of( '0' ) + 1 );
+
+		if( !Result.empty( ) && Result[Result.size( ) - 1] == '.' )
+			Result.erase( Result.size( ) - 1 );
+	}
+
+	return Result;
+}
+
+string JoinMetricLabels( const string &labels, const string &extra )
+{
+	if( labels.empty( ) )
+		return extra.empty( ) ? string( ) : "{" + extra + "}";
+	else if( extra.empty( ) )
+		return "{" + labels + "}";
+	else
+		return "{" + labels + "," + extra + "}";
+}
+
+//
+// CMetricCounter
+//
+
+void CMetricCounter :: Render( const string &name, const string &labels, string &out )
+{
+	out += name + JoinMetricLabels( labels, string( ) ) + " " + UTIL_ToString( GetValue( ) ) + "\n";
+}
+
+//
+// CMetricGauge
+//
+
+void CMetricGauge :: Render( const string &name, const string &labels, string &out )
+{
+	out += name + JoinMetricLabels( labels, string( ) ) + " " + FormatMetricValue( (double)GetValue( ) ) + "\n";
+}
+
+//
+// CMetricHistogram
+//
+
+CMetricHistogram :: CMetricHistogram( const vector<uint64_t> &nBounds, double nScale ) : m_Bounds( nBounds ), m_Count( 0 ), m_Sum( 0 ), m_Scale( nScale )
+{
+	m_Buckets = new boost :: atomic<uint64_t>[m_Bounds.size( ) + 1];
+
+	for( uint32_t i = 0; i <= m_Bounds.size( ); i++ )
+		m_Buckets[i].store( 0 );
+}
+
+CMetricHistogram :: ~CMetricHistogram( )
+{
+	delete [] m_Buckets;
+}
+
+void CMetricHistogram :: Observe( uint64_t value )
+{
+	// the buckets are few and sorted so a linear search is as fast as anything else
+
+	uint32_t Bucket = 0;
+
+	while( Bucket < m_Bounds.size( ) && value > m_Bounds[Bucket] )
+		Bucket++;
+
+	m_Buckets[Bucket].fetch_add( 1, boost :: memory_order_relaxed );
+	m_Sum.fetch_add( value, boost :: memory_order_relaxed );
+	m_Count.fetch_add( 1, boost :: memory_order_relaxed );
+}
+
+void CMetricHistogram :: Render( const string &name, const string &labels, string &out )
+{
+	// the buckets are read one after another while other threads may be observing
+	// so the count is taken from the buckets we rendered to keep the +Inf bucket and the count consistent
+
+	uint64_t Cumulative = 0;
+
+	for( uint32_t i = 0; i < m_Bounds.size( ); i++ )
+	{
+		Cumulative += m_Buckets[i].load( boost :: memory_order_relaxed );
+		out += name + "_bucket" + JoinMetricLabels( labels, "le=\"" + FormatMetricValue( m_Bounds[i] / m_Scale ) + "\"" ) + " " + UTIL_ToString( Cumulative ) + "\n";
+	}
+
+	Cumulative += m_Buckets[m_Bounds.size( )].load( boost :: memory_order_relaxed );
+	out += name + "_bucket" + JoinMetricLabels( labels, "le=\"+Inf\"" ) + " " + UTIL_ToString( Cumulative ) + "\n";
+	out += name + "_sum" + JoinMetricLabels( labels, string( ) ) + " " + FormatMetricValue( m_Sum.load( boost :: memory_order_relaxed ) / m_Scale ) + "\n";
+	out += name + "_count" + JoinMetricLabels( labels, string( ) ) + " " + UTIL_ToString( Cumulative ) + "\n";
+}
+
+//
+// CMetrics
+//
+
+CMetrics :: CMetrics( )
+{
+
+}
+
+CMetrics :: ~CMetrics( )
+{
+	for( map<string, Family> :: iterator i = m_Families.begin( ); i != m_Families.end( ); i++ )
+	{
+		for( map<string, CMetric *> :: iterator j = i->second.Series.begin( ); j != i->second.Series.end( ); j++ )
+			delete j->second;
+	}
+}
+
+string CMetrics :: Label( const string &name, const string &value )
+{
+	string Escaped;
+
+	for( string :: const_iterator i = value.begin( ); i != value.end( ); i++ )
+	{
+		if( *i == '\\' )
+			Escaped += "\\\\";
+		else if( *i == '"' )
+			Escaped += "\\\"";
+		else if( *i == '\n' )
+			Escaped += "\\n";
+		else
+			Escaped += *i;
+	}
+
+	return name + "=\"" + Escaped + "\"";
+}
+
+vector<uint64_t> CMetrics :: MicrosecondBuckets( )
+{
+	uint64_t Bounds[] = { 10, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000 };
+	return vector<uint64_t>( Bounds, Bounds + sizeof( Bounds ) / sizeof( Bounds[0] ) );
+}
+
+vector<uint64_t> CMetrics :: MillisecondBuckets( )
+{
+	uint64_t Bounds[] = { 1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+	return vector<uint64_t>( Bounds, Bounds + sizeof( Bounds ) / sizeof( Bounds[0] ) );
+}
+
+vector<uint64_t> CMetrics :: RateBuckets( )
+{
+	uint64_t Bounds[] = { 10, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 100000 };
+	return vector<uint64_t>( Bounds, Bounds + sizeof( Bounds ) / sizeof( Bounds[0] ) );
+}
+
+vector<uint64_t> CMetrics :: CountBuckets( )
+{
+	uint64_t Bounds[] = { 0, 1, 2, 5, 10, 25, 50, 100, 250, 1000 };
+	return vector<uint64_t>( Bounds, Bounds + sizeof( Bounds ) / sizeof( Bounds[0] ) );
+}
+
+CMetric *CMetrics :: Find( const string &name, const string &labels )
+{
+	map<string, Family> :: iterator i = m_Families.find( name );
+
+	if( i == m_Families.end( ) )
+		return NULL;
+
+	map<string, CMetric *> :: iterator j = i->second.Series.find( labels );
+	return j == i->second.Series.end( ) ? NULL : j->second;
+}
+
+void CMetrics :: Add( const string &name, const string &help, const string &type, const string &labels, CMetric *metric )
+{
+	Family &F = m_Families[name];
+	F.Help = help;
+	F.Type = type;
+	F.Series[labels] = metric;
+}
+
+CMetricCounter *CMetrics :: Counter( const string &name, const string &help, const string &labels )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	CMetricCounter *Metric = dynamic_cast<CMetricCounter *>( Find( name, labels ) );
+
+	if( !Metric )
+	{
+		Metric = new CMetricCounter( );
+		Add( name, help, "counter", labels, Metric );
+	}
+
+	return Metric;
+}
+
+CMetricGauge *CMetrics :: Gauge( const string &name, const string &help, const string &labels )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	CMetricGauge *Metric = dynamic_cast<CMetricGauge *>( Find( name, labels ) );
+
+	if( !Metric )
+	{
+		Metric = new CMetricGauge( );
+		Add( name, help, "gauge", labels, Metric );
+	}
+
+	return Metric;
+}
+
+CMetricHistogram *CMetrics :: Histogram( const string &name, const string &help, const string &labels, const vector<uint64_t> &bounds, double scale )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	CMetricHistogram *Metric = dynamic_cast<CMetricHistogram *>( Find( name, labels ) );
+
+	if( !Metric )
+	{
+		Metric = new CMetricHistogram( bounds, scale );
+		Add( name, help, "histogram", labels, Metric );
+	}
+
+	return Metric;
+}
+
+void CMetrics :: Remove( const string &name, const string &labels )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	map<string, Family> :: iterator i = m_Families.find( name );
+
+	if( i == m_Families.end( ) )
+		return;
+
+	map<string, CMetric *> :: iterator j = i->second.Series.find( labels );
+
+	if( j != i->second.Series.end( ) )
+	{
+		delete j->second;
+		i->second.Series.erase( j );
+	}
+}
+
+string CMetrics :: Render( )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	string Result;
+
+	for( map<string, Family> :: iterator i = m_Families.begin( ); i != m_Families.end( ); i++ )
+	{
+		if( i->second.Series.empty( ) )
+			continue;
+
+		Result += "# HELP " + i->first + " " + i->second.Help + "\n";
+		Result += "# TYPE " + i->first + " " + i->second.Type + "\n";
+
+		for( map<string, CMetric *> :: iterator j = i->second.Series.begin( ); j != i->second.Series.end( ); j++ )
+			j->second->Render( i->first, j->first, Result );
+	}
+
+	return Result;
+}
+
+//
+// CMetricsServer
+//
+
+CMetricsServer :: CMetricsServer( )
+{
+	m_Socket = new CTCPServer( );
+}
+
+CMetricsServer :: ~CMetricsServer( )
+{
+	for( vector<CTCPSocket *> :: iterator i = m_Clients.begin( ); i != m_Clients.end( ); i++ )
+		delete *i;
+
+	delete m_Socket;
+}
+
+bool CMetricsServer :: Listen( string address, uint16_t port )
+{
+	return m_Socket->Listen( address, port );
+}
+
+void CMetricsServer :: Update( )
+{
+	CTCPSocket *NewSocket = m_Socket->Accept( );
+
+	if( NewSocket )
+		m_Clients.push_back( NewSocket );
+
+	for( vector<CTCPSocket *> :: iterator i = m_Clients.begin( ); i != m_Clients.end( ); )
+	{
+		// a client is done when the response has been flushed, we give up on clients which take more than 5 seconds
+
+		if( (*i)->HasError( ) || !(*i)->GetConnected( ) || GetTime( ) - (*i)->GetLastRecv( ) >= 5 )
+		{
+			m_Answered.erase( *i );
+			delete *i;
+			i = m_Clients.erase( i );
+			continue;
+		}
+
+		(*i)->DoRecv( );
+
+		if( (*i)->GetRecvSize( ) > 0 )
+		{
+			string Request( (char *)(*i)->GetRecvData( ), (*i)->GetRecvSize( ) );
+
+			if( m_Answered.find( *i ) != m_Answered.end( ) )
+				(*i)->ClearRecvBuffer( );
+			else if( Request.find( "\r\n\r\n" ) != string :: npos || Request.find( "\n\n" ) != string :: npos )
+			{
+				string Body = gMetrics->Render( );
+				(*i)->ClearRecvBuffer( );
+				(*i)->PutBytes( "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + UTIL_ToString( Body.size( ) ) + "\r\nConnection: close\r\n\r\n" + Body );
+				m_Answered.insert( *i );
+			}
+			else if( Request.size( ) > 8192 )
+			{
+				delete *i;
+				i = m_Clients.erase( i );
+				continue;
+			}
+		}
+
+		(*i)->DoSend( );
+
+		if( (*i)->GetSendSize( ) == 0 && m_Answered.find( *i ) != m_Answered.end( ) )
+		{
+			m_Answered.erase( *i );
+			delete *i;
+			i = m_Clients.erase( i );
+		}
+		else
+			i++;
+	}
+}
@@ -0,0 +1,157 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+
+//
+// metrics
+//
+
+// counters, gauges and histograms which can be updated from any thread without locking (every value is a relaxed atomic)
+// they're looked up (and created on first use) by name and labels in the CMetrics registry, which does lock, so hot paths keep the pointer around
+// a metric lives until it's removed from the registry or the registry is deleted, whoever removes it must make sure nobody is still using the pointer
+// the whole registry can be rendered in the Prometheus text exposition format and is served over HTTP by CMetricsServer
+
+class CMetric
+{
+public:
+	virtual ~CMetric( ) { }
+
+	virtual void Render( const string &name, const string &labels, string &out ) = 0;
+};
+
+class CMetricCounter : public CMetric
+{
+private:
+	boost :: atomic<uint64_t> m_Value;
+
+public:
+	CMetricCounter( ) : m_Value( 0 ) { }
+
+	void Add( uint64_t n )				{ m_Value.fetch_add( n, boost :: memory_order_relaxed ); }
+	uint64_t GetValue( )				{ return m_Value.load( boost :: memory_order_relaxed ); }
+
+	virtual void Render( const string &name, const string &labels, string &out );
+};
+
+class CMetricGauge : public CMetric
+{
+private:
+	boost :: atomic<int64_t> m_Value;
+
+public:
+	CMetricGauge( ) : m_Value( 0 ) { }
+
+	void Set( int64_t n )				{ m_Value.store( n, boost :: memory_order_relaxed ); }
+	void Add( int64_t n )				{ m_Value.fetch_add( n, boost :: memory_order_relaxed ); }
+	int64_t GetValue( )					{ return m_Value.load( boost :: memory_order_relaxed ); }
+
+	virtual void Render( const string &name, const string &labels, string &out );
+};
+
+class CMetricHistogram : public CMetric
+{
+private:
+	vector<uint64_t> m_Bounds;					// upper bound of each bucket in observed units, the +Inf bucket is implied
+	boost :: atomic<uint64_t> *m_Buckets;		// m_Bounds.size( ) + 1 non cumulative bucket counts
+	boost :: atomic<uint64_t> m_Count;
+	boost :: atomic<uint64_t> m_Sum;
+	double m_Scale;								// observed units per exported unit (e.g. 1000 when observing milliseconds for a _seconds metric)
+
+public:
+	CMetricHistogram( const vector<uint64_t> &nBounds, double nScale );
+	virtual ~CMetricHistogram( );
+
+	void Observe( uint64_t value );
+
+	virtual void Render( const string &name, const string &labels, string &out );
+};
+
+class CMetrics
+{
+private:
+	struct Family
+	{
+		string Help;
+		string Type;
+		map<string, CMetric *> Series;			// labels -> metric
+	};
+
+	boost :: mutex m_Mutex;						// protects m_Families, not the values
+	map<string, Family> m_Families;
+
+	CMetric *Find( const string &name, const string &labels );
+	void Add( const string &name, const string &help, const string &type, const string &labels, CMetric *metric );
+
+public:
+	CMetrics( );
+	~CMetrics( );
+
+	// the label string is the part between the braces, e.g. Label( "server", "europe" ) + "," + Label( "type", "chat" )
+
+	static string Label( const string &name, const string &value );
+
+	// microseconds (10 to 1000000), milliseconds (1 to 10000), kilobytes per second (10 to 100000) and plain count (0 to 1000) bucket bounds
+
+	static vector<uint64_t> MicrosecondBuckets( );
+	static vector<uint64_t> MillisecondBuckets( );
+	static vector<uint64_t> RateBuckets( );
+	static vector<uint64_t> CountBuckets( );
+
+	CMetricCounter *Counter( const string &name, const string &help, const string &labels = string( ) );
+	CMetricGauge *Gauge( const string &name, const string &help, const string &labels = string( ) );
+	CMetricHistogram *Histogram( const string &name, const string &help, const string &labels, const vector<uint64_t> &bounds, double scale );
+	void Remove( const string &name, const string &labels );
+
+	string Render( );
+};
+
+extern CMetrics *gMetrics;
+
+//
+// CMetricsServer
+//
+
+// a minimal HTTP/1.0 server for scraping the metrics, it runs on the main thread like every other socket we own
+// every request gets the whole registry no matter what was asked for and the connection is closed after the response
+
+class CTCPServer;
+class CTCPSocket;
+
+class CMetricsServer
+{
+private:
+	CTCPServer *m_Socket;
+	vector<CTCPSocket *> m_Clients;
+	set<CTCPSocket *> m_Answered;				// clients we've already put the response in the send buffer for
+
+public:
+	CMetricsServer( );
+	~CMetricsServer( );
+
+	bool Listen( string address, uint16_t port );
+	void Update( );
+};
+
+#endif
@@ -290,47 +290,83 @@ void CPacked :: Compress( bool TFT )
 	m_Compressed.clear( );
 
 	// compress data into blocks of size 8192 bytes
-	// use a buffer of size 8213 bytes because in the worst case zlib will grow the data 0.1% plus 12 bytes
 
-	uint32_t CompressedSize = 0;
 	string Padded = m_Decompressed;
 	Padded.append( 8192 - ( Padded.size( ) % 8192 ), 0 );
-	vector<string> CompressedBlocks;
-	string :: size_type Position = 0;
-	unsigned char *CompressedData = new unsigned char[8213];
+	string Blocks;
+	uint32_t NumBlocks = 0;
 
-	while( Position < Padded.size( ) )
+	for( string :: size_type Position = 0; Position < Padded.size( ); Position += 8192 )
 	{
-		uLongf BlockCompressedLong = 8213;
-		int Result = compress( CompressedData, &BlockCompressedLong, (const Bytef *)Padded.c_str( ) + Position, 8192 );
-
-		if( Result != Z_OK )
-		{
-			CONSOLE_Print( "[PACKED] compress error " + UTIL_ToString( Result ) );
-			delete [] CompressedData;
-			m_Valid = false;
+		if( !CompressBlock( (const unsigned char *)Padded.c_str( ) + Position, Blocks ) )
 			return;
-		}
 
-		CompressedBlocks.push_back( string( (char *)CompressedData, BlockCompressedLong ) );
-		CompressedSize += BlockCompressedLong;
-		Position += 8192;
+		NumBlocks++;
 	}
 
-	delete [] CompressedData;
+	CompressHeader( TFT, m_Decompressed.size( ), Blocks.size( ), NumBlocks );
+	m_Compressed += Blocks;
+}
+
+bool CPacked :: CompressBlock( const unsigned char *data, string &blocks )
+{
+	// compress exactly 8192 bytes of data and append the block (header and compressed data) to blocks
+	// use a buffer of size 8213 bytes because in the worst case zlib will grow the data 0.1% plus 12 bytes
+
+	unsigned char CompressedData[8213];
+	uLongf BlockCompressedLong = 8213;
+	int Result = compress( CompressedData, &BlockCompressedLong, (const Bytef *)data, 8192 );
+
+	if( Result != Z_OK )
+	{
+		CONSOLE_Print( "[PACKED] compress error " + UTIL_ToString( Result ) );
+		m_Valid = false;
+		return false;
+	}
+
+	BYTEARRAY BlockHeader;
+	UTIL_AppendByteArray( BlockHeader, (uint16_t)BlockCompressedLong, false );
+	UTIL_AppendByteArray( BlockHeader, (uint16_t)8192, false );
+
+	// append zero block header CRC
+
+	UTIL_AppendByteArray( BlockHeader, (uint32_t)0, false );
+
+	// calculate block header CRC
 
-	// build header
+	uint32_t CRC1 = m_CRC->FullCRC( (unsigned char *)&BlockHeader[0], BlockHeader.size( ) );
+	CRC1 = CRC1 ^ ( CRC1 >> 16 );
+	uint32_t CRC2 = m_CRC->FullCRC( CompressedData, BlockCompressedLong );
+	CRC2 = CRC2 ^ ( CRC2 >> 16 );
+	uint32_t BlockCRC = ( CRC1 & 0xFFFF ) | ( CRC2 << 16 );
+
+	// overwrite the block header CRC with the calculated CRC
+
+	BlockHeader.erase( BlockHeader.end( ) - 4, BlockHeader.end( ) );
+	UTIL_AppendByteArray( BlockHeader, BlockCRC, false );
+
+	// append block header and data
+
+	blocks += string( BlockHeader.begin( ), BlockHeader.end( ) );
+	blocks += string( (char *)CompressedData, BlockCompressedLong );
+	return true;
+}
+
+void CPacked :: CompressHeader( bool TFT, uint32_t decompressedSize, uint32_t blocksSize, uint32_t numBlocks )
+{
+	// replace m_Compressed with the header for numBlocks blocks taking up blocksSize bytes (including the block headers)
+	// the blocks themselves are appended by the caller
 
 	uint32_t HeaderSize = 68;
-	uint32_t HeaderCompressedSize = HeaderSize + CompressedSize + CompressedBlocks.size( ) * 8;
+	uint32_t HeaderCompressedSize = HeaderSize + blocksSize;
 	uint32_t HeaderVersion = 1;
 	BYTEARRAY Header;
 	UTIL_AppendByteArray( Header, "Warcraft III recorded game\x01A" );
 	UTIL_AppendByteArray( Header, HeaderSize, false );
 	UTIL_AppendByteArray( Header, HeaderCompressedSize, false );
 	UTIL_AppendByteArray( Header, HeaderVersion, false );
-	UTIL_AppendByteArray( Header, (uint32_t)m_Decompressed.size( ), false );
-	UTIL_AppendByteArray( Header, (uint32_t)CompressedBlocks.size( ), false );
+	UTIL_AppendByteArray( Header, decompressedSize, false );
+	UTIL_AppendByteArray( Header, numBlocks, false );
 
 	if( TFT )
 	{
@@ -367,40 +403,5 @@ void CPacked :: Compress( bool TFT )
 
 	Header.erase( Header.end( ) - 4, Header.end( ) );
 	UTIL_AppendByteArray( Header, CRC, false );
-
-	// append header
-
-	m_Compressed += string( Header.begin( ), Header.end( ) );
-
-	// append blocks
-
-	for( vector<string> :: iterator i = CompressedBlocks.begin( ); i != CompressedBlocks.end( ); i++ )
-	{
-		BYTEARRAY BlockHeader;
-		UTIL_AppendByteArray( BlockHeader, (uint16_t)(*i).size( ), false );
-		UTIL_AppendByteArray( BlockHeader, (uint16_t)8192, false );
-
-		// append zero block header CRC
-
-		UTIL_AppendByteArray( BlockHeader, (uint32_t)0, false );
-
-		// calculate block header CRC
-
-		string BlockHeaderString = string( BlockHeader.begin( ), BlockHeader.end( ) );
-		uint32_t CRC1 = m_CRC->FullCRC( (unsigned char *)BlockHeaderString.c_str( ), BlockHeaderString.size( ) );
-		CRC1 = CRC1 ^ ( CRC1 >> 16 );
-		uint32_t CRC2 = m_CRC->FullCRC( (unsigned char *)(*i).c_str( ), (*i).size( ) );
-		CRC2 = CRC2 ^ ( CRC2 >> 16 );
-		uint32_t BlockCRC = ( CRC1 & 0xFFFF ) | ( CRC2 << 16 );
-
-		// overwrite the block header CRC with the calculated CRC
-
-		BlockHeader.erase( BlockHeader.end( ) - 4, BlockHeader.end( ) );
-		UTIL_AppendByteArray( BlockHeader, BlockCRC, false );
-
-		// append block header and data
-
-		m_Compressed += string( BlockHeader.begin( ), BlockHeader.end( ) );
-		m_Compressed += *i;
-	}
+	m_Compressed = string( Header.begin( ), Header.end( ) );
 }
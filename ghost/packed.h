@@ -74,6 +74,10 @@ public:
 	virtual bool Pack( bool TFT, string inFileName, string outFileName );
 	virtual void Decompress( bool allBlocks );
 	virtual void Compress( bool TFT );
+
+protected:
+	virtual bool CompressBlock( const unsigned char *data, string &blocks );
+	virtual void CompressHeader( bool TFT, uint32_t decompressedSize, uint32_t blocksSize, uint32_t numBlocks );
 };
 
 #endif
@@ -0,0 +1,81 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#ifndef POOL_H
+#define POOL_H
+
+//
+// CPool
+//
+
+// a free list of objects which are allocated and deleted at a high rate (e.g. one per received packet)
+// 1.) Get returns a recycled object (or a new one if there aren't any) and Put takes it back instead of deleting it
+// 2.) recycled objects keep the memory they already allocated (e.g. the capacity of their byte arrays) so a warmed up pool rarely calls the allocator at all
+// 3.) at most m_MaxFree objects are kept, anything beyond that is deleted
+// 4.) a pool isn't thread safe, the games' pools are only used from the main thread
+// note: metrics.h must be included before this file
+
+template <class T> class CPool
+{
+private:
+	vector<T *> m_Free;
+	uint32_t m_MaxFree;
+	uint32_t m_Allocations;					// the number of new objects since the last ResetAllocations
+	CMetricCounter *m_AllocationCounter;
+	CMetricCounter *m_ReuseCounter;
+
+public:
+	CPool( uint32_t nMaxFree, CMetricCounter *nAllocationCounter, CMetricCounter *nReuseCounter ) : m_MaxFree( nMaxFree ), m_Allocations( 0 ), m_AllocationCounter( nAllocationCounter ), m_ReuseCounter( nReuseCounter ) { }
+
+	~CPool( )
+	{
+		for( typename vector<T *> :: iterator i = m_Free.begin( ); i != m_Free.end( ); i++ )
+			delete *i;
+	}
+
+	T *Get( )
+	{
+		if( m_Free.empty( ) )
+		{
+			m_Allocations++;
+			m_AllocationCounter->Add( 1 );
+			return new T( );
+		}
+
+		T *Object = m_Free.back( );
+		m_Free.pop_back( );
+		m_ReuseCounter->Add( 1 );
+		return Object;
+	}
+
+	void Put( T *object )
+	{
+		if( m_Free.size( ) < m_MaxFree )
+			m_Free.push_back( object );
+		else
+			delete object;
+	}
+
+	uint32_t GetNumFree( )					{ return m_Free.size( ); }
+	uint32_t GetAllocations( )				{ return m_Allocations; }
+	void ResetAllocations( )				{ m_Allocations = 0; }
+};
+
+#endif
@@ -0,0 +1,228 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#include "ghost.h"
+#include "util.h"
+#include "profilecache.h"
+
+//
+// CProfileCache
+//
+
+CProfileCache :: CProfileCache( uint32_t nTTL, uint32_t nMaxEntries )
+{
+	m_TTL = nTTL;
+	m_MaxEntries = nMaxEntries;
+	m_Hits = 0;
+	m_Misses = 0;
+}
+
+CProfileCache :: ~CProfileCache( )
+{
+
+}
+
+string CProfileCache :: GetKey( string name, const string &realm )
+{
+	// the name comes first so all of a player's realms are next to each other in the map (see Invalidate)
+	// a newline can't appear in a name or a realm
+
+	transform( name.begin( ), name.end( ), name.begin( ), (int(*)(int))tolower );
+	return name + "\n" + realm;
+}
+
+CProfileCache :: Entry *CProfileCache :: Find( const string &name, const string &realm )
+{
+	if( m_TTL == 0 )
+		return NULL;
+
+	map<string, Entry> :: iterator i = m_Entries.find( GetKey( name, realm ) );
+
+	if( i == m_Entries.end( ) )
+		return NULL;
+
+	if( GetTime( ) - i->second.Time >= m_TTL )
+	{
+		m_LRU.erase( i->second.LRU );
+		m_Entries.erase( i );
+		return NULL;
+	}
+
+	// move the entry to the front of the LRU list
+
+	m_LRU.splice( m_LRU.begin( ), m_LRU, i->second.LRU );
+	return &i->second;
+}
+
+CProfileCache :: Entry *CProfileCache :: Add( const string &name, const string &realm )
+{
+	if( m_TTL == 0 || m_MaxEntries == 0 )
+		return NULL;
+
+	Entry *Existing = Find( name, realm );
+
+	if( Existing )
+		return Existing;
+
+	while( m_Entries.size( ) >= m_MaxEntries )
+	{
+		m_Entries.erase( m_LRU.back( ) );
+		m_LRU.pop_back( );
+	}
+
+	string Key = GetKey( name, realm );
+	m_LRU.push_front( Key );
+	Entry &New = m_Entries[Key];
+	New.Time = GetTime( );
+	New.PlayerID = 0;
+	New.LRU = m_LRU.begin( );
+	return &New;
+}
+
+bool CProfileCache :: GetPlayerID( const string &name, const string &realm, uint32_t *playerID )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	Entry *Cached = Find( name, realm );
+
+	if( Cached && Cached->PlayerID != 0 )
+	{
+		*playerID = Cached->PlayerID;
+		m_Hits++;
+		return true;
+	}
+
+	m_Misses++;
+	return false;
+}
+
+bool CProfileCache :: GetScore( const string &name, const string &realm, uint32_t aliasID, double *score )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	Entry *Cached = Find( name, realm );
+
+	if( Cached )
+	{
+		map<uint32_t, double> :: iterator i = Cached->Scores.find( aliasID );
+
+		if( i != Cached->Scores.end( ) )
+		{
+			*score = i->second;
+			m_Hits++;
+			return true;
+		}
+	}
+
+	m_Misses++;
+	return false;
+}
+
+bool CProfileCache :: GetStats( const string &name, const string &realm, uint32_t aliasID, map<string, string> *stats )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	Entry *Cached = Find( name, realm );
+
+	if( Cached )
+	{
+		map<uint32_t, map<string, string> > :: iterator i = Cached->Stats.find( aliasID );
+
+		if( i != Cached->Stats.end( ) )
+		{
+			*stats = i->second;
+			m_Hits++;
+			return true;
+		}
+	}
+
+	m_Misses++;
+	return false;
+}
+
+bool CProfileCache :: GetCategoryScore( const string &name, const string &realm, const string &category, double *score )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	Entry *Cached = Find( name, realm );
+
+	if( Cached )
+	{
+		map<string, double> :: iterator i = Cached->CategoryScores.find( category );
+
+		if( i != Cached->CategoryScores.end( ) )
+		{
+			*score = i->second;
+			m_Hits++;
+			return true;
+		}
+	}
+
+	m_Misses++;
+	return false;
+}
+
+void CProfileCache :: SetPlayerID( const string &name, const string &realm, uint32_t playerID )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	Entry *Cached = Add( name, realm );
+
+	if( Cached )
+		Cached->PlayerID = playerID;
+}
+
+void CProfileCache :: SetScore( const string &name, const string &realm, uint32_t aliasID, double score )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	Entry *Cached = Add( name, realm );
+
+	if( Cached )
+		Cached->Scores[aliasID] = score;
+}
+
+void CProfileCache :: SetStats( const string &name, const string &realm, uint32_t aliasID, const map<string, string> &stats )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	Entry *Cached = Add( name, realm );
+
+	if( Cached )
+		Cached->Stats[aliasID] = stats;
+}
+
+void CProfileCache :: SetCategoryScore( const string &name, const string &realm, const string &category, double score )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	Entry *Cached = Add( name, realm );
+
+	if( Cached )
+		Cached->CategoryScores[category] = score;
+}
+
+void CProfileCache :: Invalidate( string name )
+{
+	// drop the player's entry on every realm, we don't always know which realm a saved game player joined from
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+	string Prefix = GetKey( name, string( ) );
+	map<string, Entry> :: iterator i = m_Entries.lower_bound( Prefix );
+
+	while( i != m_Entries.end( ) && i->first.compare( 0, Prefix.size( ), Prefix ) == 0 )
+	{
+		m_LRU.erase( i->second.LRU );
+		m_Entries.erase( i++ );
+	}
+}
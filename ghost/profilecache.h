@@ -0,0 +1,82 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#ifndef PROFILECACHE_H
+#define PROFILECACHE_H
+
+#include <list>
+#include <boost/thread/mutex.hpp>
+
+//
+// CProfileCache
+//
+
+// remembers what the database told us about a player when they joined so the regulars don't cost us the same queries in every lobby
+// entries are keyed by lowercase name and realm, they expire m_TTL seconds after they were created and the least recently used entry is dropped when the cache is full
+// a player's entries are invalidated when a game result containing them is saved because their score and stats changed
+// the running games use it from their game threads so every public function takes the lock
+
+class CProfileCache
+{
+private:
+	struct Entry
+	{
+		uint32_t Time;									// GetTime when the entry was created
+		uint32_t PlayerID;								// 0 if we don't know it
+		map<uint32_t, double> Scores;					// alias id -> score
+		map<uint32_t, map<string, string> > Stats;		// alias id -> stats (as used by the stats templates)
+		map<string, double> CategoryScores;				// matchmaking category -> score
+		list<string> :: iterator LRU;					// our position in m_LRU
+	};
+
+	map<string, Entry> m_Entries;						// "name\nrealm" -> entry
+	list<string> m_LRU;									// keys of m_Entries, most recently used first
+	uint32_t m_TTL;										// seconds, 0 disables the cache
+	uint32_t m_MaxEntries;
+	uint32_t m_Hits;
+	uint32_t m_Misses;
+	boost :: mutex m_Mutex;
+
+	static string GetKey( string name, const string &realm );
+	Entry *Find( const string &name, const string &realm );
+	Entry *Add( const string &name, const string &realm );
+
+public:
+	CProfileCache( uint32_t nTTL, uint32_t nMaxEntries );
+	~CProfileCache( );
+
+	uint32_t GetSize( )			{ return m_Entries.size( ); }
+	uint32_t GetHits( )			{ return m_Hits; }
+	uint32_t GetMisses( )		{ return m_Misses; }
+
+	bool GetPlayerID( const string &name, const string &realm, uint32_t *playerID );
+	bool GetScore( const string &name, const string &realm, uint32_t aliasID, double *score );
+	bool GetStats( const string &name, const string &realm, uint32_t aliasID, map<string, string> *stats );
+	bool GetCategoryScore( const string &name, const string &realm, const string &category, double *score );
+
+	void SetPlayerID( const string &name, const string &realm, uint32_t playerID );
+	void SetScore( const string &name, const string &realm, uint32_t aliasID, double score );
+	void SetStats( const string &name, const string &realm, uint32_t aliasID, const map<string, string> &stats );
+	void SetCategoryScore( const string &name, const string &realm, const string &category, double score );
+
+	void Invalidate( string name );
+};
+
+#endif
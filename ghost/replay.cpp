@@ -24,6 +24,8 @@
 #include "replay.h"
 #include "gameprotocol.h"
 
+#include <boost/bind.hpp>
+
 //
 // CReplay
 //
@@ -36,7 +38,10 @@ CReplay :: CReplay( ) : CPacked( )
 	m_RandomSeed = 0;
 	m_SelectMode = 0;
 	m_StartSpotCount = 0;
-	m_CompiledBlocks.reserve( 262144 );
+	m_Streaming = false;
+	m_StreamHeadSize = 0;
+	m_NumStreamedBlocks = 0;
+	m_CompiledBlocks.reserve( 16384 );
 }
 
 CReplay :: ~CReplay( )
@@ -53,6 +58,7 @@ void CReplay :: AddLeaveGame( uint32_t reason, unsigned char PID, uint32_t resul
 	UTIL_AppendByteArray( Block, result, false );
 	UTIL_AppendByteArray( Block, (uint32_t)1, false );
 	m_CompiledBlocks += string( Block.begin( ), Block.end( ) );
+	StreamBlocks( );
 }
 
 void CReplay :: AddLeaveGameDuringLoading( uint32_t reason, unsigned char PID, uint32_t result )
@@ -66,20 +72,18 @@ void CReplay :: AddLeaveGameDuringLoading( uint32_t reason, unsigned char PID, u
 	m_LoadingBlocks.push( Block );
 }
 
-void CReplay :: AddTimeSlot2( queue<CIncomingAction *> actions )
+void CReplay :: AddTimeSlot2( const vector<CIncomingAction *> &actions )
 {
 	BYTEARRAY Block;
 	Block.push_back( REPLAY_TIMESLOT2 );
 	UTIL_AppendByteArray( Block, (uint16_t)0, false );
 	UTIL_AppendByteArray( Block, (uint16_t)0, false );
 
-	while( !actions.empty( ) )
+	for( vector<CIncomingAction *> :: const_iterator i = actions.begin( ); i != actions.end( ); i++ )
 	{
-		CIncomingAction *Action = actions.front( );
-		actions.pop( );
-		Block.push_back( Action->GetPID( ) );
-		UTIL_AppendByteArray( Block, (uint16_t)Action->GetAction( )->size( ), false );
-		UTIL_AppendByteArrayFast( Block, *Action->GetAction( ) );
+		Block.push_back( (*i)->GetPID( ) );
+		UTIL_AppendByteArray( Block, (uint16_t)(*i)->GetAction( )->size( ), false );
+		UTIL_AppendByteArrayFast( Block, *(*i)->GetAction( ) );
 	}
 
 	// assign length
@@ -88,22 +92,21 @@ void CReplay :: AddTimeSlot2( queue<CIncomingAction *> actions )
 	Block[1] = LengthBytes[0];
 	Block[2] = LengthBytes[1];
 	m_CompiledBlocks += string( Block.begin( ), Block.end( ) );
+	StreamBlocks( );
 }
 
-void CReplay :: AddTimeSlot( uint16_t timeIncrement, queue<CIncomingAction *> actions )
+void CReplay :: AddTimeSlot( uint16_t timeIncrement, const vector<CIncomingAction *> &actions )
 {
 	BYTEARRAY Block;
 	Block.push_back( REPLAY_TIMESLOT );
 	UTIL_AppendByteArray( Block, (uint16_t)0, false );
 	UTIL_AppendByteArray( Block, timeIncrement, false );
 
-	while( !actions.empty( ) )
+	for( vector<CIncomingAction *> :: const_iterator i = actions.begin( ); i != actions.end( ); i++ )
 	{
-		CIncomingAction *Action = actions.front( );
-		actions.pop( );
-		Block.push_back( Action->GetPID( ) );
-		UTIL_AppendByteArray( Block, (uint16_t)Action->GetAction( )->size( ), false );
-		UTIL_AppendByteArrayFast( Block, *Action->GetAction( ) );
+		Block.push_back( (*i)->GetPID( ) );
+		UTIL_AppendByteArray( Block, (uint16_t)(*i)->GetAction( )->size( ), false );
+		UTIL_AppendByteArrayFast( Block, *(*i)->GetAction( ) );
 	}
 
 	// assign length
@@ -113,6 +116,7 @@ void CReplay :: AddTimeSlot( uint16_t timeIncrement, queue<CIncomingAction *> ac
 	Block[2] = LengthBytes[1];
 	m_CompiledBlocks += string( Block.begin( ), Block.end( ) );
 	m_ReplayLength += timeIncrement;
+	StreamBlocks( );
 }
 
 void CReplay :: AddChatMessage( unsigned char PID, unsigned char flags, uint32_t chatMode, string message )
@@ -131,6 +135,7 @@ void CReplay :: AddChatMessage( unsigned char PID, unsigned char flags, uint32_t
 	Block[2] = LengthBytes[0];
 	Block[3] = LengthBytes[1];
 	m_CompiledBlocks += string( Block.begin( ), Block.end( ) );
+	StreamBlocks( );
 }
 
 void CReplay :: AddLoadingBlock( BYTEARRAY &loadingBlock )
@@ -138,14 +143,55 @@ void CReplay :: AddLoadingBlock( BYTEARRAY &loadingBlock )
 	m_LoadingBlocks.push( loadingBlock );
 }
 
-void CReplay :: BuildReplay( string gameName, string statString, uint32_t war3Version, uint16_t buildNumber )
+void CReplay :: StartStreaming( string gameName, string statString )
 {
-	m_War3Version = war3Version;
-	m_BuildNumber = buildNumber;
-	m_Flags = 32768;
+	// the header holds the host's name which can change until the very end of the game (it's whoever leaves last)
+	// but changing the host just moves a player between the host record and the player list so the header's size is fixed once the game has loaded
+	// which means we know where every block boundary is and can compress each block as soon as it's full instead of holding the entire game in memory
+
+	uint32_t HeaderSize = BuildReplayHeader( gameName, statString ).size( );
+	m_StreamHeadSize = 8192 - HeaderSize % 8192;
+	m_Streaming = true;
+	StreamBlocks( );
+}
 
-	CONSOLE_Print( "[REPLAY] building replay" );
+void CReplay :: StreamBlocks( )
+{
+	if( !m_Streaming )
+		return;
+
+	string :: size_type Position = 0;
+
+	if( m_StreamHead.size( ) < m_StreamHeadSize )
+	{
+		Position = min( (string :: size_type)( m_StreamHeadSize - m_StreamHead.size( ) ), m_CompiledBlocks.size( ) );
+		m_StreamHead.append( m_CompiledBlocks, 0, Position );
+	}
+
+	if( m_StreamHead.size( ) == m_StreamHeadSize )
+	{
+		while( m_CompiledBlocks.size( ) - Position >= 8192 )
+		{
+			if( !CompressBlock( (const unsigned char *)m_CompiledBlocks.c_str( ) + Position, m_StreamedBlocks ) )
+			{
+				// the replay is already marked invalid, stop collecting data for it
+
+				m_Streaming = false;
+				m_CompiledBlocks.clear( );
+				return;
+			}
+
+			m_NumStreamedBlocks++;
+			Position += 8192;
+		}
+	}
+
+	if( Position > 0 )
+		m_CompiledBlocks.erase( 0, Position );
+}
 
+string CReplay :: BuildReplayHeader( string gameName, string statString )
+{
 	uint32_t LanguageID = 0x0012F8B0;
 
 	BYTEARRAY Replay;
@@ -202,19 +248,92 @@ void CReplay :: BuildReplay( string gameName, string statString, uint32_t war3Ve
 
 	// leavers during loading need to be stored between the second and third start blocks
 
-	while( !m_LoadingBlocks.empty( ) )
+	queue<BYTEARRAY> LoadingBlocks = m_LoadingBlocks;
+
+	while( !LoadingBlocks.empty( ) )
 	{
-		UTIL_AppendByteArray( Replay, m_LoadingBlocks.front( ) );
-		m_LoadingBlocks.pop( );
+		UTIL_AppendByteArray( Replay, LoadingBlocks.front( ) );
+		LoadingBlocks.pop( );
 	}
 
 	Replay.push_back( REPLAY_THIRDSTARTBLOCK );
 	UTIL_AppendByteArray( Replay, (uint32_t)1, false );
 
-	// done
+	return string( Replay.begin( ), Replay.end( ) );
+}
+
+void CReplay :: BuildReplay( string gameName, string statString, uint32_t war3Version, uint16_t buildNumber )
+{
+	m_War3Version = war3Version;
+	m_BuildNumber = buildNumber;
+	m_Flags = 32768;
+
+	CONSOLE_Print( "[REPLAY] building replay" );
+
+	m_Decompressed = BuildReplayHeader( gameName, statString );
+
+	if( m_Streaming )
+	{
+		if( m_Decompressed.size( ) % 8192 + m_StreamHeadSize != 8192 )
+		{
+			CONSOLE_Print( "[REPLAY] replay header changed size after the game loaded, unable to build replay" );
+			m_Valid = false;
+		}
+
+		m_Decompressed += m_StreamHead;
+		m_StreamHead.clear( );
+	}
+
+	// if no blocks were compressed yet everything left is compressed in one go as usual
+
+	if( m_NumStreamedBlocks == 0 )
+	{
+		m_Decompressed += m_CompiledBlocks;
+		m_CompiledBlocks.clear( );
+	}
+}
+
+void CReplay :: Compress( bool TFT )
+{
+	if( m_NumStreamedBlocks == 0 )
+	{
+		CPacked :: Compress( TFT );
+		return;
+	}
+
+	CONSOLE_Print( "[REPLAY] compressing data (" + UTIL_ToString( m_NumStreamedBlocks ) + " blocks already compressed)" );
+
+	// m_Decompressed holds the header and the data sharing its blocks which together end exactly on a block boundary
+	// then come the blocks compressed while the game was running and finally whatever is left in m_CompiledBlocks (less than one block) padded with zeros
 
-	m_Decompressed = string( Replay.begin( ), Replay.end( ) );
-	m_Decompressed += m_CompiledBlocks;
+	string Head;
+	string Tail;
+	uint32_t NumBlocks = m_NumStreamedBlocks;
+
+	for( string :: size_type Position = 0; Position < m_Decompressed.size( ); Position += 8192 )
+	{
+		if( !CompressBlock( (const unsigned char *)m_Decompressed.c_str( ) + Position, Head ) )
+			return;
+
+		NumBlocks++;
+	}
+
+	uint32_t DecompressedSize = m_Decompressed.size( ) + m_NumStreamedBlocks * 8192 + m_CompiledBlocks.size( );
+	m_CompiledBlocks.append( 8192 - ( m_CompiledBlocks.size( ) % 8192 ), 0 );
+
+	for( string :: size_type Position = 0; Position < m_CompiledBlocks.size( ); Position += 8192 )
+	{
+		if( !CompressBlock( (const unsigned char *)m_CompiledBlocks.c_str( ) + Position, Tail ) )
+			return;
+
+		NumBlocks++;
+	}
+
+	CompressHeader( TFT, DecompressedSize, Head.size( ) + m_StreamedBlocks.size( ) + Tail.size( ), NumBlocks );
+	m_Compressed += Head;
+	m_Compressed += m_StreamedBlocks;
+	m_Compressed += Tail;
+	string( ).swap( m_StreamedBlocks );
 }
 
 #define READB( x, y, z )	(x).read( (char *)(y), (z) )
@@ -580,3 +699,85 @@ void CReplay :: ParseReplay( bool parseBlocks )
 
 	m_Valid = true;
 }
+
+//
+// CReplayWriter
+//
+
+CReplayWriter :: CReplayWriter( )
+{
+	m_Exiting = false;
+
+	try
+	{
+		m_Thread = new boost :: thread( boost :: bind( &CReplayWriter :: ThreadLoop, this ) );
+	}
+	catch( const boost :: thread_resource_error &tre )
+	{
+		CONSOLE_Print( "[REPLAY] error spawning replay writer thread [" + string( tre.what( ) ) + "], replays will be saved on the main thread" );
+		m_Thread = NULL;
+	}
+}
+
+CReplayWriter :: ~CReplayWriter( )
+{
+	if( m_Thread )
+	{
+		{
+			boost :: mutex :: scoped_lock Lock( m_Mutex );
+			m_Exiting = true;
+		}
+
+		m_JobQueued.notify_one( );
+		m_Thread->join( );
+		delete m_Thread;
+	}
+}
+
+void CReplayWriter :: Save( CReplay *replay, bool TFT, string fileName )
+{
+	if( !m_Thread )
+	{
+		replay->Save( TFT, fileName );
+		delete replay;
+		return;
+	}
+
+	ReplayJob Job;
+	Job.Replay = replay;
+	Job.TFT = TFT;
+	Job.FileName = fileName;
+
+	{
+		boost :: mutex :: scoped_lock Lock( m_Mutex );
+		m_Jobs.push( Job );
+	}
+
+	m_JobQueued.notify_one( );
+}
+
+void CReplayWriter :: ThreadLoop( )
+{
+	while( true )
+	{
+		ReplayJob Job;
+
+		{
+			boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+			while( !m_Exiting && m_Jobs.empty( ) )
+				m_JobQueued.wait( Lock );
+
+			// finish the queued replays before exiting
+
+			if( m_Jobs.empty( ) )
+				return;
+
+			Job = m_Jobs.front( );
+			m_Jobs.pop( );
+		}
+
+		Job.Replay->Save( Job.TFT, Job.FileName );
+		delete Job.Replay;
+	}
+}
@@ -23,6 +23,8 @@
 
 #include "gameslot.h"
 
+#include <boost/thread.hpp>
+
 //
 // CReplay
 //
@@ -59,7 +61,12 @@ private:
 	queue<BYTEARRAY> m_LoadingBlocks;
 	queue<BYTEARRAY> m_Blocks;
 	queue<uint32_t> m_CheckSums;
-	string m_CompiledBlocks;
+	string m_CompiledBlocks;				// replay data that hasn't been compressed yet
+	bool m_Streaming;						// set once the game has loaded, from then on every full block of replay data is compressed right away
+	uint32_t m_StreamHeadSize;				// the amount of replay data sharing the first blocks with the header (those blocks can't be compressed until the header is final)
+	string m_StreamHead;					// the replay data sharing the first blocks with the header
+	string m_StreamedBlocks;				// the blocks compressed so far (each with its block header)
+	uint32_t m_NumStreamedBlocks;
 
 public:
 	CReplay( );
@@ -91,13 +98,49 @@ public:
 
 	void AddLeaveGame( uint32_t reason, unsigned char PID, uint32_t result );
 	void AddLeaveGameDuringLoading( uint32_t reason, unsigned char PID, uint32_t result );
-	void AddTimeSlot2( queue<CIncomingAction *> actions );
-	void AddTimeSlot( uint16_t timeIncrement, queue<CIncomingAction *> actions );
+	void AddTimeSlot2( const vector<CIncomingAction *> &actions );
+	void AddTimeSlot( uint16_t timeIncrement, const vector<CIncomingAction *> &actions );
 	void AddChatMessage( unsigned char PID, unsigned char flags, uint32_t chatMode, string message );
 	void AddLoadingBlock( BYTEARRAY &loadingBlock );
+	void StartStreaming( string gameName, string statString );
 	void BuildReplay( string gameName, string statString, uint32_t war3Version, uint16_t buildNumber );
+	virtual void Compress( bool TFT );
 
 	void ParseReplay( bool parseBlocks );
+
+private:
+	string BuildReplayHeader( string gameName, string statString );
+	void StreamBlocks( );
+};
+
+//
+// CReplayWriter
+//
+
+// finished replays are compressed and written to disk by a background thread so a game ending doesn't stall the main loop
+// the writer takes ownership of the replays it's given and deletes them once they've been saved
+
+struct ReplayJob {
+	CReplay *Replay;
+	bool TFT;
+	string FileName;
+};
+
+class CReplayWriter
+{
+private:
+	boost :: thread *m_Thread;
+	boost :: mutex m_Mutex;
+	boost :: condition_variable m_JobQueued;
+	queue<ReplayJob> m_Jobs;
+	bool m_Exiting;
+
+public:
+	CReplayWriter( );
+	~CReplayWriter( );						// waits for every queued replay to be saved
+
+	void Save( CReplay *replay, bool TFT, string fileName );
+	void ThreadLoop( );
 };
 
 #endif
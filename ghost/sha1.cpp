@@ -19,9 +19,23 @@
 
 #include "sha1.h"
 
+// the SHA-NI transformation is compiled for that instruction set on its own and only used if CPUID says it's supported
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define SHA1_X86
+	#define SHA1_TARGET_SHANI __attribute__((target("sse2,ssse3,sse4.1,sha")))
+	#include <cpuid.h>
+	#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#define SHA1_X86
+	#define SHA1_TARGET_SHANI
+	#include <intrin.h>
+#endif
+
 
 CSHA1::CSHA1()
 {
+	m_Hardware = HasHardware();
 	Reset();
 }
 
@@ -48,8 +62,9 @@ void CSHA1::Transform(uint32_t state[5], unsigned char buffer[64])
 {
 	uint32_t a = 0, b = 0, c = 0, d = 0, e = 0;
 
+	// Not static, several threads can be hashing at once
 	SHA1_WORKSPACE_BLOCK* block;
-	static unsigned char workspace[64];
+	uint32_t workspace[16];
 	block = (SHA1_WORKSPACE_BLOCK *)workspace;
 	memcpy(block, buffer, 64);
 
@@ -93,6 +108,111 @@ void CSHA1::Transform(uint32_t state[5], unsigned char buffer[64])
 	a = 0; b = 0; c = 0; d = 0; e = 0;
 }
 
+#ifdef SHA1_X86
+
+static bool SHA1_HasSHANI()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+
+	if(info[0] < 7)
+		return false;
+
+	__cpuid(info, 1);
+	bool sse41 = (info[2] & (1 << 19)) != 0;
+	bool ssse3 = (info[2] & (1 << 9)) != 0;
+	__cpuidex(info, 7, 0);
+	return sse41 && ssse3 && (info[1] & (1 << 29)) != 0;
+#else
+	unsigned int eax, ebx, ecx, edx;
+
+	if(__get_cpuid_max(0, 0) < 7 || !__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return false;
+
+	bool sse41 = (ecx & bit_SSE4_1) != 0;
+	bool ssse3 = (ecx & bit_SSSE3) != 0;
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return sse41 && ssse3 && (ebx & (1 << 29)) != 0;
+#endif
+}
+
+// Four rounds at a time with the SHA extensions, the message schedule is computed four words at a time too
+// W[g] = sha1msg2(sha1msg1(W[g-4], W[g-3]) ^ W[g-2], W[g-1]) for every group of four words past the first sixteen
+
+SHA1_TARGET_SHANI static void SHA1_TransformSHANI(uint32_t state[5], unsigned char *data, uint32_t blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+
+	__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)state), 0x1B);
+	__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+	for (; blocks > 0; blocks--, data += 64)
+	{
+		__m128i abcd_save = abcd;
+		__m128i e0_save = e0;
+		__m128i msg[4];
+		__m128i e1 = e0;
+
+		// Fully unrolled the switch below disappears and the message schedule overlaps the rounds
+#if defined(__GNUC__) && __GNUC__ >= 8
+		#pragma GCC unroll 20
+#endif
+		for (int g = 0; g < 20; g++)
+		{
+			if (g < 4)
+				msg[g] = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)(data + g * 16)), mask);
+			else
+				msg[g & 3] = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(msg[g & 3], msg[(g + 1) & 3]), msg[(g + 2) & 3]), msg[(g + 3) & 3]);
+
+			// e1 holds a from four rounds ago (which becomes e) except before the first group where it's just e
+
+			__m128i e = g == 0 ? _mm_add_epi32(e1, msg[0]) : _mm_sha1nexte_epu32(e1, msg[g & 3]);
+			e1 = abcd;
+
+			switch (g / 5)
+			{
+				case 0: abcd = _mm_sha1rnds4_epu32(abcd, e, 0); break;
+				case 1: abcd = _mm_sha1rnds4_epu32(abcd, e, 1); break;
+				case 2: abcd = _mm_sha1rnds4_epu32(abcd, e, 2); break;
+				default: abcd = _mm_sha1rnds4_epu32(abcd, e, 3); break;
+			}
+		}
+
+		e0 = _mm_sha1nexte_epu32(e1, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+	}
+
+	_mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1B));
+	state[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+#endif
+
+bool CSHA1::HasHardware()
+{
+#ifdef SHA1_X86
+	static const bool hasSHANI = SHA1_HasSHANI();
+	return hasSHANI;
+#else
+	return false;
+#endif
+}
+
+void CSHA1::TransformBlocks(uint32_t state[5], unsigned char *data, uint32_t blocks)
+{
+#ifdef SHA1_X86
+	if(m_Hardware)
+	{
+		SHA1_TransformSHANI(state, data, blocks);
+		return;
+	}
+#endif
+
+	for (; blocks > 0; blocks--, data += 64)
+		Transform(state, data);
+}
+
 // Use this function to hash in binary data and strings
 void CSHA1::Update(unsigned char* data, unsigned int len)
 {
@@ -107,11 +227,13 @@ void CSHA1::Update(unsigned char* data, unsigned int len)
 	if((j + len) > 63)
 	{
 		memcpy(&m_buffer[j], data, (i = 64 - j));
-		Transform(m_state, m_buffer);
+		TransformBlocks(m_state, m_buffer, 1);
 
-		for (; i+63 < len; i += 64)
+		if (i+63 < len)
 		{
-			Transform(m_state, &data[i]);
+			uint32_t blocks = (len - i) / 64;
+			TransformBlocks(m_state, &data[i], blocks);
+			i += blocks * 64;
 		}
 
 		j = 0;
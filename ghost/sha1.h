@@ -83,9 +83,17 @@ public:
 	void ReportHash(char *szReport, unsigned char uReportType = REPORT_HEX);
 	void GetHash(unsigned char *uDest);
 
+	// Use the SHA extensions (SHA-NI) when the CPU supports them, this is the default
+	static bool HasHardware();
+	void SetHardware(bool hardware) { m_Hardware = hardware && HasHardware(); }
+	bool GetHardware() { return m_Hardware; }
+
 private:
+	bool m_Hardware;
+
 	// Private SHA-1 transformation
 	void Transform(uint32_t state[5], unsigned char buffer[64]);
+	void TransformBlocks(uint32_t state[5], unsigned char *data, uint32_t blocks);
 };
 
 #endif // ___SHA1_H___
@@ -21,13 +21,26 @@
 #include "ghost.h"
 #include "util.h"
 #include "socket.h"
+#include "metrics.h"
 
 #include <string.h>
 
+#ifndef WIN32
+ #include <sys/uio.h>
+#endif
+
+#ifdef __linux__
+ #include <sys/epoll.h>
+ #include <sys/timerfd.h>
+ #include <sys/eventfd.h>
+#endif
+
 #ifndef WIN32
  int GetLastError( ) { return errno; }
 #endif
 
+CSocketPoller *gSocketPoller = NULL;
+
 //
 // CSocket
 //
@@ -38,6 +51,10 @@ CSocket :: CSocket( )
 	memset( &m_SIN, 0, sizeof( m_SIN ) );
 	m_HasError = false;
 	m_Error = 0;
+	m_Poller = NULL;
+	m_Registered = false;
+	m_Readable = false;
+	m_Writable = false;
 }
 
 CSocket :: CSocket( SOCKET nSocket, struct sockaddr_in nSIN )
@@ -46,10 +63,16 @@ CSocket :: CSocket( SOCKET nSocket, struct sockaddr_in nSIN )
 	m_SIN = nSIN;
 	m_HasError = false;
 	m_Error = 0;
+	m_Poller = NULL;
+	m_Registered = false;
+	m_Readable = false;
+	m_Writable = false;
 }
 
 CSocket :: ~CSocket( )
 {
+	Unregister( );
+
 	if( m_Socket != INVALID_SOCKET )
 		closesocket( m_Socket );
 }
@@ -117,18 +140,53 @@ string CSocket :: GetErrorString( )
 	return "UNKNOWN ERROR (" + UTIL_ToString( m_Error ) + ")";
 }
 
-void CSocket :: SetFD( fd_set *fd, fd_set *send_fd, int *nfds )
+void CSocket :: Register( bool watchWritable )
 {
-	if( m_Socket == INVALID_SOCKET )
+	// sockets are created on the main thread so they start out on its poller
+
+	if( !m_Poller )
+		m_Poller = gSocketPoller;
+
+	if( m_Socket == INVALID_SOCKET || m_Registered || !m_Poller )
 		return;
 
-	FD_SET( m_Socket, fd );
-	FD_SET( m_Socket, send_fd );
+	// a socket which isn't watched for writability (i.e. it isn't connecting) is assumed to be writable until a send would block
 
-#ifndef WIN32
-	if( m_Socket > *nfds )
-		*nfds = m_Socket;
-#endif
+	m_Readable = false;
+	m_Writable = !watchWritable;
+	m_Poller->Add( this, watchWritable );
+	m_Registered = true;
+}
+
+void CSocket :: Unregister( )
+{
+	if( !m_Registered )
+		return;
+
+	if( m_Poller )
+		m_Poller->Remove( this );
+
+	m_Registered = false;
+	m_Readable = false;
+	m_Writable = false;
+}
+
+void CSocket :: Detach( )
+{
+	// called by the thread which owns the socket right before handing it to another thread, which then calls Attach
+	// in between the socket isn't registered anywhere so no poller can flag it while it's changing hands
+
+	Unregister( );
+	m_Poller = NULL;
+}
+
+void CSocket :: Attach( CSocketPoller *poller )
+{
+	// any data which arrived in the meantime is reported again because the pollers are level triggered for reads
+	// we don't know if a send would have blocked so the socket is watched for writability until the new poller says it's writable
+
+	m_Poller = poller;
+	Register( true );
 }
 
 void CSocket :: Allocate( int type )
@@ -146,6 +204,8 @@ void CSocket :: Allocate( int type )
 
 void CSocket :: Reset( )
 {
+	Unregister( );
+
 	if( m_Socket != INVALID_SOCKET )
 		closesocket( m_Socket );
 
@@ -163,8 +223,14 @@ CTCPSocket :: CTCPSocket( ) : CSocket( )
 {
 	Allocate( SOCK_STREAM );
 	m_Connected = false;
+	m_RecvStart = 0;
+	m_RecvEnd = 0;
+	m_SendOffset = 0;
+	m_SendSize = 0;
 	m_LastRecv = GetTime( );
 	m_LastSend = GetTime( );
+	m_BytesReceived = NULL;
+	m_BytesSent = NULL;
 
 	// make socket non blocking
 
@@ -179,8 +245,14 @@ CTCPSocket :: CTCPSocket( ) : CSocket( )
 CTCPSocket :: CTCPSocket( SOCKET nSocket, struct sockaddr_in nSIN ) : CSocket( nSocket, nSIN )
 {
 	m_Connected = true;
+	m_RecvStart = 0;
+	m_RecvEnd = 0;
+	m_SendOffset = 0;
+	m_SendSize = 0;
 	m_LastRecv = GetTime( );
 	m_LastSend = GetTime( );
+	m_BytesReceived = NULL;
+	m_BytesSent = NULL;
 
 	// make socket non blocking
 
@@ -204,7 +276,9 @@ void CTCPSocket :: Reset( )
 	Allocate( SOCK_STREAM );
 	m_Connected = false;
 	m_RecvBuffer.clear( );
-	m_SendBuffer.clear( );
+	m_RecvStart = 0;
+	m_RecvEnd = 0;
+	ClearSendBuffer( );
 	m_LastRecv = GetTime( );
 	m_LastSend = GetTime( );
 
@@ -232,74 +306,172 @@ void CTCPSocket :: Reset( )
 
 void CTCPSocket :: PutBytes( string bytes )
 {
-	m_SendBuffer += bytes;
+	BYTEARRAY Bytes = BYTEARRAY( bytes.begin( ), bytes.end( ) );
+	PutBytes( UTIL_CreateSharedByteArray( Bytes ) );
 }
 
 void CTCPSocket :: PutBytes( BYTEARRAY bytes )
 {
-	m_SendBuffer += string( bytes.begin( ), bytes.end( ) );
+	PutBytes( UTIL_CreateSharedByteArray( bytes ) );
 }
 
-void CTCPSocket :: DoRecv( fd_set *fd )
+void CTCPSocket :: PutBytes( SHAREDBYTEARRAY bytes )
+{
+	if( !bytes || bytes->empty( ) )
+		return;
+
+	m_SendQueue.push_back( bytes );
+	m_SendSize += bytes->size( );
+}
+
+void CTCPSocket :: ConsumeRecvBytes( uint32_t length )
+{
+	if( length >= m_RecvEnd - m_RecvStart )
+	{
+		// everything has been consumed, start filling from the beginning of the buffer again
+
+		m_RecvStart = 0;
+		m_RecvEnd = 0;
+	}
+	else
+		m_RecvStart += length;
+}
+
+void CTCPSocket :: DoRecv( )
 {
 	if( m_Socket == INVALID_SOCKET || m_HasError || !m_Connected )
 		return;
 
-	if( FD_ISSET( m_Socket, fd ) )
+	if( m_Readable )
 	{
 		// data is waiting, receive it
+		// the pollers are level triggered for reads so if there's more data waiting we'll be told again on the next loop
 
-		char buffer[1024];
-		int c = recv( m_Socket, buffer, 1024, 0 );
-                
-		if( c == SOCKET_ERROR && GetLastError( ) != EWOULDBLOCK )
-		{
-			// receive error
+		// we receive directly into the free space at the end of the receive buffer and keep going until the socket is drained
+		// there's a limit per call so a single flooding socket can't starve everyone else, the poller will report it again next loop
 
-			m_HasError = true;
-			m_Error = GetLastError( );
-			CONSOLE_Print( "[TCPSOCKET] error (recv) - " + GetErrorString( ) );
-			return;
-		}
-		else if( c == 0 )
-		{
-			// the other end closed the connection
+		m_Readable = false;
+		uint32_t Received = 0;
 
-			CONSOLE_Print( "[TCPSOCKET] closed by remote host" );
-			m_Connected = false;
-		}
-		else if( c > 0 )
+		while( Received < TCPSOCKET_RECV_LIMIT )
 		{
-			// success! add the received data to the buffer
-
-			if( !m_LogFile.empty( ) )
+			if( m_RecvBuffer.size( ) - m_RecvEnd < TCPSOCKET_RECV_CHUNK )
 			{
-				ofstream Log;
-				Log.open( m_LogFile.c_str( ), ios :: app );
+				// not enough free space at the end of the buffer
+				// move the unconsumed data (usually a partial packet) to the front and only grow the buffer if that didn't help
 
-				if( !Log.fail( ) )
+				if( m_RecvStart > 0 )
 				{
-					Log << "					RECEIVE <<< " << UTIL_ByteArrayToHexString( UTIL_CreateByteArray( (unsigned char *)buffer, c ) ) << endl;
-					Log.close( );
+					memmove( &m_RecvBuffer[0], &m_RecvBuffer[m_RecvStart], m_RecvEnd - m_RecvStart );
+					m_RecvEnd -= m_RecvStart;
+					m_RecvStart = 0;
 				}
+
+				if( m_RecvBuffer.size( ) - m_RecvEnd < TCPSOCKET_RECV_CHUNK )
+					m_RecvBuffer.resize( m_RecvEnd + TCPSOCKET_RECV_CHUNK );
 			}
 
-			m_RecvBuffer += string( buffer, c );
-			m_LastRecv = GetTime( );
+			int Free = m_RecvBuffer.size( ) - m_RecvEnd;
+			int c = recv( m_Socket, (char *)&m_RecvBuffer[m_RecvEnd], Free, 0 );
+
+			if( c == SOCKET_ERROR && GetLastError( ) != EWOULDBLOCK )
+			{
+				// receive error
+				// stop polling the socket, otherwise the poller would keep reporting it until the owner gets around to deleting it
+
+				m_HasError = true;
+				m_Error = GetLastError( );
+				CONSOLE_Print( "[TCPSOCKET] error (recv) - " + GetErrorString( ) );
+				Unregister( );
+				return;
+			}
+			else if( c == 0 )
+			{
+				// the other end closed the connection
+				// note: GProxy++ players keep their closed socket around until they reconnect so stop polling it here
+
+				CONSOLE_Print( "[TCPSOCKET] closed by remote host" );
+				m_Connected = false;
+				Unregister( );
+				return;
+			}
+			else if( c > 0 )
+			{
+				// success! the received data is already in the buffer
+
+				if( !m_LogFile.empty( ) )
+				{
+					ofstream Log;
+					Log.open( m_LogFile.c_str( ), ios :: app );
+
+					if( !Log.fail( ) )
+					{
+						Log << "					RECEIVE <<< " << UTIL_ByteArrayToHexString( UTIL_CreateByteArray( &m_RecvBuffer[m_RecvEnd], c ) ) << endl;
+						Log.close( );
+					}
+				}
+
+				m_RecvEnd += c;
+				m_LastRecv = GetTime( );
+				Received += c;
+
+				if( m_BytesReceived )
+					m_BytesReceived->Add( c );
+
+				// a short read means the socket is drained
+
+				if( c < Free )
+					return;
+			}
+			else
+				return;
 		}
 	}
 }
 
-void CTCPSocket :: DoSend( fd_set *send_fd )
+void CTCPSocket :: DoSend( )
 {
-	if( m_Socket == INVALID_SOCKET || m_HasError || !m_Connected || m_SendBuffer.empty( ) )
+	if( m_Socket == INVALID_SOCKET || m_HasError || !m_Connected || m_SendQueue.empty( ) )
 		return;
 
-	if( FD_ISSET( m_Socket, send_fd ) )
+	if( m_Writable )
 	{
-		// socket is ready, send it
+		// socket is ready, send as much of the queue as possible with a single gather write
+		// the queued byte arrays are handed to the kernel as they are so nothing is copied into a contiguous buffer first
+
+#ifdef WIN32
+		WSABUF Buffers[TCPSOCKET_SEND_BUFFERS];
+#else
+		struct iovec Buffers[TCPSOCKET_SEND_BUFFERS];
+#endif
+		unsigned int NumBuffers = 0;
+		uint32_t Queued = 0;
+
+		for( deque<SHAREDBYTEARRAY> :: iterator i = m_SendQueue.begin( ); i != m_SendQueue.end( ) && NumBuffers < TCPSOCKET_SEND_BUFFERS; i++ )
+		{
+			uint32_t Offset = i == m_SendQueue.begin( ) ? m_SendOffset : 0;
 
-		int s = send( m_Socket, m_SendBuffer.c_str( ), (int)m_SendBuffer.size( ), MSG_NOSIGNAL );
+#ifdef WIN32
+			Buffers[NumBuffers].buf = (char *)&(**i)[Offset];
+			Buffers[NumBuffers].len = (*i)->size( ) - Offset;
+#else
+			Buffers[NumBuffers].iov_base = (void *)&(**i)[Offset];
+			Buffers[NumBuffers].iov_len = (*i)->size( ) - Offset;
+#endif
+			Queued += (*i)->size( ) - Offset;
+			NumBuffers++;
+		}
+
+#ifdef WIN32
+		DWORD Sent = 0;
+		int s = WSASend( m_Socket, Buffers, NumBuffers, &Sent, 0, NULL, NULL ) == SOCKET_ERROR ? SOCKET_ERROR : (int)Sent;
+#else
+		struct msghdr Message;
+		memset( &Message, 0, sizeof( Message ) );
+		Message.msg_iov = Buffers;
+		Message.msg_iovlen = NumBuffers;
+		int s = sendmsg( m_Socket, &Message, MSG_NOSIGNAL );
+#endif
 
 		if( s == SOCKET_ERROR && GetLastError( ) != EWOULDBLOCK )
 		{
@@ -310,9 +482,44 @@ void CTCPSocket :: DoSend( fd_set *send_fd )
 			CONSOLE_Print( "[TCPSOCKET] error (send) - " + GetErrorString( ) );
 			return;
 		}
-		else if( s > 0 )
+
+		if( s == SOCKET_ERROR || s < (int)Queued )
 		{
-			// success! only some of the data may have been sent, remove it from the buffer
+			// the socket's send buffer is full, ask the poller to tell us when there's room again
+
+			m_Writable = false;
+
+			if( m_Registered && m_Poller )
+				m_Poller->WatchWritable( this, true );
+		}
+
+		if( s > 0 )
+		{
+			// success! only some of the data may have been sent, remove it from the queue
+
+			BYTEARRAY SentBytes;
+			uint32_t Remaining = s;
+
+			while( Remaining > 0 )
+			{
+				SHAREDBYTEARRAY Front = m_SendQueue.front( );
+				uint32_t Length = Front->size( ) - m_SendOffset;
+
+				if( Remaining < Length )
+					Length = Remaining;
+
+				if( !m_LogFile.empty( ) )
+					SentBytes.insert( SentBytes.end( ), Front->begin( ) + m_SendOffset, Front->begin( ) + m_SendOffset + Length );
+
+				Remaining -= Length;
+				m_SendOffset += Length;
+
+				if( m_SendOffset == Front->size( ) )
+				{
+					m_SendQueue.pop_front( );
+					m_SendOffset = 0;
+				}
+			}
 
 			if( !m_LogFile.empty( ) )
 			{
@@ -321,13 +528,16 @@ void CTCPSocket :: DoSend( fd_set *send_fd )
 
 				if( !Log.fail( ) )
 				{
-					Log << "SEND >>> " << UTIL_ByteArrayToHexString( BYTEARRAY( m_SendBuffer.begin( ), m_SendBuffer.begin( ) + s ) ) << endl;
+					Log << "SEND >>> " << UTIL_ByteArrayToHexString( SentBytes ) << endl;
 					Log.close( );
 				}
 			}
 
-			m_SendBuffer = m_SendBuffer.substr( s );
+			m_SendSize -= s;
 			m_LastSend = GetTime( );
+
+			if( m_BytesSent )
+				m_BytesSent->Add( s );
 		}
 	}
 }
@@ -337,9 +547,21 @@ void CTCPSocket :: Disconnect( )
 	if( m_Socket != INVALID_SOCKET )
 		shutdown( m_Socket, SHUT_RDWR );
 
+	Unregister( );
 	m_Connected = false;
 }
 
+void CTCPSocket :: SetMetricsClass( string metricsClass )
+{
+	// the traffic of every socket of the same class is added up in one pair of counters
+
+	if( gMetrics )
+	{
+		m_BytesReceived = gMetrics->Counter( "ghost_socket_received_bytes_total", "Bytes received on TCP sockets.", CMetrics :: Label( "class", metricsClass ) );
+		m_BytesSent = gMetrics->Counter( "ghost_socket_sent_bytes_total", "Bytes sent on TCP sockets.", CMetrics :: Label( "class", metricsClass ) );
+	}
+}
+
 void CTCPSocket :: SetNoDelay( bool noDelay )
 {
 	int OptVal = 0;
@@ -436,6 +658,9 @@ void CTCPClient :: Connect( string localaddress, string address, uint16_t port )
 		}
 	}
 
+	// the socket becomes writable when the connection attempt completes
+
+	Register( true );
 	m_Connecting = true;
 }
 
@@ -444,28 +669,10 @@ bool CTCPClient :: CheckConnect( )
 	if( m_Socket == INVALID_SOCKET || m_HasError || !m_Connecting )
 		return false;
 
-	fd_set fd;
-	FD_ZERO( &fd );
-	FD_SET( m_Socket, &fd );
-
-	struct timeval tv;
-	tv.tv_sec = 0;
-	tv.tv_usec = 0;
-
 	// check if the socket is connected
+	// the socket was registered with the poller in Connect so it'll report the socket as writable when the attempt completes
 
-#ifdef WIN32
-	if( select( 1, NULL, &fd, NULL, &tv ) == SOCKET_ERROR )
-#else
-	if( select( m_Socket + 1, NULL, &fd, NULL, &tv ) == SOCKET_ERROR )
-#endif
-	{
-		m_HasError = true;
-		m_Error = GetLastError( );
-		return false;
-	}
-
-	if( FD_ISSET( m_Socket, &fd ) )
+	if( m_Writable )
 	{
 		m_Connecting = false;
 		m_Connected = true;
@@ -532,17 +739,21 @@ bool CTCPServer :: Listen( string address, uint16_t port )
 		return false;
 	}
 
+	Register( false );
 	return true;
 }
 
-CTCPSocket *CTCPServer :: Accept( fd_set *fd )
+CTCPSocket *CTCPServer :: Accept( )
 {
 	if( m_Socket == INVALID_SOCKET || m_HasError )
 		return NULL;
 
-	if( FD_ISSET( m_Socket, fd ) )
+	if( m_Readable )
 	{
 		// a connection is waiting, accept it
+		// if more than one connection is waiting the poller will report the socket as readable again on the next loop
+
+		m_Readable = false;
 
 		struct sockaddr_in Addr;
 		int AddrLen = sizeof( Addr );
@@ -558,9 +769,11 @@ CTCPSocket *CTCPServer :: Accept( fd_set *fd )
 		}
 		else
 		{
-			// success! return the new socket
+			// success! register and return the new socket
 
-			return new CTCPSocket( NewSocket, Addr );
+			CTCPSocket *Socket = new CTCPSocket( NewSocket, Addr );
+			Socket->Register( false );
+			return Socket;
 		}
 	}
 
@@ -736,6 +949,7 @@ bool CUDPServer :: Bind( struct sockaddr_in sin )
 		return false;
 	}
 
+	Register( false );
 	return true;
 }
 
@@ -760,17 +974,19 @@ bool CUDPServer :: Bind( string address, uint16_t port )
 	return Bind( sin );
 }
 
-void CUDPServer :: RecvFrom( fd_set *fd, struct sockaddr_in *sin, string *message )
+void CUDPServer :: RecvFrom( struct sockaddr_in *sin, string *message )
 {
 	if( m_Socket == INVALID_SOCKET || m_HasError || !sin || !message )
 		return;
 
 	int AddrLen = sizeof( *sin );
 
-	if( FD_ISSET( m_Socket, fd ) )
+	if( m_Readable )
 	{
 		// data is waiting, receive it
 
+		m_Readable = false;
+
 		char buffer[1024];
 
 #ifdef WIN32
@@ -795,3 +1011,337 @@ void CUDPServer :: RecvFrom( fd_set *fd, struct sockaddr_in *sin, string *messag
 		}
 	}
 }
+
+//
+// CSocketPoller
+//
+
+CSocketPoller :: CSocketPoller( )
+{
+
+}
+
+CSocketPoller :: ~CSocketPoller( )
+{
+
+}
+
+CSocketPoller *CSocketPoller :: Create( string method )
+{
+	// use the best backend available on this platform unless the select backend was specifically requested
+
+#ifdef __linux__
+	if( method != "select" )
+	{
+		CEPollPoller *Poller = new CEPollPoller( );
+
+		if( Poller->GetValid( ) )
+			return Poller;
+
+		CONSOLE_Print( "[POLLER] unable to create epoll instance, falling back to select" );
+		delete Poller;
+	}
+#endif
+
+	return new CSelectPoller( );
+}
+
+//
+// CSelectPoller
+//
+
+CSelectPoller :: CSelectPoller( ) : CSocketPoller( )
+{
+
+}
+
+CSelectPoller :: ~CSelectPoller( )
+{
+
+}
+
+void CSelectPoller :: Add( CSocket *socket, bool watchWritable )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+#ifdef WIN32
+	// on windows FD_SETSIZE limits the number of sockets in an fd_set
+
+	if( m_Sockets.size( ) >= FD_SETSIZE )
+	{
+		CONSOLE_Print( "[POLLER] error - more than " + UTIL_ToString( FD_SETSIZE ) + " sockets registered with the select backend, this socket will not be polled" );
+		return;
+	}
+#else
+	// everywhere else FD_SETSIZE limits the value of the descriptors themselves, FD_SET with a larger one writes past the end of the fd_set
+
+	if( socket->GetFD( ) >= FD_SETSIZE )
+	{
+		CONSOLE_Print( "[POLLER] error - socket descriptor " + UTIL_ToString( socket->GetFD( ) ) + " is too large for the select backend (FD_SETSIZE is " + UTIL_ToString( FD_SETSIZE ) + "), this socket will not be polled, use the epoll backend instead" );
+		return;
+	}
+#endif
+
+	m_Sockets.push_back( socket );
+}
+
+void CSelectPoller :: Remove( CSocket *socket )
+{
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+	m_Sockets.erase( remove( m_Sockets.begin( ), m_Sockets.end( ), socket ), m_Sockets.end( ) );
+}
+
+void CSelectPoller :: Wait( long usecBlock )
+{
+	// the lock is only held while the fd_sets are built and while the results are handed out, not while we block in select
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+	if( m_Sockets.empty( ) )
+	{
+		// we don't have any sockets (i.e. we aren't connected to battle.net maybe due to a lost connection and there aren't any games running)
+		// select will return immediately and we'll chew up the CPU if we let it loop so just sleep for 50ms to kill some time
+
+		Lock.unlock( );
+		MILLISLEEP( 50 );
+		return;
+	}
+
+	// take every registered socket and throw it in one giant select statement so we can block on all sockets
+
+	int nfds = 0;
+	unsigned int NumFDs = 0;
+	fd_set fd;
+	fd_set send_fd;
+	FD_ZERO( &fd );
+	FD_ZERO( &send_fd );
+
+	for( vector<CSocket *> :: iterator i = m_Sockets.begin( ); i != m_Sockets.end( ) && NumFDs < FD_SETSIZE; i++ )
+	{
+		FD_SET( (*i)->GetFD( ), &fd );
+		FD_SET( (*i)->GetFD( ), &send_fd );
+		NumFDs++;
+
+#ifndef WIN32
+		if( (*i)->GetFD( ) > nfds )
+			nfds = (*i)->GetFD( );
+#endif
+	}
+
+	Lock.unlock( );
+
+	struct timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = usecBlock;
+
+	struct timeval send_tv;
+	send_tv.tv_sec = 0;
+	send_tv.tv_usec = 0;
+
+#ifdef WIN32
+	select( 1, &fd, NULL, NULL, &tv );
+	select( 1, NULL, &send_fd, NULL, &send_tv );
+#else
+	select( nfds + 1, &fd, NULL, NULL, &tv );
+	select( nfds + 1, NULL, &send_fd, NULL, &send_tv );
+#endif
+
+	// a socket removed in the meantime is no longer in m_Sockets so it isn't touched, a socket added in the meantime is picked up by the next Wait
+
+	Lock.lock( );
+	NumFDs = 0;
+
+	for( vector<CSocket *> :: iterator i = m_Sockets.begin( ); i != m_Sockets.end( ) && NumFDs < FD_SETSIZE; i++ )
+	{
+		(*i)->SetReadable( FD_ISSET( (*i)->GetFD( ), &fd ) != 0 );
+		(*i)->SetWritable( FD_ISSET( (*i)->GetFD( ), &send_fd ) != 0 );
+		NumFDs++;
+	}
+}
+
+#ifdef __linux__
+
+//
+// CEPollPoller
+//
+
+CEPollPoller :: CEPollPoller( ) : CSocketPoller( )
+{
+	// the size argument is ignored by modern kernels but must be greater than zero
+
+	m_EPoll = epoll_create( 256 );
+	m_NumSockets = 0;
+
+	// epoll_wait only takes a timeout in milliseconds so the game timers would be rounded
+	// instead we arm a timer fd for the exact timeout and let epoll wait on it like on any other socket
+
+	m_TimerFD = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK );
+
+	if( m_TimerFD != -1 && m_EPoll != -1 )
+	{
+		struct epoll_event Event;
+		memset( &Event, 0, sizeof( Event ) );
+		Event.events = EPOLLIN;
+		Event.data.ptr = NULL;
+
+		if( epoll_ctl( m_EPoll, EPOLL_CTL_ADD, m_TimerFD, &Event ) == -1 )
+		{
+			close( m_TimerFD );
+			m_TimerFD = -1;
+		}
+	}
+
+	// Wake writes to an eventfd so another thread can interrupt epoll_wait, it's told apart from the sockets by its data pointer
+
+	m_WakeFD = eventfd( 0, EFD_NONBLOCK );
+
+	if( m_WakeFD != -1 && m_EPoll != -1 )
+	{
+		struct epoll_event Event;
+		memset( &Event, 0, sizeof( Event ) );
+		Event.events = EPOLLIN;
+		Event.data.ptr = &m_WakeFD;
+
+		if( epoll_ctl( m_EPoll, EPOLL_CTL_ADD, m_WakeFD, &Event ) == -1 )
+		{
+			close( m_WakeFD );
+			m_WakeFD = -1;
+		}
+	}
+}
+
+CEPollPoller :: ~CEPollPoller( )
+{
+	if( m_TimerFD != -1 )
+		close( m_TimerFD );
+
+	if( m_WakeFD != -1 )
+		close( m_WakeFD );
+
+	if( m_EPoll != -1 )
+		close( m_EPoll );
+}
+
+void CEPollPoller :: Add( CSocket *socket, bool watchWritable )
+{
+	struct epoll_event Event;
+	memset( &Event, 0, sizeof( Event ) );
+	Event.events = watchWritable ? ( EPOLLIN | EPOLLOUT ) : EPOLLIN;
+	Event.data.ptr = socket;
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+	if( epoll_ctl( m_EPoll, EPOLL_CTL_ADD, socket->GetFD( ), &Event ) == -1 )
+		CONSOLE_Print( "[POLLER] error (epoll_ctl add) - " + UTIL_ToString( GetLastError( ) ) );
+	else
+		m_NumSockets++;
+}
+
+void CEPollPoller :: Remove( CSocket *socket )
+{
+	// kernels before 2.6.9 require a non NULL event pointer even though it's ignored
+
+	struct epoll_event Event;
+	memset( &Event, 0, sizeof( Event ) );
+
+	boost :: mutex :: scoped_lock Lock( m_Mutex );
+
+	if( epoll_ctl( m_EPoll, EPOLL_CTL_DEL, socket->GetFD( ), &Event ) != -1 )
+		m_NumSockets--;
+}
+
+void CEPollPoller :: WatchWritable( CSocket *socket, bool watchWritable )
+{
+	struct epoll_event Event;
+	memset( &Event, 0, sizeof( Event ) );
+	Event.events = watchWritable ? ( EPOLLIN | EPOLLOUT ) : EPOLLIN;
+	Event.data.ptr = socket;
+	epoll_ctl( m_EPoll, EPOLL_CTL_MOD, socket->GetFD( ), &Event );
+}
+
+void CEPollPoller :: Wake( )
+{
+	if( m_WakeFD != -1 )
+	{
+		uint64_t One = 1;
+
+		if( write( m_WakeFD, &One, sizeof( One ) ) == -1 )
+		{
+			// the counter can only be full if nobody has waited in a very long time, either way the waiting thread will wake up
+		}
+	}
+}
+
+void CEPollPoller :: Wait( long usecBlock )
+{
+	// only sockets with pending work are returned so this loop is proportional to the number of ready sockets rather than the number of registered sockets
+	// note: the sockets are only flagged here, the owners consume the flags during their update so a socket deleted after this point can't leave a dangling pointer behind
+
+	if( m_NumSockets == 0 && m_WakeFD == -1 )
+	{
+		// see the comment in CSelectPoller :: Wait
+
+		MILLISLEEP( 50 );
+		return;
+	}
+
+	struct epoll_event Events[256];
+	int Timeout = 0;
+
+	if( usecBlock > 0 )
+	{
+		if( m_TimerFD != -1 )
+		{
+			// arming the timer also resets it so an expiration we didn't wait for can't wake us up early
+			// the millisecond timeout is only a safety net, the timer fd fires first
+
+			struct itimerspec Timer;
+			memset( &Timer, 0, sizeof( Timer ) );
+			Timer.it_value.tv_sec = usecBlock / 1000000;
+			Timer.it_value.tv_nsec = ( usecBlock % 1000000 ) * 1000;
+			timerfd_settime( m_TimerFD, 0, &Timer, NULL );
+			Timeout = usecBlock / 1000 + 1;
+		}
+		else
+			Timeout = ( usecBlock + 999 ) / 1000;
+	}
+
+	int NumEvents = epoll_wait( m_EPoll, Events, 256, Timeout );
+
+	for( int i = 0; i < NumEvents; i++ )
+	{
+		if( Events[i].data.ptr == &m_WakeFD )
+		{
+			// reset the counter so the next Wait blocks again
+
+			uint64_t Count;
+
+			if( read( m_WakeFD, &Count, sizeof( Count ) ) == -1 )
+			{
+				// nothing to do, the counter was already reset
+			}
+
+			continue;
+		}
+
+		CSocket *Socket = (CSocket *)Events[i].data.ptr;
+
+		if( !Socket )
+			continue;
+
+		if( Events[i].events & ( EPOLLIN | EPOLLERR | EPOLLHUP ) )
+			Socket->SetReadable( true );
+
+		if( Events[i].events & ( EPOLLOUT | EPOLLERR | EPOLLHUP ) )
+		{
+			Socket->SetWritable( true );
+
+			// stop watching for writability until the next send would block, otherwise every Wait would return immediately
+
+			if( Events[i].events & EPOLLOUT )
+				WatchWritable( Socket, false );
+		}
+	}
+}
+
+#endif
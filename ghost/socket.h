@@ -21,6 +21,8 @@
 #ifndef SOCKET_H
 #define SOCKET_H
 
+#include <boost/thread/mutex.hpp>
+
 #ifdef WIN32
  #include <winsock2.h>
  #include <errno.h>
@@ -95,6 +97,14 @@
  #define SHUT_RDWR 2
 #endif
 
+class CSocketPoller;
+
+#define TCPSOCKET_RECV_CHUNK	8192		// minimum free space in the receive buffer before each recv call
+#define TCPSOCKET_RECV_LIMIT	65536		// maximum number of bytes received from a socket per DoRecv
+#define TCPSOCKET_SEND_BUFFERS	64			// maximum number of queued byte arrays passed to a single gather write
+
+extern CSocketPoller *gSocketPoller;
+
 //
 // CSocket
 //
@@ -106,19 +116,32 @@ protected:
 	struct sockaddr_in m_SIN;
 	bool m_HasError;
 	int m_Error;
+	CSocketPoller *m_Poller;					// the poller we register with, gSocketPoller unless the socket was handed to a game thread
+	bool m_Registered;							// if the socket is registered with m_Poller
+	bool m_Readable;							// if the socket poller reported the socket as readable
+	bool m_Writable;							// if the socket poller reported the socket as writable
 
 public:
 	CSocket( );
 	CSocket( SOCKET nSocket, struct sockaddr_in nSIN );
-	~CSocket( );
+	virtual ~CSocket( );
 
+	virtual SOCKET GetFD( )							{ return m_Socket; }
 	virtual BYTEARRAY GetPort( );
 	virtual BYTEARRAY GetIP( );
 	virtual string GetIPString( );
 	virtual bool HasError( )						{ return m_HasError; }
 	virtual int GetError( )							{ return m_Error; }
 	virtual string GetErrorString( );
-	virtual void SetFD( fd_set *fd, fd_set *send_fd, int *nfds );
+	virtual bool GetReadable( )						{ return m_Readable; }
+	virtual bool GetWritable( )						{ return m_Writable; }
+	virtual void SetReadable( bool nReadable )		{ m_Readable = nReadable; }
+	virtual void SetWritable( bool nWritable )		{ m_Writable = nWritable; }
+	virtual CSocketPoller *GetPoller( )				{ return m_Poller; }
+	virtual void Register( bool watchWritable );
+	virtual void Unregister( );
+	virtual void Detach( );
+	virtual void Attach( CSocketPoller *poller );
 	virtual void Allocate( int type );
 	virtual void Reset( );
 };
@@ -127,6 +150,8 @@ public:
 // CTCPSocket
 //
 
+class CMetricCounter;
+
 class CTCPSocket : public CSocket
 {
 protected:
@@ -134,10 +159,16 @@ protected:
 	string m_LogFile;
 
 private:
-	string m_RecvBuffer;
-	string m_SendBuffer;
+	BYTEARRAY m_RecvBuffer;						// received data, only the bytes between m_RecvStart and m_RecvEnd haven't been consumed yet
+	uint32_t m_RecvStart;
+	uint32_t m_RecvEnd;
+	deque<SHAREDBYTEARRAY> m_SendQueue;			// byte arrays waiting to be sent, these are shared and must never be modified
+	uint32_t m_SendOffset;						// number of bytes of the first queued byte array which have already been sent
+	uint32_t m_SendSize;						// total number of queued bytes which haven't been sent yet
 	uint32_t m_LastRecv;
 	uint32_t m_LastSend;
+	CMetricCounter *m_BytesReceived;			// NULL unless SetMetricsClass was called
+	CMetricCounter *m_BytesSent;
 
 public:
 	CTCPSocket( );
@@ -146,18 +177,23 @@ public:
 
 	virtual void Reset( );
 	virtual bool GetConnected( )				{ return m_Connected; }
-	virtual string *GetBytes( )					{ return &m_RecvBuffer; }
+	virtual unsigned char *GetRecvData( )		{ return m_RecvStart < m_RecvEnd ? &m_RecvBuffer[m_RecvStart] : NULL; }
+	virtual uint32_t GetRecvSize( )				{ return m_RecvEnd - m_RecvStart; }
+	virtual void ConsumeRecvBytes( uint32_t length );
 	virtual void PutBytes( string bytes );
 	virtual void PutBytes( BYTEARRAY bytes );
-	virtual void ClearRecvBuffer( )				{ m_RecvBuffer.clear( ); }
-	virtual void ClearSendBuffer( )				{ m_SendBuffer.clear( ); }
+	virtual void PutBytes( SHAREDBYTEARRAY bytes );
+	virtual uint32_t GetSendSize( )				{ return m_SendSize; }
+	virtual void ClearRecvBuffer( )				{ m_RecvStart = 0; m_RecvEnd = 0; }
+	virtual void ClearSendBuffer( )				{ m_SendQueue.clear( ); m_SendOffset = 0; m_SendSize = 0; }
 	virtual uint32_t GetLastRecv( )				{ return m_LastRecv; }
 	virtual uint32_t GetLastSend( )				{ return m_LastSend; }
-	virtual void DoRecv( fd_set *fd );
-	virtual void DoSend( fd_set *send_fd );
+	virtual void DoRecv( );
+	virtual void DoSend( );
 	virtual void Disconnect( );
 	virtual void SetNoDelay( bool noDelay );
 	virtual void SetLogFile( string nLogFile )	{ m_LogFile = nLogFile; }
+	virtual void SetMetricsClass( string metricsClass );
 };
 
 //
@@ -191,7 +227,7 @@ public:
 	virtual ~CTCPServer( );
 
 	virtual bool Listen( string address, uint16_t port );
-	virtual CTCPSocket *Accept( fd_set *fd );
+	virtual CTCPSocket *Accept( );
 };
 
 //
@@ -225,7 +261,98 @@ public:
 
 	virtual bool Bind( struct sockaddr_in sin );
 	virtual bool Bind( string address, uint16_t port );
-	virtual void RecvFrom( fd_set *fd, struct sockaddr_in *sin, string *message );
+	virtual void RecvFrom( struct sockaddr_in *sin, string *message );
+};
+
+//
+// CSocketPoller
+// a readiness backend for all the sockets we block on in the main loop
+// sockets register themselves once (when listening, accepting, connecting, or binding) and unregister when they're closed
+// after each Wait the poller has set the readable/writable flags on every socket with pending work so the owners don't need to rebuild fd_sets every loop
+// every thread with an event loop (the main thread and each game thread) has its own poller and only waits on that one
+// a socket moves to another thread by being detached from its poller on the old thread and attached to the new thread's poller there
+// so each poller only ever sees its own thread's sockets and a socket's flags are only ever written by the thread which currently owns it
+//
+
+class CSocketPoller
+{
+protected:
+	boost :: mutex m_Mutex;						// serializes Add and Remove
+
+public:
+	CSocketPoller( );
+	virtual ~CSocketPoller( );
+
+	static CSocketPoller *Create( string method );
+
+	virtual string GetName( ) = 0;
+	virtual unsigned int GetNumSockets( ) = 0;
+	virtual void Add( CSocket *socket, bool watchWritable ) = 0;
+	virtual void Remove( CSocket *socket ) = 0;
+	virtual void WatchWritable( CSocket *socket, bool watchWritable ) = 0;
+	virtual void Wait( long usecBlock ) = 0;
+
+	// interrupts a Wait from another thread (e.g. when a task was queued for the thread waiting on us)
+	// if the backend can't be woken up the waiting thread has to limit how long it blocks for instead
+
+	virtual bool GetCanWake( )						{ return false; }
+	virtual void Wake( )							{ }
 };
 
+//
+// CSelectPoller
+// portable fallback, level triggered
+// this backend still rebuilds the fd_sets on every Wait but only from the registered sockets and it's limited to FD_SETSIZE sockets
+//
+
+class CSelectPoller : public CSocketPoller
+{
+private:
+	vector<CSocket *> m_Sockets;
+
+public:
+	CSelectPoller( );
+	virtual ~CSelectPoller( );
+
+	virtual string GetName( )						{ return "select"; }
+	virtual unsigned int GetNumSockets( )			{ return m_Sockets.size( ); }
+	virtual void Add( CSocket *socket, bool watchWritable );
+	virtual void Remove( CSocket *socket );
+	virtual void WatchWritable( CSocket *, bool )	{ }	// the fd_sets are rebuilt from the sockets on every Wait
+	virtual void Wait( long usecBlock );
+};
+
+#ifdef __linux__
+
+//
+// CEPollPoller
+// level triggered for reads, writes are only watched after a send would have blocked (or while connecting)
+// this means idle sockets cost nothing per loop and there's no limit on the number of sockets
+//
+
+class CEPollPoller : public CSocketPoller
+{
+private:
+	int m_EPoll;
+	int m_TimerFD;									// wakes epoll_wait with microsecond precision (-1 if unavailable)
+	int m_WakeFD;									// an eventfd which is written to by Wake (-1 if unavailable)
+	unsigned int m_NumSockets;
+
+public:
+	CEPollPoller( );
+	virtual ~CEPollPoller( );
+
+	virtual bool GetValid( )						{ return m_EPoll != -1; }
+	virtual string GetName( )						{ return "epoll"; }
+	virtual unsigned int GetNumSockets( )			{ return m_NumSockets; }
+	virtual void Add( CSocket *socket, bool watchWritable );
+	virtual void Remove( CSocket *socket );
+	virtual void WatchWritable( CSocket *socket, bool watchWritable );
+	virtual void Wait( long usecBlock );
+	virtual bool GetCanWake( )						{ return m_WakeFD != -1; }
+	virtual void Wake( );
+};
+
+#endif
+
 #endif
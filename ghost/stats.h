@@ -28,12 +28,12 @@
 // the stats class is passed a copy of every player action in ProcessAction when it's received
 // then when the game is over the Save function is called
 // so the idea is that you parse the actions to gather data about the game, storing the results in any member variables you need in your subclass
-// and in the Save function you write the results to the database
+// and in the Save function you add the results to the game's CDBGameResult which is then written to the database in one go
 // e.g. for dota the number of kills/deaths/assists, etc...
 // the base class is almost completely empty
 
 class CIncomingAction;
-class CGHostDB;
+class CDBGameResult;
 
 class CStats
 {
@@ -46,7 +46,7 @@ public:
 
         virtual void SetWinner( uint32_t nWinner ) {}
 	virtual bool ProcessAction( CIncomingAction *Action );
-	virtual void Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID );
+	virtual void Save( CDBGameResult *Result );
 };
 
 #endif
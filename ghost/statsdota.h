@@ -26,6 +26,7 @@
 //
 
 class CDBDotAPlayer;
+class CActionScanner;
 
 class CStatsDOTA : public CStats
 {
@@ -34,6 +35,7 @@ private:
 	uint32_t m_Winner;
 	uint32_t m_Min;
 	uint32_t m_Sec;
+	CActionScanner *m_Scanner;
 
 public:
 	CStatsDOTA( CBaseGame *nGame );
@@ -41,7 +43,7 @@ public:
 
 	virtual bool ProcessAction( CIncomingAction *Action );
         virtual void SetWinner( uint32_t nWinner )                  { m_Winner = nWinner; }
-	virtual void Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID );
+	virtual void Save( CDBGameResult *Result );
 };
 
 #endif
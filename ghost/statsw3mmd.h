@@ -25,6 +25,8 @@
 // CStatsW3MMD
 //
 
+class CActionScanner;
+
 typedef pair<uint32_t,string> VarP;
 
 class CStatsW3MMD : public CStats
@@ -42,13 +44,14 @@ private:
 	map<VarP,double> m_VarPReals;				// pid,varname -> value (e.g. 0,"x" -> 0.8)
 	map<VarP,string> m_VarPStrings;				// pid,varname -> value (e.g. 0,"hero" -> "heroname")
 	map<string, vector<string> > m_DefEvents;	// event -> vector of arguments + format
+	CActionScanner *m_Scanner;
 
 public:
 	CStatsW3MMD( CBaseGame *nGame, string nCategory );
 	virtual ~CStatsW3MMD( );
 
 	virtual bool ProcessAction( CIncomingAction *Action );
-	virtual void Save( CGHost *GHost, CGHostDB *DB, uint32_t GameID );
+	virtual void Save( CDBGameResult *Result );
 	virtual vector<string> TokenizeKey( string key );
 };
 
@@ -0,0 +1,291 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#include "ghost.h"
+#include "timerwheel.h"
+
+#include <string.h>
+
+//
+// CTimer
+//
+
+CTimer :: ~CTimer( )
+{
+	if( m_Wheel )
+		m_Wheel->Cancel( this );
+}
+
+//
+// CTimerWheel
+//
+
+CTimerWheel :: CTimerWheel( uint64_t now )
+{
+	memset( m_Level0, 0, sizeof( m_Level0 ) );
+	memset( m_Level1, 0, sizeof( m_Level1 ) );
+	memset( m_Level2, 0, sizeof( m_Level2 ) );
+	m_Current = now / 1000;
+	m_NumTimers = 0;
+}
+
+CTimerWheel :: ~CTimerWheel( )
+{
+	// the timers belong to their owners, we just make sure they don't try to unlink themselves from us later
+
+	CTimer **Levels[] = { m_Level0, m_Level1, m_Level2 };
+	uint32_t Sizes[] = { TIMERWHEEL_LEVEL0_SLOTS, TIMERWHEEL_LEVEL_SLOTS, TIMERWHEEL_LEVEL_SLOTS };
+
+	for( uint32_t i = 0; i < 3; i++ )
+	{
+		for( uint32_t j = 0; j < Sizes[i]; j++ )
+		{
+			for( CTimer *Timer = Levels[i][j]; Timer; Timer = Timer->m_Next )
+			{
+				Timer->m_Wheel = NULL;
+				Timer->m_Slot = NULL;
+			}
+		}
+	}
+}
+
+CTimer **CTimerWheel :: GetSlot( uint64_t ticks )
+{
+	if( ticks < m_Current )
+		ticks = m_Current;
+
+	if( ticks - m_Current < TIMERWHEEL_LEVEL0_SLOTS )
+		return &m_Level0[ticks % TIMERWHEEL_LEVEL0_SLOTS];
+
+	// compare the slot numbers rather than the distance so a timer never ends up in the slot which is currently being spread over the level below
+
+	uint64_t Slot1 = ticks >> TIMERWHEEL_LEVEL0_BITS;
+	uint64_t Current1 = m_Current >> TIMERWHEEL_LEVEL0_BITS;
+
+	if( Slot1 - Current1 < TIMERWHEEL_LEVEL_SLOTS )
+		return &m_Level1[Slot1 % TIMERWHEEL_LEVEL_SLOTS];
+
+	uint64_t Slot2 = ticks >> ( TIMERWHEEL_LEVEL0_BITS + TIMERWHEEL_LEVEL_BITS );
+	uint64_t Current2 = m_Current >> ( TIMERWHEEL_LEVEL0_BITS + TIMERWHEEL_LEVEL_BITS );
+
+	if( Slot2 - Current2 >= TIMERWHEEL_LEVEL_SLOTS )
+		Slot2 = Current2 + TIMERWHEEL_LEVEL_SLOTS - 1;
+
+	return &m_Level2[Slot2 % TIMERWHEEL_LEVEL_SLOTS];
+}
+
+void CTimerWheel :: Link( CTimer *timer )
+{
+	CTimer **Slot = GetSlot( timer->m_Deadline / 1000 );
+	timer->m_Slot = Slot;
+	timer->m_Prev = NULL;
+	timer->m_Next = *Slot;
+
+	if( *Slot )
+		(*Slot)->m_Prev = timer;
+
+	*Slot = timer;
+}
+
+void CTimerWheel :: Unlink( CTimer *timer )
+{
+	if( timer->m_Prev )
+		timer->m_Prev->m_Next = timer->m_Next;
+	else
+		*timer->m_Slot = timer->m_Next;
+
+	if( timer->m_Next )
+		timer->m_Next->m_Prev = timer->m_Prev;
+
+	timer->m_Prev = NULL;
+	timer->m_Next = NULL;
+	timer->m_Slot = NULL;
+}
+
+void CTimerWheel :: Cascade( CTimer **slot )
+{
+	CTimer *Timer = *slot;
+	*slot = NULL;
+
+	while( Timer )
+	{
+		CTimer *Next = Timer->m_Next;
+		Link( Timer );
+		Timer = Next;
+	}
+}
+
+uint64_t CTimerWheel :: GetEarliest( CTimer *slot )
+{
+	uint64_t Earliest = slot->m_Deadline;
+
+	for( CTimer *Timer = slot->m_Next; Timer; Timer = Timer->m_Next )
+	{
+		if( Timer->m_Deadline < Earliest )
+			Earliest = Timer->m_Deadline;
+	}
+
+	return Earliest;
+}
+
+void CTimerWheel :: Schedule( CTimer *timer, uint64_t deadline )
+{
+	if( timer->m_Wheel == this )
+		Unlink( timer );
+	else
+	{
+		if( timer->m_Wheel )
+			timer->m_Wheel->Cancel( timer );
+
+		timer->m_Wheel = this;
+		m_NumTimers++;
+	}
+
+	timer->m_Deadline = deadline;
+	timer->m_Expired = false;
+	Link( timer );
+}
+
+void CTimerWheel :: Cancel( CTimer *timer )
+{
+	timer->m_Expired = false;
+
+	if( timer->m_Wheel != this )
+		return;
+
+	Unlink( timer );
+	timer->m_Wheel = NULL;
+	m_NumTimers--;
+}
+
+uint64_t CTimerWheel :: GetNextDeadline( uint64_t now, uint64_t maxWait )
+{
+	uint64_t Best = now + maxWait;
+
+	if( m_NumTimers == 0 )
+		return Best;
+
+	// within the first two levels the slots are in order so the first non empty slot holds the level's earliest deadline
+	// but a higher level slot is only spread over the level below once we get there, so the next one can still hold an earlier deadline than a lower level
+	// that's why we look at every level, skipping the slots which start after the best deadline we already have
+
+	for( uint64_t i = 0; i < TIMERWHEEL_LEVEL0_SLOTS; i++ )
+	{
+		uint64_t Ticks = m_Current + i;
+
+		if( Ticks * 1000 >= Best )
+			break;
+
+		CTimer *Slot = m_Level0[Ticks % TIMERWHEEL_LEVEL0_SLOTS];
+
+		if( Slot )
+		{
+			Best = min( Best, GetEarliest( Slot ) );
+			break;
+		}
+	}
+
+	for( uint64_t i = 1; i < TIMERWHEEL_LEVEL_SLOTS; i++ )
+	{
+		uint64_t Slot1 = ( m_Current >> TIMERWHEEL_LEVEL0_BITS ) + i;
+
+		if( ( Slot1 << TIMERWHEEL_LEVEL0_BITS ) * 1000 >= Best )
+			break;
+
+		CTimer *Slot = m_Level1[Slot1 % TIMERWHEEL_LEVEL_SLOTS];
+
+		if( Slot )
+		{
+			Best = min( Best, GetEarliest( Slot ) );
+			break;
+		}
+	}
+
+	// the last slot of the third level also holds the timers which are too far out for the wheel, so this level isn't in order
+
+	for( uint64_t i = 1; i < TIMERWHEEL_LEVEL_SLOTS; i++ )
+	{
+		uint64_t Slot2 = ( m_Current >> ( TIMERWHEEL_LEVEL0_BITS + TIMERWHEEL_LEVEL_BITS ) ) + i;
+
+		if( ( Slot2 << ( TIMERWHEEL_LEVEL0_BITS + TIMERWHEEL_LEVEL_BITS ) ) * 1000 >= Best )
+			break;
+
+		CTimer *Slot = m_Level2[Slot2 % TIMERWHEEL_LEVEL_SLOTS];
+
+		if( Slot )
+			Best = min( Best, GetEarliest( Slot ) );
+	}
+
+	return Best;
+}
+
+uint32_t CTimerWheel :: Expire( uint64_t now )
+{
+	uint64_t Ticks = now / 1000;
+	uint32_t NumExpired = 0;
+
+	while( true )
+	{
+		if( m_NumTimers == 0 )
+		{
+			// there's nothing to expire or spread over the lower levels so we can skip ahead
+
+			if( Ticks > m_Current )
+				m_Current = Ticks;
+
+			break;
+		}
+
+		// every timer in a slot before the current millisecond is due, in the current millisecond we have to check the exact deadline
+
+		CTimer *Timer = m_Level0[m_Current % TIMERWHEEL_LEVEL0_SLOTS];
+
+		while( Timer )
+		{
+			CTimer *Next = Timer->m_Next;
+
+			if( Timer->m_Deadline <= now )
+			{
+				Unlink( Timer );
+				Timer->m_Wheel = NULL;
+				Timer->m_Expired = true;
+				m_NumTimers--;
+				NumExpired++;
+			}
+
+			Timer = Next;
+		}
+
+		if( m_Current >= Ticks )
+			break;
+
+		m_Current++;
+
+		if( m_Current % TIMERWHEEL_LEVEL0_SLOTS == 0 )
+		{
+			if( ( m_Current >> TIMERWHEEL_LEVEL0_BITS ) % TIMERWHEEL_LEVEL_SLOTS == 0 )
+				Cascade( &m_Level2[( m_Current >> ( TIMERWHEEL_LEVEL0_BITS + TIMERWHEEL_LEVEL_BITS ) ) % TIMERWHEEL_LEVEL_SLOTS] );
+
+			Cascade( &m_Level1[( m_Current >> TIMERWHEEL_LEVEL0_BITS ) % TIMERWHEEL_LEVEL_SLOTS] );
+		}
+	}
+
+	return NumExpired;
+}
@@ -0,0 +1,106 @@
+/*
+
+   Copyright [2008] [Trevor Hogan]
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   CODE PORTED FROM THE ORIGINAL GHOST PROJECT: http://ghost.pwner.org/
+
+*/
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+//
+// CTimer
+//
+
+// a timer is owned (and usually embedded) by whoever schedules it, the wheel only links it into one of its slots
+// when the deadline passes the wheel unlinks it and sets the expired flag, the owner checks the flag and reschedules it if needed
+
+class CTimerWheel;
+
+class CTimer
+{
+	friend class CTimerWheel;
+
+private:
+	uint64_t m_Deadline;				// GetMicroTicks
+	CTimer *m_Prev;
+	CTimer *m_Next;
+	CTimer **m_Slot;					// the head of the list we're linked into
+	CTimerWheel *m_Wheel;				// the wheel we're linked into (NULL if we aren't scheduled)
+	bool m_Expired;
+
+public:
+	CTimer( ) : m_Deadline( 0 ), m_Prev( NULL ), m_Next( NULL ), m_Slot( NULL ), m_Wheel( NULL ), m_Expired( false ) { }
+	~CTimer( );
+
+	uint64_t GetDeadline( )				{ return m_Deadline; }
+	bool GetScheduled( )				{ return m_Wheel != NULL; }
+	bool GetExpired( )					{ return m_Expired; }
+	void ClearExpired( )				{ m_Expired = false; }
+};
+
+//
+// CTimerWheel
+//
+
+// a hierarchical timer wheel with millisecond slots, the deadlines themselves are kept in microseconds
+// 1.) the first level has one slot per millisecond for the next 256ms, the second level one slot per 256ms for the next ~16s and the third one slot per ~16s for the next ~17m
+// 2.) timers further out than that wait in the last slot of the third level and are simply put back when it comes around
+// 3.) when the first level wraps the next slot of the second level is spread over it (and likewise for the third level), so every timer is moved at most twice
+// 4.) scheduling and cancelling a timer is constant time, the slots are intrusive doubly linked lists
+// 5.) the next deadline is exact (not rounded to the slot) so the main loop can sleep until exactly then
+
+#define TIMERWHEEL_LEVEL0_BITS		8
+#define TIMERWHEEL_LEVEL_BITS		6
+#define TIMERWHEEL_LEVEL0_SLOTS		( 1 << TIMERWHEEL_LEVEL0_BITS )
+#define TIMERWHEEL_LEVEL_SLOTS		( 1 << TIMERWHEEL_LEVEL_BITS )
+
+class CTimerWheel
+{
+private:
+	CTimer *m_Level0[TIMERWHEEL_LEVEL0_SLOTS];
+	CTimer *m_Level1[TIMERWHEEL_LEVEL_SLOTS];
+	CTimer *m_Level2[TIMERWHEEL_LEVEL_SLOTS];
+	uint64_t m_Current;					// the millisecond whose first level slot hasn't been fully expired yet
+	uint32_t m_NumTimers;
+
+	CTimer **GetSlot( uint64_t ticks );
+	void Link( CTimer *timer );
+	void Unlink( CTimer *timer );
+	void Cascade( CTimer **slot );
+	uint64_t GetEarliest( CTimer *slot );
+
+public:
+	CTimerWheel( uint64_t now );
+	~CTimerWheel( );
+
+	uint32_t GetNumTimers( )			{ return m_NumTimers; }
+
+	// scheduling a timer which is already scheduled moves it, a deadline in the past expires on the next call to Expire
+
+	void Schedule( CTimer *timer, uint64_t deadline );
+	void Cancel( CTimer *timer );
+
+	// returns the earliest deadline of any scheduled timer (or now + maxWait if that's sooner)
+
+	uint64_t GetNextDeadline( uint64_t now, uint64_t maxWait );
+
+	// unlinks every timer whose deadline is at or before now and sets its expired flag, returns the number of expired timers
+
+	uint32_t Expire( uint64_t now );
+};
+
+#endif
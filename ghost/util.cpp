@@ -64,6 +64,15 @@ BYTEARRAY UTIL_CreateByteArray( uint32_t i, bool reverse )
 		return result;
 }
 
+SHAREDBYTEARRAY UTIL_CreateSharedByteArray( BYTEARRAY &b )
+{
+	// the contents of b are moved (not copied) into the shared byte array so b is left empty
+
+	BYTEARRAY *Shared = new BYTEARRAY( );
+	Shared->swap( b );
+	return SHAREDBYTEARRAY( Shared );
+}
+
 uint16_t UTIL_ByteArrayToUInt16( BYTEARRAY b, bool reverse, unsigned int start )
 {
 	if( b.size( ) < start + 2 )
@@ -90,6 +99,26 @@ uint32_t UTIL_ByteArrayToUInt32( BYTEARRAY b, bool reverse, unsigned int start )
 	return (uint32_t)( temp[3] << 24 | temp[2] << 16 | temp[1] << 8 | temp[0] );
 }
 
+uint16_t UTIL_ByteArrayToUInt16( const unsigned char *b, bool reverse )
+{
+	// the caller is responsible for making sure there are at least 2 bytes available
+
+	if( reverse )
+		return (uint16_t)( b[0] << 8 | b[1] );
+
+	return (uint16_t)( b[1] << 8 | b[0] );
+}
+
+uint32_t UTIL_ByteArrayToUInt32( const unsigned char *b, bool reverse )
+{
+	// the caller is responsible for making sure there are at least 4 bytes available
+
+	if( reverse )
+		return (uint32_t)( b[0] << 24 | b[1] << 16 | b[2] << 8 | b[3] );
+
+	return (uint32_t)( b[3] << 24 | b[2] << 16 | b[1] << 8 | b[0] );
+}
+
 string UTIL_ByteArrayToDecString( BYTEARRAY b )
 {
 	if( b.empty( ) )
@@ -27,8 +27,11 @@ BYTEARRAY UTIL_CreateByteArray( unsigned char *a, int size );
 BYTEARRAY UTIL_CreateByteArray( unsigned char c );
 BYTEARRAY UTIL_CreateByteArray( uint16_t i, bool reverse );
 BYTEARRAY UTIL_CreateByteArray( uint32_t i, bool reverse );
+SHAREDBYTEARRAY UTIL_CreateSharedByteArray( BYTEARRAY &b );
 uint16_t UTIL_ByteArrayToUInt16( BYTEARRAY b, bool reverse, unsigned int start = 0 );
 uint32_t UTIL_ByteArrayToUInt32( BYTEARRAY b, bool reverse, unsigned int start = 0 );
+uint16_t UTIL_ByteArrayToUInt16( const unsigned char *b, bool reverse );
+uint32_t UTIL_ByteArrayToUInt32( const unsigned char *b, bool reverse );
 string UTIL_ByteArrayToDecString( BYTEARRAY b );
 string UTIL_ByteArrayToHexString( BYTEARRAY b );
 void UTIL_AppendByteArray( BYTEARRAY &b, BYTEARRAY append );